@@ -0,0 +1,218 @@
+/**
+ * @file bench.h
+ * @author Britannio Jarrett
+ * @brief Shared pieces of the CRSF benchmark harness.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * The harness builds for the host, where ticks are nanoseconds, and for the
+ * RP2040 (BENCH_CYCLES=1), where ticks are core clock cycles counted by SysTick.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "crsf.h"
+
+#ifndef BENCH_CYCLES
+#define BENCH_CYCLES 0
+#endif
+
+#if BENCH_CYCLES
+#define BENCH_TICK_UNIT "cycles"
+#else
+#define BENCH_TICK_UNIT "ns"
+#endif
+
+// Free-running tick counter. Only differences taken with bench_elapsed() are meaningful.
+uint32_t bench_ticks(void);
+// Ticks since `start`. Batches must be shorter than the counter period (2^24 cycles on the RP2040).
+uint32_t bench_elapsed(uint32_t start);
+// Converts ticks to seconds of wall time.
+double bench_seconds(uint64_t ticks);
+// Wall time a suite should accumulate before reporting.
+double bench_target_seconds(void);
+// Microseconds of wall time, for transports that run in real time.
+uint64_t bench_time_us(void);
+void bench_init(void);
+// Sorts tick counts in place, for percentiles.
+void bench_sort_ticks(uint32_t *ticks, size_t count);
+
+typedef struct
+{
+	// RC_CHANNELS_PACKED frames per second (50 - 1000)
+	uint32_t rc_rate_hz;
+	// LINK_STATISTICS frames per second, interleaved with the RC frames
+	uint32_t link_stats_rate_hz;
+	// Length of the stream in milliseconds of airtime
+	uint32_t duration_ms;
+	// Probability of each bit being flipped
+	double bit_error_rate;
+	// Probability of each byte being lost
+	double byte_drop_rate;
+	// Probability of a burst of garbage before each frame, and its maximum length
+	double garbage_rate;
+	uint8_t garbage_max_len;
+	uint32_t seed;
+	// Leave the frames the errors would have damaged out instead, keeping the
+	// garbage and every other frame the same, as a baseline for their cost
+	bool omit_corrupted;
+} bench_stream_config_t;
+
+typedef struct
+{
+	uint8_t *data;
+	size_t capacity;
+	size_t len;
+	// Frames written, and how many of those were damaged by bit errors or drops
+	uint32_t frames;
+	uint32_t corrupted_frames;
+} bench_stream_t;
+
+#if BENCH_CYCLES
+// Fits one second of stream at 1 kHz with garbage
+#define BENCH_STREAM_CAPACITY (40 * 1024)
+#else
+#define BENCH_STREAM_CAPACITY (1024 * 1024)
+#endif
+
+// Size of the chunks handed to crsf_ctx_parse(), as a DMA or FIFO drain would
+#define BENCH_PARSE_CHUNK 64
+
+// Backing store for the stream of whichever suite is running
+extern uint8_t bench_stream_data[BENCH_STREAM_CAPACITY];
+
+void bench_stream_default_config(bench_stream_config_t *config);
+void bench_stream_generate(bench_stream_t *stream, const bench_stream_config_t *config);
+uint32_t bench_random(uint32_t *state);
+// An RC frame whose 16 channels all carry `value`, so a torn or mixed up frame is easy to spot
+void bench_rc_frame(uint8_t frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4], uint16_t value);
+// Appends a frame with `length` bytes of `payload` at data + *len and advances *len past it
+void bench_put_frame(uint8_t *data, size_t *len, uint8_t type, const uint8_t *payload, uint8_t length);
+
+#define BENCH_LINK_BUFFER_SIZE 512
+
+/**
+ * One end of a UART link in virtual time, behind a crsf_transport_t (see
+ * bench_link.c). Reads return rx[rx_offset, rx_len), `chunk` bytes at most.
+ * Writes reach the peer's buffer, intact while both ends run at the same baud
+ * rate and as noise otherwise; without a peer they are collected in `out`, if
+ * set, or discarded.
+ */
+typedef struct bench_link_s
+{
+	// `buffer` unless bench_link_replay() pointed the reads elsewhere
+	const uint8_t *rx;
+	size_t rx_len;
+	size_t rx_offset;
+	// Largest read, as a FIFO drain would return, 0 for no limit
+	size_t chunk;
+	uint8_t buffer[BENCH_LINK_BUFFER_SIZE];
+	struct bench_link_s *peer;
+	uint8_t *out;
+	size_t out_capacity;
+	size_t out_len;
+	// Bytes written, whether or not they arrived
+	size_t written;
+	// Chance of a write being lost whole, per mille
+	uint32_t loss_per_mille;
+	uint32_t baud_rate;
+	// Calls to set_baud
+	uint32_t baud_switches;
+	uint32_t rng;
+	// Called with every write after it has been delivered, with `user` free for it
+	void (*on_write)(struct bench_link_s *link, const uint8_t *buf, size_t len);
+	void *user;
+} bench_link_t;
+
+// The virtual time every link reports, advanced by the suites
+extern uint64_t bench_now_us;
+
+// Empties `link` and sets it to CRSF_BAUD_RATE_DEFAULT with no peer
+void bench_link_init(bench_link_t *link);
+// Makes `a` and `b` each other's peer
+void bench_link_connect(bench_link_t *a, bench_link_t *b);
+void bench_link_transport(crsf_transport_t *transport, bench_link_t *link);
+// Queues bytes for the reader as they arrived, going back to the link's own buffer after a replay
+void bench_link_push(bench_link_t *link, const uint8_t *data, size_t len);
+// Points the reads at `len` bytes of `data`, which must outlive them
+void bench_link_replay(bench_link_t *link, const uint8_t *data, size_t len);
+// The transport's write, for sending from this end without a crsf_t
+size_t bench_link_write(void *ctx, const uint8_t *buf, size_t len);
+
+#if CRSF_STATS
+// Prints crsf_ctx_get_stats(), see bench_parser.c
+void bench_print_stats(const crsf_t *crsf);
+#endif
+
+// Suites that rely on parts of the library crsf_config.h can leave out. Their
+// files build empty without them, and crsf_bench and crsf_check skip them.
+// Most drive a crsf_t with RC frames, which also open its telemetry slots.
+#define BENCH_RC_CHANGES (CRSF_CALLBACKS && CRSF_FRAME_RC_CHANNELS_PACKED)
+// Switches on the link statistics, reported through the callbacks
+#define BENCH_DIVERSITY (CRSF_CALLBACKS && CRSF_FRAME_RC_CHANNELS_PACKED && CRSF_FRAME_LINK_STATISTICS)
+// Fragments go out as custom payload telemetry and come back through the frame callback
+#define BENCH_FRAGMENT (CRSF_TELEMETRY && CRSF_CALLBACKS && CRSF_FRAME_RC_CHANNELS_PACKED && CRSF_FRAME_CUSTOM_PAYLOAD)
+// The module corrects the timing with radio ID frames, and its link statistics
+// are read back from the snapshot
+#define BENCH_TX (CRSF_TELEMETRY && CRSF_SNAPSHOT && CRSF_FRAME_RADIO_ID && CRSF_FRAME_LINK_STATISTICS)
+// Negotiated with command frames. The switch is reported through a callback, and
+// the RC frame after it read from the snapshot
+#define BENCH_BAUD_RATE \
+  (CRSF_TELEMETRY && CRSF_CALLBACKS && CRSF_SNAPSHOT && CRSF_FRAME_RC_CHANNELS_PACKED && CRSF_FRAME_COMMAND)
+// The router's check injects the local instance's telemetry into the RC slots
+#define BENCH_ROUTER_CHECK (CRSF_TELEMETRY && CRSF_FRAME_RC_CHANNELS_PACKED)
+// The pipeline worker delivers its events through the callbacks
+#define BENCH_PIPELINE (CRSF_CALLBACKS && CRSF_FRAME_RC_CHANNELS_PACKED)
+
+// Timing suites, one file each, run by crsf_bench
+void bench_parser(const bench_stream_config_t *config);
+void bench_crc(void);
+void bench_channels(void);
+void bench_condition(void);
+void bench_encoder(void);
+void bench_rc_changes(void);
+void bench_telemetry(void);
+void bench_fragment(void);
+void bench_tx(void);
+void bench_baud_rate(void);
+void bench_snapshot(void);
+void bench_router(void);
+void bench_diversity(void);
+// Timings of the C++ layer in crsf.hpp against the C path, see bench_cpp.cpp
+void bench_cpp(void);
+#if !BENCH_CYCLES
+void bench_failsafe(void);
+void bench_pipeline(void);
+void bench_router_latency(void);
+// Writes the noisy stream as a capture file, and times the parser over one
+bool bench_save_capture(const char *path, const bench_stream_config_t *config);
+bool bench_capture_file(const char *path);
+#endif
+
+// Correctness checks next to the suites, run by crsf_check. Each prints what
+// went wrong and returns false on a failure.
+bool bench_check_crc(void);
+bool bench_check_channels(void);
+bool bench_check_condition(void);
+bool bench_check_rc_changes(void);
+bool bench_check_fragment(void);
+bool bench_check_tx(void);
+bool bench_check_baud_rate(void);
+bool bench_check_capture(void);
+bool bench_check_router(void);
+bool bench_check_diversity(void);
+bool bench_check_cpp(void);
+#if !BENCH_CYCLES
+bool bench_check_failsafe(void);
+bool bench_check_pipeline(void);
+bool bench_check_snapshot(void);
+bool bench_check_ring(void);
+bool bench_check_linux_write(void);
+#endif
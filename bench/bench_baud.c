@@ -0,0 +1,146 @@
+/**
+ * @file bench_baud.c
+ * @author Britannio Jarrett
+ * @brief Baud rate negotiation between two instances, and autobaud lock time.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+
+#if BENCH_BAUD_RATE
+static uint32_t _baud_reported;
+
+static void _on_baud_rate_bench(crsf_t *crsf, uint32_t baud_rate)
+{
+  (void)crsf;
+  _baud_reported = baud_rate;
+}
+
+// Two ends of a UART, which only understand each other at the same rate
+static void _baud_link(bench_link_t *a, bench_link_t *b, crsf_transport_t *ta, crsf_transport_t *tb)
+{
+  bench_link_init(a);
+  bench_link_init(b);
+  bench_link_connect(a, b);
+  bench_link_transport(ta, a);
+  bench_link_transport(tb, b);
+  bench_now_us = 0;
+}
+
+/**
+ * A transmitter proposes a faster rate to a flight controller. Both ends must
+ * switch after the response, and an RC frame must then get through. A rate
+ * above the flight controller's limit must be rejected with neither end moving.
+ */
+static bool _check_baud_negotiation(uint32_t baud_rate, uint32_t max_baud_rate)
+{
+  static bench_link_t fc_end, tx_end;
+  static crsf_transport_t fc_transport, tx_transport;
+  static crsf_t fc, tx;
+  _baud_link(&fc_end, &tx_end, &fc_transport, &tx_transport);
+  crsf_init(&fc, &fc_transport);
+  crsf_init(&tx, &tx_transport);
+  crsf_ctx_set_address(&tx, CRSF_ADDRESS_CRSF_TRANSMITTER);
+  crsf_ctx_set_max_baud_rate(&fc, max_baud_rate);
+  crsf_ctx_set_on_baud_rate(&tx, _on_baud_rate_bench);
+  _baud_reported = 0;
+
+  crsf_ctx_propose_baud_rate(&tx, CRSF_ADDRESS_FLIGHT_CONTROLLER, baud_rate);
+  crsf_ctx_process_frames(&fc);
+  crsf_ctx_process_frames(&tx);
+
+  const bool accepted = baud_rate <= max_baud_rate;
+  const uint32_t expected = accepted ? baud_rate : CRSF_BAUD_RATE_DEFAULT;
+  uint8_t frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4];
+  bench_rc_frame(frame, 1234);
+  bench_link_write(&tx_end, frame, sizeof(frame));
+  crsf_snapshot_t snapshot;
+  crsf_ctx_process_frames(&fc);
+  return crsf_ctx_get_baud_rate(&fc) == expected && crsf_ctx_get_baud_rate(&tx) == expected &&
+         fc_end.baud_rate == expected && tx_end.baud_rate == expected && _baud_reported == (accepted ? baud_rate : 0) &&
+         crsf_ctx_get_latest(&fc, &snapshot) && snapshot.channels[0] == 1234;
+}
+
+/**
+ * A receiver sends RC frames at 500 Hz at `baud_rate` while the flight
+ * controller starts listening at 420 kbaud. Returns the virtual time to lock on.
+ */
+static uint64_t _autobaud_lock_us(uint32_t baud_rate, uint8_t lock_frames)
+{
+  static bench_link_t fc_end, rx_end;
+  static crsf_transport_t fc_transport, rx_transport;
+  static crsf_t fc;
+  _baud_link(&fc_end, &rx_end, &fc_transport, &rx_transport);
+  rx_end.baud_rate = baud_rate;
+  crsf_init(&fc, &fc_transport);
+  crsf_ctx_set_on_baud_rate(&fc, _on_baud_rate_bench);
+  _baud_reported = 0;
+  crsf_ctx_start_autobaud(&fc, lock_frames);
+
+  uint8_t frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4];
+  bench_rc_frame(frame, 992);
+  for (uint32_t n = 1; n <= 5000; n++)
+  {
+    bench_now_us = (uint64_t)n * 2000;
+    bench_link_write(&rx_end, frame, sizeof(frame));
+    crsf_ctx_process_frames(&fc);
+    if (_baud_reported != 0)
+    {
+      return _baud_reported == baud_rate ? bench_now_us : 0;
+    }
+  }
+  return 0;
+}
+
+// A request within the limit is switched to at both ends, one beyond it is
+// refused, and autobaud locks onto every standard rate
+bool bench_check_baud_rate(void)
+{
+  bool ok = true;
+  if (!_check_baud_negotiation(1870000, 5250000))
+  {
+    printf("baud       negotiation to 1870000 did not switch both ends\n");
+    ok = false;
+  }
+  if (!_check_baud_negotiation(5250000, 2250000))
+  {
+    printf("baud       request beyond the limit was not rejected\n");
+    ok = false;
+  }
+  for (int i = 0; i < CRSF_BAUD_RATE_COUNT; i++)
+  {
+    if (_autobaud_lock_us(crsf_baud_rates[i], 3) == 0)
+    {
+      printf("autobaud   no lock at %lu\n", (unsigned long)crsf_baud_rates[i]);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+void bench_baud_rate(void)
+{
+  printf("autobaud   lock (3 frames at 500 Hz):");
+  for (int i = 0; i < CRSF_BAUD_RATE_COUNT; i++)
+  {
+    const uint64_t lock_us = _autobaud_lock_us(crsf_baud_rates[i], 3);
+    if (lock_us == 0)
+    {
+      printf(" %lu none", (unsigned long)crsf_baud_rates[i]);
+    }
+    else
+    {
+      printf(" %lu in %lu ms", (unsigned long)crsf_baud_rates[i], (unsigned long)(lock_us / 1000));
+    }
+  }
+  printf("\n");
+}
+#endif
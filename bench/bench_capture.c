@@ -0,0 +1,218 @@
+/**
+ * @file bench_capture.c
+ * @author Britannio Jarrett
+ * @brief Capture ring round trip, and capture files written from and parsed like a live link.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ */
+
+#include "bench.h"
+#include "crsf_capture.h"
+#include <stdio.h>
+#include <string.h>
+
+#if !BENCH_CYCLES
+#include <stdlib.h>
+#endif
+
+// Small enough for the records below to wrap the ring many times
+#define CAPTURE_RING_SIZE 1000
+#define CAPTURE_RECORDS 500
+
+static uint8_t _capture_dump[CRSF_CAPTURE_HEADER_SIZE + CAPTURE_RING_SIZE];
+static size_t _capture_dump_len;
+
+static size_t _capture_dump_write(void *ctx, const uint8_t *buf, size_t len)
+{
+  (void)ctx;
+  memcpy(_capture_dump + _capture_dump_len, buf, len);
+  _capture_dump_len += len;
+  return len;
+}
+
+static size_t _capture_record_length(uint32_t i)
+{
+  return i % (CRSF_MAX_FRAME_SIZE + 1);
+}
+
+static uint8_t _capture_record_byte(uint32_t i, size_t j)
+{
+  return (uint8_t)(i * 31 + j);
+}
+
+// Records chunks of varying length and spacing into a ring that keeps
+// overflowing, then reads the survivors back out of a dump
+bool bench_check_capture(void)
+{
+  static uint8_t ring[CAPTURE_RING_SIZE];
+  static uint64_t times[CAPTURE_RECORDS];
+  crsf_capture_t capture;
+  crsf_capture_init(&capture, ring, sizeof(ring), CRSF_BAUD_RATE_DEFAULT);
+  uint8_t chunk[CRSF_MAX_FRAME_SIZE];
+  uint32_t seed = 1;
+  uint64_t time_us = 0;
+  for (uint32_t i = 0; i < CAPTURE_RECORDS; i++)
+  {
+    // Mostly frame-sized gaps, with the odd one that needs a long varint
+    time_us += i % 97 == 0 ? (uint64_t)1 << 40 : bench_random(&seed) % 5000;
+    times[i] = time_us;
+    const size_t length = _capture_record_length(i);
+    for (size_t j = 0; j < length; j++)
+    {
+      chunk[j] = _capture_record_byte(i, j);
+    }
+    crsf_capture_record(&capture, time_us, i & 1, chunk, length);
+  }
+  if (capture.records + capture.dropped != CAPTURE_RECORDS || capture.dropped == 0)
+  {
+    return false;
+  }
+
+  _capture_dump_len = 0;
+  crsf_capture_dump(&capture, _capture_dump_write, NULL);
+  crsf_capture_reader_t reader;
+  if (!crsf_capture_reader_init(&reader, _capture_dump, _capture_dump_len) || reader.baud_rate != CRSF_BAUD_RATE_DEFAULT)
+  {
+    return false;
+  }
+  const uint32_t first = CAPTURE_RECORDS - capture.records;
+  uint32_t i = first;
+  crsf_capture_record_t record;
+  while (crsf_capture_next(&reader, &record))
+  {
+    if (i == CAPTURE_RECORDS || record.time_us != times[i] - times[first] || record.tx != (i & 1) ||
+        record.length != _capture_record_length(i))
+    {
+      return false;
+    }
+    for (size_t j = 0; j < record.length; j++)
+    {
+      if (record.data[j] != _capture_record_byte(i, j))
+      {
+        return false;
+      }
+    }
+    i++;
+  }
+  return i == CAPTURE_RECORDS;
+}
+
+#if !BENCH_CYCLES
+static size_t _capture_file_write(void *ctx, const uint8_t *buf, size_t len)
+{
+  return fwrite(buf, 1, len, ctx);
+}
+
+// Writes the noisy stream as a capture of a 420000 baud line, in parser-sized chunks
+bool bench_save_capture(const char *path, const bench_stream_config_t *config)
+{
+  FILE *file = fopen(path, "wb");
+  if (file == NULL)
+  {
+    perror(path);
+    return false;
+  }
+  bench_stream_t stream = {.data = bench_stream_data, .capacity = sizeof(bench_stream_data)};
+  bench_stream_generate(&stream, config);
+  crsf_capture_t capture;
+  bool ok = crsf_capture_init_stream(&capture, _capture_file_write, file, CRSF_BAUD_RATE_DEFAULT);
+  for (size_t offset = 0; ok && offset < stream.len; offset += BENCH_PARSE_CHUNK)
+  {
+    const size_t len = stream.len - offset < BENCH_PARSE_CHUNK ? stream.len - offset : BENCH_PARSE_CHUNK;
+    // Frames are packed back to back, so spread the chunks over the stream's airtime
+    const uint64_t time_us = (uint64_t)(offset + len) * config->duration_ms * 1000 / stream.len;
+    ok = crsf_capture_record(&capture, time_us, false, stream.data + offset, len);
+  }
+  ok = fclose(file) == 0 && ok;
+  printf("capture    wrote %s: %lu bytes in %lu records, %lu frames (%lu corrupted)\n", path, (unsigned long)stream.len,
+         (unsigned long)capture.records, (unsigned long)stream.frames, (unsigned long)stream.corrupted_frames);
+  return ok;
+}
+
+// Parses the received side of a capture, chunk for chunk as it was recorded
+bool bench_capture_file(const char *path)
+{
+  FILE *file = fopen(path, "rb");
+  if (file == NULL)
+  {
+    perror(path);
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  rewind(file);
+  uint8_t *data = malloc(size > 0 ? size : 1);
+  const bool read = size >= 0 && fread(data, 1, size, file) == (size_t)size;
+  fclose(file);
+  crsf_capture_reader_t reader;
+  if (!read || !crsf_capture_reader_init(&reader, data, size))
+  {
+    fprintf(stderr, "%s: not a capture\n", path);
+    free(data);
+    return false;
+  }
+
+  // Decoded up front so that only the parser is timed
+  size_t count = 0;
+  size_t capacity = 1024;
+  crsf_capture_record_t *records = malloc(capacity * sizeof(*records));
+  size_t bytes = 0;
+  uint64_t duration_us = 0;
+  crsf_capture_record_t record;
+  while (crsf_capture_next(&reader, &record))
+  {
+    duration_us = record.time_us;
+    if (record.tx)
+    {
+      continue;
+    }
+    if (count == capacity)
+    {
+      capacity *= 2;
+      records = realloc(records, capacity * sizeof(*records));
+    }
+    records[count++] = record;
+    bytes += record.length;
+  }
+
+  uint64_t ticks = 0;
+  uint32_t passes = 0;
+  size_t frames = 0;
+  static crsf_t parser;
+  crsf_init(&parser, NULL);
+  crsf_ctx_set_baud_rate(&parser, reader.baud_rate);
+  const double target = bench_target_seconds();
+  while (passes == 0 || bench_seconds(ticks) < target)
+  {
+    frames = 0;
+    const uint32_t start = bench_ticks();
+    for (size_t i = 0; i < count; i++)
+    {
+      frames += crsf_ctx_parse(&parser, records[i].data, records[i].length);
+    }
+    ticks += bench_elapsed(start);
+    passes++;
+  }
+  const double seconds = bench_seconds(ticks) / passes;
+  printf("capture %s: %lu bytes in %lu records over %.3f s at %lu baud\n", path, (unsigned long)bytes,
+         (unsigned long)count, duration_us / 1e6, (unsigned long)reader.baud_rate);
+  printf("  parse    %8.2f %s/byte %10.0f frames/s  %lu frames\n", (double)ticks / passes / (bytes > 0 ? bytes : 1),
+         BENCH_TICK_UNIT, frames / seconds, (unsigned long)frames);
+  if (duration_us > 0)
+  {
+    printf("  load     %8.4f %%\n", 100.0 * seconds / (duration_us / 1e6));
+  }
+#if CRSF_STATS
+  bench_print_stats(&parser);
+#endif
+  free(records);
+  free(data);
+  return true;
+}
+#endif
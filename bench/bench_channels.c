@@ -0,0 +1,142 @@
+/**
+ * @file bench_channels.c
+ * @author Britannio Jarrett
+ * @brief Round trip and speed of the 11-bit channel pack and unpack variants.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+#include <string.h>
+
+// The unpack crsf.c used before crsf_unpack_channels(), kept as the baseline
+static void _unpack_channels_bitfield(const uint8_t *payload, uint16_t *channels)
+{
+  const crsf_payload_rc_channels_packed_t *packed = (const crsf_payload_rc_channels_packed_t *)payload;
+  channels[0] = packed->channel0;
+  channels[1] = packed->channel1;
+  channels[2] = packed->channel2;
+  channels[3] = packed->channel3;
+  channels[4] = packed->channel4;
+  channels[5] = packed->channel5;
+  channels[6] = packed->channel6;
+  channels[7] = packed->channel7;
+  channels[8] = packed->channel8;
+  channels[9] = packed->channel9;
+  channels[10] = packed->channel10;
+  channels[11] = packed->channel11;
+  channels[12] = packed->channel12;
+  channels[13] = packed->channel13;
+  channels[14] = packed->channel14;
+  channels[15] = packed->channel15;
+}
+
+typedef void (*unpack_fn_t)(const uint8_t *payload, uint16_t *channels);
+
+static const struct
+{
+  const char *name;
+  unpack_fn_t fn;
+} _unpack_variants[] = {
+    {"bitfield", _unpack_channels_bitfield},
+    {"scalar", crsf_unpack_channels_scalar},
+#if CRSF_CHANNELS_SIMD
+    {"simd", crsf_unpack_channels_simd},
+#endif
+};
+
+// Every value of every channel, next to random neighbours, must survive pack -> unpack
+bool bench_check_channels(void)
+{
+  uint32_t rng = 3;
+  uint16_t channels[CRSF_RC_CHANNELS];
+  uint16_t decoded[CRSF_RC_CHANNELS];
+  uint8_t payload[CRSF_RC_CHANNELS_PAYLOAD_SIZE];
+  for (int ch = 0; ch < CRSF_RC_CHANNELS; ch++)
+  {
+    for (uint16_t value = 0; value < 2048; value++)
+    {
+      for (int i = 0; i < CRSF_RC_CHANNELS; i++)
+      {
+        channels[i] = bench_random(&rng) & 0x7FF;
+      }
+      channels[ch] = value;
+      crsf_pack_channels(channels, payload);
+      for (size_t v = 0; v < sizeof(_unpack_variants) / sizeof(_unpack_variants[0]); v++)
+      {
+        _unpack_variants[v].fn(payload, decoded);
+        if (memcmp(channels, decoded, sizeof(decoded)) != 0)
+        {
+          printf("channels %s mismatch on channel %d value %u\n", _unpack_variants[v].name, ch, value);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void bench_channels(void)
+{
+  // A frame's worth of payloads at odd offsets, as they sit in the frame buffer
+  uint8_t frames[16][CRSF_RC_CHANNELS_PAYLOAD_SIZE + 3];
+  uint32_t rng = 5;
+  for (int f = 0; f < 16; f++)
+  {
+    for (int i = 0; i < CRSF_RC_CHANNELS_PAYLOAD_SIZE + 3; i++)
+    {
+      frames[f][i] = bench_random(&rng);
+    }
+  }
+
+  uint16_t channels[CRSF_RC_CHANNELS];
+  for (size_t v = 0; v < sizeof(_unpack_variants) / sizeof(_unpack_variants[0]); v++)
+  {
+    uint64_t ticks = 0;
+    uint32_t calls = 0;
+    volatile uint16_t sink = 0;
+    while (bench_seconds(ticks) < bench_target_seconds() / 4)
+    {
+      const uint32_t start = bench_ticks();
+      for (int i = 0; i < 1000; i++)
+      {
+        _unpack_variants[v].fn(&frames[i & 15][3], channels);
+        sink ^= channels[i & 15];
+      }
+      ticks += bench_elapsed(start);
+      calls += 1000;
+    }
+    (void)sink;
+    printf("unpack %-9s %8.2f %s/frame\n", _unpack_variants[v].name, (double)ticks / calls, BENCH_TICK_UNIT);
+  }
+
+  uint64_t ticks = 0;
+  uint32_t calls = 0;
+  uint8_t payload[CRSF_RC_CHANNELS_PAYLOAD_SIZE];
+  volatile uint8_t sink = 0;
+  for (int i = 0; i < CRSF_RC_CHANNELS; i++)
+  {
+    channels[i] = bench_random(&rng) & 0x7FF;
+  }
+  while (bench_seconds(ticks) < bench_target_seconds() / 4)
+  {
+    const uint32_t start = bench_ticks();
+    for (int i = 0; i < 1000; i++)
+    {
+      channels[i & 15]++;
+      crsf_pack_channels(channels, payload);
+      sink ^= payload[i % CRSF_RC_CHANNELS_PAYLOAD_SIZE];
+    }
+    ticks += bench_elapsed(start);
+    calls += 1000;
+  }
+  (void)sink;
+  printf("pack   %-9s %8.2f %s/frame\n", "scalar", (double)ticks / calls, BENCH_TICK_UNIT);
+}
@@ -0,0 +1,105 @@
+/**
+ * @file bench_clock.c
+ * @author Britannio Jarrett
+ * @brief Tick source for the benchmark harness.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+
+#include "bench.h"
+#include <stdlib.h>
+
+#if BENCH_CYCLES
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+#include "pico/time.h"
+
+// SysTick is a 24-bit down counter clocked by the processor clock
+
+void bench_init(void)
+{
+  systick_hw->rvr = 0x00FFFFFF;
+  systick_hw->cvr = 0;
+  // Enable, processor clock source, no interrupt
+  systick_hw->csr = 0x5;
+}
+
+uint32_t bench_ticks(void)
+{
+  return systick_hw->cvr;
+}
+
+uint32_t bench_elapsed(uint32_t start)
+{
+  return (start - systick_hw->cvr) & 0x00FFFFFF;
+}
+
+double bench_seconds(uint64_t ticks)
+{
+  return (double)ticks / clock_get_hz(clk_sys);
+}
+
+double bench_target_seconds(void)
+{
+  return 0.05;
+}
+
+uint64_t bench_time_us(void)
+{
+  return time_us_64();
+}
+#else
+#include <time.h>
+
+void bench_init(void)
+{
+}
+
+uint32_t bench_ticks(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec);
+}
+
+uint32_t bench_elapsed(uint32_t start)
+{
+  return bench_ticks() - start;
+}
+
+double bench_seconds(uint64_t ticks)
+{
+  return ticks * 1e-9;
+}
+
+double bench_target_seconds(void)
+{
+  return 0.25;
+}
+
+uint64_t bench_time_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+#endif
+
+static int _compare_ticks(const void *a, const void *b)
+{
+  const uint32_t x = *(const uint32_t *)a;
+  const uint32_t y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+void bench_sort_ticks(uint32_t *ticks, size_t count)
+{
+  qsort(ticks, count, sizeof(ticks[0]), _compare_ticks);
+}
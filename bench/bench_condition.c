@@ -0,0 +1,185 @@
+/**
+ * @file bench_condition.c
+ * @author Britannio Jarrett
+ * @brief Channel conditioning in fixed point against a floating-point reference, and its cost.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Calibration and expo in floating point, for the integer version to be compared against
+static double _condition_reference(const crsf_channel_config_t *config, uint16_t ticks)
+{
+  const double offset = (double)ticks - config->center;
+  double value = 0;
+  if (offset > config->deadband)
+  {
+    value = (offset - config->deadband) / (config->max - config->center - config->deadband);
+  }
+  else if (offset < -config->deadband)
+  {
+    value = (offset + config->deadband) / (config->center - config->min - config->deadband);
+  }
+  value = value > 1 ? 1 : value < -1 ? -1 : value;
+  const double e = config->expo / 100.0;
+  return ((1 - e) * value + e * value * value * value) * CRSF_Q15_ONE;
+}
+
+static bool _check_condition(int32_t *max_error)
+{
+  static crsf_conditioner_t conditioner;
+  uint16_t ticks[CRSF_RC_CHANNELS];
+  int16_t out[CRSF_RC_CHANNELS];
+
+  // Standard range onto both output scales, clamped past the endpoints
+  static const struct
+  {
+    uint16_t ticks;
+    int16_t q15;
+    int16_t us;
+  } points[] = {{0, -CRSF_Q15_ONE, 1000}, {172, -CRSF_Q15_ONE, 1000}, {992, 0, 1500}, {1811, CRSF_Q15_ONE, 2000}, {2047, CRSF_Q15_ONE, 2000}};
+  for (size_t i = 0; i < sizeof(points) / sizeof(points[0]); i++)
+  {
+    for (int c = 0; c < CRSF_RC_CHANNELS; c++)
+    {
+      ticks[c] = points[i].ticks;
+    }
+    crsf_conditioner_init(&conditioner, CRSF_CONDITION_Q15);
+    crsf_condition_apply(&conditioner, ticks, out);
+    const int16_t q15 = out[0];
+    crsf_conditioner_init(&conditioner, CRSF_CONDITION_US);
+    crsf_condition_apply(&conditioner, ticks, out);
+    if (q15 != points[i].q15 || out[0] != points[i].us || CRSF_TICKS_TO_US(points[i].ticks) != (uint32_t)(TICKS_TO_US(points[i].ticks) + 0.5f))
+    {
+      return false;
+    }
+  }
+
+  // Every tick value through an asymmetric calibration with deadband and expo, against the float reference
+  crsf_conditioner_init(&conditioner, CRSF_CONDITION_Q15);
+  crsf_channel_config_t config = {.min = 200, .center = 1000, .max = 1700, .deadband = 12, .expo = 40};
+  if (!crsf_conditioner_configure(&conditioner, 0, &config))
+  {
+    return false;
+  }
+  *max_error = 0;
+  int16_t previous = -CRSF_Q15_ONE;
+  for (uint16_t t = 0; t < 2048; t++)
+  {
+    ticks[0] = t;
+    crsf_condition_apply(&conditioner, ticks, out);
+    const double reference = _condition_reference(&config, t);
+    const int32_t error = abs(out[0] - (int32_t)(reference + (reference < 0 ? -0.5 : 0.5)));
+    *max_error = error > *max_error ? error : *max_error;
+    if (out[0] < previous || (t >= 988 && t <= 1012 && out[0] != 0))
+    {
+      return false;
+    }
+    previous = out[0];
+  }
+
+  // A 10 Hz low-pass at 500 Hz reaches 1 - 1/e of a step after about one time constant (8 frames)
+  config = (crsf_channel_config_t){.min = 172, .center = 992, .max = 1811, .lpf_alpha = crsf_condition_lpf_alpha(10, 500)};
+  config.reversed = true;
+  crsf_conditioner_configure(&conditioner, 0, &config);
+  crsf_conditioner_reset(&conditioner);
+  ticks[0] = 992;
+  crsf_condition_apply(&conditioner, ticks, out);
+  ticks[0] = 172;
+  for (int i = 0; i < 8; i++)
+  {
+    crsf_condition_apply(&conditioner, ticks, out);
+  }
+  if (out[0] < 18000 || out[0] > 23000)
+  {
+    return false;
+  }
+  for (int i = 0; i < 2000; i++)
+  {
+    crsf_condition_apply(&conditioner, ticks, out);
+  }
+  return out[0] >= CRSF_Q15_ONE - 4 && crsf_conditioner_configure(&conditioner, 0, &(crsf_channel_config_t){.min = 992, .center = 992, .max = 1811}) == false;
+}
+
+static double _bench_condition_run(crsf_conditioner_t *conditioner, uint16_t frames[16][CRSF_RC_CHANNELS])
+{
+  int16_t out[CRSF_RC_CHANNELS];
+  uint64_t ticks = 0;
+  uint32_t calls = 0;
+  volatile int16_t sink = 0;
+  while (bench_seconds(ticks) < bench_target_seconds() / 4)
+  {
+    const uint32_t start = bench_ticks();
+    for (int i = 0; i < 1000; i++)
+    {
+      crsf_condition_apply(conditioner, frames[i & 15], out);
+      sink ^= out[i & 15];
+    }
+    ticks += bench_elapsed(start);
+    calls += 1000;
+  }
+  (void)sink;
+  return (double)ticks / calls;
+}
+
+bool bench_check_condition(void)
+{
+  int32_t max_error = 0;
+  const bool ok = _check_condition(&max_error);
+  printf("condition  max error %ld Q15 steps against floating point\n", (long)max_error);
+  return ok;
+}
+
+void bench_condition(void)
+{
+  static uint16_t frames[16][CRSF_RC_CHANNELS];
+  uint32_t rng = 9;
+  for (int f = 0; f < 16; f++)
+  {
+    for (int c = 0; c < CRSF_RC_CHANNELS; c++)
+    {
+      frames[f][c] = CRSF_CHANNEL_MIN + bench_random(&rng) % (CRSF_CHANNEL_MAX - CRSF_CHANNEL_MIN + 1);
+    }
+  }
+  static crsf_conditioner_t conditioner;
+  crsf_conditioner_init(&conditioner, CRSF_CONDITION_US);
+  const double linear = _bench_condition_run(&conditioner, frames);
+  crsf_channel_config_t config = {.min = 180, .center = 995, .max = 1800, .deadband = 8, .expo = 30,
+                                  .lpf_alpha = crsf_condition_lpf_alpha(20, 500)};
+  for (uint8_t c = 0; c < CRSF_RC_CHANNELS; c++)
+  {
+    crsf_conditioner_configure(&conditioner, c, &config);
+  }
+  const double all = _bench_condition_run(&conditioner, frames);
+
+  // What converting each channel with the float macro costs
+  uint64_t ticks = 0;
+  uint32_t calls = 0;
+  volatile int32_t sink = 0;
+  while (bench_seconds(ticks) < bench_target_seconds() / 4)
+  {
+    const uint32_t start = bench_ticks();
+    for (int i = 0; i < 1000; i++)
+    {
+      const uint16_t *channels = frames[i & 15];
+      for (int c = 0; c < CRSF_RC_CHANNELS; c++)
+      {
+        sink += (int32_t)TICKS_TO_US(channels[c]);
+      }
+    }
+    ticks += bench_elapsed(start);
+    calls += 1000;
+  }
+  (void)sink;
+  printf("condition  %8.2f %s/frame calibrated, %.2f with deadband, expo and low-pass, %.2f for float TICKS_TO_US\n",
+         linear, BENCH_TICK_UNIT, all, (double)ticks / calls);
+}
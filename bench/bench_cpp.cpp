@@ -0,0 +1,321 @@
+/**
+ * @file bench_cpp.cpp
+ * @author Britannio Jarrett
+ * @brief Checks and timings of the C++ layer in crsf.hpp against the C path.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * crsf::decode<>() and crsf::encode<>() are checked against the C codecs on
+ * random payloads and crsf::parser against crsf_ctx_parse() on a noisy stream,
+ * then both paths are timed: per decode, through crsf_frame_codecs versus the
+ * descriptors, and per byte of stream. The code size of the two receive paths
+ * is compared by the crsf_size report (frames_c and frames_cpp).
+ */
+
+extern "C"
+{
+#include "bench.h"
+}
+#include "crsf.hpp"
+#include <stdio.h>
+#include <string.h>
+
+#define CODEC_CHECKS 2000
+// Payloads cycled through by the decode timings
+#define DECODE_PAYLOADS 64
+// The parsers are compared on the RC and link statistics frames the C side sees through its callbacks
+#define CPP_PARSE (CRSF_CALLBACKS && CRSF_FRAME_RC_CHANNELS_PACKED && CRSF_FRAME_LINK_STATISTICS)
+
+#if CPP_PARSE
+static crsf_t _parser;
+#endif
+
+// Makes the optimizer assume all of `*p` is read, so no part of a decode can be dropped
+static inline void _keep(const void *p)
+{
+  __asm__ volatile("" : : "g"(p) : "memory");
+}
+
+// Every type with a descriptor must decode and encode exactly as its C codec does
+static bool _check_codecs(void)
+{
+  uint32_t rng = 25;
+  bool ok = true;
+  for (unsigned type = 0; type < CRSF_FRAME_CODECS; type++)
+  {
+    crsf::visit(type, [&](auto descriptor) {
+      using descriptor_t = decltype(descriptor);
+      using payload_type = typename descriptor_t::payload_type;
+      const crsf_frame_codec_t &codec = crsf_frame_codecs[descriptor_t::type];
+      for (int i = 0; i < CODEC_CHECKS && ok; i++)
+      {
+        uint8_t wire[CRSF_MAX_PAYLOAD_SIZE];
+        for (size_t j = 0; j < sizeof(wire); j++)
+        {
+          wire[j] = bench_random(&rng);
+        }
+        // Short payloads included, which both must reject
+        const uint8_t length = bench_random(&rng) % (CRSF_MAX_PAYLOAD_SIZE + 1);
+        payload_type from_c;
+        payload_type from_cpp;
+        memset(&from_c, 0, sizeof(from_c));
+        memset(&from_cpp, 0, sizeof(from_cpp));
+        const bool decoded = codec.decode(wire, length, &from_c);
+        if (crsf::decode<descriptor_t::type>(wire, length, from_cpp) != decoded ||
+            memcmp(&from_c, &from_cpp, sizeof(from_c)) != 0)
+        {
+          printf("c++ decode of type 0x%02X differs at length %u\n", descriptor_t::type, length);
+          ok = false;
+          break;
+        }
+        if (!decoded)
+        {
+          continue;
+        }
+        uint8_t encoded_c[CRSF_MAX_PAYLOAD_SIZE];
+        uint8_t encoded_cpp[CRSF_MAX_PAYLOAD_SIZE];
+        const uint8_t encoded_length = codec.encode(&from_c, encoded_c);
+        if (crsf::encode<descriptor_t::type>(from_cpp, encoded_cpp) != encoded_length ||
+            memcmp(encoded_c, encoded_cpp, encoded_length) != 0)
+        {
+          printf("c++ encode of type 0x%02X differs\n", descriptor_t::type);
+          ok = false;
+        }
+      }
+      return true;
+    });
+  }
+  return ok;
+}
+
+#if CPP_PARSE
+// The work both receive paths do per frame: read the channels and the uplink RSSI
+typedef struct
+{
+  uint32_t rc_frames;
+  uint32_t link_frames;
+  uint32_t sum;
+} frame_totals_t;
+
+static frame_totals_t _c_totals;
+
+static void _on_rc_channels(crsf_t *crsf, const uint16_t channels[16])
+{
+  (void)crsf;
+  _c_totals.rc_frames++;
+  _c_totals.sum += channels[0] + channels[15];
+}
+
+static void _on_frame(crsf_t *crsf, frame_type_t type, const crsf_frame_payload_t *payload)
+{
+  (void)crsf;
+  if (type == CRSF_FRAMETYPE_LINK_STATISTICS)
+  {
+    _c_totals.link_frames++;
+    _c_totals.sum += payload->link_statistics.uplink_rssi_ant_1;
+  }
+}
+
+struct totals_handler
+{
+  frame_totals_t totals = {};
+
+  void operator()(const crsf_payload_rc_channels_packed_t &rc)
+  {
+    uint16_t channels[CRSF_RC_CHANNELS];
+    crsf::unpack_channels(rc, channels);
+    totals.rc_frames++;
+    totals.sum += channels[0] + channels[15];
+  }
+
+  void operator()(const crsf_payload_link_statistics_t &link)
+  {
+    totals.link_frames++;
+    totals.sum += link.uplink_rssi_ant_1;
+  }
+};
+
+typedef struct
+{
+  uint64_t ticks;
+  uint32_t passes;
+  size_t frames;
+} parse_result_t;
+
+static parse_result_t _parse_c(const bench_stream_t *stream)
+{
+  parse_result_t result = {0, 0, 0};
+  crsf_init(&_parser, NULL);
+  crsf_ctx_set_on_rc_channels(&_parser, _on_rc_channels);
+  crsf_ctx_set_on_frame(&_parser, _on_frame);
+  const double target = bench_target_seconds();
+  while (result.passes == 0 || bench_seconds(result.ticks) < target)
+  {
+    _c_totals = frame_totals_t{};
+    size_t frames = 0;
+    const uint32_t start = bench_ticks();
+    for (size_t offset = 0; offset < stream->len; offset += BENCH_PARSE_CHUNK)
+    {
+      const size_t len = stream->len - offset < BENCH_PARSE_CHUNK ? stream->len - offset : BENCH_PARSE_CHUNK;
+      frames += crsf_ctx_parse(&_parser, stream->data + offset, len);
+    }
+    result.ticks += bench_elapsed(start);
+    result.frames = frames;
+    result.passes++;
+  }
+  return result;
+}
+
+static parse_result_t _parse_cpp(const bench_stream_t *stream, frame_totals_t *totals)
+{
+  parse_result_t result = {0, 0, 0};
+  const double target = bench_target_seconds();
+  while (result.passes == 0 || bench_seconds(result.ticks) < target)
+  {
+    crsf::parser<totals_handler> parser{totals_handler{}};
+    size_t frames = 0;
+    const uint32_t start = bench_ticks();
+    for (size_t offset = 0; offset < stream->len; offset += BENCH_PARSE_CHUNK)
+    {
+      const size_t len = stream->len - offset < BENCH_PARSE_CHUNK ? stream->len - offset : BENCH_PARSE_CHUNK;
+      frames += parser.parse(stream->data + offset, len);
+    }
+    result.ticks += bench_elapsed(start);
+    result.frames = frames;
+    result.passes++;
+    *totals = parser.handler().totals;
+  }
+  return result;
+}
+#endif
+
+// Ticks per decode of `Type`, through crsf_frame_codecs as crsf_ctx_parse() does and through its descriptor
+template <frame_type_t Type>
+static void _bench_decode(const char *label)
+{
+  using payload_type = crsf::payload_t<Type>;
+  uint8_t payloads[DECODE_PAYLOADS][CRSF_MAX_PAYLOAD_SIZE];
+  uint32_t rng = 3;
+  for (int i = 0; i < DECODE_PAYLOADS; i++)
+  {
+    for (int j = 0; j < CRSF_MAX_PAYLOAD_SIZE; j++)
+    {
+      payloads[i][j] = bench_random(&rng);
+    }
+  }
+  const uint8_t length = crsf::frame<Type>::payload_size;
+  const double target = bench_target_seconds() / 4;
+
+  uint64_t c_ticks = 0;
+  uint64_t c_decodes = 0;
+  while (c_decodes == 0 || bench_seconds(c_ticks) < target)
+  {
+    // Looked up per frame as in _handle_frame()
+    volatile uint8_t type = Type;
+    const uint32_t start = bench_ticks();
+    for (int i = 0; i < DECODE_PAYLOADS; i++)
+    {
+      crsf_frame_payload_t payload;
+      crsf_frame_codecs[type].decode(payloads[i], length, &payload);
+      _keep(&payload);
+    }
+    c_ticks += bench_elapsed(start);
+    c_decodes += DECODE_PAYLOADS;
+  }
+
+  uint64_t cpp_ticks = 0;
+  uint64_t cpp_decodes = 0;
+  while (cpp_decodes == 0 || bench_seconds(cpp_ticks) < target)
+  {
+    const uint32_t start = bench_ticks();
+    for (int i = 0; i < DECODE_PAYLOADS; i++)
+    {
+      payload_type payload;
+      crsf::decode<Type>(payloads[i], length, payload);
+      _keep(&payload);
+    }
+    cpp_ticks += bench_elapsed(start);
+    cpp_decodes += DECODE_PAYLOADS;
+  }
+  printf("  decode   %-18s c %7.2f  c++ %7.2f %s\n", label, (double)c_ticks / c_decodes,
+         (double)cpp_ticks / cpp_decodes, BENCH_TICK_UNIT);
+}
+
+#if CPP_PARSE
+// A noisy stream, so the resync after corruption is compared as well
+static void _noisy_stream(bench_stream_t *stream)
+{
+  bench_stream_config_t config;
+  bench_stream_default_config(&config);
+  config.rc_rate_hz = 500;
+  config.duration_ms = 1000;
+  config.link_stats_rate_hz = 10;
+  config.bit_error_rate = 1e-4;
+  config.byte_drop_rate = 5e-4;
+  config.garbage_rate = 0.05;
+  bench_stream_generate(stream, &config);
+}
+#endif
+
+// The descriptors must match the C codecs, and the same frames must reach both handlers
+bool bench_check_cpp(void)
+{
+  bool ok = _check_codecs();
+  if (!ok)
+  {
+    printf("c++        a descriptor disagrees with its C codec\n");
+  }
+#if CPP_PARSE
+  bench_stream_t stream = {bench_stream_data, sizeof(bench_stream_data), 0, 0, 0};
+  _noisy_stream(&stream);
+  const parse_result_t c = _parse_c(&stream);
+  frame_totals_t cpp_totals;
+  const parse_result_t cpp = _parse_cpp(&stream, &cpp_totals);
+  if (c.frames != cpp.frames || _c_totals.rc_frames != cpp_totals.rc_frames ||
+      _c_totals.link_frames != cpp_totals.link_frames || _c_totals.sum != cpp_totals.sum)
+  {
+    printf("c++        parser: c %lu frames, %lu rc, %lu link statistics; c++ %lu, %lu, %lu\n", (unsigned long)c.frames,
+           (unsigned long)_c_totals.rc_frames, (unsigned long)_c_totals.link_frames, (unsigned long)cpp.frames,
+           (unsigned long)cpp_totals.rc_frames, (unsigned long)cpp_totals.link_frames);
+    ok = false;
+  }
+#endif
+  return ok;
+}
+
+void bench_cpp(void)
+{
+  printf("c++ layer (crsf.hpp)\n");
+#if CPP_PARSE
+  bench_stream_t stream = {bench_stream_data, sizeof(bench_stream_data), 0, 0, 0};
+  _noisy_stream(&stream);
+  const parse_result_t c = _parse_c(&stream);
+  frame_totals_t cpp_totals;
+  const parse_result_t cpp = _parse_cpp(&stream, &cpp_totals);
+  // crsf_ctx_parse() also runs the failsafe timer and publishes the snapshot per frame
+  printf("  parse    c %7.2f  c++ %7.2f %s/byte  %lu frames\n", (double)c.ticks / c.passes / stream.len,
+         (double)cpp.ticks / cpp.passes / stream.len, BENCH_TICK_UNIT, (unsigned long)cpp.frames);
+#endif
+
+#if CRSF_FRAME_RC_CHANNELS_PACKED
+  _bench_decode<CRSF_FRAMETYPE_RC_CHANNELS_PACKED>("rc_channels_packed");
+#endif
+#if CRSF_FRAME_LINK_STATISTICS
+  _bench_decode<CRSF_FRAMETYPE_LINK_STATISTICS>("link_statistics");
+#endif
+#if CRSF_FRAME_BATTERY_SENSOR
+  _bench_decode<CRSF_FRAMETYPE_BATTERY_SENSOR>("battery_sensor");
+#endif
+#if CRSF_FRAME_GPS
+  _bench_decode<CRSF_FRAMETYPE_GPS>("gps");
+#endif
+#if CRSF_FRAME_RADIO_ID
+  _bench_decode<CRSF_FRAMETYPE_RADIO_ID>("radio_id");
+#endif
+}
@@ -0,0 +1,123 @@
+/**
+ * @file bench_crc.c
+ * @author Britannio Jarrett
+ * @brief CRC-8/DVB-S2 variants against a bit-at-a-time reference, and their throughput.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+
+typedef uint8_t (*crc_fn_t)(uint8_t crc, const uint8_t *ptr, size_t len);
+
+static const struct
+{
+  const char *name;
+  crc_fn_t fn;
+} _crc_variants[] = {
+    {"nibble", crsf_crc8_nibble},
+    {"table256", crsf_crc8_bytewise},
+    {"slice4", crsf_crc8_slice4},
+    {"slice8", crsf_crc8_slice8},
+};
+
+// Reference bit-at-a-time CRC-8/DVB-S2
+static uint8_t _crc8_reference(const uint8_t *ptr, size_t len)
+{
+  uint8_t crc = 0;
+  while (len--)
+  {
+    crc ^= *ptr++;
+    for (int bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 0x80) ? (uint8_t)(crc << 1) ^ 0xD5 : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+// Every variant must match the reference for every length, alignment and split point
+bool bench_check_crc(void)
+{
+  uint8_t buf[300];
+  uint32_t rng = 7;
+  for (size_t i = 0; i < sizeof(buf); i++)
+  {
+    buf[i] = bench_random(&rng);
+  }
+  if (_crc8_reference((const uint8_t *)"123456789", 9) != 0xBC)
+  {
+    return false;
+  }
+  for (size_t v = 0; v < sizeof(_crc_variants) / sizeof(_crc_variants[0]); v++)
+  {
+    const crc_fn_t fn = _crc_variants[v].fn;
+    for (size_t offset = 0; offset < 8; offset++)
+    {
+      for (size_t len = 0; len + offset <= 256; len++)
+      {
+        const uint8_t expected = _crc8_reference(buf + offset, len);
+        const size_t split = len / 3;
+        if (fn(0, buf + offset, len) != expected ||
+            fn(fn(0, buf + offset, split), buf + offset + split, len - split) != expected)
+        {
+          printf("crc8 %s mismatch at offset %lu length %lu\n", _crc_variants[v].name,
+                 (unsigned long)offset, (unsigned long)len);
+          return false;
+        }
+      }
+    }
+  }
+  // The incremental single-byte update used by the parser
+  uint8_t crc = 0;
+  for (size_t i = 0; i < 62; i++)
+  {
+    crc = crsf_crc8_update(crc, buf[i]);
+  }
+  return crc == _crc8_reference(buf, 62) && crsf_crc8(buf, 62) == crc;
+}
+
+void bench_crc(void)
+{
+  // A full CRSF frame body and a bulk replay-sized buffer
+  static const size_t lengths[] = {23, 62, 4096};
+  static uint8_t buf[4096];
+  uint32_t rng = 1;
+  for (size_t i = 0; i < sizeof(buf); i++)
+  {
+    buf[i] = bench_random(&rng);
+  }
+
+  for (size_t v = 0; v < sizeof(_crc_variants) / sizeof(_crc_variants[0]); v++)
+  {
+    printf("crc8 %-9s", _crc_variants[v].name);
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+    {
+      const size_t len = lengths[l];
+      const int reps = len > 1000 ? 10 : 1000;
+      uint64_t ticks = 0;
+      uint64_t bytes = 0;
+      volatile uint8_t sink = 0;
+      while (bench_seconds(ticks) < bench_target_seconds() / 4)
+      {
+        const uint32_t start = bench_ticks();
+        for (int i = 0; i < reps; i++)
+        {
+          sink ^= _crc_variants[v].fn(0, buf, len);
+        }
+        ticks += bench_elapsed(start);
+        bytes += (uint64_t)reps * len;
+      }
+      (void)sink;
+      printf("  %8.2f %s/byte (%lu B)", (double)ticks / bytes, BENCH_TICK_UNIT, (unsigned long)len);
+    }
+    printf("\n");
+  }
+}
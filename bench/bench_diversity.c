@@ -0,0 +1,324 @@
+/**
+ * @file bench_diversity.c
+ * @author Britannio Jarrett
+ * @brief Receiver diversity merge: switchover and failsafe on scripted links, and its cost.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ */
+
+#include "bench.h"
+#include "crsf_diversity.h"
+#include <stdio.h>
+#include <string.h>
+
+#if BENCH_DIVERSITY
+// Two receivers in virtual time at 500 Hz. Each delivers one RC frame per
+// period while it is alive and a link statistics report every
+// DIVERSITY_STATS_EVERY frames, link B half way between link A's.
+#define DIVERSITY_INTERVAL_US 2000
+#define DIVERSITY_STATS_EVERY 10
+#define DIVERSITY_FRAMES 2000
+
+// Sets what each link reports at `frame`
+typedef void (*diversity_script_t)(uint32_t frame, uint32_t *rng, uint8_t link_quality[2], bool alive[2]);
+
+static int _diversity_forwarded_link;
+// When the forwarded link first changed, 0 if it never did
+static uint64_t _diversity_changed_us;
+static uint32_t _diversity_failsafe_on;
+static uint32_t _diversity_failsafe_off;
+static uint64_t _diversity_failsafe_on_us;
+
+static void _on_diversity_channels(crsf_diversity_t *diversity, uint8_t link, const uint16_t channels[16])
+{
+  (void)diversity;
+  (void)channels;
+  if (link != _diversity_forwarded_link && _diversity_changed_us == 0)
+  {
+    _diversity_changed_us = bench_now_us;
+  }
+  _diversity_forwarded_link = link;
+}
+
+static void _on_diversity_failsafe(crsf_diversity_t *diversity, const bool failsafe)
+{
+  (void)diversity;
+  if (failsafe)
+  {
+    _diversity_failsafe_on++;
+    _diversity_failsafe_on_us = bench_now_us;
+  }
+  else
+  {
+    _diversity_failsafe_off++;
+  }
+}
+
+static uint64_t _diversity_frame_us(uint32_t frame)
+{
+  return 1000 + (uint64_t)frame * DIVERSITY_INTERVAL_US;
+}
+
+static void _diversity_run(diversity_script_t script, crsf_diversity_stats_t *stats)
+{
+  static crsf_t links[2];
+  static crsf_diversity_t diversity;
+  static bench_link_t ports[2];
+  crsf_transport_t transports[2];
+  for (int i = 0; i < 2; i++)
+  {
+    bench_link_init(&ports[i]);
+    ports[i].chunk = BENCH_PARSE_CHUNK;
+    bench_link_transport(&transports[i], &ports[i]);
+    crsf_init(&links[i], &transports[i]);
+  }
+  crsf_diversity_init(&diversity, &links[0], &links[1]);
+  crsf_diversity_set_on_rc_channels(&diversity, _on_diversity_channels);
+  crsf_diversity_set_on_failsafe(&diversity, _on_diversity_failsafe);
+  _diversity_forwarded_link = 0;
+  _diversity_changed_us = 0;
+  _diversity_failsafe_on = 0;
+  _diversity_failsafe_off = 0;
+  _diversity_failsafe_on_us = 0;
+
+  uint32_t rng = 1;
+  for (uint32_t frame = 0; frame < DIVERSITY_FRAMES; frame++)
+  {
+    bench_now_us = _diversity_frame_us(frame);
+    uint8_t link_quality[2];
+    bool alive[2];
+    script(frame, &rng, link_quality, alive);
+    for (int i = 0; i < 2; i++)
+    {
+      uint8_t data[2 * CRSF_MAX_FRAME_SIZE];
+      size_t len = 0;
+      if (alive[i])
+      {
+        bench_rc_frame(data, 1000 + i);
+        len = CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4;
+        if ((frame + i * DIVERSITY_STATS_EVERY / 2) % DIVERSITY_STATS_EVERY == 0)
+        {
+          uint8_t payload[CRSF_MAX_FRAME_SIZE];
+          const crsf_payload_link_statistics_t link = {.uplink_rssi_ant_1 = 60,
+                                                       .uplink_package_success_rate = link_quality[i]};
+          bench_put_frame(data, &len, CRSF_FRAMETYPE_LINK_STATISTICS, payload,
+                            crsf_encode_link_statistics(&link, payload));
+        }
+      }
+      bench_link_push(&ports[i], data, len);
+    }
+    crsf_diversity_process_frames(&diversity);
+  }
+  crsf_diversity_get_stats(&diversity, stats);
+}
+
+// Link A fades one point per report from frame 400 while link B holds at 95
+#define DIVERSITY_FADE_START 400
+static void _script_fade(uint32_t frame, uint32_t *rng, uint8_t link_quality[2], bool alive[2])
+{
+  (void)rng;
+  const uint32_t faded = frame < DIVERSITY_FADE_START ? 0 : (frame - DIVERSITY_FADE_START) / DIVERSITY_STATS_EVERY;
+  link_quality[0] = faded < 25 ? 100 - faded : 75;
+  link_quality[1] = 95;
+  alive[0] = alive[1] = true;
+}
+
+// Link A's receiver goes silent at frame 600
+#define DIVERSITY_CUT_FRAME 600
+static void _script_cut(uint32_t frame, uint32_t *rng, uint8_t link_quality[2], bool alive[2])
+{
+  (void)rng;
+  link_quality[0] = link_quality[1] = 100;
+  alive[0] = frame < DIVERSITY_CUT_FRAME;
+  alive[1] = true;
+}
+
+// Both links report a noisy 85 - 100 independently, so the better one changes all the time
+static uint32_t _diversity_noise_leader_changes;
+static void _script_noise(uint32_t frame, uint32_t *rng, uint8_t link_quality[2], bool alive[2])
+{
+  static uint8_t reported[2];
+  static int leader;
+  for (int i = 0; i < 2; i++)
+  {
+    if ((frame + i * DIVERSITY_STATS_EVERY / 2) % DIVERSITY_STATS_EVERY == 0)
+    {
+      reported[i] = 85 + bench_random(rng) % 16;
+    }
+    link_quality[i] = reported[i];
+    alive[i] = true;
+  }
+  const int now = reported[1] > reported[0] ? 1 : reported[0] > reported[1] ? 0 : leader;
+  if (frame > 0 && now != leader)
+  {
+    _diversity_noise_leader_changes++;
+  }
+  leader = now;
+}
+
+// Link A drops below the failsafe threshold at frame 500, link B at 1000, and link A recovers at 1500
+static void _script_failsafe(uint32_t frame, uint32_t *rng, uint8_t link_quality[2], bool alive[2])
+{
+  (void)rng;
+  link_quality[0] = frame >= 500 && frame < 1500 ? 50 : 100;
+  link_quality[1] = frame >= 1000 ? 50 : 100;
+  alive[0] = alive[1] = true;
+}
+
+bool bench_check_diversity(void)
+{
+  bool ok = true;
+  crsf_diversity_stats_t stats;
+
+  _diversity_run(_script_fade, &stats);
+  // First report in which link B leads by the margin
+  const uint32_t better_frame = DIVERSITY_FADE_START + (100 - 95 + CRSF_DIVERSITY_LQ_MARGIN) * DIVERSITY_STATS_EVERY;
+  const double fade_ms = _diversity_changed_us > 0 ? (_diversity_changed_us - _diversity_frame_us(better_frame)) / 1000.0 : -1;
+  const bool fade_ok = stats.quality_switches == 1 && stats.loss_switches == 0 && _diversity_failsafe_on == 0 &&
+                       fade_ms >= 0;
+  printf("diversity  fade: switched %.0f ms after link B pulled ahead %s\n", fade_ms, fade_ok ? "ok" : "FAILED");
+  ok &= fade_ok;
+
+  _diversity_run(_script_cut, &stats);
+  const double cut_ms = _diversity_changed_us > 0 ? (_diversity_changed_us - _diversity_frame_us(DIVERSITY_CUT_FRAME)) / 1000.0 : -1;
+  const bool cut_ok = stats.loss_switches == 1 && stats.quality_switches == 0 && _diversity_failsafe_on == 0 &&
+                      cut_ms >= 0 && cut_ms <= (CRSF_DIVERSITY_STALE_FRAMES + 1) * DIVERSITY_INTERVAL_US / 1000.0;
+  printf("diversity  receiver cut: switched %.0f ms after its first missing frame %s\n", cut_ms,
+         cut_ok ? "ok" : "FAILED");
+  ok &= cut_ok;
+
+  _diversity_noise_leader_changes = 0;
+  _diversity_run(_script_noise, &stats);
+  const uint32_t switches = stats.quality_switches + stats.loss_switches;
+  const bool noise_ok = switches * 10 <= _diversity_noise_leader_changes && _diversity_failsafe_on == 0;
+  printf("diversity  noisy links: %lu switches where the better link changed %lu times %s\n", (unsigned long)switches,
+         (unsigned long)_diversity_noise_leader_changes, noise_ok ? "ok" : "FAILED");
+  ok &= noise_ok;
+
+  _diversity_run(_script_failsafe, &stats);
+  // Declared at link B's first report below the threshold, lifted again once link A recovers
+  const bool failsafe_ok = stats.loss_switches == 2 && _diversity_failsafe_on == 1 && _diversity_failsafe_off == 2 &&
+                           _diversity_failsafe_on_us >= _diversity_frame_us(1000) &&
+                           _diversity_failsafe_on_us <= _diversity_frame_us(1000 + DIVERSITY_STATS_EVERY);
+  printf("diversity  failsafe only with both links down %s\n", failsafe_ok ? "ok" : "FAILED");
+  ok &= failsafe_ok;
+  return ok;
+}
+
+// What the links' callbacks were called with, in order, so the merge can be timed on its own
+#define DIVERSITY_EVENTS 256
+typedef struct
+{
+  bool rc;
+  uint16_t channels[CRSF_RC_CHANNELS];
+  link_statistics_t link_statistics;
+} diversity_event_t;
+
+static diversity_event_t _diversity_events[DIVERSITY_EVENTS];
+static size_t _diversity_event_count;
+static size_t _diversity_rc_events;
+
+static void _record_channels(crsf_t *crsf, const uint16_t channels[16])
+{
+  (void)crsf;
+  if (_diversity_event_count < DIVERSITY_EVENTS)
+  {
+    diversity_event_t *event = &_diversity_events[_diversity_event_count++];
+    event->rc = true;
+    memcpy(event->channels, channels, sizeof(event->channels));
+    _diversity_rc_events++;
+  }
+}
+
+static void _record_link_statistics(crsf_t *crsf, const link_statistics_t link_stats)
+{
+  (void)crsf;
+  if (_diversity_event_count < DIVERSITY_EVENTS)
+  {
+    diversity_event_t *event = &_diversity_events[_diversity_event_count++];
+    event->rc = false;
+    event->link_statistics = link_stats;
+  }
+}
+
+static void _no_channels(crsf_t *crsf, const uint16_t channels[16])
+{
+  (void)crsf;
+  (void)channels;
+}
+
+static void _no_link_statistics(crsf_t *crsf, const link_statistics_t link_stats)
+{
+  (void)crsf;
+  (void)link_stats;
+}
+
+// Fastest pass of both links' callbacks over the recorded events
+static uint32_t _time_diversity_callbacks(crsf_t links[2])
+{
+  uint32_t best = UINT32_MAX;
+  uint64_t ticks = 0;
+  const double target = bench_target_seconds() / 4;
+  while (best == UINT32_MAX || bench_seconds(ticks) < target)
+  {
+    const uint32_t start = bench_ticks();
+    for (size_t e = 0; e < _diversity_event_count; e++)
+    {
+      const diversity_event_t *event = &_diversity_events[e];
+      for (int i = 0; i < 2; i++)
+      {
+        if (event->rc)
+        {
+          links[i].rc_channels_callback(&links[i], event->channels);
+        }
+        else
+        {
+          links[i].link_statistics_callback(&links[i], event->link_statistics);
+        }
+      }
+    }
+    const uint32_t elapsed = bench_elapsed(start);
+    ticks += elapsed;
+    best = elapsed < best ? elapsed : best;
+  }
+  return best;
+}
+
+void bench_diversity(void)
+{
+  static crsf_t links[2];
+  static crsf_diversity_t diversity;
+  bench_stream_config_t config;
+  bench_stream_default_config(&config);
+  config.rc_rate_hz = 500;
+  config.link_stats_rate_hz = 50;
+  config.duration_ms = 200;
+  bench_stream_t stream = {.data = bench_stream_data, .capacity = sizeof(bench_stream_data)};
+  bench_stream_generate(&stream, &config);
+
+  // Parsed once up front, leaving both links with the stream's RC timing and link statistics
+  _diversity_event_count = 0;
+  _diversity_rc_events = 0;
+  for (int i = 0; i < 2; i++)
+  {
+    crsf_init(&links[i], NULL);
+    crsf_ctx_set_on_rc_channels(&links[i], i == 0 ? _record_channels : _no_channels);
+    crsf_ctx_set_on_link_statistics(&links[i], i == 0 ? _record_link_statistics : _no_link_statistics);
+    crsf_ctx_parse(&links[i], stream.data, stream.len);
+  }
+
+  // The same calls with and without the merge behind them
+  const uint32_t plain = _time_diversity_callbacks(links);
+  crsf_diversity_init(&diversity, &links[0], &links[1]);
+  const uint32_t merged = _time_diversity_callbacks(links);
+  const double per_frame = 2.0 * _diversity_rc_events;
+  printf("diversity  merge %8.2f %s per RC frame received (callbacks %.2f, merged %.2f)\n",
+         ((double)merged - plain) / per_frame, BENCH_TICK_UNIT, plain / per_frame, merged / per_frame);
+}
+#endif
@@ -0,0 +1,231 @@
+/**
+ * @file bench_encoder.c
+ * @author Britannio Jarrett
+ * @brief Telemetry encoder cost, and RC change detection against every-frame delivery.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+#include <string.h>
+
+// Nothing to read, writes counted, and time that only moves when a suite says so
+static bench_link_t _link;
+
+#if BENCH_RC_CHANGES
+// 3 s at 500 Hz, which fits the RP2040's stream buffer
+#define CHANGE_FRAMES 1500
+#define CHANGE_FRAME_SIZE (CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4)
+#define CHANGE_INTERVAL_US 2000
+
+static uint16_t _change_truth[CHANGE_FRAMES][CRSF_RC_CHANNELS];
+static uint16_t _change_shadow[CRSF_RC_CHANNELS];
+static uint32_t _change_calls;
+static uint32_t _change_updates;
+static uint32_t _change_full;
+
+static void _on_changes_bench(crsf_t *crsf, const uint16_t channels[16], uint16_t dirty)
+{
+  (void)crsf;
+  _change_calls++;
+  _change_full += dirty == CRSF_ALL_CHANNELS;
+  for (int i = 0; i < CRSF_RC_CHANNELS; i++)
+  {
+    if (dirty & (1 << i))
+    {
+      _change_shadow[i] = channels[i];
+      _change_updates++;
+    }
+  }
+}
+
+static void _on_every_frame_bench(crsf_t *crsf, const uint16_t channels[16])
+{
+  (void)crsf;
+  memcpy(_change_shadow, channels, sizeof(_change_shadow));
+  _change_calls++;
+  _change_updates += CRSF_RC_CHANNELS;
+}
+
+// Sticks held still for stretches and then moved, with a tick of gimbal jitter
+// on a third of the frames, and aux switches flipped now and then
+static size_t _build_change_stream(uint8_t *data)
+{
+  uint32_t rng = 21;
+  uint16_t sticks[4] = {992, 992, 172, 992};
+  uint16_t channels[CRSF_RC_CHANNELS];
+  for (int i = 0; i < CRSF_RC_CHANNELS; i++)
+  {
+    channels[i] = i < 4 ? sticks[i] : 172;
+  }
+  for (uint32_t f = 0; f < CHANGE_FRAMES; f++)
+  {
+    // Moving for 100 ms out of every 500
+    if (f % 250 < 50)
+    {
+      for (int i = 0; i < 4; i++)
+      {
+        sticks[i] = sticks[i] + 8 > 1811 ? 172 : sticks[i] + 8;
+      }
+    }
+    for (int i = 0; i < 4; i++)
+    {
+      channels[i] = sticks[i] + (bench_random(&rng) % 3 == 0 ? 1 : 0);
+    }
+    if (f % 400 == 399)
+    {
+      channels[4] = channels[4] == 172 ? 1811 : 172;
+    }
+    memcpy(_change_truth[f], channels, sizeof(channels));
+    uint8_t *frame = data + f * CHANGE_FRAME_SIZE;
+    frame[0] = 0xC8;
+    frame[1] = CRSF_RC_CHANNELS_PAYLOAD_SIZE + 2;
+    frame[2] = CRSF_FRAMETYPE_RC_CHANNELS_PACKED;
+    crsf_pack_channels(channels, frame + 3);
+    frame[CHANGE_FRAME_SIZE - 1] = crsf_crc8(frame + 2, CRSF_RC_CHANNELS_PAYLOAD_SIZE + 1);
+  }
+  return CHANGE_FRAMES * CHANGE_FRAME_SIZE;
+}
+
+// Replays the stream a frame at a time, checking that every delivered channel
+// stays within its threshold of the truth
+static bool _run_changes(crsf_t *crsf, const uint8_t *data, uint16_t threshold, bool every_frame)
+{
+  static crsf_transport_t transport;
+  bench_link_init(&_link);
+  bench_link_transport(&transport, &_link);
+  crsf_init(crsf, &transport);
+  if (every_frame)
+  {
+    crsf_ctx_set_on_rc_channels(crsf, _on_every_frame_bench);
+  }
+  else
+  {
+    crsf_ctx_set_on_rc_channels_changed(crsf, _on_changes_bench);
+  }
+  for (uint8_t i = 0; i < CRSF_RC_CHANNELS; i++)
+  {
+    crsf_ctx_set_channel_threshold(crsf, i, threshold);
+  }
+  _change_calls = 0;
+  _change_updates = 0;
+  _change_full = 0;
+  bool ok = true;
+  for (uint32_t f = 0; f < CHANGE_FRAMES; f++)
+  {
+    bench_now_us = (uint64_t)(f + 1) * CHANGE_INTERVAL_US;
+    crsf_ctx_parse(crsf, data + f * CHANGE_FRAME_SIZE, CHANGE_FRAME_SIZE);
+    for (int i = 0; i < CRSF_RC_CHANNELS; i++)
+    {
+      const int32_t error = (int32_t)_change_shadow[i] - _change_truth[f][i];
+      ok = ok && (uint32_t)(error < 0 ? -error : error) <= threshold;
+    }
+  }
+  return ok;
+}
+
+static double _time_changes(crsf_t *crsf, const uint8_t *data, size_t len)
+{
+  uint64_t ticks = 0;
+  uint32_t frames = 0;
+  while (bench_seconds(ticks) < bench_target_seconds() / 4)
+  {
+    const uint32_t start = bench_ticks();
+    for (size_t offset = 0; offset < len; offset += BENCH_PARSE_CHUNK)
+    {
+      crsf_ctx_parse(crsf, data + offset, len - offset < BENCH_PARSE_CHUNK ? len - offset : BENCH_PARSE_CHUNK);
+    }
+    ticks += bench_elapsed(start);
+    frames += CHANGE_FRAMES;
+  }
+  return (double)ticks / frames;
+}
+
+// Every delivered channel must stay within its threshold of the sent value,
+// whether delivered on every frame or only on change
+bool bench_check_rc_changes(void)
+{
+  static crsf_t crsf;
+  _build_change_stream(bench_stream_data);
+  bool ok = _run_changes(&crsf, bench_stream_data, 0, true);
+  static const uint16_t thresholds[] = {0, 2};
+  for (size_t t = 0; t < sizeof(thresholds) / sizeof(thresholds[0]); t++)
+  {
+    if (!_run_changes(&crsf, bench_stream_data, thresholds[t], false))
+    {
+      printf("changes    threshold %u delivered a value beyond it\n", thresholds[t]);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+void bench_rc_changes(void)
+{
+  static crsf_t crsf;
+  const size_t len = _build_change_stream(bench_stream_data);
+  _run_changes(&crsf, bench_stream_data, 0, true);
+  const uint32_t every_calls = _change_calls;
+  const uint32_t every_updates = _change_updates;
+  const double every_ticks = _time_changes(&crsf, bench_stream_data, len);
+  printf("changes    every frame      %5lu calls, %6lu channel updates, %6.1f %s/frame\n", (unsigned long)every_calls,
+         (unsigned long)every_updates, every_ticks, BENCH_TICK_UNIT);
+  static const uint16_t thresholds[] = {0, 2};
+  for (size_t t = 0; t < sizeof(thresholds) / sizeof(thresholds[0]); t++)
+  {
+    _run_changes(&crsf, bench_stream_data, thresholds[t], false);
+    const uint32_t calls = _change_calls;
+    const uint32_t updates = _change_updates;
+    const uint32_t full = _change_full;
+    const double ticks = _time_changes(&crsf, bench_stream_data, len);
+    printf("changes    threshold %u      %5lu calls, %6lu channel updates, %6.1f %s/frame, %lu keep-alives\n", thresholds[t],
+           (unsigned long)calls, (unsigned long)updates, ticks, BENCH_TICK_UNIT, (unsigned long)full);
+  }
+}
+#endif
+
+// Sends battery frames at 1 kHz of virtual time, setting new values before each
+// send (`changing`) or the same values every time
+static void _bench_encoder_run(crsf_t *crsf, const char *label, bool changing)
+{
+  uint64_t ticks = 0;
+  uint32_t frames = 0;
+  _link.written = 0;
+  while (bench_seconds(ticks) < bench_target_seconds())
+  {
+    const uint32_t start = bench_ticks();
+    for (int i = 0; i < 1000; i++)
+    {
+      bench_now_us += 1000;
+      crsf_ctx_telem_set_battery_data(crsf, 168 + (changing ? i & 7 : 0), 50, changing ? 1200 + i : 1200, 80);
+      crsf_ctx_send_telem(crsf);
+    }
+    ticks += bench_elapsed(start);
+    frames += 1000;
+  }
+  const double seconds = bench_seconds(ticks);
+  printf("encoder %-9s %8.2f %s/frame %10.0f bytes/s\n",
+         label, (double)ticks / frames, BENCH_TICK_UNIT, _link.written / seconds);
+}
+
+void bench_encoder(void)
+{
+  static crsf_transport_t transport;
+  static crsf_t crsf;
+  bench_link_init(&_link);
+  bench_link_transport(&transport, &_link);
+  crsf_init(&crsf, &transport);
+  crsf_ctx_telem_set_schedule(&crsf, CRSF_BATTERY_INDEX, 1000, 1);
+  bench_now_us = 0;
+  // Changed fields are patched into the frame and the CRC recomputed; an
+  // unchanged frame is handed to the transport as it is
+  _bench_encoder_run(&crsf, "changed", true);
+  _bench_encoder_run(&crsf, "unchanged", false);
+}
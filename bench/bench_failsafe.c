@@ -0,0 +1,134 @@
+/**
+ * @file bench_failsafe.c
+ * @author Britannio Jarrett
+ * @brief How late the failsafe alarm fires after the RC stream stops, and how it recovers.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Host only: the alarm runs on a thread against the wall clock.
+ */
+
+#include "bench.h"
+
+#if !BENCH_CYCLES
+#include <sched.h>
+#include <stdio.h>
+#include <time.h>
+
+#define FAILSAFE_TIMEOUT_US 20000
+#define FAILSAFE_TRIALS 30
+
+static bool _timeout_active(crsf_t *crsf)
+{
+  return (__atomic_load_n(&crsf->failsafe_flags, __ATOMIC_ACQUIRE) & CRSF_FAILSAFE_TIMEOUT) != 0;
+}
+
+typedef struct
+{
+  uint64_t worst;
+  uint64_t total;
+  uint32_t measured;
+  uint32_t early;
+  uint32_t bad_recovery;
+} failsafe_result_t;
+
+// Stops a 250 Hz RC stream and measures how long after the timeout the failsafe is seen,
+// and counts the frames it takes to clear. Returns false if no alarm is available.
+static bool _failsafe_trials(failsafe_result_t *result)
+{
+  static crsf_t crsf;
+  crsf_init(&crsf, NULL);
+  if (!crsf_ctx_set_failsafe_timeout_us(&crsf, FAILSAFE_TIMEOUT_US))
+  {
+    return false;
+  }
+  uint8_t frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4];
+  bench_rc_frame(frame, 992);
+  const struct timespec interval = {.tv_nsec = 4000000};
+
+  *result = (failsafe_result_t){0, 0, 0, 0, 0};
+  bool overslept = true;
+  for (int trial = 0; trial < FAILSAFE_TRIALS; trial++)
+  {
+    // Recover from the previous trial's timeout, counting the frames it takes
+    uint32_t recovery = 0;
+    while (_timeout_active(&crsf) && recovery <= CRSF_FAILSAFE_RECOVERY_FRAMES)
+    {
+      crsf_ctx_parse(&crsf, frame, sizeof(frame));
+      recovery++;
+    }
+    if (!overslept && recovery != CRSF_FAILSAFE_RECOVERY_FRAMES)
+    {
+      result->bad_recovery++;
+    }
+    uint64_t last_frame_us = 0;
+    overslept = false;
+    for (int i = 0; i < 5; i++)
+    {
+      nanosleep(&interval, NULL);
+      // A host that deschedules the thread for longer than the timeout trips it for real
+      overslept |= _timeout_active(&crsf);
+      crsf_ctx_parse(&crsf, frame, sizeof(frame));
+      last_frame_us = bench_time_us();
+    }
+    if (overslept)
+    {
+      continue;
+    }
+    while (!_timeout_active(&crsf))
+    {
+      sched_yield();
+    }
+    const uint64_t elapsed = bench_time_us() - last_frame_us;
+    if (elapsed < FAILSAFE_TIMEOUT_US)
+    {
+      result->early++;
+      continue;
+    }
+    const uint64_t late = elapsed - FAILSAFE_TIMEOUT_US;
+    result->total += late;
+    result->worst = late > result->worst ? late : result->worst;
+    result->measured++;
+  }
+  crsf_ctx_set_failsafe_timeout_us(&crsf, 0);
+  return true;
+}
+
+// The failsafe never fires before its timeout and clears after exactly
+// CRSF_FAILSAFE_RECOVERY_FRAMES frames
+bool bench_check_failsafe(void)
+{
+  failsafe_result_t result;
+  if (!_failsafe_trials(&result))
+  {
+    printf("failsafe   no alarm\n");
+    return false;
+  }
+  if (result.early > 0 || result.bad_recovery > 0)
+  {
+    printf("failsafe   %lu early, %lu wrong recovery counts\n", (unsigned long)result.early,
+           (unsigned long)result.bad_recovery);
+    return false;
+  }
+  return true;
+}
+
+void bench_failsafe(void)
+{
+  failsafe_result_t result;
+  if (!_failsafe_trials(&result))
+  {
+    printf("failsafe   no alarm\n");
+    return;
+  }
+  printf("failsafe   %u ms timeout, detected %.1f us late on average, %lu us worst over %lu trials\n",
+         FAILSAFE_TIMEOUT_US / 1000, result.measured ? (double)result.total / result.measured : 0.0,
+         (unsigned long)result.worst, (unsigned long)result.measured);
+}
+#endif
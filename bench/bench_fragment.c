@@ -0,0 +1,178 @@
+/**
+ * @file bench_fragment.c
+ * @author Britannio Jarrett
+ * @brief Large messages fragmented over telemetry slots, with frames lost on the way.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ */
+
+#include "bench.h"
+#include "crsf_fragment.h"
+#include <stdio.h>
+#include <string.h>
+
+#if BENCH_FRAGMENT
+#define FRAGMENT_SECONDS 10
+
+// The receiving end of the link, where the fragments that got through are put back together
+static crsf_reassembler_t _reassembler;
+static uint32_t _fragment_corrupt;
+
+static void _on_fragment_frame(crsf_t *crsf, frame_type_t type, const crsf_frame_payload_t *payload)
+{
+  (void)crsf;
+  if (type == CRSF_FRAMETYPE_CUSTOM_PAYLOAD)
+  {
+    crsf_reassembler_push(&_reassembler, payload->custom.buffer, payload->custom.length);
+  }
+}
+
+// Message `number` is numbered in its first four bytes, with a mix of sizes up to the largest
+static size_t _fragment_message(uint32_t number, uint8_t *data)
+{
+  static const size_t sizes[] = {300, 1000, CRSF_FRAGMENT_MESSAGE_MAX, CRSF_FRAGMENT_DATA_SIZE, 4};
+  const size_t length = sizes[number % (sizeof(sizes) / sizeof(sizes[0]))];
+  memcpy(data, &number, sizeof(number));
+  for (size_t i = sizeof(number); i < length; i++)
+  {
+    data[i] = (uint8_t)(number * 7 + i);
+  }
+  return length;
+}
+
+static void _on_fragment_message(void *ctx, const uint8_t *data, size_t length)
+{
+  static uint8_t expected[CRSF_FRAGMENT_MESSAGE_MAX];
+  (void)ctx;
+  uint32_t number;
+  memcpy(&number, data, sizeof(number));
+  if (length < sizeof(number) || _fragment_message(number, expected) != length || memcmp(data, expected, length) != 0)
+  {
+    _fragment_corrupt++;
+  }
+}
+
+/**
+ * Keeps every message slot full for FRAGMENT_SECONDS of RC frames at `rate_hz`
+ * and `baud_rate` with a 1:`ratio` telemetry ratio and battery telemetry at
+ * 1 Hz competing for the slots, then lets the queue drain. Returns whether
+ * every message arrived intact or was counted as lost.
+ */
+static bool _fragment_run(uint32_t rate_hz, uint32_t baud_rate, uint8_t ratio, uint32_t loss_per_mille,
+                          crsf_fragment_stats_t *stats)
+{
+  static crsf_t sender;
+  static crsf_t receiver;
+  static crsf_fragmenter_t fragmenter;
+  static uint8_t message[CRSF_FRAGMENT_MESSAGE_MAX];
+  static bench_link_t sender_link;
+  static bench_link_t receiver_link;
+  static crsf_transport_t sender_transport;
+  static crsf_transport_t receiver_transport;
+  bench_link_init(&sender_link);
+  bench_link_init(&receiver_link);
+  // Telemetry only goes one way
+  sender_link.peer = &receiver_link;
+  sender_link.loss_per_mille = loss_per_mille;
+  sender_link.rng = 5;
+  bench_link_transport(&sender_transport, &sender_link);
+  bench_link_transport(&receiver_transport, &receiver_link);
+  bench_now_us = 0;
+  crsf_init(&sender, &sender_transport);
+  crsf_ctx_set_baud_rate(&sender, baud_rate);
+  crsf_ctx_telem_set_ratio(&sender, ratio);
+  crsf_init(&receiver, &receiver_transport);
+  crsf_ctx_set_baud_rate(&receiver, baud_rate);
+  crsf_ctx_set_on_frame(&receiver, _on_fragment_frame);
+  crsf_fragmenter_init(&fragmenter, &sender);
+  crsf_reassembler_init(&_reassembler, &receiver, _on_fragment_message, NULL);
+  _fragment_corrupt = 0;
+
+  uint8_t frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4];
+  bench_rc_frame(frame, 992);
+  const uint32_t frame_us = (sizeof(frame) * 10 * 1000000 + baud_rate - 1) / baud_rate;
+  const uint32_t period_us = 1000000 / rate_hz;
+  const uint32_t frames = rate_hz * FRAGMENT_SECONDS;
+  uint32_t number = 0;
+  // Draining takes at most the queued fragments' slots, so give up well after that
+  for (uint32_t n = 1; n <= 2 * frames && (n <= frames || fragmenter.count > 0 || fragmenter.in_flight); n++)
+  {
+    bench_now_us = (uint64_t)n * period_us + frame_us;
+    bench_link_push(&sender_link, frame, sizeof(frame));
+    crsf_ctx_process_frames(&sender);
+    if (n % rate_hz == 0)
+    {
+      crsf_ctx_telem_set_battery_data(&sender, 168, 50, n / rate_hz, 80);
+    }
+    while (n <= frames && crsf_fragmenter_free_slots(&fragmenter) > 0)
+    {
+      crsf_fragmenter_queue(&fragmenter, message, _fragment_message(number++, message));
+    }
+    crsf_fragmenter_poll(&fragmenter);
+    crsf_ctx_process_frames(&receiver);
+  }
+
+  crsf_fragmenter_get_stats(&fragmenter, stats);
+  const crsf_reassembly_stats_t *received = &_reassembler.stats;
+  if (_fragment_corrupt > 0 || fragmenter.count > 0 || received->messages + received->lost + _reassembler.active != stats->messages_sent ||
+      received->bytes > stats->bytes_sent || (loss_per_mille == 0 && (received->lost > 0 || received->bytes != stats->bytes_sent)))
+  {
+    printf("fragments  %lu Hz loss %lu: %lu corrupt, %lu delivered + %lu lost of %lu sent\n", (unsigned long)rate_hz,
+           (unsigned long)loss_per_mille, (unsigned long)_fragment_corrupt, (unsigned long)received->messages,
+           (unsigned long)received->lost, (unsigned long)stats->messages_sent);
+    return false;
+  }
+  return true;
+}
+
+static const struct
+{
+  uint32_t rate_hz;
+  uint32_t baud_rate;
+  uint8_t ratio;
+  uint32_t loss_per_mille;
+} _fragment_configs[] = {
+    {250, CRSF_BAUD_RATE_DEFAULT, 2, 0},
+    {250, CRSF_BAUD_RATE_DEFAULT, 2, 20},
+    {500, 1870000, 4, 0},
+    {500, 1870000, 4, 20},
+};
+
+bool bench_check_fragment(void)
+{
+  bool ok = true;
+  for (size_t i = 0; i < sizeof(_fragment_configs) / sizeof(_fragment_configs[0]); i++)
+  {
+    crsf_fragment_stats_t stats;
+    ok = _fragment_run(_fragment_configs[i].rate_hz, _fragment_configs[i].baud_rate, _fragment_configs[i].ratio,
+                       _fragment_configs[i].loss_per_mille, &stats) && ok;
+  }
+  return ok;
+}
+
+void bench_fragment(void)
+{
+  for (size_t i = 0; i < sizeof(_fragment_configs) / sizeof(_fragment_configs[0]); i++)
+  {
+    const uint32_t rate_hz = _fragment_configs[i].rate_hz;
+    const uint32_t baud_rate = _fragment_configs[i].baud_rate;
+    const uint32_t loss_per_mille = _fragment_configs[i].loss_per_mille;
+    crsf_fragment_stats_t stats;
+    _fragment_run(rate_hz, baud_rate, _fragment_configs[i].ratio, loss_per_mille, &stats);
+    crsf_reassembly_stats_t received;
+    crsf_reassembler_get_stats(&_reassembler, &received);
+    // Goodput is what the receiver got; throughput what went out, lost or not
+    printf("fragments  %4lu Hz %7lu baud 1:%u loss %lu.%lu %%  goodput %5lu of %5lu B/s (%3.0f %%)  throughput %5lu B/s  %lu messages, %lu lost\n",
+           (unsigned long)rate_hz, (unsigned long)baud_rate, _fragment_configs[i].ratio,
+           (unsigned long)(loss_per_mille / 10), (unsigned long)(loss_per_mille % 10), (unsigned long)received.goodput_bps,
+           (unsigned long)stats.capacity_bps, stats.capacity_bps ? 100.0 * received.goodput_bps / stats.capacity_bps : 0.0,
+           (unsigned long)stats.throughput_bps, (unsigned long)received.messages, (unsigned long)received.lost);
+  }
+}
+#endif
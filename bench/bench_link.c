@@ -0,0 +1,133 @@
+/**
+ * @file bench_link.c
+ * @author Britannio Jarrett
+ * @brief Loopback transport in virtual time for the benchmark harness.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * The suites decide when every byte arrives and what the time is, so runs are
+ * the same on every machine. Two linked ends stand in for a UART between two
+ * crsf_t instances; a single end is fed by the suite and its writes collected.
+ */
+
+#include "bench.h"
+#include <string.h>
+
+uint64_t bench_now_us;
+
+static size_t _link_read(void *ctx, uint8_t *buf, size_t max)
+{
+  bench_link_t *link = ctx;
+  size_t count = link->rx_len - link->rx_offset;
+  count = count < max ? count : max;
+  if (link->chunk > 0 && count > link->chunk)
+  {
+    count = link->chunk;
+  }
+  memcpy(buf, link->rx + link->rx_offset, count);
+  link->rx_offset += count;
+  return count;
+}
+
+static uint64_t _link_time(void *ctx)
+{
+  (void)ctx;
+  return bench_now_us;
+}
+
+static bool _link_set_baud(void *ctx, uint32_t baud)
+{
+  bench_link_t *link = ctx;
+  link->baud_rate = baud;
+  link->baud_switches++;
+  return true;
+}
+
+void bench_link_init(bench_link_t *link)
+{
+  memset(link, 0, sizeof(*link));
+  link->rx = link->buffer;
+  link->baud_rate = CRSF_BAUD_RATE_DEFAULT;
+  link->rng = 1;
+}
+
+void bench_link_connect(bench_link_t *a, bench_link_t *b)
+{
+  a->peer = b;
+  b->peer = a;
+  // So that the two directions garble differently
+  b->rng = 2;
+}
+
+void bench_link_transport(crsf_transport_t *transport, bench_link_t *link)
+{
+  *transport = (crsf_transport_t){
+      .read = _link_read,
+      .write = bench_link_write,
+      .time_us = _link_time,
+      .set_baud = _link_set_baud,
+      .ctx = link,
+  };
+}
+
+void bench_link_push(bench_link_t *link, const uint8_t *data, size_t len)
+{
+  if (link->rx != link->buffer)
+  {
+    link->rx = link->buffer;
+    link->rx_len = 0;
+    link->rx_offset = 0;
+  }
+  // Make room by dropping what has been read
+  memmove(link->buffer, link->buffer + link->rx_offset, link->rx_len - link->rx_offset);
+  link->rx_len -= link->rx_offset;
+  link->rx_offset = 0;
+  const size_t space = sizeof(link->buffer) - link->rx_len;
+  const size_t count = len < space ? len : space;
+  memcpy(link->buffer + link->rx_len, data, count);
+  link->rx_len += count;
+}
+
+void bench_link_replay(bench_link_t *link, const uint8_t *data, size_t len)
+{
+  link->rx = data;
+  link->rx_len = len;
+  link->rx_offset = 0;
+}
+
+size_t bench_link_write(void *ctx, const uint8_t *buf, size_t len)
+{
+  bench_link_t *link = ctx;
+  bench_link_t *peer = link->peer;
+  size_t count = len;
+  link->written += len;
+  const bool lost = link->loss_per_mille > 0 && bench_random(&link->rng) % 1000 < link->loss_per_mille;
+  if (!lost && peer != NULL)
+  {
+    uint8_t garbled[BENCH_LINK_BUFFER_SIZE];
+    const size_t length = len < sizeof(garbled) ? len : sizeof(garbled);
+    for (size_t i = 0; i < length; i++)
+    {
+      garbled[i] = peer->baud_rate == link->baud_rate ? buf[i] : (uint8_t)bench_random(&peer->rng);
+    }
+    bench_link_push(peer, garbled, length);
+  }
+  else if (!lost && link->out != NULL)
+  {
+    const size_t space = link->out_capacity - link->out_len;
+    count = len < space ? len : space;
+    memcpy(link->out + link->out_len, buf, count);
+    link->out_len += count;
+  }
+  if (link->on_write != NULL)
+  {
+    link->on_write(link, buf, len);
+  }
+  return count;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file bench_linux.c
+ * @author Britannio Jarrett
+ * @brief Whole-frame writes of the Linux transport into a pty nobody is reading.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ */
+
+#include "bench.h"
+
+#if !BENCH_CYCLES
+#include "crsf_transport_linux.h"
+#include <stdio.h>
+#include <string.h>
+
+#define LINUX_WRITE_ATTEMPTS 2000
+
+static crsf_linux_port_t _linux_port;
+static crsf_linux_port_t _linux_peer;
+static uint8_t _linux_received[LINUX_WRITE_ATTEMPTS * (CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4)];
+
+// Keeps writing RC frames into the pty until its queue is full, retrying the
+// refused ones. What comes out of the other side must be whole frames only.
+bool bench_check_linux_write(void)
+{
+  char peer_path[64];
+  if (!crsf_linux_port_open_pty(&_linux_port, peer_path, sizeof(peer_path)) ||
+      !crsf_linux_port_open(&_linux_peer, peer_path, CRSF_BAUD_RATE_DEFAULT))
+  {
+    printf("linux      no pty\n");
+    crsf_linux_port_close(&_linux_port);
+    return false;
+  }
+  crsf_transport_t transport;
+  crsf_transport_t peer;
+  crsf_linux_transport(&transport, &_linux_port);
+  crsf_linux_transport(&peer, &_linux_peer);
+
+  uint8_t frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4];
+  uint32_t sent = 0;
+  uint32_t refused = 0;
+  for (uint32_t n = 0; n < LINUX_WRITE_ATTEMPTS; n++)
+  {
+    bench_rc_frame(frame, (uint16_t)(sent & 0x7FF));
+    const size_t count = transport.write(transport.ctx, frame, sizeof(frame));
+    if (count == sizeof(frame))
+    {
+      sent++;
+    }
+    else if (count == 0)
+    {
+      refused++;
+    }
+    else
+    {
+      printf("linux      partial write of %lu bytes\n", (unsigned long)count);
+      sent = UINT32_MAX;
+      break;
+    }
+  }
+
+  size_t received = 0;
+  size_t count;
+  while (crsf_linux_port_wait(&_linux_peer, 50) > 0 &&
+         (count = peer.read(peer.ctx, _linux_received + received, sizeof(_linux_received) - received)) > 0)
+  {
+    received += count;
+  }
+  crsf_linux_port_close(&_linux_peer);
+  crsf_linux_port_close(&_linux_port);
+  if (sent == UINT32_MAX)
+  {
+    return false;
+  }
+
+  // Each frame carries the count of frames before it, so a repeated or cut one shows
+  bool whole = received == (size_t)sent * sizeof(frame);
+  for (uint32_t n = 0; whole && n < sent; n++)
+  {
+    bench_rc_frame(frame, (uint16_t)(n & 0x7FF));
+    whole = memcmp(_linux_received + n * sizeof(frame), frame, sizeof(frame)) == 0;
+  }
+  if (!whole || refused == 0)
+  {
+    printf("linux      %lu frames sent, %lu refused, %lu bytes received\n", (unsigned long)sent,
+           (unsigned long)refused, (unsigned long)received);
+    return false;
+  }
+  return true;
+}
+#endif
@@ -0,0 +1,128 @@
+/**
+ * @file bench_parser.c
+ * @author Britannio Jarrett
+ * @brief Parser throughput over clean and noisy synthetic streams.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+
+// Instance of its own so the parser runs without any transport
+static crsf_t _parser;
+
+typedef struct
+{
+  uint64_t ticks;
+  uint32_t passes;
+  // Fastest single pass, the least disturbed by the host
+  uint32_t best;
+  size_t frames;
+} parse_result_t;
+
+static parse_result_t _parse_stream(const bench_stream_t *stream)
+{
+  parse_result_t result = {0, 0, UINT32_MAX, 0};
+  crsf_init(&_parser, NULL);
+  const double target = bench_target_seconds();
+  while (result.passes == 0 || bench_seconds(result.ticks) < target)
+  {
+    size_t frames = 0;
+    const uint32_t start = bench_ticks();
+    for (size_t offset = 0; offset < stream->len; offset += BENCH_PARSE_CHUNK)
+    {
+      const size_t len = stream->len - offset < BENCH_PARSE_CHUNK ? stream->len - offset : BENCH_PARSE_CHUNK;
+      frames += crsf_ctx_parse(&_parser, stream->data + offset, len);
+    }
+    const uint32_t elapsed = bench_elapsed(start);
+    result.ticks += elapsed;
+    result.best = elapsed < result.best ? elapsed : result.best;
+    result.frames = frames;
+    result.passes++;
+  }
+  return result;
+}
+
+#if CRSF_STATS
+static void _print_histogram(const char *label, const crsf_histogram_t *histogram)
+{
+  if (histogram->count == 0)
+  {
+    return;
+  }
+  printf("  %-9s avg %9.0f min %9lu max %9lu ns over %lu\n", label, (double)histogram->sum / histogram->count,
+         (unsigned long)histogram->min, (unsigned long)histogram->max, (unsigned long)histogram->count);
+}
+
+void bench_print_stats(const crsf_t *crsf)
+{
+  crsf_stats_t stats;
+  if (!crsf_ctx_get_stats(crsf, &stats))
+  {
+    printf("  stats    unavailable\n");
+    return;
+  }
+  printf("  stats    %lu frames, %lu crc, %lu length, %lu unknown, %lu malformed, %lu resyncs, %llu bytes discarded\n",
+         (unsigned long)stats.frames, (unsigned long)stats.crc_errors, (unsigned long)stats.bad_lengths,
+         (unsigned long)stats.unknown_types, (unsigned long)stats.malformed, (unsigned long)stats.resyncs,
+         (unsigned long long)stats.bytes_discarded);
+  _print_histogram("latency", &stats.latency_ns);
+  _print_histogram("decode", &stats.decode_ns);
+  _print_histogram("callback", &stats.callback_ns);
+  _print_histogram("interval", &stats.rc_interval_ns);
+}
+#endif
+
+void bench_parser(const bench_stream_config_t *config)
+{
+  bench_stream_t stream = {.data = bench_stream_data, .capacity = sizeof(bench_stream_data)};
+  bench_stream_config_t clean_config = *config;
+  clean_config.bit_error_rate = 0;
+  clean_config.byte_drop_rate = 0;
+  clean_config.garbage_rate = 0;
+
+  bench_stream_generate(&stream, &clean_config);
+  const size_t clean_len = stream.len;
+  const parse_result_t clean = _parse_stream(&stream);
+  const double clean_per_byte = (double)clean.ticks / clean.passes / clean_len;
+  const double clean_seconds = bench_seconds(clean.ticks) / clean.passes;
+
+  printf("parser @ %lu Hz (%lu ms of stream)\n", (unsigned long)config->rc_rate_hz, (unsigned long)config->duration_ms);
+  printf("  clean    %8.2f %s/byte %10.0f frames/s  %lu/%lu frames\n",
+         clean_per_byte, BENCH_TICK_UNIT, clean.frames / clean_seconds,
+         (unsigned long)clean.frames, (unsigned long)stream.frames);
+  // Share of one core spent parsing this link in real time
+  printf("  load     %8.4f %%\n", 100.0 * clean_seconds / (config->duration_ms / 1000.0));
+
+  // The same garbage and frames with the damaged frames left out, to set their cost against
+  bench_stream_config_t omitted_config = *config;
+  omitted_config.omit_corrupted = true;
+  bench_stream_generate(&stream, &omitted_config);
+  const parse_result_t omitted = _parse_stream(&stream);
+
+  bench_stream_generate(&stream, config);
+  const parse_result_t noisy = _parse_stream(&stream);
+  const double noisy_ticks = (double)noisy.ticks / noisy.passes;
+  const double noisy_seconds = bench_seconds(noisy.ticks) / noisy.passes;
+  printf("  noisy    %8.2f %s/byte %10.0f frames/s  %lu/%lu frames, %lu corrupted\n",
+         noisy_ticks / stream.len, BENCH_TICK_UNIT, noisy.frames / noisy_seconds,
+         (unsigned long)noisy.frames, (unsigned long)stream.frames, (unsigned long)stream.corrupted_frames);
+  if (stream.corrupted_frames > 0)
+  {
+    // Rejecting a damaged frame and finding the next sync byte, against a clean frame's decode
+    const double resync = ((double)noisy.best - omitted.best) / stream.corrupted_frames;
+    printf("  resync   %8.1f %s per corrupted frame, %.1f per clean frame\n", resync, BENCH_TICK_UNIT,
+           (double)clean.best / clean.frames);
+  }
+#if CRSF_STATS
+  // Accumulated over every pass of the noisy stream
+  bench_print_stats(&_parser);
+#endif
+}
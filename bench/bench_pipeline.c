@@ -0,0 +1,236 @@
+/**
+ * @file bench_pipeline.c
+ * @author Britannio Jarrett
+ * @brief Latency through the threaded pipeline, from byte ring to popped event.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Host only: the feeder and the worker run on pthreads.
+ */
+
+#include "bench.h"
+
+#if !BENCH_CYCLES && BENCH_PIPELINE
+#include "crsf_pipeline.h"
+#include "crsf_ring.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+#define PIPELINE_FRAMES 20000
+
+// A receiver stand-in: a feeder thread writes RC frames into `ring`, the pipeline worker reads them
+typedef struct
+{
+  crsf_ring_t ring;
+  uint32_t frames;
+  // Frames per second, 0 to send as fast as the worker drains the ring
+  uint32_t rate_hz;
+  uint32_t done;
+  // Telemetry frames sent by the worker
+  uint32_t telem_frames;
+} pipeline_link_t;
+
+static pipeline_link_t _link;
+// bench_ticks() when each frame was handed to the ring, indexed by the sequence number it carries
+static uint32_t _sent_at[PIPELINE_FRAMES];
+static uint32_t _latency[PIPELINE_FRAMES];
+
+static size_t _link_read(void *ctx, uint8_t *buf, size_t max)
+{
+  return crsf_ring_pop(&((pipeline_link_t *)ctx)->ring, buf, max);
+}
+
+static size_t _link_write(void *ctx, const uint8_t *buf, size_t len)
+{
+  (void)buf;
+  ((pipeline_link_t *)ctx)->telem_frames++;
+  return len;
+}
+
+static uint64_t _link_time(void *ctx)
+{
+  (void)ctx;
+  return bench_time_us();
+}
+
+// Sends RC frames carrying a 22-bit sequence number in channels 0 and 1
+static void *_feed_link(void *arg)
+{
+  pipeline_link_t *link = arg;
+  uint16_t channels[CRSF_RC_CHANNELS] = {0};
+  uint8_t frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4] = {0xC8, CRSF_RC_CHANNELS_PAYLOAD_SIZE + 2, CRSF_FRAMETYPE_RC_CHANNELS_PACKED};
+  const uint32_t period = link->rate_hz ? 1000000000u / link->rate_hz : 0;
+  uint32_t next = bench_ticks();
+  for (uint32_t seq = 0; seq < link->frames; seq++)
+  {
+    if (period)
+    {
+      while ((int32_t)(bench_ticks() - next) < 0)
+      {
+        sched_yield();
+      }
+      next += period;
+    }
+    channels[0] = seq & 0x7FF;
+    channels[1] = seq >> 11;
+    crsf_pack_channels(channels, frame + 3);
+    frame[sizeof(frame) - 1] = crsf_crc8(frame + 2, sizeof(frame) - 3);
+    while (CRSF_RX_RING_SIZE - crsf_ring_count(&link->ring) < sizeof(frame))
+    {
+      sched_yield();
+    }
+    _sent_at[seq] = bench_ticks();
+    for (size_t i = 0; i < sizeof(frame); i++)
+    {
+      crsf_ring_push(&link->ring, frame[i]);
+    }
+  }
+  __atomic_store_n(&link->done, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+typedef struct
+{
+  uint32_t received;
+  uint32_t dropped;
+  uint32_t gaps;
+  uint32_t out_of_order;
+} pipeline_result_t;
+
+static crsf_t _pipeline_crsf;
+
+/**
+ * Runs the pipeline worker on its own thread against a feeder thread and
+ * measures the time from a frame entering the byte ring to its event being
+ * popped here, into _latency. Returns whether every sequence number arrived in
+ * order, with gaps only where the event queue reported a drop.
+ */
+static bool _pipeline_run(uint32_t frames, uint32_t rate_hz, pipeline_result_t *result)
+{
+  crsf_t *crsf = &_pipeline_crsf;
+  static crsf_pipeline_t pipeline;
+  const crsf_transport_t transport = {
+      .read = _link_read,
+      .write = _link_write,
+      .time_us = _link_time,
+      .ctx = &_link,
+  };
+  crsf_ring_init(&_link.ring);
+  _link.frames = frames;
+  _link.rate_hz = rate_hz;
+  _link.done = 0;
+  _link.telem_frames = 0;
+  crsf_init(crsf, &transport);
+  crsf_pipeline_init(&pipeline, crsf);
+  crsf_pipeline_start(&pipeline);
+  pthread_t feeder;
+  pthread_create(&feeder, NULL, _feed_link, &_link);
+
+  uint32_t received = 0;
+  uint32_t expected = 0;
+  uint32_t gaps = 0;
+  uint32_t out_of_order = 0;
+  uint32_t idle_since = bench_ticks();
+  crsf_event_t event;
+  for (;;)
+  {
+    if (!crsf_pipeline_pop(&pipeline, &event))
+    {
+      // Give the worker time to drain the ring once the feeder is done
+      if (__atomic_load_n(&_link.done, __ATOMIC_ACQUIRE) && bench_elapsed(idle_since) > 50000000u)
+      {
+        break;
+      }
+      sched_yield();
+      continue;
+    }
+    idle_since = bench_ticks();
+    if (event.type != CRSF_EVENT_RC_CHANNELS)
+    {
+      continue;
+    }
+    const uint32_t seq = event.channels[0] | (uint32_t)event.channels[1] << 11;
+    _latency[received++] = bench_elapsed(_sent_at[seq]);
+    if (seq < expected)
+    {
+      out_of_order++;
+    }
+    else
+    {
+      gaps += seq - expected;
+      expected = seq + 1;
+    }
+    if ((received & 63) == 0)
+    {
+      crsf_pipeline_telem_set_battery_data(&pipeline, 168, 50, received, 80);
+    }
+  }
+  pthread_join(feeder, NULL);
+  crsf_pipeline_stop(&pipeline);
+
+  result->received = received;
+  result->dropped = crsf_pipeline_events_dropped(&pipeline);
+  result->gaps = gaps;
+  result->out_of_order = out_of_order;
+  return out_of_order == 0 && gaps == result->dropped && received + result->dropped == frames;
+}
+
+static const struct
+{
+  const char *label;
+  uint32_t frames;
+  uint32_t rate_hz;
+} _pipeline_configs[] = {
+    {"1 kHz", 250, 1000},
+    {"saturated", PIPELINE_FRAMES, 0},
+};
+
+bool bench_check_pipeline(void)
+{
+  bool ok = true;
+  for (size_t i = 0; i < sizeof(_pipeline_configs) / sizeof(_pipeline_configs[0]); i++)
+  {
+    pipeline_result_t result;
+    if (!_pipeline_run(_pipeline_configs[i].frames, _pipeline_configs[i].rate_hz, &result))
+    {
+      printf("pipeline   %s: %lu out of order, %lu missing, %lu dropped, %lu of %lu received\n",
+             _pipeline_configs[i].label, (unsigned long)result.out_of_order, (unsigned long)result.gaps,
+             (unsigned long)result.dropped, (unsigned long)result.received, (unsigned long)_pipeline_configs[i].frames);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+void bench_pipeline(void)
+{
+  for (size_t i = 0; i < sizeof(_pipeline_configs) / sizeof(_pipeline_configs[0]); i++)
+  {
+    pipeline_result_t result;
+    _pipeline_run(_pipeline_configs[i].frames, _pipeline_configs[i].rate_hz, &result);
+    const uint32_t received = result.received;
+    bench_sort_ticks(_latency, received);
+    printf("pipeline %-10s p50 %7.0f p99 %7.0f max %8.0f %s  %lu/%lu frames, %lu dropped, %lu telemetry\n",
+           _pipeline_configs[i].label,
+           received ? (double)_latency[received / 2] : 0.0,
+           received ? (double)_latency[received * 99 / 100] : 0.0,
+           received ? (double)_latency[received - 1] : 0.0,
+           BENCH_TICK_UNIT, (unsigned long)received, (unsigned long)_pipeline_configs[i].frames,
+           (unsigned long)result.dropped, (unsigned long)_link.telem_frames);
+#if CRSF_STATS
+    if (_pipeline_configs[i].rate_hz != 0)
+    {
+      // Frames arrive in real time here, so the intervals show the feeder's jitter
+      bench_print_stats(&_pipeline_crsf);
+    }
+#endif
+  }
+}
+#endif
@@ -0,0 +1,104 @@
+/**
+ * @file bench_ring.c
+ * @author Britannio Jarrett
+ * @brief Overrun handling of the receive ring under a producer thread that outruns its reader.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ */
+
+#include "bench.h"
+
+#if !BENCH_CYCLES
+#include "crsf_ring.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+#define RING_BYTES (1 << 18)
+
+static crsf_ring_t _ring;
+// Whether each byte the producer offered was taken, written by the producer only
+static uint8_t _ring_accepted[RING_BYTES];
+static uint8_t _ring_received[RING_BYTES];
+static uint32_t _ring_done;
+
+// Not a multiple of the ring size, so that a stale slot never holds the expected value
+static uint8_t _ring_byte(uint32_t i)
+{
+  return (uint8_t)(i * 7 + (i >> 8));
+}
+
+// Stands in for the UART IRQ, a burst of frames at a time
+static void *_ring_producer(void *arg)
+{
+  (void)arg;
+  const struct timespec gap = {.tv_nsec = 10000};
+  for (uint32_t i = 0; i < RING_BYTES; i++)
+  {
+    _ring_accepted[i] = crsf_ring_push(&_ring, _ring_byte(i));
+    if (i % 160 == 159)
+    {
+      nanosleep(&gap, NULL);
+    }
+  }
+  __atomic_store_n(&_ring_done, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+// The bytes that got in must come out intact and in order, and every one
+// turned away must be counted as an overrun
+bool bench_check_ring(void)
+{
+  crsf_ring_init(&_ring);
+  _ring_done = 0;
+  pthread_t producer;
+  pthread_create(&producer, NULL, _ring_producer, NULL);
+
+  // A reader that falls behind, taking a DMA-sized chunk now and then
+  const struct timespec pause = {.tv_nsec = 20000};
+  size_t received = 0;
+  for (;;)
+  {
+    const bool done = __atomic_load_n(&_ring_done, __ATOMIC_ACQUIRE);
+    const size_t count = crsf_ring_pop(&_ring, _ring_received + received, 64 < RING_BYTES - received ? 64 : RING_BYTES - received);
+    received += count;
+    if (done && count == 0)
+    {
+      break;
+    }
+    nanosleep(&pause, NULL);
+  }
+  pthread_join(producer, NULL);
+
+  uint32_t dropped = 0;
+  size_t next = 0;
+  bool ordered = true;
+  for (uint32_t i = 0; i < RING_BYTES; i++)
+  {
+    if (!_ring_accepted[i])
+    {
+      dropped++;
+    }
+    else if (next >= received || _ring_received[next++] != _ring_byte(i))
+    {
+      ordered = false;
+    }
+  }
+  const uint32_t overruns = crsf_ring_overruns(&_ring);
+  if (!ordered || next != received || overruns != dropped || dropped == 0)
+  {
+    printf("ring       %lu received, %lu dropped, %lu overruns%s\n", (unsigned long)received, (unsigned long)dropped,
+           (unsigned long)overruns, ordered ? "" : ", bytes out of order or damaged");
+    return false;
+  }
+  printf("ring       %lu of %u bytes through, %lu overruns counted\n", (unsigned long)received, RING_BYTES,
+         (unsigned long)overruns);
+  return true;
+}
+#endif
@@ -0,0 +1,496 @@
+/**
+ * @file bench_router.c
+ * @author Britannio Jarrett
+ * @brief Frame router between two ports: filtering, cut-off, rewrite and injection, cost and latency.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ */
+
+#include "bench.h"
+#include "crsf_router.h"
+#include <stdio.h>
+#include <string.h>
+
+#if !BENCH_CYCLES
+#include "crsf_transport_linux.h"
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#define ROUTER_STEPS 400
+#define ROUTER_GPS_SATELLITES 12
+
+// Sized for the script in _check_router(), with room for the injected telemetry upstream
+static uint8_t _router_down[ROUTER_STEPS * 32];
+static uint8_t _router_up[ROUTER_STEPS * 8];
+static uint8_t _router_down_out[ROUTER_STEPS * 32];
+static uint8_t _router_up_out[ROUTER_STEPS * 16];
+// End of each step's downstream bytes
+static size_t _router_down_end[ROUTER_STEPS];
+static uint32_t _router_rewrites;
+
+// Counts the valid frames in a router's output by type, returning the bytes outside them.
+// GPS frames that were not rewritten are counted under type 0.
+static size_t _router_count_frames(const uint8_t *data, size_t len, uint32_t counts[256])
+{
+  size_t junk = 0;
+  size_t i = 0;
+  while (i < len)
+  {
+    const uint8_t length = i + 1 < len ? data[i + 1] : 0;
+    if ((data[i] == 0xC8 || data[i] == 0xEE) && length >= 2 && length <= CRSF_MAX_FRAME_SIZE - 2 &&
+        i + length + 2 <= len && crsf_crc8(data + i + 2, length - 1) == data[i + length + 1])
+    {
+#if CRSF_FRAME_GPS
+      crsf_payload_gps_t gps;
+      const bool stale = data[i + 2] == CRSF_FRAMETYPE_GPS &&
+                         (!crsf_decode_gps(data + i + 3, length - 2, &gps) || gps.satellites != ROUTER_GPS_SATELLITES);
+#else
+      const bool stale = false;
+#endif
+      counts[stale ? 0 : data[i + 2]]++;
+      i += length + 2;
+    }
+    else
+    {
+      junk++;
+      i++;
+    }
+  }
+  return junk;
+}
+
+// The GPS frames are only rewritten with their decoder built in, see CRSF_FRAME_GPS
+#if CRSF_FRAME_GPS
+static bool _router_rewrite_gps(void *ctx, crsf_route_direction_t direction, uint8_t *frame)
+{
+  (void)ctx;
+  crsf_payload_gps_t gps;
+  if (direction != CRSF_ROUTE_UPSTREAM || !crsf_decode_gps(frame + 3, frame[1] - 2, &gps))
+  {
+    return false;
+  }
+  gps.satellites = ROUTER_GPS_SATELLITES;
+  frame[1] = crsf_encode_gps(&gps, frame + 3) + 2;
+  _router_rewrites++;
+  return true;
+}
+#endif
+
+/**
+ * Routes a scripted exchange between in-memory ports, read back in small
+ * chunks so frames are cut through across polls:
+ *   downstream: RC frames, some corrupted, with link statistics, garbage,
+ *   flight modes (dropped) and a battery frame too short for its type
+ *   upstream: GPS frames (rewritten with CRSF_FRAME_GPS) and attitude frames, with battery
+ *   telemetry from the local instance merged in
+ * Every valid frame must come out intact, corrupted frames must be cut off by
+ * their CRC and injected frames must never land inside a forwarded one.
+ */
+static bool _check_router(uint32_t *injected)
+{
+  static crsf_router_t router;
+  static crsf_t local;
+  size_t down_len = 0;
+  size_t up_len = 0;
+  uint32_t expected[256] = {0};
+  uint32_t corrupted = 0;
+  uint8_t frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4];
+  uint8_t payload[CRSF_MAX_FRAME_SIZE];
+  for (uint32_t step = 0; step < ROUTER_STEPS; step++)
+  {
+    if (step % 20 == 7)
+    {
+      memset(_router_down + down_len, 0x55, 5);
+      down_len += 5;
+    }
+    bench_rc_frame(frame, 172 + step);
+    if (step % 33 == 5)
+    {
+      frame[10] ^= 0x10;
+      corrupted++;
+    }
+    else
+    {
+      expected[CRSF_FRAMETYPE_RC_CHANNELS_PACKED]++;
+    }
+    memcpy(_router_down + down_len, frame, sizeof(frame));
+    down_len += sizeof(frame);
+#if CRSF_FRAME_LINK_STATISTICS
+    if (step % 10 == 3)
+    {
+      const crsf_payload_link_statistics_t link = {.uplink_rssi_ant_1 = 60, .uplink_package_success_rate = 100};
+      bench_put_frame(_router_down, &down_len, CRSF_FRAMETYPE_LINK_STATISTICS, payload,
+                        crsf_encode_link_statistics(&link, payload));
+      expected[CRSF_FRAMETYPE_LINK_STATISTICS]++;
+    }
+#endif
+    if (step % 25 == 11)
+    {
+      bench_put_frame(_router_down, &down_len, CRSF_FRAMETYPE_FLIGHT_MODE, (const uint8_t *)"ACRO", 5);
+    }
+    if (step == 50)
+    {
+      bench_put_frame(_router_down, &down_len, CRSF_FRAMETYPE_BATTERY_SENSOR, payload, 1);
+    }
+    _router_down_end[step] = down_len;
+
+    if (step % 4 == 0)
+    {
+#if CRSF_FRAME_GPS
+      const crsf_payload_gps_t gps = {.latitude = 515000000, .longitude = -1000000, .altitude = 1100, .satellites = 5};
+      bench_put_frame(_router_up, &up_len, CRSF_FRAMETYPE_GPS, payload, crsf_encode_gps(&gps, payload));
+#else
+      memset(payload, step, CRSF_GPS_PAYLOAD_SIZE);
+      bench_put_frame(_router_up, &up_len, CRSF_FRAMETYPE_GPS, payload, CRSF_GPS_PAYLOAD_SIZE);
+#endif
+      expected[CRSF_FRAMETYPE_GPS]++;
+    }
+    else if (step % 4 == 2)
+    {
+      memset(payload, step, CRSF_ATTITUDE_PAYLOAD_SIZE);
+      bench_put_frame(_router_up, &up_len, CRSF_FRAMETYPE_ATTITUDE, payload, CRSF_ATTITUDE_PAYLOAD_SIZE);
+      expected[CRSF_FRAMETYPE_ATTITUDE]++;
+    }
+  }
+
+  static bench_link_t receiver;
+  static bench_link_t flight_controller;
+  crsf_transport_t receiver_transport;
+  crsf_transport_t flight_controller_transport;
+  bench_link_init(&receiver);
+  bench_link_init(&flight_controller);
+  // Each script is revealed a step at a time by moving rx_len up
+  bench_link_replay(&receiver, _router_down, 0);
+  bench_link_replay(&flight_controller, _router_up, 0);
+  receiver.chunk = 7;
+  flight_controller.chunk = 5;
+  receiver.out = _router_up_out;
+  receiver.out_capacity = sizeof(_router_up_out);
+  flight_controller.out = _router_down_out;
+  flight_controller.out_capacity = sizeof(_router_down_out);
+  bench_link_transport(&receiver_transport, &receiver);
+  bench_link_transport(&flight_controller_transport, &flight_controller);
+  crsf_router_init(&router, &receiver_transport, &flight_controller_transport, &local);
+  crsf_router_set_action(&router, CRSF_ROUTE_DOWNSTREAM, CRSF_FRAMETYPE_FLIGHT_MODE, CRSF_ROUTE_DROP);
+#if CRSF_FRAME_GPS
+  crsf_router_set_action(&router, CRSF_ROUTE_UPSTREAM, CRSF_FRAMETYPE_GPS, CRSF_ROUTE_REWRITE);
+  crsf_router_set_rewrite(&router, _router_rewrite_gps, NULL);
+  const uint32_t rewrites = expected[CRSF_FRAMETYPE_GPS];
+#else
+  // Forwarded as they are
+  const uint32_t rewrites = 0;
+#endif
+  _router_rewrites = 0;
+  bench_now_us = 0;
+  for (uint32_t step = 0; step < ROUTER_STEPS; step++)
+  {
+    if (step % 50 == 0)
+    {
+      crsf_ctx_telem_set_battery_data(&local, 168 - step / 50, 12, step, 80);
+    }
+    bench_now_us += 4000;
+    receiver.rx_len = _router_down_end[step];
+    // Upstream frames straddle the polls, so injection has to wait for the gaps
+    flight_controller.rx_len = (step + 1) * 9 < up_len ? (step + 1) * 9 : up_len;
+    crsf_router_poll(&router);
+  }
+  flight_controller.rx_len = up_len;
+  crsf_router_poll(&router);
+  crsf_router_poll(&router);
+
+  crsf_route_stats_t down;
+  crsf_route_stats_t up;
+  crsf_router_get_stats(&router, CRSF_ROUTE_DOWNSTREAM, &down);
+  crsf_router_get_stats(&router, CRSF_ROUTE_UPSTREAM, &up);
+  *injected = up.injected;
+  uint32_t down_counts[256] = {0};
+  uint32_t up_counts[256] = {0};
+  const size_t down_junk = _router_count_frames(_router_down_out, flight_controller.out_len, down_counts);
+  const size_t up_junk = _router_count_frames(_router_up_out, receiver.out_len, up_counts);
+  for (int type = 1; type < 256; type++)
+  {
+    const uint32_t direction_expected = type == CRSF_FRAMETYPE_GPS || type == CRSF_FRAMETYPE_ATTITUDE ? 0 : expected[type];
+    if (down_counts[type] != direction_expected)
+    {
+      return false;
+    }
+  }
+  return down_counts[0] == 0 && down_junk == corrupted * sizeof(frame) && down.crc_errors == corrupted &&
+         down.filtered == ROUTER_STEPS / 25 && down.bad_lengths > 0 && down.overflows == 0 &&
+         up_counts[CRSF_FRAMETYPE_GPS] == expected[CRSF_FRAMETYPE_GPS] && up_counts[0] == 0 &&
+         up_counts[CRSF_FRAMETYPE_ATTITUDE] == expected[CRSF_FRAMETYPE_ATTITUDE] && up_junk == 0 &&
+         _router_rewrites == rewrites && up.rewritten == _router_rewrites &&
+         up.injected > 0 && up_counts[CRSF_FRAMETYPE_BATTERY_SENSOR] == up.injected && up.overflows == 0;
+}
+
+static bool _router_rewrite_identity(void *ctx, crsf_route_direction_t direction, uint8_t *frame)
+{
+  (void)ctx;
+  (void)direction;
+  (void)frame;
+  return true;
+}
+
+// Cost of routing a noisy 500 Hz stream downstream, per byte
+static void _bench_router_run(const char *label, const bench_stream_t *stream, bool store_and_forward)
+{
+  static crsf_router_t router;
+  static bench_link_t receiver;
+  static bench_link_t flight_controller;
+  crsf_transport_t receiver_transport;
+  crsf_transport_t flight_controller_transport;
+  bench_link_init(&receiver);
+  bench_link_init(&flight_controller);
+  bench_link_replay(&receiver, stream->data, stream->len);
+  receiver.chunk = BENCH_PARSE_CHUNK;
+  bench_link_transport(&receiver_transport, &receiver);
+  bench_link_transport(&flight_controller_transport, &flight_controller);
+  crsf_router_init(&router, &receiver_transport, &flight_controller_transport, NULL);
+  if (store_and_forward)
+  {
+    crsf_router_set_action(&router, CRSF_ROUTE_DOWNSTREAM, CRSF_FRAMETYPE_RC_CHANNELS_PACKED, CRSF_ROUTE_REWRITE);
+    crsf_router_set_action(&router, CRSF_ROUTE_DOWNSTREAM, CRSF_FRAMETYPE_LINK_STATISTICS, CRSF_ROUTE_REWRITE);
+    crsf_router_set_rewrite(&router, _router_rewrite_identity, NULL);
+  }
+  uint64_t ticks = 0;
+  uint32_t passes = 0;
+  const double target = bench_target_seconds();
+  do
+  {
+    receiver.rx_offset = 0;
+    const uint32_t start = bench_ticks();
+    crsf_router_poll(&router);
+    ticks += bench_elapsed(start);
+    passes++;
+  } while (bench_seconds(ticks) < target);
+  crsf_route_stats_t stats;
+  crsf_router_get_stats(&router, CRSF_ROUTE_DOWNSTREAM, &stats);
+  printf("router     %-17s %8.2f %s/byte  %lu/%lu frames forwarded per pass\n", label,
+         (double)ticks / passes / stream->len, BENCH_TICK_UNIT, (unsigned long)(stats.forwarded / passes),
+         (unsigned long)stream->frames);
+}
+
+bool bench_check_router(void)
+{
+  uint32_t injected = 0;
+  const bool ok = _check_router(&injected);
+  printf("router     filter, cut-off, rewrite and injection, %lu telemetry frames injected\n", (unsigned long)injected);
+  return ok;
+}
+
+void bench_router(void)
+{
+  bench_stream_config_t config;
+  bench_stream_default_config(&config);
+  config.rc_rate_hz = 500;
+  config.duration_ms = 200;
+  config.bit_error_rate = 1e-4;
+  config.garbage_rate = 0.05;
+  bench_stream_t stream = {.data = bench_stream_data, .capacity = sizeof(bench_stream_data)};
+  bench_stream_generate(&stream, &config);
+  _bench_router_run("cut-through", &stream, false);
+  _bench_router_run("store-and-forward", &stream, true);
+}
+
+#if !BENCH_CYCLES
+#define ROUTER_LATENCY_FRAMES 1000
+// Pieces each RC frame is written in, a piece's airtime apart, as bytes would trickle off a UART
+#define ROUTER_LATENCY_PIECES 4
+
+// bench_ticks() when each frame's first byte was written, by sequence number, and each frame's latency
+static uint32_t _sent_at[ROUTER_LATENCY_FRAMES];
+static uint32_t _latency[ROUTER_LATENCY_FRAMES];
+
+// The router's receiver and flight controller ports, and the far ends of their ptys
+static crsf_linux_port_t _router_receiver_port;
+static crsf_linux_port_t _router_fc_port;
+static crsf_linux_port_t _router_feeder_port;
+static crsf_linux_port_t _router_sink_port;
+static uint32_t _router_stop;
+static uint32_t _router_received;
+
+static void *_router_thread(void *arg)
+{
+  crsf_router_t *router = arg;
+  while (!__atomic_load_n(&_router_stop, __ATOMIC_ACQUIRE))
+  {
+    crsf_linux_port_wait(&_router_receiver_port, 10);
+    crsf_router_poll(router);
+  }
+  return NULL;
+}
+
+// Stands in for the flight controller, timing when the first byte of each frame arrives
+static void *_router_sink(void *arg)
+{
+  (void)arg;
+  crsf_transport_t transport;
+  crsf_linux_transport(&transport, &_router_sink_port);
+  uint8_t frame[CRSF_MAX_FRAME_SIZE];
+  size_t have = 0;
+  uint32_t first_byte_at = 0;
+  while (!__atomic_load_n(&_router_stop, __ATOMIC_ACQUIRE))
+  {
+    if (crsf_linux_port_wait(&_router_sink_port, 10) <= 0)
+    {
+      continue;
+    }
+    uint8_t chunk[256];
+    const size_t count = transport.read(transport.ctx, chunk, sizeof(chunk));
+    const uint32_t now = bench_ticks();
+    for (size_t i = 0; i < count; i++)
+    {
+      if (have == 0)
+      {
+        if (chunk[i] != 0xC8)
+        {
+          continue;
+        }
+        first_byte_at = now;
+      }
+      frame[have++] = chunk[i];
+      if (have >= 2 && (frame[1] < 2 || frame[1] > CRSF_MAX_FRAME_SIZE - 2))
+      {
+        have = 0;
+      }
+      else if (have >= 2 && have == (size_t)frame[1] + 2)
+      {
+        have = 0;
+        if (frame[2] != CRSF_FRAMETYPE_RC_CHANNELS_PACKED || crsf_crc8(frame + 2, frame[1] - 1) != frame[frame[1] + 1])
+        {
+          continue;
+        }
+        uint16_t channels[CRSF_RC_CHANNELS];
+        crsf_unpack_channels(frame + 3, channels);
+        const uint32_t seq = channels[0] | (uint32_t)channels[1] << 11;
+        if (seq < ROUTER_LATENCY_FRAMES && _router_received < ROUTER_LATENCY_FRAMES)
+        {
+          _latency[_router_received] = first_byte_at - _sent_at[seq];
+          __atomic_store_n(&_router_received, _router_received + 1, __ATOMIC_RELEASE);
+        }
+      }
+    }
+  }
+  return NULL;
+}
+
+/**
+ * Forwards 1 kHz RC frames between two pairs of ptys, with the router and the
+ * far ends on their own threads, and reports the time from the first byte of
+ * a frame being written to the receiver port to it arriving at the flight
+ * controller. The frames are written in pieces spread over their airtime, so
+ * store-and-forward pays for the whole frame where cut-through does not.
+ */
+static void _bench_router_latency_run(const char *label, bool store_and_forward)
+{
+  static crsf_router_t router;
+  char receiver_peer[64];
+  char fc_peer[64];
+  if (!crsf_linux_port_open_pty(&_router_receiver_port, receiver_peer, sizeof(receiver_peer)) ||
+      !crsf_linux_port_open_pty(&_router_fc_port, fc_peer, sizeof(fc_peer)) ||
+      !crsf_linux_port_open(&_router_feeder_port, receiver_peer, CRSF_BAUD_RATE_DEFAULT) ||
+      !crsf_linux_port_open(&_router_sink_port, fc_peer, CRSF_BAUD_RATE_DEFAULT))
+  {
+    printf("router     %-17s skipped, no ptys\n", label);
+    crsf_linux_port_close(&_router_receiver_port);
+    crsf_linux_port_close(&_router_fc_port);
+    crsf_linux_port_close(&_router_feeder_port);
+    return;
+  }
+  crsf_transport_t receiver;
+  crsf_transport_t flight_controller;
+  crsf_transport_t feeder;
+  crsf_linux_transport(&receiver, &_router_receiver_port);
+  crsf_linux_transport(&flight_controller, &_router_fc_port);
+  crsf_linux_transport(&feeder, &_router_feeder_port);
+  crsf_router_init(&router, &receiver, &flight_controller, NULL);
+  if (store_and_forward)
+  {
+    crsf_router_set_action(&router, CRSF_ROUTE_DOWNSTREAM, CRSF_FRAMETYPE_RC_CHANNELS_PACKED, CRSF_ROUTE_REWRITE);
+    crsf_router_set_rewrite(&router, _router_rewrite_identity, NULL);
+  }
+  _router_stop = 0;
+  _router_received = 0;
+  pthread_t router_thread;
+  pthread_t sink_thread;
+  pthread_create(&router_thread, NULL, _router_thread, &router);
+  pthread_create(&sink_thread, NULL, _router_sink, NULL);
+
+  uint16_t channels[CRSF_RC_CHANNELS] = {0};
+  uint8_t frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4] = {0xC8, CRSF_RC_CHANNELS_PAYLOAD_SIZE + 2, CRSF_FRAMETYPE_RC_CHANNELS_PACKED};
+  const size_t piece = (sizeof(frame) + ROUTER_LATENCY_PIECES - 1) / ROUTER_LATENCY_PIECES;
+  const uint32_t piece_ns = piece * 10 * 1000000000ull / CRSF_BAUD_RATE_DEFAULT;
+  uint32_t next = bench_ticks();
+  for (uint32_t seq = 0; seq < ROUTER_LATENCY_FRAMES; seq++)
+  {
+    channels[0] = seq & 0x7FF;
+    channels[1] = seq >> 11;
+    crsf_pack_channels(channels, frame + 3);
+    frame[sizeof(frame) - 1] = crsf_crc8(frame + 2, sizeof(frame) - 3);
+    for (size_t offset = 0; offset < sizeof(frame); offset += piece)
+    {
+      while ((int32_t)(bench_ticks() - next) < 0)
+      {
+        sched_yield();
+      }
+      if (offset == 0)
+      {
+        _sent_at[seq] = bench_ticks();
+      }
+      const size_t length = sizeof(frame) - offset < piece ? sizeof(frame) - offset : piece;
+      feeder.write(feeder.ctx, frame + offset, length);
+      next += offset + piece < sizeof(frame) ? piece_ns : 1000000u - (ROUTER_LATENCY_PIECES - 1) * piece_ns;
+    }
+  }
+  const uint32_t idle_since = bench_ticks();
+  while (__atomic_load_n(&_router_received, __ATOMIC_ACQUIRE) < ROUTER_LATENCY_FRAMES && bench_elapsed(idle_since) < 200000000u)
+  {
+    sched_yield();
+  }
+  __atomic_store_n(&_router_stop, 1, __ATOMIC_RELEASE);
+  pthread_join(router_thread, NULL);
+  pthread_join(sink_thread, NULL);
+  crsf_linux_port_close(&_router_feeder_port);
+  crsf_linux_port_close(&_router_sink_port);
+  crsf_linux_port_close(&_router_receiver_port);
+  crsf_linux_port_close(&_router_fc_port);
+
+  const uint32_t received = _router_received;
+  if (received == 0)
+  {
+    printf("router     %-17s nothing forwarded\n", label);
+    return;
+  }
+  bench_sort_ticks(_latency, received);
+  printf("router     %-17s p50 %5.0f p99 %5.0f max %6.0f us  %lu/%lu frames\n", label, _latency[received / 2] / 1000.0,
+         _latency[received * 99 / 100] / 1000.0, _latency[received - 1] / 1000.0, (unsigned long)received,
+         (unsigned long)ROUTER_LATENCY_FRAMES);
+  // Doubling buckets from 32 us
+  printf("           ");
+  uint32_t bound_us = 32;
+  for (uint32_t i = 0; i < received; bound_us *= 2)
+  {
+    uint32_t count = 0;
+    while (i < received && _latency[i] < (uint64_t)bound_us * 1000)
+    {
+      count++;
+      i++;
+    }
+    printf(" <%lu:%lu", (unsigned long)bound_us, (unsigned long)count);
+  }
+  printf(" us\n");
+}
+
+void bench_router_latency(void)
+{
+  _bench_router_latency_run("cut-through", false);
+  _bench_router_latency_run("store-and-forward", true);
+}
+#endif
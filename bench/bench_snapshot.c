@@ -0,0 +1,138 @@
+/**
+ * @file bench_snapshot.c
+ * @author Britannio Jarrett
+ * @brief Cost of reading the latest-frame snapshot, and torn reads under contention.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+
+#if !BENCH_CYCLES
+#include <pthread.h>
+
+static bool _snapshot_consistent(const crsf_snapshot_t *snapshot)
+{
+  for (int i = 1; i < CRSF_RC_CHANNELS; i++)
+  {
+    if (snapshot->channels[i] != snapshot->channels[0])
+    {
+      return false;
+    }
+  }
+  // The writer sends value n & 0x7FF as its n-th frame
+  return snapshot->seq == 0 || snapshot->channels[0] == ((snapshot->seq - 1) & 0x7FF);
+}
+
+static crsf_t _snapshot_crsf;
+static uint32_t _snapshot_stop;
+
+static void *_snapshot_writer(void *arg)
+{
+  uint32_t *frames = arg;
+  uint8_t frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4];
+  for (uint32_t n = 0; !__atomic_load_n(&_snapshot_stop, __ATOMIC_RELAXED); n++)
+  {
+    bench_rc_frame(frame, n & 0x7FF);
+    crsf_ctx_parse(&_snapshot_crsf, frame, sizeof(frame));
+    *frames = n + 1;
+  }
+  return NULL;
+}
+
+typedef struct
+{
+  uint32_t reads;
+  uint32_t frames;
+  uint32_t failed;
+  uint32_t torn;
+} snapshot_contended_t;
+
+// Reads snapshots while another thread parses frames as fast as it can
+static void _snapshot_contended(snapshot_contended_t *result)
+{
+  crsf_init(&_snapshot_crsf, NULL);
+  _snapshot_stop = 0;
+  uint32_t frames = 0;
+  pthread_t writer;
+  pthread_create(&writer, NULL, _snapshot_writer, &frames);
+
+  uint32_t reads = 0;
+  uint32_t failed = 0;
+  uint32_t torn = 0;
+  crsf_snapshot_t snapshot;
+  const uint32_t start = bench_ticks();
+  uint64_t ticks = 0;
+  while (bench_seconds(ticks) < bench_target_seconds())
+  {
+    for (int i = 0; i < 1000; i++)
+    {
+      if (!crsf_ctx_get_latest(&_snapshot_crsf, &snapshot))
+      {
+        failed++;
+      }
+      else if (!_snapshot_consistent(&snapshot))
+      {
+        torn++;
+      }
+    }
+    reads += 1000;
+    ticks = bench_elapsed(start);
+  }
+  __atomic_store_n(&_snapshot_stop, 1, __ATOMIC_RELAXED);
+  pthread_join(writer, NULL);
+  *result = (snapshot_contended_t){reads, frames, failed, torn};
+}
+
+// No read may return a snapshot that mixes two frames
+bool bench_check_snapshot(void)
+{
+  snapshot_contended_t result;
+  _snapshot_contended(&result);
+  if (result.torn > 0)
+  {
+    printf("snapshot   %lu torn of %lu reads\n", (unsigned long)result.torn, (unsigned long)result.reads);
+  }
+  return result.torn == 0;
+}
+#endif
+
+void bench_snapshot(void)
+{
+  static crsf_t crsf;
+  crsf_init(&crsf, NULL);
+  uint8_t frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4];
+  bench_rc_frame(frame, 0);
+  crsf_ctx_parse(&crsf, frame, sizeof(frame));
+
+  uint64_t ticks = 0;
+  uint32_t reads = 0;
+  crsf_snapshot_t snapshot;
+  volatile uint32_t sink = 0;
+  while (bench_seconds(ticks) < bench_target_seconds() / 4)
+  {
+    const uint32_t start = bench_ticks();
+    for (int i = 0; i < 1000; i++)
+    {
+      crsf_ctx_get_latest(&crsf, &snapshot);
+      sink += snapshot.seq;
+    }
+    ticks += bench_elapsed(start);
+    reads += 1000;
+  }
+  (void)sink;
+  printf("snapshot   %8.2f %s/read\n", (double)ticks / reads, BENCH_TICK_UNIT);
+#if !BENCH_CYCLES
+  snapshot_contended_t result;
+  _snapshot_contended(&result);
+  printf("snapshot   contended %lu reads against %lu frames, %lu gave up, %lu torn\n", (unsigned long)result.reads,
+         (unsigned long)result.frames, (unsigned long)result.failed, (unsigned long)result.torn);
+#endif
+}
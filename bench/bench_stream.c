@@ -0,0 +1,206 @@
+/**
+ * @file bench_stream.c
+ * @author Britannio Jarrett
+ * @brief Synthetic CRSF byte streams for the benchmark harness.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+
+#include "bench.h"
+#include "crsf.h"
+#include <string.h>
+
+#define MAX_FRAME_SIZE 64
+#define RC_PAYLOAD_SIZE 22
+#define LINK_STATS_PAYLOAD_SIZE 10
+
+uint8_t bench_stream_data[BENCH_STREAM_CAPACITY];
+
+// xorshift32, deterministic for a given seed on every target
+uint32_t bench_random(uint32_t *state)
+{
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+static bool _chance(uint32_t *state, double probability)
+{
+  return probability > 0 && bench_random(state) < probability * 4294967296.0;
+}
+
+void bench_stream_default_config(bench_stream_config_t *config)
+{
+  config->rc_rate_hz = 500;
+  config->link_stats_rate_hz = 10;
+  config->duration_ms = 200;
+  config->bit_error_rate = 0;
+  config->byte_drop_rate = 0;
+  config->garbage_rate = 0;
+  config->garbage_max_len = 16;
+  config->seed = 0x12345678;
+  config->omit_corrupted = false;
+}
+
+// Little-endian 11-bit packing, as on the wire
+static void _pack_channels(const uint16_t channels[16], uint8_t *out)
+{
+  memset(out, 0, RC_PAYLOAD_SIZE);
+  for (int i = 0; i < 16; i++)
+  {
+    const uint32_t bit = i * 11;
+    const uint32_t value = (uint32_t)(channels[i] & 0x7FF) << (bit % 8);
+    out[bit / 8] |= value;
+    out[bit / 8 + 1] |= value >> 8;
+    if (bit / 8 + 2 < RC_PAYLOAD_SIZE)
+    {
+      out[bit / 8 + 2] |= value >> 16;
+    }
+  }
+}
+
+static size_t _write_frame(uint8_t *out, uint8_t type, const uint8_t *payload, uint8_t payload_len)
+{
+  out[0] = 0xC8;
+  out[1] = payload_len + 2;
+  out[2] = type;
+  memcpy(out + 3, payload, payload_len);
+  out[3 + payload_len] = crsf_crc8(out + 2, payload_len + 1);
+  return payload_len + 4;
+}
+
+/**
+ * Fills `stream` with RC frames at the configured rate, link statistics
+ * interleaved at their own rate, garbage between frames and channel errors.
+ * Generation stops early if the buffer fills up.
+ */
+void bench_stream_generate(bench_stream_t *stream, const bench_stream_config_t *config)
+{
+  uint32_t rng = config->seed ? config->seed : 1;
+  // The channel errors draw from their own sequence, so that the garbage and the
+  // frames are the same whatever the error rates
+  uint32_t noise_rng = rng ^ 0x5A5A5A5A ? rng ^ 0x5A5A5A5A : 1;
+  uint16_t channels[16];
+  for (int i = 0; i < 16; i++)
+  {
+    channels[i] = 992;
+  }
+
+  stream->len = 0;
+  stream->frames = 0;
+  stream->corrupted_frames = 0;
+
+  const uint32_t rc_frames = config->rc_rate_hz * config->duration_ms / 1000;
+  const uint32_t link_every = config->link_stats_rate_hz ? config->rc_rate_hz / config->link_stats_rate_hz : 0;
+  for (uint32_t n = 0; n < rc_frames; n++)
+  {
+    // Garbage, an optional link statistics frame and the RC frame
+    uint8_t frame[255 + 2 * MAX_FRAME_SIZE];
+    size_t len = 0;
+    uint32_t frames = 0;
+
+    size_t garbage = 0;
+    if (_chance(&rng, config->garbage_rate) && config->garbage_max_len > 0)
+    {
+      garbage = 1 + bench_random(&rng) % config->garbage_max_len;
+      for (size_t i = 0; i < garbage; i++)
+      {
+        frame[len++] = bench_random(&rng);
+      }
+    }
+
+    uint8_t payload[RC_PAYLOAD_SIZE];
+    if (link_every && n % link_every == link_every - 1)
+    {
+      for (int i = 0; i < LINK_STATS_PAYLOAD_SIZE; i++)
+      {
+        payload[i] = bench_random(&rng) % 100;
+      }
+      len += _write_frame(frame + len, CRSF_FRAMETYPE_LINK_STATISTICS, payload, LINK_STATS_PAYLOAD_SIZE);
+      frames++;
+    }
+
+    // Sticks drift by a few ticks per frame
+    for (int i = 0; i < 16; i++)
+    {
+      const int step = (int)(bench_random(&rng) % 9) - 4;
+      const int value = channels[i] + step;
+      channels[i] = value < 172 ? 172 : value > 1811 ? 1811 : value;
+    }
+    _pack_channels(channels, payload);
+    len += _write_frame(frame + len, CRSF_FRAMETYPE_RC_CHANNELS_PACKED, payload, RC_PAYLOAD_SIZE);
+    frames++;
+
+    // Only errors in the frames themselves count as corruption
+    bool corrupted = false;
+    size_t out = 0;
+    size_t garbage_out = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+      if (_chance(&noise_rng, config->byte_drop_rate))
+      {
+        corrupted |= i >= garbage;
+        continue;
+      }
+      uint8_t byte = frame[i];
+      if (config->bit_error_rate > 0)
+      {
+        for (int bit = 0; bit < 8; bit++)
+        {
+          if (_chance(&noise_rng, config->bit_error_rate))
+          {
+            byte ^= 1 << bit;
+            corrupted |= i >= garbage;
+          }
+        }
+      }
+      frame[out++] = byte;
+      garbage_out += i < garbage;
+    }
+    const bool omitted = corrupted && config->omit_corrupted;
+    if (omitted)
+    {
+      out = garbage_out;
+    }
+    if (stream->len + out > stream->capacity)
+    {
+      return;
+    }
+    memcpy(stream->data + stream->len, frame, out);
+    stream->len += out;
+    if (!omitted)
+    {
+      stream->frames += frames;
+      stream->corrupted_frames += corrupted;
+    }
+  }
+}
+
+void bench_rc_frame(uint8_t frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4], uint16_t value)
+{
+  uint16_t channels[CRSF_RC_CHANNELS];
+  for (int i = 0; i < CRSF_RC_CHANNELS; i++)
+  {
+    channels[i] = value;
+  }
+  frame[0] = 0xC8;
+  frame[1] = CRSF_RC_CHANNELS_PAYLOAD_SIZE + 2;
+  frame[2] = CRSF_FRAMETYPE_RC_CHANNELS_PACKED;
+  crsf_pack_channels(channels, frame + 3);
+  frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 3] = crsf_crc8(frame + 2, CRSF_RC_CHANNELS_PAYLOAD_SIZE + 1);
+}
+
+void bench_put_frame(uint8_t *data, size_t *len, uint8_t type, const uint8_t *payload, uint8_t length)
+{
+  *len += _write_frame(data + *len, type, payload, length);
+}
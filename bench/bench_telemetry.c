@@ -0,0 +1,108 @@
+/**
+ * @file bench_telemetry.c
+ * @author Britannio Jarrett
+ * @brief Slot-aware telemetry sending and the telemetry scheduler, in virtual time.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+
+/**
+ * Feeds `seconds` of RC frames at `rate_hz` and `baud_rate`, each processed up to
+ * 50 us after its last byte. Every telemetry type is scheduled at `rates[i]` Hz
+ * with `priorities[i]` and set again after every frame.
+ */
+static void _run_slot_link(crsf_t *crsf, uint32_t rate_hz, uint32_t baud_rate, uint32_t seconds, uint8_t ratio,
+                           const uint16_t rates[CRSF_TELEMETRY_FRAME_TYPES], const uint8_t priorities[CRSF_TELEMETRY_FRAME_TYPES])
+{
+  static bench_link_t link;
+  static crsf_transport_t transport;
+  bench_link_init(&link);
+  bench_link_transport(&transport, &link);
+  bench_now_us = 0;
+  crsf_init(crsf, &transport);
+  crsf_ctx_set_baud_rate(crsf, baud_rate);
+  crsf_ctx_telem_set_ratio(crsf, ratio);
+  for (uint8_t i = 0; i < CRSF_TELEMETRY_FRAME_TYPES; i++)
+  {
+    crsf_ctx_telem_set_schedule(crsf, i, rates[i], priorities[i]);
+  }
+
+  uint8_t frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4];
+  bench_rc_frame(frame, 992);
+  uint8_t custom[32] = {0};
+  const uint32_t frame_us = (sizeof(frame) * 10 * 1000000 + baud_rate - 1) / baud_rate;
+  const uint32_t period_us = 1000000 / rate_hz;
+  uint32_t rng = 11;
+  for (uint32_t n = 1; n <= rate_hz * seconds; n++)
+  {
+    bench_now_us = (uint64_t)n * period_us + frame_us + bench_random(&rng) % 50;
+    bench_link_push(&link, frame, sizeof(frame));
+    crsf_ctx_process_frames(crsf);
+    custom[0] = n;
+    crsf_ctx_telem_set_custom_payload(crsf, custom, sizeof(custom));
+    crsf_ctx_telem_set_battery_data(crsf, 168, 50, 1200 + n, 80);
+  }
+}
+
+/**
+ * One second at `rate_hz` with both telemetry types sent whenever they are set.
+ * Slot-aware sending should defer what does not fit and never collide.
+ */
+static void _bench_telem_slots(uint32_t rate_hz, uint32_t baud_rate)
+{
+  static crsf_t crsf;
+  static const uint16_t rates[CRSF_TELEMETRY_FRAME_TYPES] = {0};
+  static const uint8_t priorities[CRSF_TELEMETRY_FRAME_TYPES] = {0};
+  _run_slot_link(&crsf, rate_hz, baud_rate, 1, 1, rates, priorities);
+
+  crsf_telem_stats_t stats;
+  crsf_ctx_get_telem_stats(&crsf, &stats);
+  printf("telemetry slots @ %4lu Hz %7lu baud  %5lu sent %5lu deferred %5lu oversized %5lu collisions\n",
+         (unsigned long)rate_hz, (unsigned long)baud_rate, (unsigned long)stats.sent, (unsigned long)stats.deferred,
+         (unsigned long)stats.oversized, (unsigned long)stats.collisions);
+}
+
+/**
+ * Ten seconds at 500 Hz with a 1:8 telemetry ratio, battery scheduled at 1 Hz
+ * and the custom payload at 10 Hz with a higher priority.
+ */
+static void _bench_telem_scheduler(void)
+{
+  static crsf_t crsf;
+  static const uint16_t rates[CRSF_TELEMETRY_FRAME_TYPES] = {[CRSF_BATTERY_INDEX] = 1, [CRSF_CUSTOM_PAYLOAD_INDEX] = 10};
+  static const uint8_t priorities[CRSF_TELEMETRY_FRAME_TYPES] = {[CRSF_BATTERY_INDEX] = 1, [CRSF_CUSTOM_PAYLOAD_INDEX] = 2};
+  static const char *names[CRSF_TELEMETRY_FRAME_TYPES] = {[CRSF_BATTERY_INDEX] = "battery", [CRSF_CUSTOM_PAYLOAD_INDEX] = "custom"};
+  _run_slot_link(&crsf, 500, CRSF_BAUD_RATE_DEFAULT, 10, 8, rates, priorities);
+
+  crsf_telem_stats_t stats;
+  crsf_ctx_get_telem_stats(&crsf, &stats);
+  printf("telemetry scheduler @ 500 Hz, 1:8  %lu sent in %u slots\n", (unsigned long)stats.sent, 500 * 10 / 8);
+  for (uint8_t i = 0; i < CRSF_TELEMETRY_FRAME_TYPES; i++)
+  {
+    crsf_telem_type_stats_t type_stats;
+    crsf_ctx_get_telem_type_stats(&crsf, i, &type_stats);
+    printf("  %-8s target %3u Hz achieved %6.2f Hz  latency avg %6lu max %6lu us\n",
+           names[i], rates[i], type_stats.achieved_hz,
+           (unsigned long)type_stats.latency_avg_us, (unsigned long)type_stats.latency_max_us);
+  }
+}
+
+void bench_telemetry(void)
+{
+  _bench_telem_slots(150, CRSF_BAUD_RATE_DEFAULT);
+  _bench_telem_slots(500, CRSF_BAUD_RATE_DEFAULT);
+  for (int i = 0; i < CRSF_BAUD_RATE_COUNT; i++)
+  {
+    _bench_telem_slots(1000, crsf_baud_rates[i]);
+  }
+  _bench_telem_scheduler();
+}
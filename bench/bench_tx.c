@@ -0,0 +1,259 @@
+/**
+ * @file bench_tx.c
+ * @author Britannio Jarrett
+ * @brief TX-side RC frame generator: locking onto a module's timing, and sending from the alarm.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ */
+
+#include "bench.h"
+#include "crsf_tx.h"
+#include <stdio.h>
+
+#if !BENCH_CYCLES
+#include <sched.h>
+#endif
+
+#if BENCH_TX
+// A TX module in virtual time. Its RF clock runs `ppm` parts per million slow
+// against ours, and it wants each RC frame to arrive TX_ADVANCE_US before the
+// RF tick that sends it.
+#define TX_ADVANCE_US 500
+#define TX_SECONDS 5
+// RF ticks between timing corrections, and between link statistics frames
+#define TX_SYNC_TICKS 20
+#define TX_LINK_STATS_TICKS 100
+#define TX_LINK_QUALITY 97
+// How far the reported trim may be from the module's clock error once locked
+#define TX_TRIM_TOLERANCE_PPM 25
+
+// When the latest RC frame finished arriving at the module, and when the one
+// on the wire will have, in tenths of a microsecond
+typedef struct
+{
+  uint64_t arrival;
+  uint64_t arriving;
+} tx_wire_t;
+
+static void _tx_on_write(bench_link_t *link, const uint8_t *buf, size_t len)
+{
+  tx_wire_t *wire = link->user;
+  (void)buf;
+  wire->arrival = wire->arriving;
+  wire->arriving = bench_now_us * 10 + (uint64_t)len * 10 * 10000000 / CRSF_BAUD_RATE_DEFAULT;
+}
+
+// Queues a frame from the module, which addresses it to the handset
+static void _tx_module_frame(bench_link_t *link, frame_type_t type, const crsf_frame_payload_t *payload)
+{
+  uint8_t frame[CRSF_MAX_FRAME_SIZE];
+  const uint8_t length = crsf_frame_codecs[type].encode(payload, &frame[3]);
+  frame[0] = CRSF_ADDRESS_RADIO_TRANSMITTER;
+  frame[1] = length + 2;
+  frame[2] = type;
+  frame[length + 3] = crsf_crc8(&frame[2], length + 1);
+  bench_link_push(link, frame, length + 4);
+}
+
+typedef struct
+{
+  crsf_tx_stats_t stats;
+  uint64_t locked_us;
+  uint8_t link_quality;
+} tx_lock_t;
+
+/**
+ * Runs TX_SECONDS at `rate_hz` against a module whose clock is `ppm` off, each
+ * poll `latency_max_us` late at most, and records how long the generator took
+ * to lock and the phase error after that.
+ */
+static void _tx_lock_run(uint16_t rate_hz, int32_t ppm, uint32_t latency_max_us, tx_lock_t *result)
+{
+  static crsf_t crsf;
+  static crsf_tx_t tx;
+  static bench_link_t link;
+  static crsf_transport_t transport;
+  static tx_wire_t wire;
+  bench_link_init(&link);
+  link.on_write = _tx_on_write;
+  link.user = &wire;
+  wire = (tx_wire_t){0, 0};
+  bench_link_transport(&transport, &link);
+  bench_now_us = 1000;
+  crsf_init(&crsf, &transport);
+  crsf_tx_init(&tx, &crsf, rate_hz);
+
+  const uint64_t interval = 10000000 / rate_hz;
+  // The RF clock's period in our tenths of a microsecond, times 10^6, starting out of phase
+  const uint64_t rf_period = interval * (1000000 + ppm);
+  uint64_t rf_tick = (uint64_t)(bench_now_us * 10 + interval / 3) * 1000000;
+  uint32_t ticks = 0;
+  uint32_t rng = 3;
+  uint32_t latency_us = 0;
+  uint32_t sent = 0;
+  uint64_t locked_us = 0;
+  const uint64_t end_us = bench_now_us + TX_SECONDS * 1000000;
+  for (;;)
+  {
+    const uint64_t send_us = crsf_tx_next_send_us(&tx) + latency_us;
+    const uint64_t tick_us = (rf_tick / 1000000 + 9) / 10;
+    bench_now_us = send_us < tick_us ? send_us : tick_us;
+    if (bench_now_us > end_us)
+    {
+      break;
+    }
+    while ((rf_tick / 1000000 + 9) / 10 <= bench_now_us)
+    {
+      ticks++;
+      if (wire.arriving <= rf_tick / 1000000)
+      {
+        wire.arrival = wire.arriving;
+      }
+      if (ticks % TX_SYNC_TICKS == 0)
+      {
+        const crsf_payload_radio_id_t radio_id = {
+            .destination = CRSF_ADDRESS_RADIO_TRANSMITTER,
+            .origin = CRSF_ADDRESS_CRSF_TRANSMITTER,
+            .subtype = CRSF_RADIO_ID_TIMING_CORRECTION,
+            .interval = interval,
+            .offset = (int32_t)((int64_t)(rf_tick / 1000000) - (int64_t)wire.arrival - TX_ADVANCE_US * 10),
+        };
+        _tx_module_frame(&link, CRSF_FRAMETYPE_RADIO_ID, (const crsf_frame_payload_t *)&radio_id);
+      }
+      if (ticks % TX_LINK_STATS_TICKS == 0)
+      {
+        const crsf_payload_link_statistics_t link_statistics = {.uplink_package_success_rate = TX_LINK_QUALITY};
+        _tx_module_frame(&link, CRSF_FRAMETYPE_LINK_STATISTICS, (const crsf_frame_payload_t *)&link_statistics);
+      }
+      rf_tick += rf_period;
+    }
+    crsf_tx_poll(&tx);
+    crsf_tx_stats_t stats;
+    crsf_tx_get_stats(&tx, &stats);
+    if (stats.frames_sent != sent)
+    {
+      sent = stats.frames_sent;
+      latency_us = latency_max_us > 0 ? bench_random(&rng) % (latency_max_us + 1) : 0;
+    }
+    if (locked_us == 0 && stats.locked)
+    {
+      locked_us = bench_now_us;
+    }
+  }
+
+  crsf_snapshot_t snapshot;
+  crsf_ctx_get_latest(&crsf, &snapshot);
+  crsf_tx_get_stats(&tx, &result->stats);
+  result->locked_us = locked_us;
+  result->link_quality = snapshot.link_statistics.link_quality;
+}
+
+static const struct
+{
+  uint16_t rate_hz;
+  int32_t ppm;
+  uint32_t latency_max_us;
+} _tx_lock_configs[] = {
+    {250, 0, 0},
+    {500, 200, 2},
+    {1000, -150, 2},
+};
+
+static uint64_t _tx_clock_us(void *ctx)
+{
+  (void)ctx;
+  return bench_time_us();
+}
+
+/**
+ * One second of frames sent from the alarm (the timer IRQ on the RP2040, a
+ * thread on the host) while the main loop polls, with how late each send was.
+ */
+static void _bench_tx_alarm(uint16_t rate_hz)
+{
+  static crsf_t crsf;
+  static crsf_tx_t tx;
+  static bench_link_t link;
+  static crsf_transport_t transport;
+  bench_link_init(&link);
+  bench_link_transport(&transport, &link);
+  // Sent for real, so on the wall clock
+  transport.time_us = _tx_clock_us;
+  crsf_init(&crsf, &transport);
+  crsf_tx_init(&tx, &crsf, rate_hz);
+  if (!crsf_tx_start(&tx))
+  {
+    printf("tx alarm   unavailable\n");
+    return;
+  }
+  uint16_t channels[CRSF_RC_CHANNELS] = {0};
+  const uint64_t end_us = _tx_clock_us(NULL) + 1000000;
+  while (_tx_clock_us(NULL) < end_us)
+  {
+    channels[0] = (channels[0] + 1) & 0x7FF;
+    crsf_tx_set_channels(&tx, channels);
+    crsf_tx_poll(&tx);
+#if !BENCH_CYCLES
+    // Leave the CPU to the alarm thread on a single-core host
+    sched_yield();
+#endif
+  }
+  crsf_tx_stop(&tx);
+  crsf_tx_stats_t stats;
+  crsf_tx_get_stats(&tx, &stats);
+  printf("tx alarm   %4u Hz  %lu frames, %lu missed  jitter avg %lu max %lu us\n", rate_hz,
+         (unsigned long)stats.frames_sent, (unsigned long)stats.frames_missed,
+         (unsigned long)stats.jitter_avg_us, (unsigned long)stats.jitter_max_us);
+}
+
+// Every generator locks onto its module without missing a frame, trims its
+// period by the module's clock error, and the module's link statistics get through
+bool bench_check_tx(void)
+{
+  bool ok = true;
+  for (size_t i = 0; i < sizeof(_tx_lock_configs) / sizeof(_tx_lock_configs[0]); i++)
+  {
+    tx_lock_t result;
+    _tx_lock_run(_tx_lock_configs[i].rate_hz, _tx_lock_configs[i].ppm, _tx_lock_configs[i].latency_max_us, &result);
+    const int32_t trim_error = result.stats.trim_ppm - _tx_lock_configs[i].ppm;
+    if (!result.stats.locked || result.stats.frames_missed > 0 || result.link_quality != TX_LINK_QUALITY ||
+        trim_error > TX_TRIM_TOLERANCE_PPM || trim_error < -TX_TRIM_TOLERANCE_PPM)
+    {
+      printf("tx lock    %u Hz %+ld ppm: locked %d, %lu missed, link quality %u, trim %+ld ppm\n",
+             _tx_lock_configs[i].rate_hz, (long)_tx_lock_configs[i].ppm, result.stats.locked,
+             (unsigned long)result.stats.frames_missed, result.link_quality, (long)result.stats.trim_ppm);
+      ok = false;
+    }
+  }
+
+  crsf_t crsf;
+  crsf_tx_t tx;
+  if (crsf_tx_init(&tx, &crsf, 0))
+  {
+    printf("tx init    a rate of 0 Hz was accepted\n");
+    ok = false;
+  }
+  return ok;
+}
+
+void bench_tx(void)
+{
+  for (size_t i = 0; i < sizeof(_tx_lock_configs) / sizeof(_tx_lock_configs[0]); i++)
+  {
+    tx_lock_t result;
+    _tx_lock_run(_tx_lock_configs[i].rate_hz, _tx_lock_configs[i].ppm, _tx_lock_configs[i].latency_max_us, &result);
+    const crsf_tx_stats_t *stats = &result.stats;
+    printf("tx lock    %4u Hz %+4ld ppm  locked in %4lu ms  phase error avg %5.1f max %5.1f us  trim %+6ld ppm  jitter max %lu us\n",
+           _tx_lock_configs[i].rate_hz, (long)_tx_lock_configs[i].ppm,
+           (unsigned long)(result.locked_us > 0 ? (result.locked_us - 1000) / 1000 : 0), stats->phase_error_avg / 10.0,
+           stats->phase_error_max / 10.0, (long)stats->trim_ppm, (unsigned long)stats->jitter_max_us);
+  }
+  _bench_tx_alarm(500);
+}
+#endif
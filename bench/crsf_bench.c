@@ -0,0 +1,166 @@
+/**
+ * @file crsf_bench.c
+ * @author Britannio Jarrett
+ * @brief Entry point of the benchmark harness; the suites live in bench_*.c, one per feature.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Usage (host): crsf_bench [--rate HZ] [--ber P] [--drop P] [--garbage P] [--ms N] [--seed N]
+ *                          [--save-capture FILE] [--capture FILE]
+ * Without --rate the parser suite is swept over 50, 150, 250, 500 and 1000 Hz.
+ * --save-capture writes the noisy stream as a capture file instead of running the suites,
+ * and --capture times the parser over a capture file (see crsf_capture.h) instead.
+ * On the RP2040 the sweep runs at boot and the results are printed over USB.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if BENCH_CYCLES
+#include "pico/stdlib.h"
+#endif
+
+static void _run(const bench_stream_config_t *config, bool sweep)
+{
+  static const uint32_t rates[] = {50, 150, 250, 500, 1000};
+  if (sweep)
+  {
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+    {
+      bench_stream_config_t rate_config = *config;
+      rate_config.rc_rate_hz = rates[i];
+      bench_parser(&rate_config);
+    }
+  }
+  else
+  {
+    bench_parser(config);
+  }
+  bench_crc();
+  bench_channels();
+  bench_condition();
+  bench_encoder();
+#if BENCH_RC_CHANGES
+  bench_rc_changes();
+#endif
+  bench_telemetry();
+#if BENCH_FRAGMENT
+  bench_fragment();
+#endif
+#if BENCH_TX
+  bench_tx();
+#endif
+#if BENCH_BAUD_RATE
+  bench_baud_rate();
+#endif
+  bench_snapshot();
+  bench_router();
+#if BENCH_DIVERSITY
+  bench_diversity();
+#endif
+  bench_cpp();
+#if !BENCH_CYCLES
+  bench_failsafe();
+#if BENCH_PIPELINE
+  bench_pipeline();
+#endif
+  bench_router_latency();
+#endif
+}
+
+int main(int argc, char **argv)
+{
+  bench_stream_config_t config;
+  bench_stream_default_config(&config);
+  config.duration_ms = 1000;
+  config.bit_error_rate = 1e-4;
+  config.byte_drop_rate = 5e-4;
+  config.garbage_rate = 0.05;
+  bool sweep = true;
+#if !BENCH_CYCLES
+  const char *save_capture = NULL;
+  const char *capture = NULL;
+#endif
+
+#if BENCH_CYCLES
+  (void)argc;
+  (void)argv;
+  stdio_init_all();
+  // Give the USB host time to open the port
+  sleep_ms(3000);
+#else
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    const char *opt = argv[i];
+    const char *val = argv[i + 1];
+    if (strcmp(opt, "--rate") == 0)
+    {
+      config.rc_rate_hz = strtoul(val, NULL, 0);
+      sweep = false;
+    }
+    else if (strcmp(opt, "--ber") == 0)
+    {
+      config.bit_error_rate = strtod(val, NULL);
+    }
+    else if (strcmp(opt, "--drop") == 0)
+    {
+      config.byte_drop_rate = strtod(val, NULL);
+    }
+    else if (strcmp(opt, "--garbage") == 0)
+    {
+      config.garbage_rate = strtod(val, NULL);
+    }
+    else if (strcmp(opt, "--ms") == 0)
+    {
+      config.duration_ms = strtoul(val, NULL, 0);
+    }
+    else if (strcmp(opt, "--seed") == 0)
+    {
+      config.seed = strtoul(val, NULL, 0);
+    }
+    else if (strcmp(opt, "--save-capture") == 0)
+    {
+      save_capture = val;
+    }
+    else if (strcmp(opt, "--capture") == 0)
+    {
+      capture = val;
+    }
+    else
+    {
+      fprintf(stderr, "unknown option %s\n", opt);
+      return EXIT_FAILURE;
+    }
+  }
+#endif
+
+  bench_init();
+#if !BENCH_CYCLES
+  if (save_capture != NULL)
+  {
+    return bench_save_capture(save_capture, &config) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  if (capture != NULL)
+  {
+    return bench_capture_file(capture) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+#endif
+  printf("stream: ber %g, drop %g, garbage %g\n", config.bit_error_rate, config.byte_drop_rate, config.garbage_rate);
+  _run(&config, sweep);
+
+#if BENCH_CYCLES
+  for (;;)
+  {
+    tight_loop_contents();
+  }
+#endif
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file crsf_check.c
+ * @author Britannio Jarrett
+ * @brief Entry point of the correctness checks that sit next to the benchmark suites.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Usage (host): crsf_check
+ * Runs every check and exits non-zero if any failed; registered with CTest.
+ * On the RP2040 the checks run at boot and the results are printed over USB.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if BENCH_CYCLES
+#include "pico/stdlib.h"
+#endif
+
+static const struct
+{
+  const char *name;
+  bool (*check)(void);
+} _checks[] = {
+    {"crc", bench_check_crc},
+    {"channels", bench_check_channels},
+    {"condition", bench_check_condition},
+#if BENCH_RC_CHANGES
+    {"rc_changes", bench_check_rc_changes},
+#endif
+#if BENCH_FRAGMENT
+    {"fragment", bench_check_fragment},
+#endif
+#if BENCH_TX
+    {"tx", bench_check_tx},
+#endif
+#if BENCH_BAUD_RATE
+    {"baud_rate", bench_check_baud_rate},
+#endif
+    {"capture", bench_check_capture},
+#if BENCH_ROUTER_CHECK
+    {"router", bench_check_router},
+#endif
+#if BENCH_DIVERSITY
+    {"diversity", bench_check_diversity},
+#endif
+    {"cpp", bench_check_cpp},
+#if !BENCH_CYCLES
+    {"failsafe", bench_check_failsafe},
+#if BENCH_PIPELINE
+    {"pipeline", bench_check_pipeline},
+#endif
+    {"snapshot", bench_check_snapshot},
+    {"ring", bench_check_ring},
+    {"linux_write", bench_check_linux_write},
+#endif
+};
+
+int main(void)
+{
+#if BENCH_CYCLES
+  stdio_init_all();
+  // Give the USB host time to open the port
+  sleep_ms(3000);
+#endif
+  bench_init();
+  size_t failed = 0;
+  for (size_t i = 0; i < sizeof(_checks) / sizeof(_checks[0]); i++)
+  {
+    const bool ok = _checks[i].check();
+    printf("%-12s %s\n", _checks[i].name, ok ? "ok" : "FAILED");
+    failed += !ok;
+  }
+  printf("%lu of %lu checks failed\n", (unsigned long)failed, (unsigned long)(sizeof(_checks) / sizeof(_checks[0])));
+
+#if BENCH_CYCLES
+  for (;;)
+  {
+    tight_loop_contents();
+  }
+#endif
+  return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -14,15 +14,13 @@
  */
 
 #include "crsf.h"
-#include <hardware/uart.h>
-#include <hardware/gpio.h>
+#if !CRSF_HOST
+#include "crsf_transport_pico.h"
+#endif
 #include <stdlib.h>
 #include <string.h>
 
-#define BAUD_RATE 420000
 #define CRSF_MAX_CHANNELS 16
-#define CRSF_MAX_FRAME_SIZE 64
-#define CRSF_DEBUG 0
 #if CRSF_DEBUG
 #include <stdio.h>
 #define DEBUG_WARN(...) fprintf(stderr, __VA_ARGS__)
@@ -31,37 +29,252 @@
 #define DEBUG_WARN(...)
 #define DEBUG_INFO(...)
 #endif
+// Instrumentation statements, compiled out unless CRSF_STATS is set
+#if CRSF_STATS
+#define STATS(...) __VA_ARGS__
+#if CRSF_HOST
+#include <time.h>
+#endif
+#else
+#define STATS(...)
+#endif
+
+#define CRSF_DEFAULT_LINK_QUALITY_THRESHOLD 70
+#define CRSF_DEFAULT_RSSI_THRESHOLD 105
+// General command and its baud rate sub-commands, see crsf_ctx_propose_baud_rate()
+#define CRSF_COMMAND_GENERAL 0x0A
+#define CRSF_COMMAND_SPEED_PROPOSAL 0x70
+#define CRSF_COMMAND_SPEED_RESPONSE 0x71
+// Slowest RC packet rate autodetection waits for at each candidate, 50 Hz
+#define CRSF_AUTOBAUD_FRAME_INTERVAL_US 20000
+// Attempts crsf_ctx_get_latest() makes before giving up on a writer that does not finish
+#define CRSF_SNAPSHOT_RETRIES 256
+// Gaps between RC frames longer than this are link outages, not the packet rate
+#define CRSF_MAX_RC_INTERVAL_US 100000
+// Idle time kept between the end of a telemetry frame and the next RC frame
+#define CRSF_TELEM_GUARD_BYTES 2
+
+#if CRSF_TELEMETRY
+// Battery once a second, custom payloads whenever they are set and ahead of everything else
+#define CRSF_TELEM_SCHEDULE_DEFAULTS                             \
+  {                                                              \
+    [CRSF_BATTERY_INDEX] = {.rate_hz = 1, .priority = 1},        \
+    [CRSF_CUSTOM_PAYLOAD_INDEX] = {.rate_hz = 0, .priority = 2}, \
+  }
+static const crsf_telem_schedule_t _telem_schedule_defaults[CRSF_TELEMETRY_FRAME_TYPES] = CRSF_TELEM_SCHEDULE_DEFAULTS;
+
+// Telemetry frames start out with their sync, length and type bytes in place;
+// the setters only ever touch the payload and the CRC
+#define CRSF_TELEM_FRAME_DEFAULTS                                                          \
+  {                                                                                        \
+    [CRSF_BATTERY_INDEX] = {                                                               \
+        .data = {CRSF_SYNC_BYTE, CRSF_BATTERY_SENSOR_PAYLOAD_SIZE + 2, CRSF_FRAMETYPE_BATTERY_SENSOR}, \
+        .length = CRSF_BATTERY_SENSOR_PAYLOAD_SIZE + 4,                                    \
+        .crc_stale = true,                                                                 \
+    },                                                                                     \
+    [CRSF_CUSTOM_PAYLOAD_INDEX] = {                                                        \
+        .data = {CRSF_SYNC_BYTE, 2, CRSF_FRAMETYPE_CUSTOM_PAYLOAD},                        \
+        .length = 4,                                                                       \
+        .crc_stale = true,                                                                 \
+    },                                                                                     \
+  }
+static const crsf_telem_frame_t _telem_frame_defaults[CRSF_TELEMETRY_FRAME_TYPES] = CRSF_TELEM_FRAME_DEFAULTS;
+#endif
 
-uart_inst_t *_uart = NULL;
-uint8_t _incoming_frame[CRSF_MAX_FRAME_SIZE];
-uint16_t _rc_channels[CRSF_MAX_CHANNELS];
-link_statistics_t _link_statistics;
-bool _failsafe = true;
-uint8_t _link_quality_threshold = 70;
-uint8_t _rssi_threshold = 105;
+const uint32_t crsf_baud_rates[CRSF_BAUD_RATE_COUNT] = {420000, 921600, 1870000, 2250000, 3750000, 5250000};
+
+// Instance behind the crsf_* functions that take no handle
+crsf_t _crsf = {
+    .failsafe_flags = CRSF_FAILSAFE_LINK,
+    .failsafe_reported = true,
+    .link_quality_threshold = CRSF_DEFAULT_LINK_QUALITY_THRESHOLD,
+    .rssi_threshold = CRSF_DEFAULT_RSSI_THRESHOLD,
+    .baud_rate = CRSF_BAUD_RATE_DEFAULT,
+    .address = CRSF_ADDRESS_FLIGHT_CONTROLLER,
+    .baud_rate_max = CRSF_BAUD_RATE_DEFAULT,
+    .autobaud_index = -1,
+#if CRSF_CALLBACKS
+    .rc_keepalive_us = CRSF_RC_KEEPALIVE_US,
+#endif
+#if CRSF_TELEMETRY
+    .telem_schedule = CRSF_TELEM_SCHEDULE_DEFAULTS,
+    .telem_ratio = 1,
+    .telem_frames = CRSF_TELEM_FRAME_DEFAULTS,
+#endif
+};
+#if !CRSF_HOST
+// Backing the transport set up by crsf_begin()/crsf_begin_irq()
+crsf_pico_uart_t _pico_uart;
+crsf_transport_t _pico_uart_transport;
+bool _pico_uart_active = false;
+#endif
 
+#if CRSF_CALLBACKS
+// Callbacks registered through the handle-less API, called by the trampolines below
 void (*rc_channels_callback)(const uint16_t channels[]);
 void (*link_statistics_callback)(const link_statistics_t link_stats);
 void (*failsafe_callback)(const bool failsafe);
+void (*frame_callback)(frame_type_t type, const crsf_frame_payload_t *payload);
+void (*baud_rate_callback)(uint32_t baud_rate);
+void (*conditioned_channels_callback)(const int16_t channels[16]);
+void (*rc_changed_callback)(const uint16_t channels[16], uint16_t dirty);
 
-uint8_t _telem_buf_data[CRSF_MAX_FRAME_SIZE];
-buffer_t _telem_buf = {
-    .buffer = _telem_buf_data,
-    .capacity = CRSF_MAX_FRAME_SIZE,
-    .offset = 0,
-};
-telemetry_t _telemetry;
+void _on_rc_channels(crsf_t *crsf, const uint16_t channels[16])
+{
+  (void)crsf;
+  rc_channels_callback(channels);
+}
 
-enum
+void _on_link_statistics(crsf_t *crsf, const link_statistics_t link_stats)
 {
-  CRSF_BATTERY_INDEX = 0,
-  CRSF_CUSTOM_PAYLOAD_INDEX = 1,
-  // Add new frame types above
-  TELEMETRY_FRAME_TYPES
-};
+  (void)crsf;
+  link_statistics_callback(link_stats);
+}
+
+void _on_failsafe(crsf_t *crsf, const bool failsafe)
+{
+  (void)crsf;
+  failsafe_callback(failsafe);
+}
+
+void _on_frame(crsf_t *crsf, frame_type_t type, const crsf_frame_payload_t *payload)
+{
+  (void)crsf;
+  frame_callback(type, payload);
+}
+
+void _on_baud_rate(crsf_t *crsf, uint32_t baud_rate)
+{
+  (void)crsf;
+  baud_rate_callback(baud_rate);
+}
+
+void _on_conditioned_channels(crsf_t *crsf, const int16_t channels[16])
+{
+  (void)crsf;
+  conditioned_channels_callback(channels);
+}
+
+void _on_rc_channels_changed(crsf_t *crsf, const uint16_t channels[16], uint16_t dirty)
+{
+  (void)crsf;
+  rc_changed_callback(channels, dirty);
+}
+#endif
+
+/**
+ * Initializes a CRSF instance.
+ *
+ * Everything lives inside `crsf`, so it can be a static or a stack variable and
+ * several instances can run at once. Callbacks and thresholds are reset, so set
+ * them after this call.
+ *
+ * @param crsf The instance to initialize.
+ * @param transport The transport to read frames from and send telemetry to, or NULL when frames are
+ * only fed in through crsf_ctx_parse(). It must outlive the instance.
+ */
+void crsf_init(crsf_t *crsf, const crsf_transport_t *transport)
+{
+  memset(crsf, 0, sizeof(*crsf));
+  crsf->transport = transport;
+  crsf->failsafe_flags = CRSF_FAILSAFE_LINK;
+  crsf->failsafe_reported = true;
+  crsf->link_quality_threshold = CRSF_DEFAULT_LINK_QUALITY_THRESHOLD;
+  crsf->rssi_threshold = CRSF_DEFAULT_RSSI_THRESHOLD;
+  crsf->baud_rate = CRSF_BAUD_RATE_DEFAULT;
+  crsf->address = CRSF_ADDRESS_FLIGHT_CONTROLLER;
+  crsf->baud_rate_max = CRSF_BAUD_RATE_DEFAULT;
+  crsf->autobaud_index = -1;
+#if CRSF_CALLBACKS
+  crsf->rc_keepalive_us = CRSF_RC_KEEPALIVE_US;
+#endif
+#if CRSF_TELEMETRY
+  memcpy(crsf->telem_schedule, _telem_schedule_defaults, sizeof(crsf->telem_schedule));
+  crsf->telem_ratio = 1;
+  memcpy(crsf->telem_frames, _telem_frame_defaults, sizeof(crsf->telem_frames));
+#endif
+}
+
+/**
+ * Returns the instance used by the functions that do not take a crsf_t.
+ */
+crsf_t *crsf_default(void)
+{
+  return &_crsf;
+}
+
+#if CRSF_CALLBACKS
+/**
+ * Sets the callback function to be called when RC channels are received.
+ *
+ * @param crsf The instance.
+ * @param callback A function pointer to the callback function that takes an array of uint16_t channels as input.
+ */
+void crsf_ctx_set_on_rc_channels(crsf_t *crsf, void (*callback)(crsf_t *crsf, const uint16_t channels[16]))
+{
+  crsf->rc_channels_callback = callback;
+}
+
+/**
+ * Sets the callback function for link statistics.
+ *
+ * @param crsf The instance.
+ * @param callback A pointer to the callback function.
+ */
+void crsf_ctx_set_on_link_statistics(crsf_t *crsf, void (*callback)(crsf_t *crsf, const link_statistics_t link_stats))
+{
+  crsf->link_statistics_callback = callback;
+}
+
+/**
+ * Sets the callback function to be called when a failsafe event occurs.
+ *
+ * @param crsf The instance.
+ * @param callback A function pointer to the callback function that takes a boolean parameter indicating the failsafe status.
+ */
+void crsf_ctx_set_on_failsafe(crsf_t *crsf, void (*callback)(crsf_t *crsf, const bool failsafe))
+{
+  crsf->failsafe_callback = callback;
+}
+
+/**
+ * Sets the callback function to be called with every decoded frame.
+ *
+ * It receives all frame types in crsf_frame_codecs, RC channels and link
+ * statistics included, after the link state has been updated.
+ *
+ * @param crsf The instance.
+ * @param callback A function pointer to the callback function, called with the frame type and its decoded payload.
+ */
+void crsf_ctx_set_on_frame(crsf_t *crsf, void (*callback)(crsf_t *crsf, frame_type_t type, const crsf_frame_payload_t *payload))
+{
+  crsf->frame_callback = callback;
+}
+#endif
+
+/**
+ * Sets the link quality threshold below which the failsafe is triggered.
+ *
+ * @param crsf The instance.
+ * @param threshold The link quality threshold value, ranging from 0 to 100.
+ */
+void crsf_ctx_set_link_quality_threshold(crsf_t *crsf, uint8_t threshold)
+{
+  crsf->link_quality_threshold = threshold;
+}
 
-bool frameHasData[TELEMETRY_FRAME_TYPES] = {false};
+/**
+ * Sets the RSSI threshold above which the failsafe is triggered.
+ *
+ * @param crsf The instance.
+ * @param threshold The RSSI threshold value to set.
+ */
+void crsf_ctx_set_rssi_threshold(crsf_t *crsf, uint8_t threshold)
+{
+  crsf->rssi_threshold = threshold;
+}
 
+#if CRSF_CALLBACKS
 /**
  * Sets the callback function to be called when RC channels are received.
  *
@@ -70,6 +283,7 @@ bool frameHasData[TELEMETRY_FRAME_TYPES] = {false};
 void crsf_set_on_rc_channels(void (*callback)(const uint16_t channels[16]))
 {
   rc_channels_callback = callback;
+  crsf_ctx_set_on_rc_channels(&_crsf, callback != NULL ? _on_rc_channels : NULL);
 }
 
 /**
@@ -82,6 +296,7 @@ void crsf_set_on_rc_channels(void (*callback)(const uint16_t channels[16]))
 void crsf_set_on_link_statistics(void (*callback)(const link_statistics_t link_stats))
 {
   link_statistics_callback = callback;
+  crsf_ctx_set_on_link_statistics(&_crsf, callback != NULL ? _on_link_statistics : NULL);
 }
 
 /**
@@ -92,7 +307,20 @@ void crsf_set_on_link_statistics(void (*callback)(const link_statistics_t link_s
 void crsf_set_on_failsafe(void (*callback)(const bool failsafe))
 {
   failsafe_callback = callback;
+  crsf_ctx_set_on_failsafe(&_crsf, callback != NULL ? _on_failsafe : NULL);
+}
+
+/**
+ * Sets the callback function to be called with every decoded frame.
+ *
+ * @param callback A function pointer to the callback function, called with the frame type and its decoded payload.
+ */
+void crsf_set_on_frame(void (*callback)(frame_type_t type, const crsf_frame_payload_t *payload))
+{
+  frame_callback = callback;
+  crsf_ctx_set_on_frame(&_crsf, callback != NULL ? _on_frame : NULL);
 }
+#endif
 
 /**
  * Sets the link quality threshold for CRSF communication.
@@ -104,7 +332,7 @@ void crsf_set_on_failsafe(void (*callback)(const bool failsafe))
  */
 void crsf_set_link_quality_threshold(uint8_t threshold)
 {
-  _link_quality_threshold = threshold;
+  crsf_ctx_set_link_quality_threshold(&_crsf, threshold);
 }
 
 /**
@@ -114,56 +342,147 @@ void crsf_set_link_quality_threshold(uint8_t threshold)
  */
 void crsf_set_rssi_threshold(uint8_t threshold)
 {
-  _rssi_threshold = threshold;
+  crsf_ctx_set_rssi_threshold(&_crsf, threshold);
+}
+
+/**
+ * Starts CRSF communication over any transport.
+ *
+ * Unlike crsf_init(), callbacks and thresholds set beforehand are kept.
+ *
+ * @param transport The transport to read frames from and send telemetry to. It must outlive the session.
+ */
+void crsf_begin_transport(const crsf_transport_t *transport)
+{
+  _crsf.transport = transport;
+  crsf_framer_reset(&_crsf.incoming);
 }
 
+#if !CRSF_HOST
 /**
  * Initializes the CRSF communication by setting up the UART and configuring the RX and TX pins.
  *
+ * The UART runs at the rate set with crsf_set_baud_rate(), 420000 by default.
+ *
  * @param uart The UART instance to be used for CRSF communication.
  * @param tx The TX pin number.
  * @param rx The RX pin number.
  */
 void crsf_begin(uart_inst_t *uart, uint8_t tx, uint8_t rx)
 {
-  // TODO support PIO UART
-  _uart = uart;
-  // set up the UART
-  uart_init(_uart, BAUD_RATE);
-  gpio_set_function(tx, GPIO_FUNC_UART);
-  gpio_set_function(rx, GPIO_FUNC_UART);
+  crsf_pico_uart_init(&_pico_uart, uart, tx, rx, _crsf.baud_rate, false);
+  // Falls back to blocking writes if every DMA channel is taken
+  crsf_pico_uart_enable_tx_dma(&_pico_uart);
+  crsf_pico_uart_transport(&_pico_uart_transport, &_pico_uart);
+  _pico_uart_active = true;
+  crsf_begin_transport(&_pico_uart_transport);
+}
+
+/**
+ * Initializes the CRSF communication with interrupt-driven reception.
+ *
+ * Incoming bytes are drained from the UART FIFO by an IRQ into a lock-free ring buffer,
+ * so crsf_process_frames() only parses what is already queued and returns immediately.
+ *
+ * @param uart The UART instance to be used for CRSF communication.
+ * @param tx The TX pin number.
+ * @param rx The RX pin number.
+ */
+void crsf_begin_irq(uart_inst_t *uart, uint8_t tx, uint8_t rx)
+{
+  crsf_pico_uart_init(&_pico_uart, uart, tx, rx, _crsf.baud_rate, true);
+  // Falls back to blocking writes if every DMA channel is taken
+  crsf_pico_uart_enable_tx_dma(&_pico_uart);
+  crsf_pico_uart_transport(&_pico_uart_transport, &_pico_uart);
+  _pico_uart_active = true;
+  crsf_begin_transport(&_pico_uart_transport);
 }
 
+/**
+ * @brief Returns the number of received bytes that were lost.
+ *
+ * This counts both bytes dropped because the RX ring buffer was full and
+ * hardware FIFO overruns. Only meaningful after crsf_begin_irq().
+ */
+uint32_t crsf_get_rx_overruns()
+{
+  return crsf_pico_uart_overruns(&_pico_uart);
+}
+#endif
+
 /**
  * @brief Ends the CRSF communication.
  *
  * This function deinitializes the UART used for CRSF communication.
+ * Other transports are only detached and remain owned by the caller.
  */
 void crsf_end()
 {
-  uart_deinit(_uart);
+#if !CRSF_HOST
+  if (_pico_uart_active)
+  {
+    crsf_pico_uart_deinit(&_pico_uart);
+    _pico_uart_active = false;
+  }
+#endif
+  crsf_ctx_set_failsafe_timeout_us(&_crsf, 0);
+  _crsf.transport = NULL;
+}
+
+// Returns false if the payload repeats the previous one, leaving the channels as they were
+bool _process_rc_channels(crsf_t *crsf, const crsf_payload_rc_channels_packed_t *payload)
+{
+  uint32_t words[CRSF_RC_PAYLOAD_WORDS] = {0};
+  memcpy(words, payload, CRSF_RC_CHANNELS_PAYLOAD_SIZE);
+  uint32_t difference = 0;
+  for (int i = 0; i < CRSF_RC_PAYLOAD_WORDS; i++)
+  {
+    difference |= words[i] ^ crsf->rc_payload_words[i];
+  }
+  const bool changed = difference != 0 || !crsf->rc_payload_valid;
+  if (changed)
+  {
+    memcpy(crsf->rc_payload_words, words, sizeof(words));
+    crsf->rc_payload_valid = true;
+    crsf_unpack_channels((const uint8_t *)words, crsf->rc_channels);
+  }
+  if (crsf->conditioner != NULL)
+  {
+    crsf_condition_apply(crsf->conditioner, crsf->rc_channels, crsf->conditioned_channels);
+  }
+  return changed;
 }
 
-void _process_rc_channels()
+#if CRSF_CALLBACKS && CRSF_FRAME_RC_CHANNELS_PACKED
+// Calls rc_changed_callback with the channels that moved past their threshold, or all of them when the keep-alive is due
+static void _dispatch_rc_changes(crsf_t *crsf, bool changed, uint64_t now_us)
 {
-  const crsf_payload_rc_channels_packed_t *payload = (const crsf_payload_rc_channels_packed_t *)&_incoming_frame[3];
-  _rc_channels[0] = payload->channel0;
-  _rc_channels[1] = payload->channel1;
-  _rc_channels[2] = payload->channel2;
-  _rc_channels[3] = payload->channel3;
-  _rc_channels[4] = payload->channel4;
-  _rc_channels[5] = payload->channel5;
-  _rc_channels[6] = payload->channel6;
-  _rc_channels[7] = payload->channel7;
-  _rc_channels[8] = payload->channel8;
-  _rc_channels[9] = payload->channel9;
-  _rc_channels[10] = payload->channel10;
-  _rc_channels[11] = payload->channel11;
-  _rc_channels[12] = payload->channel12;
-  _rc_channels[13] = payload->channel13;
-  _rc_channels[14] = payload->channel14;
-  _rc_channels[15] = payload->channel15;
+  uint16_t dirty = 0;
+  if (!crsf->rc_delivered_valid || (crsf->rc_keepalive_us != 0 && now_us - crsf->rc_delivered_us >= crsf->rc_keepalive_us))
+  {
+    dirty = CRSF_ALL_CHANNELS;
+    memcpy(crsf->rc_delivered, crsf->rc_channels, sizeof(crsf->rc_delivered));
+    crsf->rc_delivered_us = now_us;
+    crsf->rc_delivered_valid = true;
+  }
+  else if (changed)
+  {
+    // Selects rather than branches, as jitter makes the outcome unpredictable
+    for (int i = 0; i < CRSF_RC_CHANNELS; i++)
+    {
+      const int32_t delta = (int32_t)crsf->rc_channels[i] - crsf->rc_delivered[i];
+      const bool moved = (uint32_t)(delta < 0 ? -delta : delta) > crsf->rc_change_thresholds[i];
+      dirty |= moved << i;
+      crsf->rc_delivered[i] = moved ? crsf->rc_channels[i] : crsf->rc_delivered[i];
+    }
+  }
+  if (dirty == 0)
+  {
+    return;
+  }
+  crsf->rc_changed_callback(crsf, crsf->rc_channels, dirty);
 }
+#endif
 
 const uint16_t tx_power_table[9] = {
     0,    // 0 mW
@@ -177,323 +496,1472 @@ const uint16_t tx_power_table[9] = {
     50    // 50 mW
 };
 
-void _process_link_statistics()
+void _process_link_statistics(crsf_t *crsf, const crsf_payload_link_statistics_t *link_stats_payload)
 {
-  const crsf_payload_link_statistics_t *link_stats_payload = (const crsf_payload_link_statistics_t *)&_incoming_frame[3];
-  _link_statistics.rssi = (link_stats_payload->diversity_active_antenna ? link_stats_payload->uplink_rssi_ant_2
+  link_statistics_t *link_statistics = &crsf->link_statistics;
+  link_statistics->rssi = (link_stats_payload->diversity_active_antenna ? link_stats_payload->uplink_rssi_ant_2
                                                                         : link_stats_payload->uplink_rssi_ant_1);
-  _link_statistics.link_quality = link_stats_payload->uplink_package_success_rate;
-  _link_statistics.snr = link_stats_payload->uplink_snr;
-  _link_statistics.tx_power = (link_stats_payload->uplink_tx_power < 9)
+  link_statistics->link_quality = link_stats_payload->uplink_package_success_rate;
+  link_statistics->snr = link_stats_payload->uplink_snr;
+  link_statistics->tx_power = (link_stats_payload->uplink_tx_power < 9)
                                   ? tx_power_table[link_stats_payload->uplink_tx_power]
                                   : 0;
 }
 
-bool calculate_failsafe()
+bool calculate_failsafe(const crsf_t *crsf)
 {
-  return _link_statistics.link_quality <= _link_quality_threshold || _link_statistics.rssi >= _rssi_threshold;
+  return crsf->link_statistics.link_quality <= crsf->link_quality_threshold ||
+         crsf->link_statistics.rssi >= crsf->rssi_threshold;
 }
 
-uint8_t crsf_crc8(const uint8_t *ptr, uint8_t len)
+#if CRSF_TELEMETRY
+/**
+ * Whether a telemetry type is waiting to be sent at `now_us`, and since when.
+ *
+ * Rate-limited types become due one period after their last send (straight away
+ * for the first), the others as soon as they are set.
+ */
+static bool _telem_waiting(const crsf_telem_schedule_t *schedule, uint64_t now_us, uint64_t *since_us)
 {
-  static const uint8_t crsf_crc8tab[256] = {
-      0x00, 0xD5, 0x7F, 0xAA, 0xFE, 0x2B, 0x81, 0x54, 0x29, 0xFC, 0x56, 0x83, 0xD7, 0x02, 0xA8, 0x7D,
-      0x52, 0x87, 0x2D, 0xF8, 0xAC, 0x79, 0xD3, 0x06, 0x7B, 0xAE, 0x04, 0xD1, 0x85, 0x50, 0xFA, 0x2F,
-      0xA4, 0x71, 0xDB, 0x0E, 0x5A, 0x8F, 0x25, 0xF0, 0x8D, 0x58, 0xF2, 0x27, 0x73, 0xA6, 0x0C, 0xD9,
-      0xF6, 0x23, 0x89, 0x5C, 0x08, 0xDD, 0x77, 0xA2, 0xDF, 0x0A, 0xA0, 0x75, 0x21, 0xF4, 0x5E, 0x8B,
-      0x9D, 0x48, 0xE2, 0x37, 0x63, 0xB6, 0x1C, 0xC9, 0xB4, 0x61, 0xCB, 0x1E, 0x4A, 0x9F, 0x35, 0xE0,
-      0xCF, 0x1A, 0xB0, 0x65, 0x31, 0xE4, 0x4E, 0x9B, 0xE6, 0x33, 0x99, 0x4C, 0x18, 0xCD, 0x67, 0xB2,
-      0x39, 0xEC, 0x46, 0x93, 0xC7, 0x12, 0xB8, 0x6D, 0x10, 0xC5, 0x6F, 0xBA, 0xEE, 0x3B, 0x91, 0x44,
-      0x6B, 0xBE, 0x14, 0xC1, 0x95, 0x40, 0xEA, 0x3F, 0x42, 0x97, 0x3D, 0xE8, 0xBC, 0x69, 0xC3, 0x16,
-      0xEF, 0x3A, 0x90, 0x45, 0x11, 0xC4, 0x6E, 0xBB, 0xC6, 0x13, 0xB9, 0x6C, 0x38, 0xED, 0x47, 0x92,
-      0xBD, 0x68, 0xC2, 0x17, 0x43, 0x96, 0x3C, 0xE9, 0x94, 0x41, 0xEB, 0x3E, 0x6A, 0xBF, 0x15, 0xC0,
-      0x4B, 0x9E, 0x34, 0xE1, 0xB5, 0x60, 0xCA, 0x1F, 0x62, 0xB7, 0x1D, 0xC8, 0x9C, 0x49, 0xE3, 0x36,
-      0x19, 0xCC, 0x66, 0xB3, 0xE7, 0x32, 0x98, 0x4D, 0x30, 0xE5, 0x4F, 0x9A, 0xCE, 0x1B, 0xB1, 0x64,
-      0x72, 0xA7, 0x0D, 0xD8, 0x8C, 0x59, 0xF3, 0x26, 0x5B, 0x8E, 0x24, 0xF1, 0xA5, 0x70, 0xDA, 0x0F,
-      0x20, 0xF5, 0x5F, 0x8A, 0xDE, 0x0B, 0xA1, 0x74, 0x09, 0xDC, 0x76, 0xA3, 0xF7, 0x22, 0x88, 0x5D,
-      0xD6, 0x03, 0xA9, 0x7C, 0x28, 0xFD, 0x57, 0x82, 0xFF, 0x2A, 0x80, 0x55, 0x01, 0xD4, 0x7E, 0xAB,
-      0x84, 0x51, 0xFB, 0x2E, 0x7A, 0xAF, 0x05, 0xD0, 0xAD, 0x78, 0xD2, 0x07, 0x53, 0x86, 0x2C, 0xF9};
-
-  uint8_t crc = 0;
-  for (uint8_t i = 0; i < len; i++)
+  if (!schedule->has_data)
+  {
+    return false;
+  }
+  if (schedule->rate_hz == 0)
   {
-    crc = crsf_crc8tab[crc ^ *ptr++];
+    *since_us = schedule->dirty_us;
+    return schedule->dirty;
   }
-  return crc;
+  if (schedule->sent == 0)
+  {
+    *since_us = schedule->dirty_us;
+    return true;
+  }
+  const uint64_t due = schedule->last_sent_us + 1000000 / schedule->rate_hz;
+  *since_us = due;
+  return now_us >= due;
 }
 
-void buf_reset(buffer_t *buf)
+/**
+ * Picks the telemetry type to send next: the highest priority one that is
+ * waiting and no larger than `max_size`, the longest waiting on a tie.
+ *
+ * @param too_large Set if a waiting frame was skipped because it did not fit.
+ * @return The type index, or -1 if there is nothing to send.
+ */
+static int _telem_pick(const crsf_t *crsf, uint64_t now_us, size_t max_size, uint32_t *too_large, uint64_t *since_us)
 {
-  if (buf)
+  int best = -1;
+  *too_large = 0;
+  *since_us = 0;
+  for (int i = 0; i < CRSF_TELEMETRY_FRAME_TYPES; i++)
   {
-    buf->offset = 0;
+    const crsf_telem_schedule_t *schedule = &crsf->telem_schedule[i];
+    uint64_t since;
+    if (!_telem_waiting(schedule, now_us, &since))
+    {
+      continue;
+    }
+    if (crsf->telem_frames[i].length > max_size)
+    {
+      *too_large |= (uint32_t)1 << i;
+      continue;
+    }
+    if (best < 0 || schedule->priority > crsf->telem_schedule[best].priority ||
+        (schedule->priority == crsf->telem_schedule[best].priority && since < *since_us))
+    {
+      best = i;
+      *since_us = since;
+    }
   }
+  return best;
 }
 
-// Write an uint8_t to the buffer
-void buf_write_ui8(buffer_t *buf, uint8_t data)
+static void _telem_mark_sent(crsf_t *crsf, int index, uint64_t now_us, uint64_t since_us)
 {
-  if (buf && (buf->offset + sizeof(uint8_t) <= buf->capacity))
+  crsf_telem_schedule_t *schedule = &crsf->telem_schedule[index];
+  const uint32_t latency = now_us > since_us ? now_us - since_us : 0;
+  if (schedule->sent == 0)
   {
-    buf->buffer[buf->offset] = data;
-    buf->offset += sizeof(uint8_t);
+    schedule->first_sent_us = now_us;
+  }
+  schedule->dirty = false;
+  schedule->held = false;
+  schedule->last_sent_us = now_us;
+  schedule->sent++;
+  schedule->latency_sum_us += latency;
+  if (latency > schedule->latency_max_us)
+  {
+    schedule->latency_max_us = latency;
   }
 }
+#endif
 
-// Write an int8_t to the buffer
-void buf_write_i8(buffer_t *buf, int8_t data)
+// Checks the CRC of a complete frame starting at `frame`
+static inline bool _frame_crc_valid(const uint8_t *frame)
 {
-  if (buf && (buf->offset + sizeof(int8_t) <= buf->capacity))
-  {
-    buf->buffer[buf->offset] = data;
-    buf->offset += sizeof(int8_t);
-  }
+  const uint8_t frameLength = frame[1];
+  return crsf_crc8(frame + 2, frameLength - 1) == frame[frameLength + 1];
 }
 
-// Write an uint16_t to the buffer
-void buf_write_ui16(buffer_t *buf, uint16_t data)
+#if CRSF_STATS
+static inline uint64_t _stats_now_ns(void)
 {
-  if (buf && (buf->offset + sizeof(uint16_t) <= buf->capacity))
-  {
-    buf->buffer[buf->offset] = (data >> 8) & 0xFF;
-    buf->buffer[buf->offset + 1] = data & 0xFF;
-    buf->offset += sizeof(uint16_t);
-  }
+#if CRSF_HOST
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#else
+  return time_us_64() * 1000;
+#endif
 }
 
-// Write an int16_t to the buffer
-void buf_write_i16(buffer_t *buf, int16_t data)
+// Seqlock writer sections around every change to crsf->stats, as for the snapshot
+static inline void _stats_begin(crsf_t *crsf)
 {
-  if (buf && (buf->offset + sizeof(int16_t) <= buf->capacity))
-  {
-    buf->buffer[buf->offset] = (data >> 8) & 0xFF;
-    buf->buffer[buf->offset + 1] = data & 0xFF;
-    buf->offset += sizeof(int16_t);
-  }
+  __atomic_store_n(&crsf->stats_lock, crsf->stats_lock + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void _stats_end(crsf_t *crsf)
+{
+  __atomic_store_n(&crsf->stats_lock, crsf->stats_lock + 1, __ATOMIC_RELEASE);
+}
+
+static void _stats_count(crsf_t *crsf, uint32_t *counter)
+{
+  _stats_begin(crsf);
+  (*counter)++;
+  _stats_end(crsf);
 }
 
-// Write an uint24_t to the buffer
-void buf_write_ui24(buffer_t *buf, uint32_t data)
+static void _histogram_add(crsf_histogram_t *histogram, uint64_t value_ns)
 {
-  if (buf && (buf->offset + 3 <= buf->capacity))
+  const uint32_t value = value_ns > UINT32_MAX ? UINT32_MAX : (uint32_t)value_ns;
+  int bucket = 31 - __builtin_clz(value | 1);
+  if (bucket >= CRSF_STATS_BUCKETS)
+  {
+    bucket = CRSF_STATS_BUCKETS - 1;
+  }
+  histogram->buckets[bucket]++;
+  if (histogram->count == 0 || value < histogram->min)
+  {
+    histogram->min = value;
+  }
+  if (value > histogram->max)
   {
-    buf->buffer[buf->offset] = (data >> 16) & 0xFF;
-    buf->buffer[buf->offset + 1] = (data >> 8) & 0xFF;
-    buf->buffer[buf->offset + 2] = data & 0xFF;
-    buf->offset += 3;
+    histogram->max = value;
   }
+  histogram->count++;
+  histogram->sum += value;
+}
+
+// Start of a crsf_ctx_parse() call, whose bytes are taken to have just finished arriving
+static void _stats_begin_chunk(crsf_t *crsf)
+{
+  crsf->stats_chunk_end_ns = _stats_now_ns();
+  // 10 bits per byte at 8N1, divided in one go so 5.25 Mbaud gives 1904 ns rather than 1900
+  crsf->stats_byte_ns = crsf->baud_rate != 0 ? (uint32_t)(10000000000ull / crsf->baud_rate) : 0;
 }
 
-// Write an int24_t to the buffer
-void buf_write_i24(buffer_t *buf, int32_t data)
+// A sync byte was found after `skipped` bytes of garbage, with `remaining` bytes of the chunk left
+static void _stats_sync_found(crsf_t *crsf, size_t skipped, size_t remaining)
 {
-  if (buf && (buf->offset + 3 <= buf->capacity))
+  crsf->stats_sync_ns = crsf->stats_chunk_end_ns - (uint64_t)(remaining - 1) * crsf->stats_byte_ns;
+  if (skipped > 0)
   {
-    buf->buffer[buf->offset] = (data >> 16) & 0xFF;
-    buf->buffer[buf->offset + 1] = (data >> 8) & 0xFF;
-    buf->buffer[buf->offset + 2] = data & 0xFF;
-    buf->offset += 3;
+    _stats_begin(crsf);
+    crsf->stats.bytes_discarded += skipped;
+    _stats_end(crsf);
   }
 }
 
-// Write an uint32_t to the buffer
-void buf_write_ui32(buffer_t *buf, uint32_t data)
+static void _stats_discard(crsf_t *crsf, size_t bytes)
 {
-  if (buf && (buf->offset + sizeof(uint32_t) <= buf->capacity))
+  _stats_begin(crsf);
+  crsf->stats.bytes_discarded += bytes;
+  _stats_end(crsf);
+}
+
+// The parser dropped `drop` buffered bytes, `discarded` of them outside a valid frame
+static void _stats_realign(crsf_t *crsf, size_t drop, size_t discarded, bool resync)
+{
+  crsf->stats_sync_ns += (uint64_t)drop * crsf->stats_byte_ns;
+  if (discarded > 0 || resync)
   {
-    buf->buffer[buf->offset] = (data >> 24) & 0xFF;
-    buf->buffer[buf->offset + 1] = (data >> 16) & 0xFF;
-    buf->buffer[buf->offset + 2] = (data >> 8) & 0xFF;
-    buf->buffer[buf->offset + 3] = data & 0xFF;
-    buf->offset += sizeof(uint32_t);
+    _stats_begin(crsf);
+    crsf->stats.bytes_discarded += discarded;
+    crsf->stats.resyncs += resync;
+    _stats_end(crsf);
   }
 }
 
-// Write an int32_t to the buffer
-void buf_write_i32(buffer_t *buf, int32_t data)
+// Records the timing of the valid frame in crsf->incoming.frame
+static void _stats_frame(crsf_t *crsf, uint64_t decode_start_ns, uint64_t dispatch_ns, uint64_t done_ns)
 {
-  if (buf && (buf->offset + sizeof(int32_t) <= buf->capacity))
+  const uint64_t sync_ns = crsf->stats_sync_ns;
+  crsf_stats_t *stats = &crsf->stats;
+  _stats_begin(crsf);
+  stats->frames++;
+  stats->last_sync_ns = sync_ns;
+  // The CRC is the last byte: [sync] [len] [type] [payload] [crc8]
+  stats->last_crc_ns = sync_ns + (uint64_t)(crsf->incoming.frame[1] + 1) * crsf->stats_byte_ns;
+  _histogram_add(&stats->latency_ns, dispatch_ns > sync_ns ? dispatch_ns - sync_ns : 0);
+  _histogram_add(&stats->decode_ns, dispatch_ns - decode_start_ns);
+  _histogram_add(&stats->callback_ns, done_ns - dispatch_ns);
+  if (crsf->incoming.frame[2] == CRSF_FRAMETYPE_RC_CHANNELS_PACKED)
   {
-    buf->buffer[buf->offset] = (data >> 24) & 0xFF;
-    buf->buffer[buf->offset + 1] = (data >> 16) & 0xFF;
-    buf->buffer[buf->offset + 2] = (data >> 8) & 0xFF;
-    buf->buffer[buf->offset + 3] = data & 0xFF;
-    buf->offset += sizeof(int32_t);
+    if (crsf->stats_last_rc_ns != 0 && sync_ns > crsf->stats_last_rc_ns)
+    {
+      _histogram_add(&stats->rc_interval_ns, sync_ns - crsf->stats_last_rc_ns);
+    }
+    crsf->stats_last_rc_ns = sync_ns;
   }
+  _stats_end(crsf);
 }
+#endif
 
-void _begin_frame()
+static inline uint64_t _now_us(const crsf_t *crsf)
 {
-  buf_reset(&_telem_buf);
-  // Write sync byte
-  buf_write_ui8(&_telem_buf, 0xC8);
+  return crsf->transport != NULL ? crsf->transport->time_us(crsf->transport->ctx) : 0;
 }
 
-void _end_frame()
+#if CRSF_SNAPSHOT
+// Seqlock writer: readers retry while `snapshot_lock` is odd or has moved on
+static void _publish_snapshot(crsf_t *crsf, uint64_t now_us)
 {
-  // Skip sync byte and frame length
-  const uint8_t bytesToSkip = 2;
-  const uint8_t *start = _telem_buf.buffer + bytesToSkip;
-  const uint8_t length = _telem_buf.offset - bytesToSkip;
-  const uint8_t crc = crsf_crc8(start, length);
+  const uint32_t lock = crsf->snapshot_lock;
+  __atomic_store_n(&crsf->snapshot_lock, lock + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
 
-  buf_write_ui8(&_telem_buf, crc);
-}
+  crsf_snapshot_t *snapshot = &crsf->snapshot;
+  memcpy(snapshot->channels, crsf->rc_channels, sizeof(snapshot->channels));
+  memcpy(snapshot->conditioned, crsf->conditioned_channels, sizeof(snapshot->conditioned));
+  snapshot->link_statistics = crsf->link_statistics;
+  snapshot->failsafe = __atomic_load_n(&crsf->failsafe_flags, __ATOMIC_ACQUIRE) != 0;
+  snapshot->seq++;
+  snapshot->timestamp_us = now_us;
 
-// BEGIN gen_frames.dart
-void _write_battery_sensor_payload()
+  __atomic_store_n(&crsf->snapshot_lock, lock + 2, __ATOMIC_RELEASE);
+}
+#else
+static inline void _publish_snapshot(crsf_t *crsf, uint64_t now_us)
 {
-  buf_write_ui8(&_telem_buf, 10);                            // Frame length
-  buf_write_ui8(&_telem_buf, CRSF_FRAMETYPE_BATTERY_SENSOR); // Frame type
-  buf_write_ui16(&_telem_buf, _telemetry.battery_sensor.voltage);
-  buf_write_ui16(&_telem_buf, _telemetry.battery_sensor.current);
-  buf_write_ui24(&_telem_buf, _telemetry.battery_sensor.capacity);
-  buf_write_ui8(&_telem_buf, _telemetry.battery_sensor.percent);
+  (void)crsf;
+  (void)now_us;
 }
-// END gen_frames.dart
+#endif
 
-bool crsf_telem_update()
+#if CRSF_FRAME_RC_CHANNELS_PACKED
+// Tracks the RC packet rate and opens the telemetry reply slot that follows each RC frame
+static void _open_telem_slot(crsf_t *crsf, uint64_t now_us)
 {
-  bool updated = false;
-  static int currentFrameType = 0;
+  if (crsf->last_rc_us != 0 && now_us - crsf->last_rc_us < CRSF_MAX_RC_INTERVAL_US)
+  {
+    const uint32_t interval = now_us - crsf->last_rc_us;
+    crsf->rc_interval_us = crsf->rc_interval_us == 0 ? interval : (7 * crsf->rc_interval_us + interval) / 8;
+  }
+  crsf->last_rc_us = now_us;
+#if CRSF_TELEMETRY
+  crsf->telem_slot_open = true;
+#endif
+}
+#endif
 
-  for (int i = 0; i < TELEMETRY_FRAME_TYPES; i++)
+static void _set_failsafe(crsf_t *crsf, uint32_t reason, bool active)
+{
+  if (active)
   {
-    int frameTypeIndex = (currentFrameType + i) % TELEMETRY_FRAME_TYPES;
+    __atomic_fetch_or(&crsf->failsafe_flags, reason, __ATOMIC_ACQ_REL);
+  }
+  else
+  {
+    __atomic_fetch_and(&crsf->failsafe_flags, ~reason, __ATOMIC_ACQ_REL);
+  }
+}
 
-    if (frameHasData[frameTypeIndex])
-    {
-      _begin_frame();
-      switch (frameTypeIndex)
-      {
-      case CRSF_BATTERY_INDEX:
-        _write_battery_sensor_payload();
-        break;
-      case CRSF_CUSTOM_PAYLOAD_INDEX:
-        buf_write_ui8(&_telem_buf, _telemetry.custom.length + 2);  // Frame length
-        buf_write_ui8(&_telem_buf, CRSF_FRAMETYPE_CUSTOM_PAYLOAD); // Frame type
-        for (size_t i = 0; i < _telemetry.custom.length; i++)
-        {
-          buf_write_ui8(&_telem_buf, _telemetry.custom.buffer[i]);
-        }
-        break;
-      }
-      _end_frame();
-      updated = true;
-      currentFrameType = (currentFrameType + 1) % TELEMETRY_FRAME_TYPES;
-      break;
-    }
+// Runs the failsafe callback if the state changed since it was last reported,
+// including changes made by the timeout alarm
+static void _report_failsafe(crsf_t *crsf)
+{
+  const bool failsafe = __atomic_load_n(&crsf->failsafe_flags, __ATOMIC_ACQUIRE) != 0;
+  if (failsafe == crsf->failsafe_reported)
+  {
+    return;
+  }
+  crsf->failsafe_reported = failsafe;
+  if (failsafe && crsf->conditioner != NULL)
+  {
+    // Filters restart from the first frame after the link recovers, not from stale values
+    crsf_conditioner_reset(crsf->conditioner);
   }
+#if CRSF_CALLBACKS
+  if (crsf->failsafe_callback != NULL)
+  {
+    crsf->failsafe_callback(crsf, failsafe);
+  }
+#endif
+}
 
-  return updated;
+// Alarm context (an IRQ or the timer thread): no RC frame within the timeout
+static void _failsafe_timeout(void *ctx)
+{
+  crsf_t *crsf = ctx;
+  __atomic_store_n(&crsf->failsafe_recovery_frames, 0, __ATOMIC_RELAXED);
+  _set_failsafe(crsf, CRSF_FAILSAFE_TIMEOUT, true);
 }
 
-bool crsf_process_frame(uint8_t *frameIndex, uint8_t *frameLength, uint8_t *crcIndex, uint8_t currentByte)
+/**
+ * Sets how long the link may go without a valid RC frame before the failsafe is triggered.
+ *
+ * A hardware alarm (a timer thread on the host) is re-armed by every RC frame,
+ * so the timeout is caught even when no bytes arrive at all. The failsafe is
+ * visible through crsf_ctx_get_latest() as soon as the alarm expires, and the
+ * failsafe callback runs on the next crsf_ctx_process_frames() or
+ * crsf_ctx_parse() call. It clears after CRSF_FAILSAFE_RECOVERY_FRAMES RC
+ * frames have arrived without another timeout.
+ *
+ * On the RP2040 the alarm interrupt is serviced by the core calling this.
+ * Disable the timeout before discarding the instance.
+ *
+ * @param crsf The instance.
+ * @param timeout_us The timeout in microseconds, e.g. a few RC frame intervals, or 0 to disable it.
+ * @return false if no alarm was available.
+ */
+bool crsf_ctx_set_failsafe_timeout_us(crsf_t *crsf, uint32_t timeout_us)
 {
-  // Frame format:
-  // [sync] [len] [type] [payload] [crc8]
-  if (*frameIndex == 0)
+  if (timeout_us == 0)
   {
-    // Should be the sync byte (0xC8)
-    // "OpenTX/EdgeTX sends the channels packet starting with 0xEE instead of
-    // 0xC8, this has been incorrect since the first CRSF implementation."
-    if (currentByte != 0xC8 && currentByte != 0xEE)
+    if (crsf->failsafe_timeout_us != 0)
     {
-      DEBUG_WARN("Invalid sync byte: %04x", currentByte);
-      return false;
+      crsf_alarm_deinit(&crsf->failsafe_alarm);
+      crsf->failsafe_timeout_us = 0;
     }
-    _incoming_frame[*frameIndex++] = currentByte;
+    _set_failsafe(crsf, CRSF_FAILSAFE_TIMEOUT, false);
     return true;
   }
-  else if (*frameIndex == 1)
+  if (crsf->failsafe_timeout_us == 0 && !crsf_alarm_init(&crsf->failsafe_alarm, _failsafe_timeout, crsf))
   {
-    // Should be the length byte
-    _incoming_frame[*frameIndex++] = currentByte;
-    *frameLength = currentByte;
-    *crcIndex = *frameLength + 1;
-    if (*frameLength < 2 || *frameLength > 62)
-    {
-      // Invalid frame length
-      *frameIndex = 0;
-      DEBUG_WARN("Frame length out of range: %d", *frameLength);
-      return false;
-    }
-    return true;
+    return false;
   }
-  else if (*frameIndex == *crcIndex)
-  {
-    // We have read the entire frame
-    // Check the CRC
-    if (crsf_crc8(_incoming_frame + 2, *frameLength - 1) == currentByte)
-    {
-      // Process the frame
-      const uint8_t frameType = _incoming_frame[2];
-      switch (frameType)
+  crsf->failsafe_timeout_us = timeout_us;
+  crsf_alarm_arm(&crsf->failsafe_alarm, timeout_us);
+  return true;
+}
+
+/**
+ * Sets how long the link may go without a valid RC frame before the failsafe is triggered.
+ *
+ * @param timeout_us The timeout in microseconds, or 0 to disable it.
+ * @return false if no alarm was available.
+ * @see crsf_ctx_set_failsafe_timeout_us
+ */
+bool crsf_set_failsafe_timeout_us(uint32_t timeout_us)
+{
+  return crsf_ctx_set_failsafe_timeout_us(&_crsf, timeout_us);
+}
+
+/**
+ * Moves the line and every byte time derived from it to `baud_rate`.
+ *
+ * Bytes straddling the switch are garbage at one rate or the other, so the
+ * partly received frame is dropped.
+ */
+static bool _switch_baud_rate(crsf_t *crsf, uint32_t baud_rate)
+{
+  const crsf_transport_t *transport = crsf->transport;
+  if (transport != NULL && (transport->set_baud == NULL || !transport->set_baud(transport->ctx, baud_rate)))
+  {
+    return false;
+  }
+  crsf->baud_rate = baud_rate;
+  crsf_framer_reset(&crsf->incoming);
+  crsf->valid_frame_run = 0;
+#if CRSF_TELEMETRY
+  crsf->telem_tx_end_us = 0;
+#endif
+  return true;
+}
+
+static void _apply_pending_baud_rate(crsf_t *crsf)
+{
+  const uint32_t baud_rate = crsf->baud_rate_pending;
+  crsf->baud_rate_pending = 0;
+  if (!_switch_baud_rate(crsf, baud_rate))
+  {
+    return;
+  }
+#if CRSF_CALLBACKS
+  if (crsf->baud_rate_callback != NULL)
+  {
+    crsf->baud_rate_callback(crsf, baud_rate);
+  }
+#endif
+}
+
+#if CRSF_FRAME_COMMAND
+static bool _baud_rate_supported(uint32_t baud_rate)
+{
+  for (int i = 0; i < CRSF_BAUD_RATE_COUNT; i++)
+  {
+    if (crsf_baud_rates[i] == baud_rate)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Sends [sync] [len] [0x32] [destination] [origin] [0x0A] [args] [command crc8] [crc8]
+static bool _send_general_command(crsf_t *crsf, uint8_t destination, const uint8_t *args, uint8_t count)
+{
+  const crsf_transport_t *transport = crsf->transport;
+  if (transport == NULL)
+  {
+    return false;
+  }
+  crsf_payload_command_t command = {
+      .destination = destination,
+      .origin = crsf->address,
+      .command = CRSF_COMMAND_GENERAL,
+      .length = count,
+  };
+  memcpy(command.data, args, count);
+  uint8_t frame[CRSF_MAX_FRAME_SIZE] = {CRSF_SYNC_BYTE, 0, CRSF_FRAMETYPE_COMMAND};
+  uint8_t length = 3 + crsf_encode_command(&command, &frame[3]);
+  // The command CRC covers the frame type onwards
+  frame[length] = crsf_crc8_command(&frame[2], length - 2);
+  length++;
+  frame[1] = length - 1;
+  frame[length] = crsf_crc8(&frame[2], length - 2);
+  length++;
+  return transport->write(transport->ctx, frame, length) == length;
+}
+
+// Answers baud rate proposals and picks up the response to our own
+static void _on_command_frame(crsf_t *crsf, const crsf_frame_payload_t *payload)
+{
+  const crsf_payload_command_t *command = &payload->command;
+  if (command->command != CRSF_COMMAND_GENERAL || command->length < 2 ||
+      (command->destination != crsf->address && command->destination != CRSF_ADDRESS_BROADCAST))
+  {
+    return;
+  }
+  // The command CRC sits just before the frame CRC
+  const uint8_t frameLength = crsf->incoming.frame[1];
+  if (crsf_crc8_command(&crsf->incoming.frame[2], frameLength - 2) != crsf->incoming.frame[frameLength])
+  {
+    DEBUG_WARN("Command CRC check failed.");
+    return;
+  }
+  // [sub-command] [port id] [arguments]
+  const uint8_t *args = command->data;
+  const uint8_t count = command->length - 1;
+  if (args[0] == CRSF_COMMAND_SPEED_PROPOSAL && count >= 6)
+  {
+    const uint32_t baud_rate = (uint32_t)args[2] << 24 | (uint32_t)args[3] << 16 | (uint32_t)args[4] << 8 | args[5];
+    const bool accepted = baud_rate <= crsf->baud_rate_max && _baud_rate_supported(baud_rate) &&
+                          crsf->transport != NULL && crsf->transport->set_baud != NULL;
+    const uint8_t response[] = {CRSF_COMMAND_SPEED_RESPONSE, args[1], accepted};
+    // Switch once the response has gone out at the current rate
+    if (_send_general_command(crsf, command->origin, response, sizeof(response)) && accepted &&
+        baud_rate != crsf->baud_rate)
+    {
+      crsf->baud_rate_pending = baud_rate;
+    }
+  }
+  else if (args[0] == CRSF_COMMAND_SPEED_RESPONSE && count >= 3 && crsf->baud_rate_proposed != 0 &&
+           (command->origin == crsf->baud_rate_proposed_to || crsf->baud_rate_proposed_to == CRSF_ADDRESS_BROADCAST))
+  {
+    if (args[2])
+    {
+      crsf->baud_rate_pending = crsf->baud_rate_proposed;
+    }
+    crsf->baud_rate_proposed = 0;
+  }
+}
+#endif
+
+/**
+ * Switches the link to another baud rate straight away.
+ *
+ * The transport is reconfigured and every timing that depends on the byte time
+ * (telemetry slots, the statistics) follows. Without a transport only the
+ * timing changes. Both ends must switch together, so on a live link prefer
+ * crsf_ctx_propose_baud_rate().
+ *
+ * @param crsf The instance.
+ * @param baud_rate The new rate, e.g. one of crsf_baud_rates.
+ * @return false if the transport cannot change its rate.
+ */
+bool crsf_ctx_set_baud_rate(crsf_t *crsf, uint32_t baud_rate)
+{
+  if (baud_rate == 0)
+  {
+    return false;
+  }
+  if (baud_rate == crsf->baud_rate)
+  {
+    return true;
+  }
+  return _switch_baud_rate(crsf, baud_rate);
+}
+
+/**
+ * Returns the rate the link currently runs at.
+ */
+uint32_t crsf_ctx_get_baud_rate(const crsf_t *crsf)
+{
+  return crsf->baud_rate;
+}
+
+/**
+ * Sets the address this device answers command frames on, CRSF_ADDRESS_FLIGHT_CONTROLLER by default.
+ *
+ * Frames whose first byte is this address are parsed as well as those starting
+ * with the usual sync bytes, e.g. a TX module's frames to CRSF_ADDRESS_RADIO_TRANSMITTER.
+ */
+void crsf_ctx_set_address(crsf_t *crsf, uint8_t address)
+{
+  crsf->address = address;
+}
+
+/**
+ * Sets the highest rate a baud rate proposal from the other end is accepted at.
+ *
+ * Defaults to CRSF_BAUD_RATE_DEFAULT, so proposals to go faster are rejected
+ * until this is raised. Only rates in crsf_baud_rates are ever accepted, and
+ * only when the transport can change its rate.
+ *
+ * @param crsf The instance.
+ * @param baud_rate The highest acceptable rate.
+ */
+void crsf_ctx_set_max_baud_rate(crsf_t *crsf, uint32_t baud_rate)
+{
+  crsf->baud_rate_max = baud_rate;
+}
+
+/**
+ * Asks the device at `destination` to move the link to `baud_rate`.
+ *
+ * Sends a CRSF speed proposal (general command 0x0A, sub-command 0x70). If the
+ * response accepts it, both ends switch once the response has been parsed, and
+ * the baud rate callback runs. A rejected or unanswered proposal leaves the
+ * rate unchanged.
+ *
+ * @param crsf The instance.
+ * @param destination The address of the other end, e.g. CRSF_ADDRESS_CRSF_TRANSMITTER.
+ * @param baud_rate The proposed rate.
+ * @return false if the proposal could not be sent.
+ */
+bool crsf_ctx_propose_baud_rate(crsf_t *crsf, uint8_t destination, uint32_t baud_rate)
+{
+#if CRSF_FRAME_COMMAND
+  if (crsf->transport == NULL || crsf->transport->set_baud == NULL)
+  {
+    return false;
+  }
+  // [sub-command] [port id] [baud rate, big endian]
+  const uint8_t proposal[] = {
+      CRSF_COMMAND_SPEED_PROPOSAL,
+      0,
+      baud_rate >> 24,
+      baud_rate >> 16,
+      baud_rate >> 8,
+      baud_rate,
+  };
+  if (!_send_general_command(crsf, destination, proposal, sizeof(proposal)))
+  {
+    return false;
+  }
+  crsf->baud_rate_proposed = baud_rate;
+  crsf->baud_rate_proposed_to = destination;
+  return true;
+#else
+  (void)crsf;
+  (void)destination;
+  (void)baud_rate;
+  return false;
+#endif
+}
+
+#if CRSF_CALLBACKS
+/**
+ * Sets the callback function to be called when the link changes baud rate,
+ * after a negotiation or when autodetection locks on.
+ *
+ * @param crsf The instance.
+ * @param callback A pointer to the callback function.
+ */
+void crsf_ctx_set_on_baud_rate(crsf_t *crsf, void (*callback)(crsf_t *crsf, uint32_t baud_rate))
+{
+  crsf->baud_rate_callback = callback;
+}
+#endif
+
+// Starts listening at crsf_baud_rates[index]
+static bool _autobaud_try(crsf_t *crsf, int8_t index)
+{
+  crsf->autobaud_index = index;
+  crsf->autobaud_since_us = crsf->transport->time_us(crsf->transport->ctx);
+  return _switch_baud_rate(crsf, crsf_baud_rates[index]);
+}
+
+// Locks on after enough valid frames in a row, or moves to the next candidate
+static void _autobaud_step(crsf_t *crsf)
+{
+  if (crsf->valid_frame_run >= crsf->autobaud_lock_frames)
+  {
+    crsf->autobaud_index = -1;
+#if CRSF_CALLBACKS
+    if (crsf->baud_rate_callback != NULL)
+    {
+      crsf->baud_rate_callback(crsf, crsf->baud_rate);
+    }
+#endif
+    return;
+  }
+  // Long enough to see the frames needed at the slowest packet rate
+  const uint64_t dwell_us = (uint64_t)(crsf->autobaud_lock_frames + 1) * CRSF_AUTOBAUD_FRAME_INTERVAL_US;
+  if (crsf->transport->time_us(crsf->transport->ctx) - crsf->autobaud_since_us >= dwell_us)
+  {
+    _autobaud_try(crsf, (crsf->autobaud_index + 1) % CRSF_BAUD_RATE_COUNT);
+  }
+}
+
+/**
+ * Finds the rate the other end is sending at.
+ *
+ * crsf_ctx_process_frames() cycles through crsf_baud_rates, staying at each
+ * long enough to see `lock_frames` frames at 50 Hz, and locks on once that
+ * many valid frames arrive in a row. The baud rate callback then runs with the
+ * rate found.
+ *
+ * @param crsf The instance, whose transport must be able to change its rate.
+ * @param lock_frames Valid frames in a row needed to lock on. A handful rules
+ * out frames that pass the CRC by chance at the wrong rate.
+ * @return false if the transport cannot change its rate.
+ */
+bool crsf_ctx_start_autobaud(crsf_t *crsf, uint8_t lock_frames)
+{
+  if (crsf->transport == NULL || crsf->transport->set_baud == NULL || lock_frames == 0)
+  {
+    return false;
+  }
+  crsf->autobaud_lock_frames = lock_frames;
+  return _autobaud_try(crsf, 0);
+}
+
+/**
+ * @see crsf_ctx_set_baud_rate
+ */
+bool crsf_set_baud_rate(uint32_t baud_rate)
+{
+  return crsf_ctx_set_baud_rate(&_crsf, baud_rate);
+}
+
+/**
+ * Returns the rate the default instance's link currently runs at.
+ */
+uint32_t crsf_get_baud_rate(void)
+{
+  return crsf_ctx_get_baud_rate(&_crsf);
+}
+
+/**
+ * @see crsf_ctx_set_address
+ */
+void crsf_set_address(uint8_t address)
+{
+  crsf_ctx_set_address(&_crsf, address);
+}
+
+/**
+ * @see crsf_ctx_set_max_baud_rate
+ */
+void crsf_set_max_baud_rate(uint32_t baud_rate)
+{
+  crsf_ctx_set_max_baud_rate(&_crsf, baud_rate);
+}
+
+/**
+ * @see crsf_ctx_propose_baud_rate
+ */
+bool crsf_propose_baud_rate(uint8_t destination, uint32_t baud_rate)
+{
+  return crsf_ctx_propose_baud_rate(&_crsf, destination, baud_rate);
+}
+
+#if CRSF_CALLBACKS
+/**
+ * Sets the callback function to be called when the link changes baud rate.
+ *
+ * @param callback A pointer to the callback function.
+ */
+void crsf_set_on_baud_rate(void (*callback)(uint32_t baud_rate))
+{
+  baud_rate_callback = callback;
+  crsf_ctx_set_on_baud_rate(&_crsf, callback != NULL ? _on_baud_rate : NULL);
+}
+#endif
+
+/**
+ * @see crsf_ctx_start_autobaud
+ */
+bool crsf_start_autobaud(uint8_t lock_frames)
+{
+  return crsf_ctx_start_autobaud(&_crsf, lock_frames);
+}
+
+/**
+ * Conditions the channels of every RC frame from now on.
+ *
+ * The conditioned values are published in the snapshot's `conditioned` field
+ * and passed to the conditioned channels callback, after the raw channels
+ * callback. The conditioner keeps per-channel filter state, so give each
+ * instance its own, and configure it before attaching it.
+ *
+ * @param crsf The instance.
+ * @param conditioner Set up with crsf_conditioner_init(), or NULL to stop conditioning.
+ * It must outlive its use by the instance.
+ */
+void crsf_ctx_set_conditioner(crsf_t *crsf, crsf_conditioner_t *conditioner)
+{
+  if (conditioner != NULL)
+  {
+    crsf_conditioner_reset(conditioner);
+  }
+  crsf->conditioner = conditioner;
+  memset(crsf->conditioned_channels, 0, sizeof(crsf->conditioned_channels));
+}
+
+#if CRSF_CALLBACKS
+/**
+ * Sets the callback function to be called with the conditioned channels of each RC frame.
+ *
+ * @param crsf The instance.
+ * @param callback Called only while a conditioner is set, see crsf_ctx_set_conditioner().
+ */
+void crsf_ctx_set_on_conditioned_channels(crsf_t *crsf, void (*callback)(crsf_t *crsf, const int16_t channels[16]))
+{
+  crsf->conditioned_channels_callback = callback;
+}
+
+/**
+ * Sets a callback for RC frames that change the channels, as an alternative to
+ * the per-frame RC channels callback.
+ *
+ * Each new payload is compared word by word with the previous one, and only
+ * when it differs are the channels compared with the values last delivered.
+ * The callback runs when at least one channel has moved by more than its
+ * threshold, with a mask of those channels (bit i for channel i). Channels
+ * outside the mask hold their last delivered value or have only drifted within
+ * their threshold. Every keep-alive period all channels are delivered with
+ * CRSF_ALL_CHANNELS, as is the first frame after the callback is set.
+ *
+ * @param crsf The instance. The keep-alive follows its transport's clock, so
+ * without a transport only the first frame is a full delivery.
+ * @param callback The callback, or NULL to stop change detection.
+ */
+void crsf_ctx_set_on_rc_channels_changed(crsf_t *crsf, void (*callback)(crsf_t *crsf, const uint16_t channels[16], uint16_t dirty))
+{
+  crsf->rc_changed_callback = callback;
+  crsf->rc_delivered_valid = false;
+}
+
+/**
+ * Sets how many ticks a channel must move from its last delivered value to be reported as changed.
+ *
+ * @param crsf The instance.
+ * @param channel 0 - 15, out of range values are ignored.
+ * @param threshold Ticks of movement ignored, 0 to report any change. A few ticks
+ * hide the jitter of an analogue gimbal.
+ */
+void crsf_ctx_set_channel_threshold(crsf_t *crsf, uint8_t channel, uint16_t threshold)
+{
+  if (channel < CRSF_RC_CHANNELS)
+  {
+    crsf->rc_change_thresholds[channel] = threshold;
+  }
+}
+
+/**
+ * Sets how often the changed channels callback re-delivers every channel.
+ *
+ * @param crsf The instance.
+ * @param keepalive_us The period, CRSF_RC_KEEPALIVE_US by default, or 0 to only deliver changes.
+ */
+void crsf_ctx_set_rc_keepalive_us(crsf_t *crsf, uint32_t keepalive_us)
+{
+  crsf->rc_keepalive_us = keepalive_us;
+}
+
+/**
+ * Sets the callback function to be called when RC channels change.
+ *
+ * @param callback A pointer to the callback function, passed the channels and a mask of those that changed.
+ */
+void crsf_set_on_rc_channels_changed(void (*callback)(const uint16_t channels[16], uint16_t dirty))
+{
+  rc_changed_callback = callback;
+  crsf_ctx_set_on_rc_channels_changed(&_crsf, callback != NULL ? _on_rc_channels_changed : NULL);
+}
+
+/**
+ * @see crsf_ctx_set_channel_threshold
+ */
+void crsf_set_channel_threshold(uint8_t channel, uint16_t threshold)
+{
+  crsf_ctx_set_channel_threshold(&_crsf, channel, threshold);
+}
+
+/**
+ * @see crsf_ctx_set_rc_keepalive_us
+ */
+void crsf_set_rc_keepalive_us(uint32_t keepalive_us)
+{
+  crsf_ctx_set_rc_keepalive_us(&_crsf, keepalive_us);
+}
+#endif
+
+/**
+ * @see crsf_ctx_set_conditioner
+ */
+void crsf_set_conditioner(crsf_conditioner_t *conditioner)
+{
+  crsf_ctx_set_conditioner(&_crsf, conditioner);
+}
+
+#if CRSF_CALLBACKS
+/**
+ * Sets the callback function to be called with the conditioned channels of each RC frame.
+ *
+ * @param callback A pointer to the callback function.
+ */
+void crsf_set_on_conditioned_channels(void (*callback)(const int16_t channels[16]))
+{
+  conditioned_channels_callback = callback;
+  crsf_ctx_set_on_conditioned_channels(&_crsf, callback != NULL ? _on_conditioned_channels : NULL);
+}
+#endif
+
+/**
+ * Copies the latest timing correction a TX module sent this device.
+ *
+ * Call from the context that parses, as the correction is not published
+ * with a lock. Compare `out->count` with the previous call to tell whether a
+ * new one has arrived.
+ *
+ * @param crsf The instance. Its address must be the correction's destination,
+ * see crsf_ctx_set_address().
+ * @param out Receives the correction.
+ * @return false if none has been received.
+ */
+bool crsf_ctx_get_timing_correction(const crsf_t *crsf, crsf_timing_correction_t *out)
+{
+  *out = crsf->timing_correction;
+  return out->count > 0;
+}
+
+/**
+ * @see crsf_ctx_get_timing_correction
+ */
+bool crsf_get_timing_correction(crsf_timing_correction_t *out)
+{
+  return crsf_ctx_get_timing_correction(&_crsf, out);
+}
+
+#if CRSF_FRAME_LINK_STATISTICS
+static void _on_link_statistics_frame(crsf_t *crsf, const crsf_frame_payload_t *payload)
+{
+  _process_link_statistics(crsf, &payload->link_statistics);
+  _set_failsafe(crsf, CRSF_FAILSAFE_LINK, calculate_failsafe(crsf));
+  _publish_snapshot(crsf, _now_us(crsf));
+#if CRSF_CALLBACKS
+  if (crsf->link_statistics_callback != NULL)
+  {
+    crsf->link_statistics_callback(crsf, crsf->link_statistics);
+  }
+#endif
+  _report_failsafe(crsf);
+}
+#endif
+
+#if CRSF_FRAME_RC_CHANNELS_PACKED
+static void _on_rc_channels_frame(crsf_t *crsf, const crsf_frame_payload_t *payload)
+{
+  if (crsf->failsafe_timeout_us != 0)
+  {
+    crsf_alarm_arm(&crsf->failsafe_alarm, crsf->failsafe_timeout_us);
+    // Any gap longer than the timeout restarts the count from the alarm
+    if ((__atomic_load_n(&crsf->failsafe_flags, __ATOMIC_ACQUIRE) & CRSF_FAILSAFE_TIMEOUT) &&
+        __atomic_add_fetch(&crsf->failsafe_recovery_frames, 1, __ATOMIC_RELAXED) >= CRSF_FAILSAFE_RECOVERY_FRAMES)
+    {
+      _set_failsafe(crsf, CRSF_FAILSAFE_TIMEOUT, false);
+    }
+  }
+  const bool changed = _process_rc_channels(crsf, &payload->rc_channels_packed);
+  const uint64_t now_us = _now_us(crsf);
+  _publish_snapshot(crsf, now_us);
+  _open_telem_slot(crsf, now_us);
+#if CRSF_CALLBACKS
+  if (crsf->rc_channels_callback != NULL)
+  {
+    crsf->rc_channels_callback(crsf, crsf->rc_channels);
+  }
+  if (crsf->rc_changed_callback != NULL)
+  {
+    _dispatch_rc_changes(crsf, changed, now_us);
+  }
+  if (crsf->conditioner != NULL && crsf->conditioned_channels_callback != NULL)
+  {
+    crsf->conditioned_channels_callback(crsf, crsf->conditioned_channels);
+  }
+#else
+  (void)changed;
+#endif
+  _report_failsafe(crsf);
+}
+#endif
+
+#if CRSF_FRAME_RADIO_ID
+static void _on_radio_id_frame(crsf_t *crsf, const crsf_frame_payload_t *payload)
+{
+  const crsf_payload_radio_id_t *radio_id = &payload->radio_id;
+  if (radio_id->subtype != CRSF_RADIO_ID_TIMING_CORRECTION ||
+      (radio_id->destination != crsf->address && radio_id->destination != CRSF_ADDRESS_BROADCAST))
+  {
+    return;
+  }
+  crsf_timing_correction_t *correction = &crsf->timing_correction;
+  correction->interval = radio_id->interval;
+  correction->offset = radio_id->offset;
+  correction->count++;
+  correction->received_us = _now_us(crsf);
+}
+#endif
+
+// Frame types that update the link state, indexed like crsf_frame_codecs
+static void (*const _frame_handlers[CRSF_FRAME_CODECS])(crsf_t *crsf, const crsf_frame_payload_t *payload) = {
+#if CRSF_FRAME_RC_CHANNELS_PACKED
+    [CRSF_FRAMETYPE_RC_CHANNELS_PACKED] = _on_rc_channels_frame,
+#endif
+#if CRSF_FRAME_LINK_STATISTICS
+    [CRSF_FRAMETYPE_LINK_STATISTICS] = _on_link_statistics_frame,
+#endif
+#if CRSF_FRAME_COMMAND
+    [CRSF_FRAMETYPE_COMMAND] = _on_command_frame,
+#endif
+#if CRSF_FRAME_RADIO_ID
+    [CRSF_FRAMETYPE_RADIO_ID] = _on_radio_id_frame,
+#endif
+};
+
+// Decodes the validated frame held in crsf->incoming.frame, publishes it and runs the callbacks
+void _handle_frame(crsf_t *crsf)
+{
+  const uint8_t frameType = crsf->incoming.frame[2];
+  // The frame length counts the type and CRC bytes
+  const uint8_t payloadLength = crsf->incoming.frame[1] - 2;
+  if (frameType >= CRSF_FRAME_CODECS || crsf_frame_codecs[frameType].decode == NULL)
+  {
+    DEBUG_WARN("Unknown frame type: %02x", frameType);
+    STATS(_stats_count(crsf, &crsf->stats.unknown_types));
+    return;
+  }
+  void (*const handler)(crsf_t *, const crsf_frame_payload_t *) = _frame_handlers[frameType];
+#if CRSF_CALLBACKS
+  if (handler == NULL && crsf->frame_callback == NULL)
+#else
+  if (handler == NULL)
+#endif
+  {
+    STATS(_stats_count(crsf, &crsf->stats.frames));
+    return;
+  }
+  STATS(const uint64_t decode_start_ns = _stats_now_ns());
+  crsf_frame_payload_t payload;
+  if (!crsf_frame_codecs[frameType].decode(&crsf->incoming.frame[3], payloadLength, &payload))
+  {
+    DEBUG_WARN("Malformed frame of type %02x", frameType);
+    STATS(_stats_count(crsf, &crsf->stats.malformed));
+    return;
+  }
+  STATS(const uint64_t dispatch_ns = _stats_now_ns());
+  if (handler != NULL)
+  {
+    handler(crsf, &payload);
+  }
+#if CRSF_CALLBACKS
+  if (crsf->frame_callback != NULL)
+  {
+    crsf->frame_callback(crsf, frameType, &payload);
+  }
+#endif
+  STATS(_stats_frame(crsf, decode_start_ns, dispatch_ns, _stats_now_ns()));
+}
+
+/**
+ * Consumes the bytes buffered in crsf->incoming.
+ *
+ * On return the buffer is either empty or holds the valid prefix of a frame.
+ *
+ * @return The number of frames dispatched.
+ */
+size_t _drain_incoming_frame(crsf_t *crsf)
+{
+  size_t frames = 0;
+  crsf_framer_status_t status;
+  while ((status = crsf_framer_check(&crsf->incoming)) != CRSF_FRAMER_INCOMPLETE)
+  {
+    if (status == CRSF_FRAMER_VALID)
+    {
+      _handle_frame(crsf);
+      frames++;
+      crsf->valid_frame_run++;
+    }
+    else if (status == CRSF_FRAMER_BAD_LENGTH)
+    {
+      DEBUG_WARN("Frame length out of range: %d", crsf->incoming.frame[1]);
+      STATS(_stats_count(crsf, &crsf->stats.bad_lengths));
+      crsf->valid_frame_run = 0;
+    }
+    else
+    {
+      DEBUG_WARN("CRC check failed.");
+      STATS(_stats_count(crsf, &crsf->stats.crc_errors));
+      crsf->valid_frame_run = 0;
+    }
+
+    STATS(const size_t consumed = status == CRSF_FRAMER_VALID ? (size_t)crsf->incoming.frame[1] + 2 : 1);
+    const size_t drop = crsf_framer_realign(&crsf->incoming, status, crsf->address);
+    // Only a rejected frame start (consumed == 1) is itself discarded
+    STATS(_stats_realign(crsf, drop, consumed == 1 ? drop : drop - consumed, consumed == 1));
+    (void)drop;
+  }
+  return frames;
+}
+
+/**
+ * @brief Parses a buffer of raw CRSF bytes.
+ *
+ * The parser keeps its own state between calls, so `data` may end part way
+ * through a frame and may be of any length (a DMA block, a UART FIFO drain or a
+ * chunk of a log replay). Bytes before a sync byte are skipped with a word-wise
+ * search and, once the length byte is known, the rest of the frame is copied in one go
+ * and folded into a running CRC.
+ * Callbacks run for each valid frame before this function returns.
+ *
+ * A failsafe raised by the RC frame timeout is reported to the failsafe
+ * callback from here, so when bytes may stop arriving altogether keep calling
+ * it (with `len` 0 if need be) or poll crsf_ctx_get_latest().
+ *
+ * @param crsf The instance.
+ * @param data The received bytes.
+ * @param len The number of bytes in `data`.
+ * @return The number of valid frames decoded.
+ */
+size_t crsf_ctx_parse(crsf_t *crsf, const uint8_t *data, size_t len)
+{
+  _report_failsafe(crsf);
+  STATS(_stats_begin_chunk(crsf));
+  size_t frames = 0;
+  while (len > 0)
+  {
+    if (crsf->incoming.length == 0)
+    {
+      const uint8_t *sync = crsf_find_sync_byte(data, len, crsf->address);
+      if (sync == NULL)
       {
-      case CRSF_FRAMETYPE_LINK_STATISTICS:
-        _process_link_statistics();
-        if (link_statistics_callback != NULL)
-        {
-          link_statistics_callback(_link_statistics);
-        }
-        bool new_failsafe = calculate_failsafe();
-        if (new_failsafe != _failsafe)
-        {
-          _failsafe = new_failsafe;
-          if (failsafe_callback != NULL)
-          {
-            failsafe_callback(_failsafe);
-          }
-        }
-        break;
-      case CRSF_FRAMETYPE_RC_CHANNELS_PACKED:
-        _process_rc_channels();
-        if (rc_channels_callback != NULL)
-        {
-          rc_channels_callback(_rc_channels);
-        }
-        break;
-      default:
-        DEBUG_WARN("Unknown frame type: %02x", frameType);
+        STATS(_stats_discard(crsf, len));
         break;
       }
+      STATS(_stats_sync_found(crsf, sync - data, len - (sync - data)));
+      len -= sync - data;
+      data = sync;
+    }
+
+    const size_t count = crsf_framer_fill(&crsf->incoming, data, len);
+    data += count;
+    len -= count;
+
+    frames += _drain_incoming_frame(crsf);
+  }
+  if (crsf->baud_rate_pending != 0)
+  {
+    _apply_pending_baud_rate(crsf);
+  }
+  return frames;
+}
+
+/**
+ * @brief Copies the latest decoded channels, link statistics and failsafe state.
+ *
+ * The state is published with a seqlock after every valid frame, so this can
+ * be called at any rate from another core or an ISR without locking and
+ * without callbacks. Compare `out->seq` with the previous call to tell whether
+ * new frames have arrived.
+ *
+ * @attention An ISR that interrupts crsf_ctx_parse() on the same core can never
+ * see the update finish, so the copy is only retried a bounded number of times.
+ *
+ * @param crsf The instance.
+ * @param out Receives the snapshot, zeroed when the library is built with CRSF_SNAPSHOT set to 0.
+ * @return false if no consistent copy could be taken, in which case `out` is unspecified,
+ * or if CRSF_SNAPSHOT is 0.
+ */
+bool crsf_ctx_get_latest(const crsf_t *crsf, crsf_snapshot_t *out)
+{
+#if CRSF_SNAPSHOT
+  for (int attempt = 0; attempt < CRSF_SNAPSHOT_RETRIES; attempt++)
+  {
+    const uint32_t before = __atomic_load_n(&crsf->snapshot_lock, __ATOMIC_ACQUIRE);
+    if (before & 1)
+    {
+      continue;
+    }
+    memcpy(out, &crsf->snapshot, sizeof(*out));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&crsf->snapshot_lock, __ATOMIC_RELAXED) == before)
+    {
+      // The timeout alarm changes the failsafe without publishing a snapshot
+      out->failsafe = __atomic_load_n(&crsf->failsafe_flags, __ATOMIC_ACQUIRE) != 0;
       return true;
     }
-    else
+  }
+  return false;
+#else
+  (void)crsf;
+  memset(out, 0, sizeof(*out));
+  return false;
+#endif
+}
+
+/**
+ * @brief Copies the parser counters and frame timing histograms.
+ *
+ * Like crsf_ctx_get_latest() this takes no lock, so it can run on the other
+ * core or in an ISR while frames are being parsed. Only collected when the
+ * library is built with CRSF_STATS set to 1.
+ *
+ * @param crsf The instance.
+ * @param out Receives the statistics, zeroed when they are not collected.
+ * @return false if CRSF_STATS is 0 or no consistent copy could be taken.
+ */
+bool crsf_ctx_get_stats(const crsf_t *crsf, crsf_stats_t *out)
+{
+#if CRSF_STATS
+  for (int attempt = 0; attempt < CRSF_SNAPSHOT_RETRIES; attempt++)
+  {
+    const uint32_t before = __atomic_load_n(&crsf->stats_lock, __ATOMIC_ACQUIRE);
+    if (before & 1)
     {
-      DEBUG_WARN("CRC check failed.");
+      continue;
+    }
+    memcpy(out, &crsf->stats, sizeof(*out));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&crsf->stats_lock, __ATOMIC_RELAXED) == before)
+    {
+      return true;
+    }
+  }
+  return false;
+#else
+  (void)crsf;
+  memset(out, 0, sizeof(*out));
+  return false;
+#endif
+}
+
+/**
+ * @brief Copies the parser counters and frame timing histograms of the default instance.
+ *
+ * @see crsf_ctx_get_stats
+ */
+bool crsf_get_stats(crsf_stats_t *out)
+{
+  return crsf_ctx_get_stats(&_crsf, out);
+}
+
+/**
+ * @brief Copies the latest state of the default instance.
+ *
+ * @see crsf_ctx_get_latest
+ */
+bool crsf_get_latest(crsf_snapshot_t *out)
+{
+  return crsf_ctx_get_latest(&_crsf, out);
+}
+
+/**
+ * @brief Parses a buffer of raw CRSF bytes with the default instance.
+ *
+ * @see crsf_ctx_parse
+ */
+size_t crsf_parse(const uint8_t *data, size_t len)
+{
+  return crsf_ctx_parse(&_crsf, data, len);
+}
+
+/**
+ * Processes a single byte of a CRSF frame.
+ *
+ * @deprecated Use crsf_parse(), which keeps its own state and resynchronises
+ * after a corrupt frame. The caller owns the state here and must zero
+ * `frameIndex` before the first byte.
+ *
+ * @return false if the byte was rejected or completed an invalid frame.
+ */
+bool crsf_process_frame(uint8_t *frameIndex, uint8_t *frameLength, uint8_t *crcIndex, uint8_t currentByte)
+{
+  // Frame format:
+  // [sync] [len] [type] [payload] [crc8]
+  if (*frameIndex == 0)
+  {
+    if (!crsf_is_sync_byte(currentByte, _crsf.address))
+    {
+      DEBUG_WARN("Invalid sync byte: %04x", currentByte);
+      return false;
+    }
+    _crsf.incoming.frame[(*frameIndex)++] = currentByte;
+    return true;
+  }
+  else if (*frameIndex == 1)
+  {
+    // Should be the length byte
+    _crsf.incoming.frame[(*frameIndex)++] = currentByte;
+    *frameLength = currentByte;
+    *crcIndex = *frameLength + 1;
+    if (*frameLength < CRSF_MIN_FRAME_LENGTH || *frameLength > CRSF_MAX_FRAME_LENGTH)
+    {
+      // Invalid frame length
+      *frameIndex = 0;
+      DEBUG_WARN("Frame length out of range: %d", *frameLength);
+      return false;
     }
-    // Reset the frame index
+    return true;
+  }
+  else if (*frameIndex == *crcIndex)
+  {
+    // We have read the entire frame
+    _crsf.incoming.frame[*frameIndex] = currentByte;
     *frameIndex = 0;
-    return false;
+    if (!_frame_crc_valid(_crsf.incoming.frame))
+    {
+      DEBUG_WARN("CRC check failed.");
+      return false;
+    }
+    _handle_frame(&_crsf);
+    return true;
   }
   else
   {
-    _incoming_frame[*frameIndex++] = currentByte;
+    _crsf.incoming.frame[(*frameIndex)++] = currentByte;
     return true;
   }
+}
 
-  return false;
+// Time to transmit `bytes` bytes at 8N1, rounded up
+#if CRSF_TELEMETRY
+static uint32_t _tx_time_us(const crsf_t *crsf, size_t bytes)
+{
+  return (uint32_t)((bytes * 10 * 1000000ull + crsf->baud_rate - 1) / crsf->baud_rate);
+}
+
+// Hands a telemetry frame to the transport, which may queue it (e.g. for DMA) and return at once
+static bool _transmit_telem(crsf_t *crsf, int index, uint64_t now_us, uint64_t since_us)
+{
+  crsf_telem_frame_t *frame = &crsf->telem_frames[index];
+  if (frame->crc_stale)
+  {
+    // The CRC covers the type and payload: everything after the sync and length bytes
+    frame->data[frame->length - 1] = crsf_crc8(&frame->data[2], frame->length - 3);
+    frame->crc_stale = false;
+  }
+  const crsf_transport_t *transport = crsf->transport;
+  const size_t len = frame->length;
+  if (transport->write(transport->ctx, frame->data, len) < len)
+  {
+    // Still busy with the previous frame
+    if (!crsf->telem_schedule[index].held)
+    {
+      crsf->telem_schedule[index].held = true;
+      crsf->telem_stats.deferred++;
+    }
+    return false;
+  }
+  DEBUG_INFO("Sending telemetry frame");
+  crsf->telem_stats.sent++;
+  crsf->telem_tx_end_us = now_us + _tx_time_us(crsf, len);
+  _telem_mark_sent(crsf, index, now_us, since_us);
+  return true;
+}
+
+/**
+ * Sends the most urgent telemetry frame in the reply slot after an RC frame.
+ *
+ * Only one slot in every `telem_ratio` is used, matching the downlink's
+ * telemetry ratio. Going by the measured RC packet rate, only frames that end
+ * before the next RC frame starts are considered.
+ */
+static void _send_telem_in_slot(crsf_t *crsf)
+{
+  crsf->telem_slot_open = false;
+  if (crsf->telem_credit < crsf->telem_ratio)
+  {
+    crsf->telem_credit++;
+  }
+  // The slot length is unknown until the RC packet rate has been measured
+  if (crsf->telem_credit < crsf->telem_ratio || crsf->rc_interval_us == 0)
+  {
+    return;
+  }
+
+  const uint64_t now = crsf->transport->time_us(crsf->transport->ctx);
+  // RC frames are timed from their last byte, so the next one starts arriving a frame time earlier
+  const uint64_t next_rc_start = crsf->last_rc_us + crsf->rc_interval_us - _tx_time_us(crsf, CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4);
+  const uint64_t bytes = next_rc_start > now ? (next_rc_start - now) * crsf->baud_rate / 10000000 : 0;
+  const size_t max_size = bytes > CRSF_TELEM_GUARD_BYTES ? bytes - CRSF_TELEM_GUARD_BYTES : 0;
+  // What the slot would hold had it started right as the RC frame ended
+  const uint64_t slot_bytes = next_rc_start > crsf->last_rc_us ? (next_rc_start - crsf->last_rc_us) * crsf->baud_rate / 10000000 : 0;
+  const size_t slot_max_size = slot_bytes > CRSF_TELEM_GUARD_BYTES ? slot_bytes - CRSF_TELEM_GUARD_BYTES : 0;
+
+  uint32_t too_large;
+  uint64_t since;
+  const int index = _telem_pick(crsf, now, max_size, &too_large, &since);
+  for (int i = 0; too_large != 0; i++, too_large >>= 1)
+  {
+    crsf_telem_schedule_t *schedule = &crsf->telem_schedule[i];
+    if ((too_large & 1) && !schedule->held)
+    {
+      schedule->held = true;
+      if (crsf->telem_frames[i].length > slot_max_size)
+      {
+        crsf->telem_stats.oversized++;
+      }
+      else
+      {
+        crsf->telem_stats.deferred++;
+      }
+    }
+  }
+  if (index >= 0 && _transmit_telem(crsf, index, now, since))
+  {
+    crsf->telem_credit = 0;
+  }
+}
+#endif
+
+/**
+ * Sends the most urgent waiting telemetry frame, if any, without waiting for a reply slot.
+ *
+ * @param crsf The instance.
+ */
+void crsf_ctx_send_telem(crsf_t *crsf)
+{
+#if CRSF_TELEMETRY
+  if (crsf->transport == NULL)
+  {
+    return;
+  }
+  const uint64_t now = crsf->transport->time_us(crsf->transport->ctx);
+  uint32_t too_large;
+  uint64_t since;
+  const int index = _telem_pick(crsf, now, CRSF_MAX_FRAME_SIZE, &too_large, &since);
+  if (index >= 0)
+  {
+    _transmit_telem(crsf, index, now, since);
+  }
+#else
+  (void)crsf;
+#endif
 }
 
 void crsf_send_telem()
 {
-  // Send telemetry
-  if (crsf_telem_update())
+  crsf_ctx_send_telem(&_crsf);
+}
+
+/**
+ * @brief Processes incoming CRSF frames.
+ *
+ * Parses everything the transport has received without waiting for more.
+ * After each valid RC frame a single pending telemetry frame is sent, provided
+ * it fits before the next RC frame is expected.
+ *
+ * @attention Invoke this as frequently as possible to avoid missing frames.
+ *
+ * @param crsf The instance.
+ */
+void crsf_ctx_process_frames(crsf_t *crsf)
+{
+  const crsf_transport_t *transport = crsf->transport;
+  if (transport == NULL)
+  {
+    return;
+  }
+
+  uint8_t chunk[CRSF_MAX_FRAME_SIZE];
+  size_t count;
+  while ((count = transport->read(transport->ctx, chunk, sizeof(chunk))) > 0)
   {
-    DEBUG_INFO("Sending telemetry frame");
-    for (size_t i = 0; i < _telem_buf.offset; i++)
+#if CRSF_TELEMETRY
+    if (crsf->telem_tx_end_us != 0)
+    {
+      // When the first of these bytes started arriving
+      const uint64_t arrival = transport->time_us(transport->ctx) - _tx_time_us(crsf, count);
+      if (arrival < crsf->telem_tx_end_us)
+      {
+        crsf->telem_stats.collisions++;
+      }
+      crsf->telem_tx_end_us = 0;
+    }
+#endif
+    crsf_ctx_parse(crsf, chunk, count);
+#if CRSF_TELEMETRY
+    if (crsf->telem_slot_open)
     {
-      uart_putc(_uart, _telem_buf.buffer[i]);
+      _send_telem_in_slot(crsf);
     }
+#endif
   }
+  if (crsf->autobaud_index >= 0)
+  {
+    _autobaud_step(crsf);
+  }
+}
+
+/**
+ * Copies the telemetry transmit counters.
+ *
+ * @param crsf The instance.
+ * @param out Receives the counters, zeroed when the library is built with CRSF_TELEMETRY set to 0.
+ */
+void crsf_ctx_get_telem_stats(const crsf_t *crsf, crsf_telem_stats_t *out)
+{
+#if CRSF_TELEMETRY
+  *out = crsf->telem_stats;
+#else
+  (void)crsf;
+  memset(out, 0, sizeof(*out));
+#endif
+}
+
+/**
+ * Copies the telemetry transmit counters of the default instance.
+ */
+void crsf_get_telem_stats(crsf_telem_stats_t *out)
+{
+  crsf_ctx_get_telem_stats(&_crsf, out);
 }
 
 /**
  * @brief Processes incoming CRSF frames.
  *
  * This function will attempt to process an incoming CRSF frame.
- * Once the UART queue is empty, a single pending telemetry frame will be sent.
+ * A pending telemetry frame is sent in the slot after each valid RC frame.
+ * When started with crsf_begin_irq(), only the bytes already queued by the IRQ
+ * are parsed and the function does not wait for the line to go idle.
  *
  * @attention Invoke this as frequently as possible to avoid missing frames.
  *
@@ -501,21 +1969,117 @@ void crsf_send_telem()
  * @related crsf_set_on_link_statistics
  * @related crsf_set_on_failsafe
  */
-void crsf_process_frames() 
+void crsf_process_frames()
+{
+  crsf_ctx_process_frames(&_crsf);
+}
+
+#if CRSF_TELEMETRY
+// Queues telemetry type `index` for sending if its frame changed, or if it never had data
+static void _telem_mark_dirty(crsf_t *crsf, int index, bool changed)
+{
+  crsf_telem_schedule_t *schedule = &crsf->telem_schedule[index];
+  if (changed)
+  {
+    crsf->telem_frames[index].crc_stale = true;
+  }
+  else if (schedule->has_data)
+  {
+    return;
+  }
+  if (!schedule->dirty)
+  {
+    schedule->dirty_us = _now_us(crsf);
+  }
+  schedule->has_data = true;
+  schedule->dirty = true;
+}
+#endif
+
+/**
+ * Sets the battery data in the telemetry structure.
+ *
+ * Only the fields that differ from the last call are written into the encoded
+ * frame; setting the same values again does not queue another send.
+ *
+ * @param crsf The instance.
+ * @param voltage The battery voltage in dv
+ * @param current The battery current in dA
+ * @param capacity The battery capacity in mAH
+ * @param percent The battery percentage remaining.
+ */
+void crsf_ctx_telem_set_battery_data(crsf_t *crsf, uint16_t voltage, uint16_t current, uint32_t capacity, uint8_t percent)
+{
+#if CRSF_TELEMETRY
+  const crsf_payload_battery_sensor_t battery_sensor = {
+      .voltage = voltage,
+      .current = current,
+      .capacity = capacity,
+      .percent = percent,
+  };
+  uint8_t *payload = &crsf->telem_frames[CRSF_BATTERY_INDEX].data[3];
+  _telem_mark_dirty(crsf, CRSF_BATTERY_INDEX, crsf_patch_battery_sensor(payload, &battery_sensor));
+#else
+  (void)crsf;
+  (void)voltage;
+  (void)current;
+  (void)capacity;
+  (void)percent;
+#endif
+}
+
+/**
+ * Sets the payload of the custom (0x7F) telemetry frame.
+ *
+ * A payload that has not been sent yet is replaced; check crsf_ctx_telem_pending()
+ * first, or use crsf_fragment.h to queue payloads of any size.
+ *
+ * @param crsf The instance.
+ * @param data The payload bytes.
+ * @param length The number of bytes in `data`.
+ * @return false, leaving the frame unchanged, if the payload does not fit a frame of
+ * CRSF_MAX_FRAME_SIZE bytes (60 bytes by default), or if CRSF_TELEMETRY is 0.
+ */
+bool crsf_ctx_telem_set_custom_payload(crsf_t *crsf, const uint8_t *data, uint8_t length)
 {
-  // check if there is data available to read
-  uint8_t frameIndex = 0;
-  uint8_t frameLength = 0;
-  uint8_t crcIndex = 0;
-  // It takes 23.8095238095 µs to receive the next byte at 420000 baud
-  while (uart_is_readable_within_us(_uart, 24))
+#if CRSF_TELEMETRY
+  crsf_telem_frame_t *frame = &crsf->telem_frames[CRSF_CUSTOM_PAYLOAD_INDEX];
+  if (length > sizeof(((crsf_payload_custom_t *)0)->buffer))
+  {
+    return false;
+  }
+  const bool changed = frame->length != length + 4 || memcmp(&frame->data[3], data, length) != 0;
+  if (changed)
   {
-    // read the data
-    uint8_t currentByte = uart_getc(_uart);
-    crsf_process_frame(&frameIndex, &frameLength, &crcIndex, currentByte);
+    memcpy(&frame->data[3], data, length);
+    frame->data[1] = length + 2;
+    frame->length = length + 4;
   }
+  _telem_mark_dirty(crsf, CRSF_CUSTOM_PAYLOAD_INDEX, changed);
+  return true;
+#else
+  (void)crsf;
+  (void)data;
+  (void)length;
+  return false;
+#endif
+}
 
-  crsf_send_telem();
+/**
+ * Tells whether a telemetry frame type has been set and is still waiting to be sent.
+ *
+ * @param crsf The instance.
+ * @param index The frame type, e.g. CRSF_CUSTOM_PAYLOAD_INDEX.
+ */
+bool crsf_ctx_telem_pending(const crsf_t *crsf, uint8_t index)
+{
+#if CRSF_TELEMETRY
+  return index < CRSF_TELEMETRY_FRAME_TYPES && crsf->telem_schedule[index].dirty;
+#else
+  (void)crsf;
+  (void)index;
+  return false;
+#endif
 }
 
 /**
@@ -528,20 +2092,106 @@ void crsf_process_frames()
  */
 void crsf_telem_set_battery_data(uint16_t voltage, uint16_t current, uint32_t capacity, uint8_t percent)
 {
-  _telemetry.battery_sensor.voltage = voltage;
-  _telemetry.battery_sensor.current = current;
-  _telemetry.battery_sensor.capacity = capacity;
-  _telemetry.battery_sensor.percent = percent;
-  frameHasData[CRSF_BATTERY_INDEX] = true;
+  crsf_ctx_telem_set_battery_data(&_crsf, voltage, current, capacity, percent);
+}
+
+bool crsf_telem_set_custom_payload(uint8_t *data, uint8_t length)
+{
+  return crsf_ctx_telem_set_custom_payload(&_crsf, data, length);
+}
+
+bool crsf_telem_pending(uint8_t index)
+{
+  return crsf_ctx_telem_pending(&_crsf, index);
+}
+
+/**
+ * Sets how often and how urgently a telemetry frame type is sent.
+ *
+ * @param crsf The instance.
+ * @param index The frame type, e.g. CRSF_BATTERY_INDEX.
+ * @param rate_hz Frames per second while the type has data, or 0 to send only when its data is set.
+ * @param priority Higher priorities are sent first when several frames are waiting.
+ */
+void crsf_ctx_telem_set_schedule(crsf_t *crsf, uint8_t index, uint16_t rate_hz, uint8_t priority)
+{
+#if CRSF_TELEMETRY
+  if (index < CRSF_TELEMETRY_FRAME_TYPES)
+  {
+    crsf->telem_schedule[index].rate_hz = rate_hz;
+    crsf->telem_schedule[index].priority = priority;
+  }
+#else
+  (void)crsf;
+  (void)index;
+  (void)rate_hz;
+  (void)priority;
+#endif
+}
+
+/**
+ * Sets the downlink telemetry ratio: one telemetry frame is sent for every `ratio` RC frames.
+ *
+ * Match the receiver's telemetry ratio (e.g. 8 for ELRS 1:8) so frames are not
+ * queued faster than the radio link can carry them.
+ *
+ * @param crsf The instance.
+ * @param ratio RC frames per telemetry frame, at least 1.
+ */
+void crsf_ctx_telem_set_ratio(crsf_t *crsf, uint8_t ratio)
+{
+#if CRSF_TELEMETRY
+  crsf->telem_ratio = ratio > 0 ? ratio : 1;
+  crsf->telem_credit = 0;
+#else
+  (void)crsf;
+  (void)ratio;
+#endif
 }
 
-void crsf_telem_set_custom_payload(uint8_t *data, uint8_t length)
+/**
+ * Reports the achieved rate and queueing latency of a telemetry frame type.
+ *
+ * @param crsf The instance.
+ * @param index The frame type, e.g. CRSF_BATTERY_INDEX.
+ * @param out Receives the statistics.
+ */
+void crsf_ctx_get_telem_type_stats(const crsf_t *crsf, uint8_t index, crsf_telem_type_stats_t *out)
 {
-  if (length > 60)
+  memset(out, 0, sizeof(*out));
+#if CRSF_TELEMETRY
+  if (index >= CRSF_TELEMETRY_FRAME_TYPES)
   {
     return;
   }
-  memcpy(_telemetry.custom.buffer, data, length);
-  _telemetry.custom.length = length;
-  frameHasData[CRSF_CUSTOM_PAYLOAD_INDEX] = true;
+  const crsf_telem_schedule_t *schedule = &crsf->telem_schedule[index];
+  out->sent = schedule->sent;
+  if (schedule->sent > 1 && schedule->last_sent_us > schedule->first_sent_us)
+  {
+    out->achieved_hz = (schedule->sent - 1) * 1e6f / (float)(schedule->last_sent_us - schedule->first_sent_us);
+  }
+  if (schedule->sent > 0)
+  {
+    out->latency_avg_us = schedule->latency_sum_us / schedule->sent;
+  }
+  out->latency_max_us = schedule->latency_max_us;
+#else
+  (void)crsf;
+  (void)index;
+#endif
+}
+
+void crsf_telem_set_schedule(uint8_t index, uint16_t rate_hz, uint8_t priority)
+{
+  crsf_ctx_telem_set_schedule(&_crsf, index, rate_hz, priority);
+}
+
+void crsf_telem_set_ratio(uint8_t ratio)
+{
+  crsf_ctx_telem_set_ratio(&_crsf, ratio);
+}
+
+void crsf_get_telem_type_stats(uint8_t index, crsf_telem_type_stats_t *out)
+{
+  crsf_ctx_get_telem_type_stats(&_crsf, index, out);
 }
@@ -13,120 +13,442 @@
  *
  */
 #pragma once
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include "crsf_alarm.h"
+#include "crsf_channels.h"
+#include "crsf_condition.h"
+#include "crsf_config.h"
+#include "crsf_crc.h"
+#include "crsf_frames.h"
+#include "crsf_framing.h"
+#include "crsf_transport.h"
+
+// Set to 1 by the host (Linux) build, which does not use the Pico SDK
+#ifndef CRSF_HOST
+#define CRSF_HOST 0
+#endif
+
+#if !CRSF_HOST
 #include "pico/stdlib.h"
+#endif
 
-typedef struct {
-	uint8_t buffer[60];
-	uint8_t length;
-} crsf_payload_custom_t;
-
-// BEGIN gen_frames.dart
-// The values are CRSF channel values (0-1984). CRSF 172 represents 988us, CRSF 992 represents 1500us, and CRSF 1811 represents 2012us.
-typedef struct __attribute__((packed)) {
-	unsigned channel0 : 11;
-	unsigned channel1 : 11;
-	unsigned channel2 : 11;
-	unsigned channel3 : 11;
-	unsigned channel4 : 11;
-	unsigned channel5 : 11;
-	unsigned channel6 : 11;
-	unsigned channel7 : 11;
-	unsigned channel8 : 11;
-	unsigned channel9 : 11;
-	unsigned channel10 : 11;
-	unsigned channel11 : 11;
-	unsigned channel12 : 11;
-	unsigned channel13 : 11;
-	unsigned channel14 : 11;
-	unsigned channel15 : 11;
-} crsf_payload_rc_channels_packed_t;
-
-typedef struct {
-	// voltage in dV (Big Endian)
-	uint16_t voltage;
-	// current in dA (Big Endian)
-	uint16_t current;
-	// used capacity in mAh
-	uint32_t capacity;
-	// estimated battery remaining in percent (%)
-	uint8_t percent;
-} crsf_payload_battery_sensor_t;
-
-typedef struct {
-	// Uplink RSSI Ant. 1 ( dBm * -1 )
-	uint8_t uplink_rssi_ant_1;
-	// Uplink RSSI Ant. 2 ( dBm * -1 )
-	uint8_t uplink_rssi_ant_2;
-	// Uplink Package success rate / Link quality ( % )
-	uint8_t uplink_package_success_rate;
-	// Uplink SNR ( dB, or dB*4 for TBS I believe )
-	int8_t uplink_snr;
-	// Diversity active antenna ( enum ant. 1 = 0, ant. 2 = 1 )
-	uint8_t diversity_active_antenna;
-	// RF Mode ( 500Hz, 250Hz etc, varies based on ELRS Band or TBS )
-	uint8_t rf_mode;
-	// Uplink TX Power ( enum 0mW = 0, 10mW, 25 mW, 100 mW, 500 mW, 1000 mW, 2000mW, 50mW )
-	uint8_t uplink_tx_power;
-	// Downlink RSSI ( dBm * -1 )
-	uint8_t downlink_rssi;
-	// Downlink package success rate / Link quality ( % )
-	uint8_t downlink_package_success_rate;
-	// Downlink SNR ( dB )
-	int8_t downlink_snr;
-} crsf_payload_link_statistics_t;
+#if CRSF_TELEMETRY && !CRSF_FRAME_BATTERY_SENSOR
+#error "CRSF_TELEMETRY needs CRSF_FRAME_BATTERY_SENSOR, whose encoder builds the battery frame"
+#endif
 
 typedef struct
 {
-	crsf_payload_rc_channels_packed_t rc_channels_packed;
-	crsf_payload_battery_sensor_t battery_sensor;
-	crsf_payload_link_statistics_t link_statistics;
-	crsf_payload_custom_t custom;
-} telemetry_t;
+    uint8_t rssi;
+    uint8_t link_quality;
+    int8_t snr;
+    uint16_t tx_power;
+} link_statistics_t;
+
+// Float, so soft-float on the RP2040. CRSF_TICKS_TO_US() in crsf_condition.h is integer only.
+#define TICKS_TO_US(x) ((x - 992.0f) * 5.0f / 8.0f + 1500.0f)
 
-typedef enum
+// Telemetry frames sent round-robin by crsf_send_telem()
+enum
 {
-	CRSF_FRAMETYPE_RC_CHANNELS_PACKED = 0x16,
-	CRSF_FRAMETYPE_BATTERY_SENSOR = 0x08,
-	CRSF_FRAMETYPE_LINK_STATISTICS = 0x14,
-	CRSF_FRAMETYPE_CUSTOM_PAYLOAD = 0x7F,
+    CRSF_BATTERY_INDEX = 0,
+    CRSF_CUSTOM_PAYLOAD_INDEX = 1,
+    // Add new frame types above
+    CRSF_TELEMETRY_FRAME_TYPES
+};
 
-} frame_type_t;
-// END gen_frames.dart
+/**
+ * @brief Latest decoded state, copied out by crsf_get_latest().
+ */
+typedef struct
+{
+    uint16_t channels[CRSF_RC_CHANNELS];
+    // Channels after crsf_ctx_set_conditioner()'s conditioner, 0 without one
+    int16_t conditioned[CRSF_RC_CHANNELS];
+    link_statistics_t link_statistics;
+    bool failsafe;
+    // Valid frames decoded so far, 0 until the first one arrives
+    uint32_t seq;
+    // Transport time of the latest frame in microseconds, 0 without a transport
+    uint64_t timestamp_us;
+} crsf_snapshot_t;
 
 typedef struct
 {
-    uint8_t *buffer;
-    size_t capacity;
-    size_t offset;
-} buffer_t;
+    // Telemetry frames handed to the transport
+    uint32_t sent;
+    // Frames held back because they would not fit before the next RC frame, or the transmitter was busy,
+    // counted once each time a frame becomes due however many slots it waits
+    uint32_t deferred;
+    // Frames too long for even a whole reply slot at the measured RC rate and baud rate, counted the same way
+    uint32_t oversized;
+    // Frames still being transmitted when the next frame started arriving
+    uint32_t collisions;
+} crsf_telem_stats_t;
 
+/**
+ * @brief A telemetry frame kept encoded between sends.
+ *
+ * Setters patch the bytes of the fields that changed and the CRC is refreshed
+ * before the next send, so sending is a pointer and a length.
+ */
 typedef struct
 {
-    uint8_t rssi;
-    uint8_t link_quality;
-    int8_t snr;
-    uint16_t tx_power;
-} link_statistics_t;
+    // [sync] [len] [type] [payload] [crc8]
+    uint8_t data[CRSF_MAX_FRAME_SIZE];
+    uint8_t length;
+    // Set when the payload changed since the CRC was last computed
+    bool crc_stale;
+} crsf_telem_frame_t;
 
-#define TICKS_TO_US(x) ((x - 992.0f) * 5.0f / 8.0f + 1500.0f)
+/**
+ * @brief When and how urgently one telemetry frame type is sent.
+ *
+ * Types with a rate are sent every 1 / rate_hz seconds while they have data;
+ * types without one are sent once each time their data changes.
+ */
+typedef struct
+{
+    // Target frames per second, 0 to send only when the data is set
+    uint16_t rate_hz;
+    // The highest priority wins when several frames are waiting for a slot
+    uint8_t priority;
+    bool has_data;
+    // Set since the last send
+    bool dirty;
+    uint64_t dirty_us;
+    // Held back from a slot since it was last sent, so it is counted only once
+    bool held;
+    uint64_t first_sent_us;
+    uint64_t last_sent_us;
+    uint32_t sent;
+    uint64_t latency_sum_us;
+    uint32_t latency_max_us;
+} crsf_telem_schedule_t;
+
+typedef struct
+{
+    uint32_t sent;
+    // Frames per second between the first and the latest send
+    float achieved_hz;
+    // Time from a frame becoming due (or being set) to it being handed to the transport
+    uint32_t latency_avg_us;
+    uint32_t latency_max_us;
+} crsf_telem_type_stats_t;
+
+// Histogram bucket i counts values in [2^i, 2^(i + 1)) ns, the last one everything above
+#define CRSF_STATS_BUCKETS 28
+
+typedef struct
+{
+    uint32_t buckets[CRSF_STATS_BUCKETS];
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} crsf_histogram_t;
+
+/**
+ * @brief Parser counters and per-frame timing, collected when CRSF_STATS is 1.
+ *
+ * Times are in nanoseconds (microsecond resolution on the RP2040). A frame's
+ * bytes are taken to have arrived back to back at the link's baud rate, with
+ * the last byte handed to crsf_ctx_parse() arriving just before the call, so
+ * the sync and CRC timestamps are estimates that assume the caller drains the
+ * UART promptly.
+ */
+typedef struct
+{
+    // Frames with a valid CRC
+    uint32_t frames;
+    uint32_t crc_errors;
+    // Length bytes outside 2 - 62
+    uint32_t bad_lengths;
+    // Valid frames of a type without a decoder
+    uint32_t unknown_types;
+    // Valid frames too short for their type
+    uint32_t malformed;
+    // Times the parser dropped a frame start and searched for the next sync byte
+    uint32_t resyncs;
+    // Bytes skipped outside valid frames, including the sync bytes of rejected ones
+    uint64_t bytes_discarded;
+
+    // Estimated arrival of the latest valid frame's sync and CRC bytes
+    uint64_t last_sync_ns;
+    uint64_t last_crc_ns;
+    // Sync byte to the start of the callbacks
+    crsf_histogram_t latency_ns;
+    // Payload decode
+    crsf_histogram_t decode_ns;
+    // Internal handlers and callbacks of one frame
+    crsf_histogram_t callback_ns;
+    // Between the sync bytes of consecutive RC frames
+    crsf_histogram_t rc_interval_ns;
+} crsf_stats_t;
+
+// Rate every CRSF link starts at
+#define CRSF_BAUD_RATE_DEFAULT 420000
+// Rates tried by crsf_ctx_start_autobaud() and accepted in baud rate proposals, slowest first
+#define CRSF_BAUD_RATE_COUNT 6
+
+// Device addresses used by the extended frame header
+#define CRSF_ADDRESS_BROADCAST 0x00
+#define CRSF_ADDRESS_FLIGHT_CONTROLLER 0xC8
+#define CRSF_ADDRESS_RADIO_TRANSMITTER 0xEA
+#define CRSF_ADDRESS_CRSF_RECEIVER 0xEC
+#define CRSF_ADDRESS_CRSF_TRANSMITTER 0xEE
+
+// RADIO_ID (0x3A) sub-type of the timing correction a TX module sends the handset
+#define CRSF_RADIO_ID_TIMING_CORRECTION 0x10
+
+// Reasons for the failsafe to be active, see crsf_t.failsafe_flags
+// Link quality or RSSI crossed its threshold, or no link statistics yet
+#define CRSF_FAILSAFE_LINK 0x01
+// No RC frame within the timeout set by crsf_ctx_set_failsafe_timeout_us()
+#define CRSF_FAILSAFE_TIMEOUT 0x02
+#ifndef CRSF_FAILSAFE_RECOVERY_FRAMES
+// On-time RC frames needed to leave a timeout failsafe, so a flaky link does not toggle it
+#define CRSF_FAILSAFE_RECOVERY_FRAMES 10
+#endif
+
+// Dirty mask with every channel set, as delivered by the keep-alive
+#define CRSF_ALL_CHANNELS 0xFFFF
+#ifndef CRSF_RC_KEEPALIVE_US
+// Period at which the changed channels callback re-delivers every channel
+#define CRSF_RC_KEEPALIVE_US 100000
+#endif
+// The RC payload rounded up to whole words, for comparing frames
+#define CRSF_RC_PAYLOAD_WORDS ((CRSF_RC_CHANNELS_PAYLOAD_SIZE + 3) / 4)
+
+/**
+ * @brief Latest timing correction from a TX module, see crsf_ctx_get_timing_correction().
+ */
+typedef struct
+{
+    // Frame interval the module runs at, in tenths of a microsecond
+    uint32_t interval;
+    // How much earlier than the module wanted the last RC frame arrived, in tenths of a microsecond
+    int32_t offset;
+    // Corrections received so far
+    uint32_t count;
+    // Transport time it arrived, 0 without a transport
+    uint64_t received_us;
+} crsf_timing_correction_t;
+
+typedef struct crsf_s crsf_t;
+
+/**
+ * @brief State of one CRSF link.
+ *
+ * Holds everything the parser and telemetry encoder need, so several links can
+ * run side by side (e.g. one per UART or one per core) without heap
+ * allocation. Set up with crsf_init() and only access it through the crsf_ctx_*
+ * functions, apart from `user_data`.
+ */
+struct crsf_s
+{
+    const crsf_transport_t *transport;
+
+    // Parser: bytes of the frame being received and their running CRC
+    crsf_framer_t incoming;
+
+    // Last decoded values
+    uint16_t rc_channels[CRSF_RC_CHANNELS];
+    // Previous RC payload, XORed with each new one to skip unpacking repeats
+    uint32_t rc_payload_words[CRSF_RC_PAYLOAD_WORDS];
+    bool rc_payload_valid;
+#if CRSF_CALLBACKS
+    // Change detection: values last passed to rc_changed_callback, how far each
+    // channel must move from them to be delivered, and the keep-alive period (0 for none)
+    uint16_t rc_delivered[CRSF_RC_CHANNELS];
+    uint16_t rc_change_thresholds[CRSF_RC_CHANNELS];
+    uint32_t rc_keepalive_us;
+    // Transport time of the last full delivery, valid once one has happened
+    uint64_t rc_delivered_us;
+    bool rc_delivered_valid;
+#endif
+    // Optional conditioning of every RC frame, NULL for none
+    crsf_conditioner_t *conditioner;
+    int16_t conditioned_channels[CRSF_RC_CHANNELS];
+    link_statistics_t link_statistics;
+    uint8_t link_quality_threshold;
+    uint8_t rssi_threshold;
+
+#if CRSF_CALLBACKS
+    void (*rc_channels_callback)(crsf_t *crsf, const uint16_t channels[16]);
+    void (*conditioned_channels_callback)(crsf_t *crsf, const int16_t channels[16]);
+    void (*rc_changed_callback)(crsf_t *crsf, const uint16_t channels[16], uint16_t dirty);
+    void (*link_statistics_callback)(crsf_t *crsf, const link_statistics_t link_stats);
+    void (*failsafe_callback)(crsf_t *crsf, const bool failsafe);
+    void (*frame_callback)(crsf_t *crsf, frame_type_t type, const crsf_frame_payload_t *payload);
+    void (*baud_rate_callback)(crsf_t *crsf, uint32_t baud_rate);
+#endif
+    // Free for the application, e.g. to find its own state from a callback
+    void *user_data;
+
+#if CRSF_SNAPSHOT
+    // Published after every valid frame. `snapshot_lock` is odd while an update is in progress.
+    uint32_t snapshot_lock;
+    crsf_snapshot_t snapshot;
+#endif
+
+#if CRSF_TELEMETRY
+    // Telemetry
+    crsf_telem_frame_t telem_frames[CRSF_TELEMETRY_FRAME_TYPES];
+    crsf_telem_schedule_t telem_schedule[CRSF_TELEMETRY_FRAME_TYPES];
+    // Telemetry frames per RC frame the downlink carries is 1 / telem_ratio
+    uint8_t telem_ratio;
+    // Reply slots seen since the last telemetry frame
+    uint8_t telem_credit;
+#endif
+
+    // Telemetry slot timing, in transport microseconds. Every byte time is
+    // derived from `baud_rate`, the rate the line currently runs at.
+    uint32_t baud_rate;
+    uint64_t last_rc_us;
+    // Smoothed time between RC frames, 0 until two have arrived
+    uint32_t rc_interval_us;
+#if CRSF_TELEMETRY
+    // Set by an RC frame, cleared once the reply slot after it has been used
+    bool telem_slot_open;
+    // When the last telemetry frame finishes transmitting
+    uint64_t telem_tx_end_us;
+    crsf_telem_stats_t telem_stats;
+#endif
+
+    // Failsafe. `failsafe_flags` holds the active CRSF_FAILSAFE_* reasons and
+    // is also written by the timeout alarm, so it is only accessed atomically.
+    uint32_t failsafe_flags;
+    // Last state passed to failsafe_callback
+    bool failsafe_reported;
+    // 0 while the RC frame timeout is disabled
+    uint32_t failsafe_timeout_us;
+    // RC frames received since the timeout last expired
+    uint8_t failsafe_recovery_frames;
+    crsf_alarm_t failsafe_alarm;
+
+    // Baud rate negotiation. Proposals addressed to `address` are accepted up
+    // to `baud_rate_max`, and the switch happens at the end of the crsf_ctx_parse()
+    // call that received them, once the response has been sent.
+    uint8_t address;
+    uint32_t baud_rate_max;
+    uint32_t baud_rate_pending;
+    // Sent with crsf_ctx_propose_baud_rate() and awaiting a response, 0 if none
+    uint32_t baud_rate_proposed;
+    uint8_t baud_rate_proposed_to;
+
+    // Autodetection: index into crsf_baud_rates being tried (-1 when idle),
+    // valid frames needed to lock and when the candidate was switched to
+    int8_t autobaud_index;
+    uint8_t autobaud_lock_frames;
+    uint64_t autobaud_since_us;
+    // Valid frames in a row since the last CRC or length error
+    uint32_t valid_frame_run;
+
+    // Latest RADIO_ID timing correction addressed to this device
+    crsf_timing_correction_t timing_correction;
+
+#if CRSF_STATS
+    // Published with a seqlock like the snapshot, odd while an update is in progress
+    uint32_t stats_lock;
+    crsf_stats_t stats;
+    // Estimated arrival of incoming.frame[0]
+    uint64_t stats_sync_ns;
+    // When the current crsf_ctx_parse() call started, and the wire time of one byte
+    uint64_t stats_chunk_end_ns;
+    uint32_t stats_byte_ns;
+    // Sync byte of the previous RC frame, 0 before the first
+    uint64_t stats_last_rc_ns;
+#endif
+};
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+    extern const uint32_t crsf_baud_rates[CRSF_BAUD_RATE_COUNT];
+
+    void crsf_init(crsf_t *crsf, const crsf_transport_t *transport);
+    crsf_t *crsf_default(void);
+    void crsf_ctx_set_link_quality_threshold(crsf_t *crsf, uint8_t threshold);
+    void crsf_ctx_set_rssi_threshold(crsf_t *crsf, uint8_t threshold);
+    bool crsf_ctx_set_failsafe_timeout_us(crsf_t *crsf, uint32_t timeout_us);
+    void crsf_ctx_telem_set_battery_data(crsf_t *crsf, uint16_t voltage, uint16_t current, uint32_t capacity, uint8_t percent);
+    bool crsf_ctx_telem_set_custom_payload(crsf_t *crsf, const uint8_t *data, uint8_t length);
+    bool crsf_ctx_telem_pending(const crsf_t *crsf, uint8_t index);
+    size_t crsf_ctx_parse(crsf_t *crsf, const uint8_t *data, size_t len);
+    void crsf_ctx_process_frames(crsf_t *crsf);
+    void crsf_ctx_send_telem(crsf_t *crsf);
+    bool crsf_ctx_get_latest(const crsf_t *crsf, crsf_snapshot_t *out);
+    void crsf_ctx_get_telem_stats(const crsf_t *crsf, crsf_telem_stats_t *out);
+    void crsf_ctx_telem_set_schedule(crsf_t *crsf, uint8_t index, uint16_t rate_hz, uint8_t priority);
+    void crsf_ctx_telem_set_ratio(crsf_t *crsf, uint8_t ratio);
+    void crsf_ctx_get_telem_type_stats(const crsf_t *crsf, uint8_t index, crsf_telem_type_stats_t *out);
+    bool crsf_ctx_get_stats(const crsf_t *crsf, crsf_stats_t *out);
+    bool crsf_ctx_set_baud_rate(crsf_t *crsf, uint32_t baud_rate);
+    uint32_t crsf_ctx_get_baud_rate(const crsf_t *crsf);
+    void crsf_ctx_set_address(crsf_t *crsf, uint8_t address);
+    void crsf_ctx_set_max_baud_rate(crsf_t *crsf, uint32_t baud_rate);
+    bool crsf_ctx_propose_baud_rate(crsf_t *crsf, uint8_t destination, uint32_t baud_rate);
+    bool crsf_ctx_start_autobaud(crsf_t *crsf, uint8_t lock_frames);
+    void crsf_ctx_set_conditioner(crsf_t *crsf, crsf_conditioner_t *conditioner);
+    bool crsf_ctx_get_timing_correction(const crsf_t *crsf, crsf_timing_correction_t *out);
+#if CRSF_CALLBACKS
+    void crsf_ctx_set_on_rc_channels(crsf_t *crsf, void (*callback)(crsf_t *crsf, const uint16_t channels[16]));
+    void crsf_ctx_set_on_link_statistics(crsf_t *crsf, void (*callback)(crsf_t *crsf, const link_statistics_t link_stats));
+    void crsf_ctx_set_on_failsafe(crsf_t *crsf, void (*callback)(crsf_t *crsf, const bool failsafe));
+    void crsf_ctx_set_on_frame(crsf_t *crsf, void (*callback)(crsf_t *crsf, frame_type_t type, const crsf_frame_payload_t *payload));
+    void crsf_ctx_set_on_baud_rate(crsf_t *crsf, void (*callback)(crsf_t *crsf, uint32_t baud_rate));
+    void crsf_ctx_set_on_rc_channels_changed(crsf_t *crsf, void (*callback)(crsf_t *crsf, const uint16_t channels[16], uint16_t dirty));
+    void crsf_ctx_set_channel_threshold(crsf_t *crsf, uint8_t channel, uint16_t threshold);
+    void crsf_ctx_set_rc_keepalive_us(crsf_t *crsf, uint32_t keepalive_us);
+    void crsf_ctx_set_on_conditioned_channels(crsf_t *crsf, void (*callback)(crsf_t *crsf, const int16_t channels[16]));
+#endif
+
+    // The functions below act on the default instance returned by crsf_default()
     void crsf_telem_set_battery_data(uint16_t voltage, uint16_t current, uint32_t capacity, uint8_t percent);
-	void crsf_telem_set_custom_payload(uint8_t *data, uint8_t length);
+	bool crsf_telem_set_custom_payload(uint8_t *data, uint8_t length);
+    bool crsf_telem_pending(uint8_t index);
     void crsf_set_link_quality_threshold(uint8_t threshold);
     void crsf_set_rssi_threshold(uint8_t threshold);
+    bool crsf_set_failsafe_timeout_us(uint32_t timeout_us);
+    void crsf_begin_transport(const crsf_transport_t *transport);
+#if !CRSF_HOST
+    void crsf_begin(uart_inst_t *uart, uint8_t rx, uint8_t tx);
+    void crsf_begin_irq(uart_inst_t *uart, uint8_t tx, uint8_t rx);
+    uint32_t crsf_get_rx_overruns();
+#endif
+    void crsf_end();
+    bool crsf_get_latest(crsf_snapshot_t *out);
+    void crsf_get_telem_stats(crsf_telem_stats_t *out);
+    void crsf_telem_set_schedule(uint8_t index, uint16_t rate_hz, uint8_t priority);
+    void crsf_telem_set_ratio(uint8_t ratio);
+    void crsf_get_telem_type_stats(uint8_t index, crsf_telem_type_stats_t *out);
+    bool crsf_get_stats(crsf_stats_t *out);
+    bool crsf_set_baud_rate(uint32_t baud_rate);
+    uint32_t crsf_get_baud_rate(void);
+    void crsf_set_address(uint8_t address);
+    void crsf_set_max_baud_rate(uint32_t baud_rate);
+    bool crsf_propose_baud_rate(uint8_t destination, uint32_t baud_rate);
+    bool crsf_start_autobaud(uint8_t lock_frames);
+    void crsf_set_conditioner(crsf_conditioner_t *conditioner);
+    bool crsf_get_timing_correction(crsf_timing_correction_t *out);
+#if CRSF_CALLBACKS
     void crsf_set_on_rc_channels(void (*callback)(const uint16_t channels[16]));
     void crsf_set_on_link_statistics(void (*callback)(const link_statistics_t link_stats));
     void crsf_set_on_failsafe(void (*callback)(const bool failsafe));
-    void crsf_begin(uart_inst_t *uart, uint8_t rx, uint8_t tx);
-    void crsf_end();
+    void crsf_set_on_frame(void (*callback)(frame_type_t type, const crsf_frame_payload_t *payload));
+    void crsf_set_on_baud_rate(void (*callback)(uint32_t baud_rate));
+    void crsf_set_on_rc_channels_changed(void (*callback)(const uint16_t channels[16], uint16_t dirty));
+    void crsf_set_channel_threshold(uint8_t channel, uint16_t threshold);
+    void crsf_set_rc_keepalive_us(uint32_t keepalive_us);
+    void crsf_set_on_conditioned_channels(void (*callback)(const int16_t channels[16]));
+#endif
     void crsf_process_frames();
 	void crsf_send_telem();
+	size_t crsf_parse(const uint8_t *data, size_t len);
 	bool crsf_process_frame(uint8_t *frameIndex, uint8_t *frameLength, uint8_t *crcIndex, uint8_t currentByte);
 
 
@@ -0,0 +1,228 @@
+/**
+ * @file crsf.hpp
+ * @author Britannio Jarrett
+ * @brief Header-only C++17 interface: typed frame codecs and a parser that calls functors.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * crsf::decode<>(), crsf::encode<>() and crsf::write_frame<>() are the typed
+ * counterparts of the crsf_decode_*() and crsf_encode_*() functions, picked by
+ * frame type at compile time from the descriptors in crsf_frames.hpp.
+ * crsf::parser<> frames a byte stream with the same crsf_framing.h helpers as
+ * crsf_ctx_parse() and hands each decoded payload straight to a handler, with
+ * no function pointer on the way.
+ *
+ * The C library is still what links: this header adds no sources, and the
+ * descriptors follow the same crsf_config.h switches.
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include <utility>
+#include "crsf.h"
+#include "crsf_frames.hpp"
+
+namespace crsf
+{
+    template <frame_type_t Type>
+    using payload_t = typename frame<Type>::payload_type;
+
+    /**
+     * @brief Decodes the payload of a `Type` frame, as crsf_decode_*() does.
+     *
+     * Fixed-size payloads are read field by field inline; bit-packed and
+     * variable-length ones call their C decoder directly.
+     *
+     * @param payload The bytes after [type], up to the CRC.
+     * @param length The number of bytes in `payload`.
+     * @param out Receives the decoded payload.
+     * @return false if the payload is too short or malformed.
+     */
+    template <frame_type_t Type>
+    inline bool decode(const uint8_t *payload, uint8_t length, payload_t<Type> &out)
+    {
+        return frame<Type>::layout::decode(payload, length, out);
+    }
+
+    /**
+     * @brief Encodes the payload of a `Type` frame, as crsf_encode_*() does.
+     *
+     * @param value The payload to encode.
+     * @param payload Receives the encoded bytes, CRSF_MAX_PAYLOAD_SIZE at most.
+     * @return The number of bytes written.
+     */
+    template <frame_type_t Type>
+    inline uint8_t encode(const payload_t<Type> &value, uint8_t *payload)
+    {
+        return frame<Type>::layout::encode(value, payload);
+    }
+
+    /**
+     * @brief Encodes a complete `Type` frame: [sync] [len] [type] [payload] [crc8].
+     *
+     * @param value The payload to encode.
+     * @param out Receives the frame, CRSF_MAX_FRAME_SIZE bytes at most.
+     * @param sync The first byte, the destination's address.
+     * @return The size of the frame in bytes.
+     */
+    template <frame_type_t Type>
+    inline uint8_t write_frame(const payload_t<Type> &value, uint8_t *out, uint8_t sync = CRSF_SYNC_BYTE)
+    {
+        const uint8_t length = encode<Type>(value, &out[3]);
+        out[0] = sync;
+        out[1] = length + 2;
+        out[2] = Type;
+        out[length + 3] = crsf_crc8(&out[2], length + 1);
+        return length + 4;
+    }
+
+#if CRSF_FRAME_RC_CHANNELS_PACKED
+    // Reads the 16 channels out of a packed RC payload with crsf_unpack_channels(),
+    // which is faster than going through the bitfields one by one
+    inline void unpack_channels(const crsf_payload_rc_channels_packed_t &rc, uint16_t channels[CRSF_RC_CHANNELS])
+    {
+        crsf_unpack_channels(reinterpret_cast<const uint8_t *>(&rc), channels);
+    }
+#endif
+
+    /**
+     * @brief Frames a CRSF byte stream and calls `Handler` with each decoded payload.
+     *
+     * Framing matches crsf_ctx_parse(): the same sync bytes, length limits and
+     * CRC, and after a bad frame the search for the next sync byte restarts
+     * inside the bytes already buffered. Each valid frame is decoded only when
+     * the handler can be called with its payload type, e.g.
+     *
+     *     struct flight
+     *     {
+     *         void operator()(const crsf_payload_rc_channels_packed_t &rc);
+     *         void operator()(const crsf_payload_gps_t &gps);
+     *     };
+     *
+     * Frames of other types are skipped without being decoded. Each call is
+     * resolved at compile time and can be inlined, whereas crsf_ctx_parse()
+     * decodes through crsf_frame_codecs and reports through the frame callback.
+     * To reach member functions of an existing object, pass a lambda that
+     * captures it, or the object itself as `parser<flight &>`.
+     *
+     * `Address` is accepted as a sync byte besides CRSF_SYNC_BYTE and
+     * CRSF_SYNC_BYTE_EDGETX, as by crsf_ctx_set_address(). It is fixed at
+     * compile time so a parser at namespace scope is zero-initialized, in .bss
+     * and without a static constructor, and the sync byte search compares
+     * against a constant.
+     *
+     * The failsafe timeout, the snapshot and telemetry are not handled here;
+     * they stay with crsf_t.
+     */
+    template <typename Handler, uint8_t Address = CRSF_ADDRESS_FLIGHT_CONTROLLER>
+    class parser
+    {
+    public:
+        /**
+         * @param handler Called with each decoded payload it accepts.
+         */
+        constexpr explicit parser(Handler handler) : _handler(std::forward<Handler>(handler))
+        {
+        }
+
+        /**
+         * @brief Parses a buffer of raw CRSF bytes.
+         *
+         * `data` may end part way through a frame and may be of any length; the
+         * rest of the frame is picked up by the next call.
+         *
+         * @return The number of valid frames, whether or not the handler took them.
+         */
+        size_t parse(const uint8_t *data, size_t len)
+        {
+            size_t frames = 0;
+            while (len > 0)
+            {
+                if (_framer.length == 0)
+                {
+                    const uint8_t *sync = crsf_find_sync_byte(data, len, Address);
+                    if (sync == nullptr)
+                    {
+                        break;
+                    }
+                    len -= sync - data;
+                    data = sync;
+                }
+
+                const size_t count = crsf_framer_fill(&_framer, data, len);
+                data += count;
+                len -= count;
+
+                frames += _drain();
+            }
+            return frames;
+        }
+
+        // Frames dropped for a bad length or CRC
+        uint32_t errors() const
+        {
+            return _errors;
+        }
+
+        Handler &handler()
+        {
+            return _handler;
+        }
+
+    private:
+        // Consumes the buffered bytes, leaving the buffer empty or holding the valid prefix of a frame
+        size_t _drain()
+        {
+            size_t frames = 0;
+            crsf_framer_status_t status;
+            while ((status = crsf_framer_check(&_framer)) != CRSF_FRAMER_INCOMPLETE)
+            {
+                if (status == CRSF_FRAMER_VALID)
+                {
+                    _dispatch(_framer.frame[2], &_framer.frame[3], _framer.frame[1] - 2);
+                    frames++;
+                }
+                else
+                {
+                    _errors++;
+                }
+                crsf_framer_realign(&_framer, status, Address);
+            }
+            return frames;
+        }
+
+        void _dispatch(uint8_t type, const uint8_t *payload, uint8_t length)
+        {
+            visit(type, [&](auto descriptor) {
+                using descriptor_t = decltype(descriptor);
+                using payload_type = typename descriptor_t::payload_type;
+                if constexpr (std::is_invocable_v<Handler &, const payload_type &>)
+                {
+                    payload_type value;
+                    if (!descriptor_t::layout::decode(payload, length, value))
+                    {
+                        return false;
+                    }
+                    _handler(static_cast<const payload_type &>(value));
+                    return true;
+                }
+                else
+                {
+                    return false;
+                }
+            });
+        }
+
+        Handler _handler;
+        crsf_framer_t _framer = {};
+        uint32_t _errors = 0;
+    };
+}
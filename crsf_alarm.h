@@ -0,0 +1,59 @@
+/**
+ * @file crsf_alarm.h
+ * @author Britannio Jarrett
+ * @brief One-shot timer used for the RC frame timeout.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Backends:
+ *   - crsf_alarm_pico.c: an RP2040 hardware timer alarm, the callback runs in its IRQ
+ *   - crsf_alarm_linux.c: a thread sleeping on CLOCK_MONOTONIC, the callback runs on it
+ *
+ * Re-arming is cheap on both (a register write, or an atomic store that the
+ * thread only picks up once the previous deadline passes), so it can be done
+ * on every frame.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+
+#if CRSF_HOST
+#include <pthread.h>
+#endif
+
+typedef struct
+{
+	void (*callback)(void *ctx);
+	void *ctx;
+#if CRSF_HOST
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	// CLOCK_MONOTONIC microseconds, 0 while disarmed
+	uint64_t deadline_us;
+	bool running;
+#else
+	// Hardware alarm number, -1 if none is claimed
+	int alarm_num;
+#endif
+} crsf_alarm_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    bool crsf_alarm_init(crsf_alarm_t *alarm, void (*callback)(void *ctx), void *ctx);
+    void crsf_alarm_deinit(crsf_alarm_t *alarm);
+    void crsf_alarm_arm(crsf_alarm_t *alarm, uint32_t delay_us);
+    void crsf_alarm_cancel(crsf_alarm_t *alarm);
+
+#ifdef __cplusplus
+}
+#endif
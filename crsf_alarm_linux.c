@@ -0,0 +1,122 @@
+/**
+ * @file crsf_alarm_linux.c
+ * @author Britannio Jarrett
+ * @brief One-shot timer backed by a thread on Linux.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+
+#include "crsf_alarm.h"
+#include <time.h>
+
+static uint64_t _monotonic_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void *_alarm_thread(void *arg)
+{
+  crsf_alarm_t *alarm = arg;
+  pthread_mutex_lock(&alarm->lock);
+  while (alarm->running)
+  {
+    const uint64_t deadline = __atomic_load_n(&alarm->deadline_us, __ATOMIC_ACQUIRE);
+    if (deadline == 0)
+    {
+      pthread_cond_wait(&alarm->wake, &alarm->lock);
+    }
+    else if (_monotonic_us() >= deadline)
+    {
+      // Lose to a re-arm that moved the deadline in the meantime
+      uint64_t expected = deadline;
+      if (__atomic_compare_exchange_n(&alarm->deadline_us, &expected, 0, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+      {
+        pthread_mutex_unlock(&alarm->lock);
+        alarm->callback(alarm->ctx);
+        pthread_mutex_lock(&alarm->lock);
+      }
+    }
+    else
+    {
+      // A later deadline set while sleeping is picked up when this one passes
+      const struct timespec until = {
+          .tv_sec = deadline / 1000000,
+          .tv_nsec = (deadline % 1000000) * 1000,
+      };
+      pthread_cond_timedwait(&alarm->wake, &alarm->lock, &until);
+    }
+  }
+  pthread_mutex_unlock(&alarm->lock);
+  return NULL;
+}
+
+/**
+ * Starts the timer thread. The alarm is disarmed until crsf_alarm_arm().
+ *
+ * @param callback Called on the timer thread when the alarm expires.
+ * @return false if the thread could not be started.
+ */
+bool crsf_alarm_init(crsf_alarm_t *alarm, void (*callback)(void *ctx), void *ctx)
+{
+  alarm->callback = callback;
+  alarm->ctx = ctx;
+  alarm->deadline_us = 0;
+  alarm->running = true;
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&alarm->wake, &attr);
+  pthread_condattr_destroy(&attr);
+  pthread_mutex_init(&alarm->lock, NULL);
+  if (pthread_create(&alarm->thread, NULL, _alarm_thread, alarm) != 0)
+  {
+    pthread_cond_destroy(&alarm->wake);
+    pthread_mutex_destroy(&alarm->lock);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Stops the timer thread. The callback is not called after this returns.
+ */
+void crsf_alarm_deinit(crsf_alarm_t *alarm)
+{
+  pthread_mutex_lock(&alarm->lock);
+  alarm->running = false;
+  pthread_cond_signal(&alarm->wake);
+  pthread_mutex_unlock(&alarm->lock);
+  pthread_join(alarm->thread, NULL);
+  pthread_cond_destroy(&alarm->wake);
+  pthread_mutex_destroy(&alarm->lock);
+}
+
+/**
+ * (Re)arms the alarm to expire `delay_us` from now, replacing any earlier deadline.
+ */
+void crsf_alarm_arm(crsf_alarm_t *alarm, uint32_t delay_us)
+{
+  const uint64_t deadline = _monotonic_us() + delay_us;
+  const uint64_t previous = __atomic_exchange_n(&alarm->deadline_us, deadline, __ATOMIC_ACQ_REL);
+  if (previous == 0 || deadline < previous)
+  {
+    // The thread is sleeping for longer than the new deadline
+    pthread_mutex_lock(&alarm->lock);
+    pthread_cond_signal(&alarm->wake);
+    pthread_mutex_unlock(&alarm->lock);
+  }
+}
+
+void crsf_alarm_cancel(crsf_alarm_t *alarm)
+{
+  __atomic_store_n(&alarm->deadline_us, 0, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,85 @@
+/**
+ * @file crsf_alarm_pico.c
+ * @author Britannio Jarrett
+ * @brief One-shot timer backed by an RP2040 hardware alarm.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+
+#include "crsf_alarm.h"
+#include <stddef.h>
+#include "hardware/timer.h"
+#include "pico/time.h"
+
+// The RP2040 timer has four alarms
+#define CRSF_HARDWARE_ALARMS 4
+
+// Alarm callbacks only receive the alarm number
+crsf_alarm_t *_pico_alarms[CRSF_HARDWARE_ALARMS];
+
+void _pico_alarm_fired(uint alarm_num)
+{
+  crsf_alarm_t *alarm = _pico_alarms[alarm_num];
+  if (alarm != NULL)
+  {
+    alarm->callback(alarm->ctx);
+  }
+}
+
+/**
+ * Claims a free hardware alarm. The alarm is disarmed until crsf_alarm_arm().
+ *
+ * The alarm IRQ is enabled on the calling core, which is where the callback runs.
+ *
+ * @return false if all hardware alarms are in use.
+ */
+bool crsf_alarm_init(crsf_alarm_t *alarm, void (*callback)(void *ctx), void *ctx)
+{
+  alarm->callback = callback;
+  alarm->ctx = ctx;
+  alarm->alarm_num = hardware_alarm_claim_unused(false);
+  if (alarm->alarm_num < 0 || alarm->alarm_num >= CRSF_HARDWARE_ALARMS)
+  {
+    return false;
+  }
+  _pico_alarms[alarm->alarm_num] = alarm;
+  hardware_alarm_set_callback(alarm->alarm_num, _pico_alarm_fired);
+  return true;
+}
+
+void crsf_alarm_deinit(crsf_alarm_t *alarm)
+{
+  if (alarm->alarm_num < 0)
+  {
+    return;
+  }
+  hardware_alarm_cancel(alarm->alarm_num);
+  hardware_alarm_set_callback(alarm->alarm_num, NULL);
+  hardware_alarm_unclaim(alarm->alarm_num);
+  _pico_alarms[alarm->alarm_num] = NULL;
+  alarm->alarm_num = -1;
+}
+
+/**
+ * (Re)arms the alarm to expire `delay_us` from now, replacing any earlier deadline.
+ */
+void crsf_alarm_arm(crsf_alarm_t *alarm, uint32_t delay_us)
+{
+  if (hardware_alarm_set_target(alarm->alarm_num, make_timeout_time_us(delay_us)))
+  {
+    // Already in the past
+    alarm->callback(alarm->ctx);
+  }
+}
+
+void crsf_alarm_cancel(crsf_alarm_t *alarm)
+{
+  hardware_alarm_cancel(alarm->alarm_num);
+}
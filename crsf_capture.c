@@ -0,0 +1,353 @@
+/**
+ * @file crsf_capture.c
+ * @author Britannio Jarrett
+ * @brief Timestamped capture of the raw byte stream, for replaying field logs on the bench.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+
+#include "crsf_capture.h"
+#include <string.h>
+
+// A 64-bit LEB128 varint takes at most 10 bytes
+#define CRSF_CAPTURE_VARINT_MAX 10
+
+static const uint8_t _capture_magic[7] = {'C', 'R', 'S', 'F', 'C', 'A', 'P'};
+
+static size_t _put_varint(uint8_t *out, uint64_t value)
+{
+  size_t count = 0;
+  while (value >= 0x80)
+  {
+    out[count++] = (uint8_t)value | 0x80;
+    value >>= 7;
+  }
+  out[count++] = (uint8_t)value;
+  return count;
+}
+
+static void _put_u32(uint8_t *out, uint32_t value)
+{
+  out[0] = value;
+  out[1] = value >> 8;
+  out[2] = value >> 16;
+  out[3] = value >> 24;
+}
+
+static uint32_t _get_u32(const uint8_t *in)
+{
+  return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+static void _put_header(uint8_t *out, uint32_t baud_rate, uint32_t record_bytes)
+{
+  memcpy(out, _capture_magic, sizeof(_capture_magic));
+  out[7] = CRSF_CAPTURE_VERSION;
+  _put_u32(out + 8, baud_rate);
+  _put_u32(out + 12, record_bytes);
+}
+
+static void _ring_put(crsf_capture_t *capture, const uint8_t *data, size_t length)
+{
+  // At most two copies, either side of the wrap
+  const size_t first = length < capture->size - capture->head ? length : capture->size - capture->head;
+  memcpy(capture->buffer + capture->head, data, first);
+  memcpy(capture->buffer, data + first, length - first);
+  capture->head = (capture->head + length) % capture->size;
+  capture->used += length;
+}
+
+// Reads a varint `*offset` bytes past the oldest record, advancing `*offset`
+static uint64_t _ring_varint(const crsf_capture_t *capture, size_t *offset)
+{
+  uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7)
+  {
+    const uint8_t byte = capture->buffer[(capture->tail + (*offset)++) % capture->size];
+    value |= (uint64_t)(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0)
+    {
+      break;
+    }
+  }
+  return value;
+}
+
+static void _ring_drop_oldest(crsf_capture_t *capture)
+{
+  size_t offset = 0;
+  _ring_varint(capture, &offset);
+  const size_t length = offset + (size_t)(_ring_varint(capture, &offset) >> 1);
+  capture->tail = (capture->tail + length) % capture->size;
+  capture->used -= length;
+  capture->records--;
+  capture->dropped++;
+}
+
+static void _capture_reset(crsf_capture_t *capture, uint32_t baud_rate)
+{
+  memset(capture, 0, sizeof(*capture));
+  capture->baud_rate = baud_rate;
+}
+
+/**
+ * @brief Records into a RAM ring, keeping the most recent records once it fills.
+ *
+ * Dump it with crsf_capture_dump(). At 420000 baud the stream is about 42 KB/s,
+ * so a 16 KB ring holds the last few hundred milliseconds of a busy link.
+ *
+ * @param buffer Storage for the records, which must outlive the capture.
+ * @param baud_rate The rate of the line being captured, written to the header.
+ */
+void crsf_capture_init(crsf_capture_t *capture, uint8_t *buffer, size_t size, uint32_t baud_rate)
+{
+  _capture_reset(capture, baud_rate);
+  capture->buffer = buffer;
+  capture->size = size;
+}
+
+/**
+ * @brief Records straight to a sink, such as a file, starting with the header.
+ *
+ * Records are written as they arrive and the header marks the capture as
+ * streamed, so it is read up to wherever the data ends.
+ *
+ * @return false if the sink did not accept the header.
+ */
+bool crsf_capture_init_stream(crsf_capture_t *capture, crsf_capture_write_t sink, void *ctx, uint32_t baud_rate)
+{
+  _capture_reset(capture, baud_rate);
+  capture->sink = sink;
+  capture->sink_ctx = ctx;
+  uint8_t header[CRSF_CAPTURE_HEADER_SIZE];
+  _put_header(header, baud_rate, CRSF_CAPTURE_STREAMED);
+  return sink(ctx, header, sizeof(header)) == sizeof(header);
+}
+
+/**
+ * @brief Appends one chunk of bytes.
+ *
+ * Not thread safe: record from one thread (or core), normally through the tap
+ * installed by crsf_capture_attach(), which records from crsf_process_frames().
+ *
+ * @param time_us When the chunk was read, on any monotonic microsecond clock.
+ * @param tx The chunk was transmitted rather than received.
+ * @return false if the record was dropped: larger than the ring, or refused by the sink.
+ */
+bool crsf_capture_record(crsf_capture_t *capture, uint64_t time_us, bool tx, const uint8_t *data, size_t length)
+{
+  const uint64_t delta_us = capture->started && time_us > capture->last_us ? time_us - capture->last_us : 0;
+  uint8_t header[2 * CRSF_CAPTURE_VARINT_MAX];
+  size_t header_length = _put_varint(header, delta_us);
+  header_length += _put_varint(header + header_length, (uint64_t)length << 1 | tx);
+
+  if (capture->sink != NULL)
+  {
+    if (capture->sink(capture->sink_ctx, header, header_length) < header_length ||
+        capture->sink(capture->sink_ctx, data, length) < length)
+    {
+      capture->dropped++;
+      return false;
+    }
+  }
+  else
+  {
+    const size_t total = header_length + length;
+    if (total > capture->size)
+    {
+      capture->dropped++;
+      return false;
+    }
+    while (capture->size - capture->used < total)
+    {
+      _ring_drop_oldest(capture);
+    }
+    _ring_put(capture, header, header_length);
+    _ring_put(capture, data, length);
+  }
+  capture->last_us = time_us;
+  capture->started = true;
+  capture->records++;
+  return true;
+}
+
+static size_t _tap_read(void *ctx, uint8_t *buf, size_t max)
+{
+  crsf_capture_t *capture = ctx;
+  const crsf_transport_t *inner = capture->inner;
+  const size_t count = inner->read(inner->ctx, buf, max);
+  if (count > 0)
+  {
+    crsf_capture_record(capture, inner->time_us(inner->ctx), false, buf, count);
+  }
+  return count;
+}
+
+static size_t _tap_write(void *ctx, const uint8_t *buf, size_t len)
+{
+  crsf_capture_t *capture = ctx;
+  const crsf_transport_t *inner = capture->inner;
+  const size_t count = inner->write(inner->ctx, buf, len);
+  if (count > 0)
+  {
+    crsf_capture_record(capture, inner->time_us(inner->ctx), true, buf, count);
+  }
+  return count;
+}
+
+static uint64_t _tap_time_us(void *ctx)
+{
+  const crsf_transport_t *inner = ((crsf_capture_t *)ctx)->inner;
+  return inner->time_us(inner->ctx);
+}
+
+static bool _tap_set_baud(void *ctx, uint32_t baud)
+{
+  const crsf_transport_t *inner = ((crsf_capture_t *)ctx)->inner;
+  return inner->set_baud(inner->ctx, baud);
+}
+
+/**
+ * @brief Records everything an instance reads from and writes to its transport.
+ *
+ * The instance's transport is wrapped in a tap that records each chunk as it
+ * is read, timestamped with the transport's clock, and each telemetry write.
+ * Call after the transport is attached (e.g. after crsf_begin()), and detach
+ * before ending the session or attaching another transport.
+ */
+void crsf_capture_attach(crsf_capture_t *capture, crsf_t *crsf)
+{
+  const crsf_transport_t *inner = crsf->transport;
+  capture->inner = inner;
+  capture->crsf = crsf;
+  capture->tap = (crsf_transport_t){
+      .read = _tap_read,
+      .write = _tap_write,
+      .time_us = _tap_time_us,
+      .set_baud = inner->set_baud != NULL ? _tap_set_baud : NULL,
+      .ctx = capture,
+  };
+  crsf->transport = &capture->tap;
+}
+
+/**
+ * @brief Puts back the transport that crsf_capture_attach() wrapped.
+ */
+void crsf_capture_detach(crsf_capture_t *capture)
+{
+  if (capture->crsf != NULL && capture->crsf->transport == &capture->tap)
+  {
+    capture->crsf->transport = capture->inner;
+  }
+  capture->crsf = NULL;
+}
+
+/**
+ * @brief Writes a RAM capture out as a capture file: the header, then the records oldest first.
+ *
+ * Recording must not run concurrently, so dump from the thread (or core) that
+ * records, or detach first.
+ *
+ * @param write Receives the capture in up to three calls.
+ * @return The number of bytes written.
+ */
+size_t crsf_capture_dump(const crsf_capture_t *capture, crsf_capture_write_t write, void *ctx)
+{
+  uint8_t header[CRSF_CAPTURE_HEADER_SIZE];
+  _put_header(header, capture->baud_rate, (uint32_t)capture->used);
+  size_t written = write(ctx, header, sizeof(header));
+  if (written < sizeof(header) || capture->used == 0)
+  {
+    return written;
+  }
+  const size_t first = capture->used < capture->size - capture->tail ? capture->used : capture->size - capture->tail;
+  written += write(ctx, capture->buffer + capture->tail, first);
+  if (capture->used > first)
+  {
+    written += write(ctx, capture->buffer, capture->used - first);
+  }
+  return written;
+}
+
+/**
+ * @brief Finds the capture header in `data` and prepares to read its records.
+ *
+ * Anything before the header is skipped, such as console output that preceded
+ * a dump over USB serial. A dump cut short is read up to where it ends.
+ *
+ * @param data The capture, which must outlive the reader.
+ * @return false if there is no capture header.
+ */
+bool crsf_capture_reader_init(crsf_capture_reader_t *reader, const uint8_t *data, size_t length)
+{
+  for (size_t i = 0; i + CRSF_CAPTURE_HEADER_SIZE <= length; i++)
+  {
+    if (memcmp(data + i, _capture_magic, sizeof(_capture_magic)) != 0 || data[i + 7] != CRSF_CAPTURE_VERSION)
+    {
+      continue;
+    }
+    const size_t start = i + CRSF_CAPTURE_HEADER_SIZE;
+    const uint32_t record_bytes = _get_u32(data + i + 12);
+    reader->data = data;
+    reader->length = record_bytes == CRSF_CAPTURE_STREAMED || record_bytes > length - start ? length : start + record_bytes;
+    reader->offset = start;
+    reader->baud_rate = _get_u32(data + i + 8);
+    reader->time_us = 0;
+    reader->started = false;
+    return true;
+  }
+  return false;
+}
+
+static bool _get_varint(const crsf_capture_reader_t *reader, size_t *offset, uint64_t *value)
+{
+  *value = 0;
+  for (unsigned shift = 0; shift < 64 && *offset < reader->length; shift += 7)
+  {
+    const uint8_t byte = reader->data[(*offset)++];
+    *value |= (uint64_t)(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Reads the next record.
+ *
+ * @param record Set to the record, whose data points into the capture.
+ * @return false at the end of the capture, or where a truncated record begins.
+ */
+bool crsf_capture_next(crsf_capture_reader_t *reader, crsf_capture_record_t *record)
+{
+  size_t offset = reader->offset;
+  uint64_t delta_us;
+  uint64_t tag;
+  if (!_get_varint(reader, &offset, &delta_us) || !_get_varint(reader, &offset, &tag))
+  {
+    return false;
+  }
+  const uint64_t length = tag >> 1;
+  if (length > reader->length - offset)
+  {
+    return false;
+  }
+  // The first delta is relative to a record that may have been dropped from the ring
+  reader->time_us = reader->started ? reader->time_us + delta_us : 0;
+  reader->started = true;
+  reader->offset = offset + length;
+  record->time_us = reader->time_us;
+  record->tx = tag & 1;
+  record->data = reader->data + offset;
+  record->length = length;
+  return true;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file crsf_capture.h
+ * @author Britannio Jarrett
+ * @brief Timestamped capture of the raw byte stream, for replaying field logs on the bench.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Format (all integers little endian):
+ *   header: "CRSFCAP" [version = 1] [baud rate: u32] [record bytes: u32, 0xFFFFFFFF if streamed]
+ *   record: [microseconds since the previous record: varint] [length << 1 | tx: varint] [bytes]
+ * Varints are LEB128: 7 bits per byte, least significant first, top bit set on all but the last.
+ * A record is one chunk as the transport returned it (or, with tx set, one telemetry write),
+ * so replaying the records reproduces the chunking the parser saw as well as the bytes.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "crsf.h"
+
+#define CRSF_CAPTURE_HEADER_SIZE 16
+#define CRSF_CAPTURE_VERSION 1
+// Record bytes field of a capture that was streamed and ends where the data ends
+#define CRSF_CAPTURE_STREAMED 0xFFFFFFFFu
+
+// Sink for a streamed capture or a dump. Returns the number of bytes accepted.
+typedef size_t (*crsf_capture_write_t)(void *ctx, const uint8_t *buf, size_t len);
+
+/**
+ * @brief A capture being recorded, either into a RAM ring or to a sink.
+ *
+ * The RAM ring keeps the most recent records: when it is full the oldest
+ * are dropped to make room, so a crash can be dumped after the fact.
+ */
+typedef struct
+{
+	// RAM ring, NULL when streaming. Records start at `tail` and end at `head`.
+	uint8_t *buffer;
+	size_t size;
+	size_t head;
+	size_t tail;
+	size_t used;
+	// Streaming sink, NULL when recording to RAM
+	crsf_capture_write_t sink;
+	void *sink_ctx;
+	uint32_t baud_rate;
+	// Time of the previous record, to delta-encode the next
+	uint64_t last_us;
+	bool started;
+	uint32_t records;
+	// Records overwritten in the ring, or that did not fit or could not be written
+	uint32_t dropped;
+	// Transport installed by crsf_capture_attach(), recording what passes through `inner`
+	crsf_transport_t tap;
+	const crsf_transport_t *inner;
+	crsf_t *crsf;
+} crsf_capture_t;
+
+typedef struct
+{
+	// Capture time, 0 at the first record
+	uint64_t time_us;
+	// Telemetry written by the library rather than bytes received
+	bool tx;
+	const uint8_t *data;
+	size_t length;
+} crsf_capture_record_t;
+
+typedef struct
+{
+	const uint8_t *data;
+	size_t length;
+	size_t offset;
+	uint32_t baud_rate;
+	uint64_t time_us;
+	bool started;
+} crsf_capture_reader_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    void crsf_capture_init(crsf_capture_t *capture, uint8_t *buffer, size_t size, uint32_t baud_rate);
+    bool crsf_capture_init_stream(crsf_capture_t *capture, crsf_capture_write_t sink, void *ctx, uint32_t baud_rate);
+    bool crsf_capture_record(crsf_capture_t *capture, uint64_t time_us, bool tx, const uint8_t *data, size_t length);
+    void crsf_capture_attach(crsf_capture_t *capture, crsf_t *crsf);
+    void crsf_capture_detach(crsf_capture_t *capture);
+    size_t crsf_capture_dump(const crsf_capture_t *capture, crsf_capture_write_t write, void *ctx);
+    bool crsf_capture_reader_init(crsf_capture_reader_t *reader, const uint8_t *data, size_t length);
+    bool crsf_capture_next(crsf_capture_reader_t *reader, crsf_capture_record_t *record);
+
+#ifdef __cplusplus
+}
+#endif
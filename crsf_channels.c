@@ -0,0 +1,318 @@
+/**
+ * @file crsf_channels.c
+ * @author Britannio Jarrett
+ * @brief Unpack/pack kernels for the 16 x 11-bit RC_CHANNELS_PACKED payload.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+
+#include "crsf_channels.h"
+#include <string.h>
+
+#if CRSF_CHANNELS_SIMD && defined(__SSE4_1__)
+#include <smmintrin.h>
+#elif CRSF_CHANNELS_SIMD
+#include <arm_neon.h>
+#endif
+
+// 64-bit words need fewer shifts on 64-bit hosts, 32-bit words suit the Cortex-M0+
+#if UINTPTR_MAX > 0xFFFFFFFFu
+typedef uint64_t word_t;
+#else
+typedef uint32_t word_t;
+#endif
+#define WORD_BITS (sizeof(word_t) * 8)
+#define PAYLOAD_WORDS ((CRSF_RC_CHANNELS_PAYLOAD_SIZE + sizeof(word_t) - 1) / sizeof(word_t))
+
+static inline uint16_t _load_le16(const uint8_t *p)
+{
+  return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static inline uint32_t _load_le32(const uint8_t *p)
+{
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap32(value);
+#endif
+  return value;
+}
+
+// One load per word so the words stay in registers
+static inline void _load_words(const uint8_t *payload, word_t words[PAYLOAD_WORDS])
+{
+#if UINTPTR_MAX > 0xFFFFFFFFu
+  words[0] = _load_le32(payload) | (uint64_t)_load_le32(payload + 4) << 32;
+  words[1] = _load_le32(payload + 8) | (uint64_t)_load_le32(payload + 12) << 32;
+  words[2] = _load_le32(payload + 16) | (uint64_t)_load_le16(payload + 20) << 32;
+#else
+  words[0] = _load_le32(payload);
+  words[1] = _load_le32(payload + 4);
+  words[2] = _load_le32(payload + 8);
+  words[3] = _load_le32(payload + 12);
+  words[4] = _load_le32(payload + 16);
+  words[5] = _load_le16(payload + 20);
+#endif
+}
+
+static inline void _store_words(const word_t words[PAYLOAD_WORDS], uint8_t *payload)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  memcpy(payload, words, CRSF_RC_CHANNELS_PAYLOAD_SIZE);
+#else
+  for (unsigned i = 0; i < CRSF_RC_CHANNELS_PAYLOAD_SIZE; i++)
+  {
+    payload[i] = words[i / sizeof(word_t)] >> (8 * (i % sizeof(word_t)));
+  }
+#endif
+}
+
+// Channel `i` starts at bit 11 * i. All indices are constants once unrolled, so
+// the spill test folds away and every channel is a shift, an optional OR and a mask.
+#define BIT(i) (11u * (i))
+#define WORD(i) (BIT(i) / WORD_BITS)
+#define SHIFT(i) (BIT(i) % WORD_BITS)
+#define SPILLS(i) (SHIFT(i) + 11 > WORD_BITS)
+
+#define UNPACK(i)                                                               \
+  channels[i] = (uint16_t)(((words[WORD(i)] >> SHIFT(i)) |                      \
+                            (SPILLS(i) ? words[WORD(i) + SPILLS(i)] << ((WORD_BITS - SHIFT(i)) % WORD_BITS) : 0)) & \
+                           0x7FF)
+
+#define PACK(i)                                                                     \
+  do                                                                                \
+  {                                                                                 \
+    const word_t value = channels[i] & 0x7FF;                                       \
+    words[WORD(i)] |= value << SHIFT(i);                                            \
+    if (SPILLS(i))                                                                  \
+    {                                                                               \
+      words[WORD(i) + SPILLS(i)] |= value >> ((WORD_BITS - SHIFT(i)) % WORD_BITS); \
+    }                                                                               \
+  } while (0)
+
+/**
+ * Unpacks 16 channels with word loads and shift/mask, no vector instructions.
+ */
+void crsf_unpack_channels_scalar(const uint8_t payload[CRSF_RC_CHANNELS_PAYLOAD_SIZE], uint16_t channels[CRSF_RC_CHANNELS])
+{
+  word_t words[PAYLOAD_WORDS];
+  _load_words(payload, words);
+  UNPACK(0);
+  UNPACK(1);
+  UNPACK(2);
+  UNPACK(3);
+  UNPACK(4);
+  UNPACK(5);
+  UNPACK(6);
+  UNPACK(7);
+  UNPACK(8);
+  UNPACK(9);
+  UNPACK(10);
+  UNPACK(11);
+  UNPACK(12);
+  UNPACK(13);
+  UNPACK(14);
+  UNPACK(15);
+}
+
+/**
+ * Packs 16 channels into an RC_CHANNELS_PACKED payload. Values are truncated to 11 bits.
+ */
+void crsf_pack_channels(const uint16_t channels[CRSF_RC_CHANNELS], uint8_t payload[CRSF_RC_CHANNELS_PAYLOAD_SIZE])
+{
+  word_t words[PAYLOAD_WORDS] = {0};
+  PACK(0);
+  PACK(1);
+  PACK(2);
+  PACK(3);
+  PACK(4);
+  PACK(5);
+  PACK(6);
+  PACK(7);
+  PACK(8);
+  PACK(9);
+  PACK(10);
+  PACK(11);
+  PACK(12);
+  PACK(13);
+  PACK(14);
+  PACK(15);
+  _store_words(words, payload);
+}
+
+// RC_CHANNELS_SUBSET configuration byte: start channel in bits 0-4, resolution
+// (10 + n bits) in bits 5-6
+#define SUBSET_START_MASK 0x1F
+#define SUBSET_RESOLUTION_SHIFT 5
+#define SUBSET_MIN_RESOLUTION 10
+#define SUBSET_MAX_RESOLUTION 13
+
+/**
+ * Unpacks an RC_CHANNELS_SUBSET payload.
+ *
+ * Values are packed least significant bit first like RC_CHANNELS_PACKED, but
+ * at the resolution given by the configuration byte. Channels past the 16th are
+ * dropped.
+ *
+ * @param payload The payload, configuration byte first.
+ * @param length Payload bytes.
+ * @param start_channel Receives the channel number of channels[0].
+ * @param resolution Receives the bits per value (10 - 13).
+ * @param channels Receives the raw channel values.
+ * @return The number of channels unpacked, 0 if the payload holds none.
+ */
+uint8_t crsf_unpack_channel_subset(const uint8_t *payload, uint8_t length, uint8_t *start_channel, uint8_t *resolution, uint16_t channels[CRSF_RC_CHANNELS])
+{
+  if (length < 2)
+  {
+    return 0;
+  }
+  *start_channel = payload[0] & SUBSET_START_MASK;
+  *resolution = SUBSET_MIN_RESOLUTION + ((payload[0] >> SUBSET_RESOLUTION_SHIFT) & 0x03);
+  if (*start_channel >= CRSF_RC_CHANNELS)
+  {
+    return 0;
+  }
+  const unsigned bits = *resolution;
+  const unsigned available = CRSF_RC_CHANNELS - *start_channel;
+  unsigned count = (length - 1) * 8u / bits;
+  if (count > available)
+  {
+    count = available;
+  }
+  const uint8_t *src = payload + 1;
+  uint32_t acc = 0;
+  unsigned acc_bits = 0;
+  for (unsigned i = 0; i < count; i++)
+  {
+    while (acc_bits < bits)
+    {
+      acc |= (uint32_t)*src++ << acc_bits;
+      acc_bits += 8;
+    }
+    channels[i] = acc & ((1u << bits) - 1);
+    acc >>= bits;
+    acc_bits -= bits;
+  }
+  return count;
+}
+
+/**
+ * Packs `count` channels into an RC_CHANNELS_SUBSET payload. Values are truncated to `resolution` bits.
+ *
+ * @param resolution Bits per value, clamped to 10 - 13.
+ * @return The payload length, configuration byte included.
+ */
+uint8_t crsf_pack_channel_subset(uint8_t start_channel, uint8_t resolution, const uint16_t *channels, uint8_t count, uint8_t *payload)
+{
+  if (resolution < SUBSET_MIN_RESOLUTION)
+  {
+    resolution = SUBSET_MIN_RESOLUTION;
+  }
+  else if (resolution > SUBSET_MAX_RESOLUTION)
+  {
+    resolution = SUBSET_MAX_RESOLUTION;
+  }
+  if (count > CRSF_RC_CHANNELS)
+  {
+    count = CRSF_RC_CHANNELS;
+  }
+  payload[0] = (start_channel & SUBSET_START_MASK) | (resolution - SUBSET_MIN_RESOLUTION) << SUBSET_RESOLUTION_SHIFT;
+  uint8_t *dst = payload + 1;
+  uint32_t acc = 0;
+  unsigned acc_bits = 0;
+  for (unsigned i = 0; i < count; i++)
+  {
+    acc |= (uint32_t)(channels[i] & ((1u << resolution) - 1)) << acc_bits;
+    acc_bits += resolution;
+    while (acc_bits >= 8)
+    {
+      *dst++ = acc;
+      acc >>= 8;
+      acc_bits -= 8;
+    }
+  }
+  if (acc_bits > 0)
+  {
+    *dst++ = acc;
+  }
+  return dst - payload;
+}
+
+#if CRSF_CHANNELS_SIMD
+// Each 32-bit lane receives the (up to) three bytes holding one channel, 0xFF zeroes a byte.
+// Channels 0-7 are shuffled from the 16 bytes at offset 0 and channels 8-15 from
+// the 16 bytes at offset 6, so neither load reads past the 22-byte payload.
+static const uint8_t _shuffle[4][16] = {
+    // Channels 0-3 start at bytes 0, 1, 2, 4
+    {0, 1, 2, 0xFF, 1, 2, 3, 0xFF, 2, 3, 4, 0xFF, 4, 5, 6, 0xFF},
+    // Channels 4-7 start at bytes 5, 6, 8, 9
+    {5, 6, 7, 0xFF, 6, 7, 8, 0xFF, 8, 9, 10, 0xFF, 9, 10, 11, 0xFF},
+    // Channels 8-11 start at bytes 11, 12, 13, 15 (5, 6, 7, 9 from offset 6)
+    {5, 6, 7, 0xFF, 6, 7, 8, 0xFF, 7, 8, 9, 0xFF, 9, 10, 11, 0xFF},
+    // Channels 12-15 start at bytes 16, 17, 19, 20. Channel 15 ends in byte 21.
+    {10, 11, 12, 0xFF, 11, 12, 13, 0xFF, 13, 14, 15, 0xFF, 14, 15, 0xFF, 0xFF},
+};
+// Bit offset of each channel inside its first byte, repeating every 8 channels
+static const int32_t _shift[2][4] = {{0, 3, 6, 1}, {4, 7, 2, 5}};
+
+/**
+ * Unpacks 16 channels with SSE4.1 or NEON byte shuffles and per-lane shifts.
+ */
+void crsf_unpack_channels_simd(const uint8_t payload[CRSF_RC_CHANNELS_PAYLOAD_SIZE], uint16_t channels[CRSF_RC_CHANNELS])
+{
+#if defined(__SSE4_1__)
+  // SSE has no per-lane variable right shift: shift left by 7 - offset, then right by 7
+  const __m128i mul[2] = {
+      _mm_setr_epi32(1 << (7 - _shift[0][0]), 1 << (7 - _shift[0][1]), 1 << (7 - _shift[0][2]), 1 << (7 - _shift[0][3])),
+      _mm_setr_epi32(1 << (7 - _shift[1][0]), 1 << (7 - _shift[1][1]), 1 << (7 - _shift[1][2]), 1 << (7 - _shift[1][3])),
+  };
+  const __m128i mask = _mm_set1_epi32(0x7FF);
+  for (int half = 0; half < 2; half++)
+  {
+    const __m128i bytes = _mm_loadu_si128((const __m128i *)(payload + 6 * half));
+    __m128i a = _mm_shuffle_epi8(bytes, _mm_loadu_si128((const __m128i *)_shuffle[2 * half]));
+    __m128i b = _mm_shuffle_epi8(bytes, _mm_loadu_si128((const __m128i *)_shuffle[2 * half + 1]));
+    a = _mm_and_si128(_mm_srli_epi32(_mm_mullo_epi32(a, mul[0]), 7), mask);
+    b = _mm_and_si128(_mm_srli_epi32(_mm_mullo_epi32(b, mul[1]), 7), mask);
+    _mm_storeu_si128((__m128i *)(channels + 8 * half), _mm_packus_epi32(a, b));
+  }
+#else
+  const int32x4_t shift_a = vnegq_s32(vld1q_s32(_shift[0]));
+  const int32x4_t shift_b = vnegq_s32(vld1q_s32(_shift[1]));
+  const uint32x4_t mask = vdupq_n_u32(0x7FF);
+  for (int half = 0; half < 2; half++)
+  {
+    const uint8x16_t bytes = vld1q_u8(payload + 6 * half);
+    const uint8x16_t a = vqtbl1q_u8(bytes, vld1q_u8(_shuffle[2 * half]));
+    const uint8x16_t b = vqtbl1q_u8(bytes, vld1q_u8(_shuffle[2 * half + 1]));
+    const uint32x4_t lanes_a = vandq_u32(vshlq_u32(vreinterpretq_u32_u8(a), shift_a), mask);
+    const uint32x4_t lanes_b = vandq_u32(vshlq_u32(vreinterpretq_u32_u8(b), shift_b), mask);
+    vst1q_u16(channels + 8 * half, vcombine_u16(vmovn_u32(lanes_a), vmovn_u32(lanes_b)));
+  }
+#endif
+}
+#endif
+
+/**
+ * Unpacks 16 channels from an RC_CHANNELS_PACKED payload with the fastest available kernel.
+ *
+ * @param payload The 22 payload bytes, any alignment.
+ * @param channels Receives the 11-bit channel values (0 - 2047).
+ */
+void crsf_unpack_channels(const uint8_t payload[CRSF_RC_CHANNELS_PAYLOAD_SIZE], uint16_t channels[CRSF_RC_CHANNELS])
+{
+#if CRSF_CHANNELS_SIMD
+  crsf_unpack_channels_simd(payload, channels);
+#else
+  crsf_unpack_channels_scalar(payload, channels);
+#endif
+}
@@ -0,0 +1,53 @@
+/**
+ * @file crsf_channels.h
+ * @author Britannio Jarrett
+ * @brief Unpack/pack kernels for the 16 x 11-bit RC_CHANNELS_PACKED payload.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Channels are packed little-endian, channel 0 in the least significant bits of
+ * byte 0. The kernels load the payload as 32-bit (or 64-bit on 64-bit hosts)
+ * words and extract fields with constant shifts and masks, independent of how a
+ * compiler lays out bitfields. Hosts with SSE4.1 or AArch64 NEON also get a
+ * vector unpack for log replay.
+ *
+ * RC_CHANNELS_SUBSET payloads carry a run of channels starting anywhere, at 10
+ * to 13 bits each, behind a byte holding the start channel and resolution.
+ */
+#pragma once
+#include <stdint.h>
+
+#define CRSF_RC_CHANNELS 16
+#define CRSF_RC_CHANNELS_PAYLOAD_SIZE 22
+
+#ifndef CRSF_CHANNELS_SIMD
+#if defined(__SSE4_1__) || (defined(__aarch64__) && defined(__ARM_NEON))
+#define CRSF_CHANNELS_SIMD 1
+#else
+#define CRSF_CHANNELS_SIMD 0
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    void crsf_unpack_channels(const uint8_t payload[CRSF_RC_CHANNELS_PAYLOAD_SIZE], uint16_t channels[CRSF_RC_CHANNELS]);
+    void crsf_pack_channels(const uint16_t channels[CRSF_RC_CHANNELS], uint8_t payload[CRSF_RC_CHANNELS_PAYLOAD_SIZE]);
+    void crsf_unpack_channels_scalar(const uint8_t payload[CRSF_RC_CHANNELS_PAYLOAD_SIZE], uint16_t channels[CRSF_RC_CHANNELS]);
+    uint8_t crsf_unpack_channel_subset(const uint8_t *payload, uint8_t length, uint8_t *start_channel, uint8_t *resolution, uint16_t channels[CRSF_RC_CHANNELS]);
+    uint8_t crsf_pack_channel_subset(uint8_t start_channel, uint8_t resolution, const uint16_t *channels, uint8_t count, uint8_t *payload);
+#if CRSF_CHANNELS_SIMD
+    void crsf_unpack_channels_simd(const uint8_t payload[CRSF_RC_CHANNELS_PAYLOAD_SIZE], uint16_t channels[CRSF_RC_CHANNELS]);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,203 @@
+/**
+ * @file crsf_condition.c
+ * @author Britannio Jarrett
+ * @brief Integer channel conditioning: calibration, deadband, expo and low-pass filtering.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+
+#include "crsf_condition.h"
+#include <stddef.h>
+
+// Fractional bits kept by the low-pass filter below Q15
+#define CRSF_LPF_FRACTION_BITS 6
+// Q15 steps per expo table segment
+#define CRSF_EXPO_SEGMENT_SHIFT 10
+
+void crsf_channel_config_default(crsf_channel_config_t *config)
+{
+  *config = (crsf_channel_config_t){
+      .min = CRSF_CHANNEL_MIN,
+      .center = CRSF_CHANNEL_CENTER,
+      .max = CRSF_CHANNEL_MAX,
+      .deadband = 0,
+      .expo = 0,
+      .lpf_alpha = 0,
+      .reversed = false,
+  };
+}
+
+// Rounded up so that full travel reaches exactly CRSF_Q15_ONE
+static uint32_t _travel_scale(uint16_t travel)
+{
+  return (((uint32_t)CRSF_Q15_ONE << 16) + travel - 1) / travel;
+}
+
+static int16_t _cube(uint32_t x)
+{
+  return (((x * x) >> 15) * x) >> 15;
+}
+
+/**
+ * @brief Sets every channel to the standard CRSF range, with no deadband, expo or filtering.
+ *
+ * @param output The units crsf_condition_apply() produces.
+ */
+void crsf_conditioner_init(crsf_conditioner_t *conditioner, crsf_condition_output_t output)
+{
+  conditioner->output = output;
+  crsf_channel_config_t config;
+  crsf_channel_config_default(&config);
+  for (uint8_t i = 0; i < CRSF_RC_CHANNELS; i++)
+  {
+    crsf_conditioner_configure(conditioner, i, &config);
+  }
+}
+
+/**
+ * @brief Configures one channel, precomputing its scale factors and expo table.
+ *
+ * Configure before the conditioner is attached with crsf_ctx_set_conditioner(),
+ * not while frames are being processed.
+ *
+ * @return false, leaving the channel unchanged, if the endpoints are not ordered,
+ * the deadband covers either side's travel, or expo or lpf_alpha are out of range.
+ */
+bool crsf_conditioner_configure(crsf_conditioner_t *conditioner, uint8_t channel, const crsf_channel_config_t *config)
+{
+  if (channel >= CRSF_RC_CHANNELS || config->min >= config->center || config->center >= config->max ||
+      config->deadband >= config->center - config->min || config->deadband >= config->max - config->center ||
+      config->expo > 100 || config->lpf_alpha > CRSF_LPF_ALPHA_ONE)
+  {
+    return false;
+  }
+  crsf_channel_conditioning_t *ch = &conditioner->channels[channel];
+  ch->center = config->center;
+  ch->deadband = config->deadband;
+  ch->travel_low = config->center - config->min - config->deadband;
+  ch->travel_high = config->max - config->center - config->deadband;
+  ch->scale_low = _travel_scale(ch->travel_low);
+  ch->scale_high = _travel_scale(ch->travel_high);
+  ch->reversed = config->reversed;
+  ch->expo = config->expo != 0;
+  for (uint32_t i = 0; i <= CRSF_EXPO_SEGMENTS; i++)
+  {
+    const uint32_t x = i < CRSF_EXPO_SEGMENTS ? i << CRSF_EXPO_SEGMENT_SHIFT : CRSF_Q15_ONE;
+    ch->expo_table[i] = ((100 - config->expo) * x + config->expo * _cube(x)) / 100;
+  }
+  // Full deflection stays full deflection whatever the curve
+  ch->expo_table[CRSF_EXPO_SEGMENTS] = CRSF_Q15_ONE;
+  ch->lpf_alpha = config->lpf_alpha == CRSF_LPF_ALPHA_ONE ? 0 : config->lpf_alpha;
+  ch->lpf_primed = false;
+  return true;
+}
+
+/**
+ * @brief Forgets the filter history, so the next frame passes straight through.
+ *
+ * Useful after a failsafe, so the sticks do not sweep from stale values.
+ */
+void crsf_conditioner_reset(crsf_conditioner_t *conditioner)
+{
+  for (uint8_t i = 0; i < CRSF_RC_CHANNELS; i++)
+  {
+    conditioner->channels[i].lpf_primed = false;
+  }
+}
+
+/**
+ * @brief Low-pass coefficient for a cutoff frequency at a given RC frame rate.
+ *
+ * Uses alpha = w / (1 + w) with w = 2 pi fc / fs, close to the exact
+ * 1 - e^-w of a sampled RC filter well below the frame rate.
+ *
+ * @return Q8 alpha for crsf_channel_config_t.lpf_alpha, 0 (no filter) for a cutoff of 0.
+ */
+uint16_t crsf_condition_lpf_alpha(uint16_t cutoff_hz, uint16_t rate_hz)
+{
+  if (cutoff_hz == 0 || rate_hz == 0)
+  {
+    return 0;
+  }
+  // 2 pi in Q10
+  const uint64_t omega = (uint64_t)cutoff_hz * 6434;
+  const uint64_t alpha = (omega * CRSF_LPF_ALPHA_ONE + omega / 2) / ((uint64_t)rate_hz * 1024 + omega);
+  return alpha == 0 ? 1 : (uint16_t)alpha;
+}
+
+// Written as selects rather than branches, so the cost does not depend on the stick position
+static int32_t _calibrate(const crsf_channel_conditioning_t *ch, uint16_t ticks)
+{
+  const int32_t offset = (int32_t)ticks - ch->center;
+  const bool low = offset < 0;
+  const int32_t beyond = (low ? -offset : offset) - ch->deadband;
+  const uint32_t limit = low ? ch->travel_low : ch->travel_high;
+  uint32_t travel = beyond < 0 ? 0 : (uint32_t)beyond;
+  travel = travel < limit ? travel : limit;
+  const int32_t value = (travel * (low ? ch->scale_low : ch->scale_high)) >> 16;
+  return low ? -value : value;
+}
+
+static int32_t _expo(const crsf_channel_conditioning_t *ch, int32_t value)
+{
+  const uint32_t magnitude = value < 0 ? -value : value;
+  const uint32_t segment = magnitude >> CRSF_EXPO_SEGMENT_SHIFT;
+  const uint32_t fraction = magnitude & ((1 << CRSF_EXPO_SEGMENT_SHIFT) - 1);
+  const int32_t low = ch->expo_table[segment];
+  const int32_t shaped = low + (((ch->expo_table[segment + 1] - low) * (int32_t)fraction) >> CRSF_EXPO_SEGMENT_SHIFT);
+  return value < 0 ? -shaped : shaped;
+}
+
+static int32_t _low_pass(crsf_channel_conditioning_t *ch, int32_t value)
+{
+  const int32_t target = value * (1 << CRSF_LPF_FRACTION_BITS);
+  if (!ch->lpf_primed)
+  {
+    ch->lpf_state = target;
+    ch->lpf_primed = true;
+  }
+  else
+  {
+    ch->lpf_state += ((target - ch->lpf_state) * (int32_t)ch->lpf_alpha) >> 8;
+  }
+  return (ch->lpf_state + (1 << (CRSF_LPF_FRACTION_BITS - 1))) >> CRSF_LPF_FRACTION_BITS;
+}
+
+/**
+ * @brief Conditions all 16 channels of one RC frame.
+ *
+ * The cost is fixed per frame: no loops depend on the values, and each enabled
+ * stage adds a multiply and a few compares per channel.
+ *
+ * @param ticks Channel values as decoded, e.g. crsf_t.rc_channels.
+ * @param out Q15 or microseconds, as chosen in crsf_conditioner_init().
+ */
+void crsf_condition_apply(crsf_conditioner_t *conditioner, const uint16_t ticks[CRSF_RC_CHANNELS], int16_t out[CRSF_RC_CHANNELS])
+{
+  for (uint8_t i = 0; i < CRSF_RC_CHANNELS; i++)
+  {
+    crsf_channel_conditioning_t *ch = &conditioner->channels[i];
+    int32_t value = _calibrate(ch, ticks[i]);
+    if (ch->reversed)
+    {
+      value = -value;
+    }
+    if (ch->expo)
+    {
+      value = _expo(ch, value);
+    }
+    if (ch->lpf_alpha != 0)
+    {
+      value = _low_pass(ch, value);
+    }
+    // 1000 / 65536 rather than 500 / 32767 us per step, a 0.002 % difference
+    out[i] = conditioner->output == CRSF_CONDITION_US ? 1500 + ((value * 1000 + 32768) >> 16) : value;
+  }
+}
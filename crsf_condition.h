@@ -0,0 +1,116 @@
+/**
+ * @file crsf_condition.h
+ * @author Britannio Jarrett
+ * @brief Integer channel conditioning: calibration, deadband, expo and low-pass filtering.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Each channel goes through, in order:
+ *   1. calibration: min / center / max ticks map to -1.0 / 0 / +1.0 in Q15, with
+ *      a deadband around the center and travel clamped to the endpoints
+ *   2. expo: (1 - e) * x + e * x^3, from a 33-point table interpolated linearly
+ *   3. low-pass: y += alpha * (x - y), once per RC frame
+ *   4. output as Q15 (-32767 - 32767) or as microseconds (1000 - 2000)
+ *
+ * Everything is integer arithmetic with one 32-bit multiply per stage, as the
+ * RP2040 has no FPU; the divisions all happen in crsf_conditioner_configure().
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "crsf_channels.h"
+
+// Whole-microsecond conversions without floats, rounded to nearest. Valid over
+// the 11-bit channel range (0 - 2047 ticks, 880 - 2159 us).
+#define CRSF_TICKS_TO_US(x) ((((uint32_t)(x)) * 5 + 4) / 8 + 880)
+#define CRSF_US_TO_TICKS(us) ((((uint32_t)(us) - 880) * 8 + 2) / 5)
+
+// Channel range sent by CRSF transmitters, 988 - 2012 us
+#define CRSF_CHANNEL_MIN 172
+#define CRSF_CHANNEL_CENTER 992
+#define CRSF_CHANNEL_MAX 1811
+
+#define CRSF_Q15_ONE 32767
+// Expo table segments, each covering 1024 Q15 steps
+#define CRSF_EXPO_SEGMENTS 32
+// Low-pass coefficients are Q8, see crsf_condition_lpf_alpha()
+#define CRSF_LPF_ALPHA_ONE 256
+
+typedef enum
+{
+	// -32767 - 32767 for -1.0 - 1.0
+	CRSF_CONDITION_Q15,
+	// 1000 - 2000 us, centered on 1500
+	CRSF_CONDITION_US,
+} crsf_condition_output_t;
+
+/**
+ * @brief How one channel is conditioned, in the units the user thinks in.
+ */
+typedef struct
+{
+	// Calibrated endpoints and center, in ticks. min < center < max.
+	uint16_t min;
+	uint16_t center;
+	uint16_t max;
+	// Ticks either side of the center that read as 0
+	uint16_t deadband;
+	// 0 (linear) - 100 (cubic) percent
+	uint8_t expo;
+	// Q8 smoothing coefficient, CRSF_LPF_ALPHA_ONE or 0 for no filtering
+	uint16_t lpf_alpha;
+	bool reversed;
+} crsf_channel_config_t;
+
+/**
+ * @brief One channel's configuration, precomputed for the per-frame path.
+ */
+typedef struct
+{
+	uint16_t center;
+	uint16_t deadband;
+	// Travel beyond the deadband below and above the center, in ticks
+	uint16_t travel_low;
+	uint16_t travel_high;
+	// Q15 per tick of travel, scaled by 2^16
+	uint32_t scale_low;
+	uint32_t scale_high;
+	bool reversed;
+	bool expo;
+	uint16_t lpf_alpha;
+	bool lpf_primed;
+	// Filter output in Q15, scaled by 2^6 so slow filters still settle
+	int32_t lpf_state;
+	int16_t expo_table[CRSF_EXPO_SEGMENTS + 1];
+} crsf_channel_conditioning_t;
+
+/**
+ * @brief Conditioning for all 16 channels. Owned by the caller, no allocation.
+ */
+typedef struct
+{
+	crsf_channel_conditioning_t channels[CRSF_RC_CHANNELS];
+	crsf_condition_output_t output;
+} crsf_conditioner_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    void crsf_channel_config_default(crsf_channel_config_t *config);
+    void crsf_conditioner_init(crsf_conditioner_t *conditioner, crsf_condition_output_t output);
+    bool crsf_conditioner_configure(crsf_conditioner_t *conditioner, uint8_t channel, const crsf_channel_config_t *config);
+    void crsf_conditioner_reset(crsf_conditioner_t *conditioner);
+    uint16_t crsf_condition_lpf_alpha(uint16_t cutoff_hz, uint16_t rate_hz);
+    void crsf_condition_apply(crsf_conditioner_t *conditioner, const uint16_t ticks[CRSF_RC_CHANNELS], int16_t out[CRSF_RC_CHANNELS]);
+
+#ifdef __cplusplus
+}
+#endif
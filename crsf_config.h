@@ -0,0 +1,85 @@
+/**
+ * @file crsf_config.h
+ * @author Britannio Jarrett
+ * @brief Compile-time switches that trim the library's flash and RAM footprint.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Every switch defaults to the full library. Override them with compiler
+ * definitions, or list them in a header of your own and define
+ * CRSF_USER_CONFIG as its name (e.g. -DCRSF_USER_CONFIG=\"my_crsf_config.h\").
+ * Several switches change the layout of crsf_t, so they must have the same
+ * value wherever the library's headers are included; the CMake cache variables
+ * CRSF_CONFIG and CRSF_USER_CONFIG apply them to crsf and everything linking it.
+ *
+ * Frame types are switched one by one with CRSF_FRAME_<TYPE>, named after the
+ * frame_type_t values without their CRSF_FRAMETYPE_ prefix (CRSF_FRAME_GPS,
+ * CRSF_FRAME_CUSTOM_PAYLOAD, ...). Their defaults are generated into
+ * crsf_frames.h with the rest of the schema. A type set to 0 loses its decoder,
+ * encoder and union member, and its frames are skipped as unknown types.
+ *
+ * The size report (`cmake --build build --target crsf_size`) prints the flash
+ * and RAM a receive-only firmware needs in a few configurations.
+ */
+#pragma once
+
+#ifdef CRSF_USER_CONFIG
+#include CRSF_USER_CONFIG
+#endif
+
+// Telemetry encoder, scheduler and reply slots. With 0 the telemetry
+// functions remain but do nothing: setters report failure and nothing is sent.
+#ifndef CRSF_TELEMETRY
+#define CRSF_TELEMETRY 1
+#endif
+
+// Per-instance callbacks and their crsf_set_on_* / crsf_ctx_set_on_* setters.
+// crsf_pipeline.h and crsf_diversity.h are built on them and are left out with 0.
+#ifndef CRSF_CALLBACKS
+#define CRSF_CALLBACKS 1
+#endif
+
+// The seqlocked snapshot behind crsf_ctx_get_latest(). With 0 crsf_ctx_get_latest() returns false.
+#ifndef CRSF_SNAPSHOT
+#define CRSF_SNAPSHOT 1
+#endif
+
+#if !CRSF_CALLBACKS && !CRSF_SNAPSHOT
+#error "CRSF_CALLBACKS and CRSF_SNAPSHOT are both 0, so decoded frames reach nothing"
+#endif
+
+// Implementations behind crsf_crc8(), see crsf_crc.h
+#define CRSF_CRC_TABLE_NIBBLE 1
+#define CRSF_CRC_TABLE_256 2
+#define CRSF_CRC_TABLE_SLICE4 3
+#define CRSF_CRC_TABLE_SLICE8 4
+
+#ifndef CRSF_CRC_TABLE
+#define CRSF_CRC_TABLE CRSF_CRC_TABLE_256
+#endif
+
+// Largest frame accepted or sent, [sync] to [crc8]. Longer frames are dropped
+// as bad lengths, also by the router. 26 is the smallest that fits an RC frame.
+#ifndef CRSF_MAX_FRAME_SIZE
+#define CRSF_MAX_FRAME_SIZE 64
+#endif
+
+#if CRSF_MAX_FRAME_SIZE < 26 || CRSF_MAX_FRAME_SIZE > 64
+#error "CRSF_MAX_FRAME_SIZE must be 26 - 64"
+#endif
+
+// Set to 1 to time every frame and count parse errors, see crsf_ctx_get_stats()
+#ifndef CRSF_STATS
+#define CRSF_STATS 0
+#endif
+
+// Warnings about rejected frames on stderr, for debugging on the host
+#ifndef CRSF_DEBUG
+#define CRSF_DEBUG 0
+#endif
@@ -0,0 +1,58 @@
+/**
+ * @file crsf_crc.h
+ * @author Britannio Jarrett
+ * @brief CRC-8/DVB-S2 (polynomial 0xD5) as used by CRSF frames.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * CRSF_CRC_TABLE selects the implementation behind crsf_crc8() and crsf_crc8_update():
+ *   - CRSF_CRC_TABLE_NIBBLE: 16-byte table, two lookups per byte, for flash-constrained builds
+ *   - CRSF_CRC_TABLE_256: 256-byte table, one lookup per byte (default)
+ *   - CRSF_CRC_TABLE_SLICE4 / CRSF_CRC_TABLE_SLICE8: 1 KB / 2 KB of tables, 4 / 8 bytes per
+ *     iteration with independent lookups, for bulk buffers and replay
+ * Every variant stays callable by name for benchmarks; unused tables are dropped by the linker.
+ */
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "crsf_config.h"
+
+extern const uint8_t crsf_crc8_table[256];
+extern const uint8_t crsf_crc8_nibble_table[16];
+
+/**
+ * Folds a single byte into a running CRC. Start from 0.
+ */
+static inline uint8_t crsf_crc8_update(uint8_t crc, uint8_t byte)
+{
+#if CRSF_CRC_TABLE == CRSF_CRC_TABLE_NIBBLE
+	crc ^= byte;
+	crc = (uint8_t)(crc << 4) ^ crsf_crc8_nibble_table[crc >> 4];
+	return (uint8_t)(crc << 4) ^ crsf_crc8_nibble_table[crc >> 4];
+#else
+	return crsf_crc8_table[crc ^ byte];
+#endif
+}
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    uint8_t crsf_crc8(const uint8_t *ptr, uint8_t len);
+    uint8_t crsf_crc8_update_buf(uint8_t crc, const uint8_t *ptr, size_t len);
+    uint8_t crsf_crc8_nibble(uint8_t crc, const uint8_t *ptr, size_t len);
+    uint8_t crsf_crc8_bytewise(uint8_t crc, const uint8_t *ptr, size_t len);
+    uint8_t crsf_crc8_slice4(uint8_t crc, const uint8_t *ptr, size_t len);
+    uint8_t crsf_crc8_slice8(uint8_t crc, const uint8_t *ptr, size_t len);
+    uint8_t crsf_crc8_command(const uint8_t *ptr, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
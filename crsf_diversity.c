@@ -0,0 +1,231 @@
+/**
+ * @file crsf_diversity.c
+ * @author Britannio Jarrett
+ * @brief Receiver diversity: one channel set merged from two CRSF receivers.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+
+#include "crsf_diversity.h"
+#include <string.h>
+
+// Built on the instance callbacks, see CRSF_CALLBACKS in crsf_config.h
+#if CRSF_CALLBACKS
+
+static uint8_t _link_index(const crsf_diversity_t *diversity, const crsf_t *crsf)
+{
+  return crsf == diversity->links[0] ? 0 : 1;
+}
+
+// In failsafe for any reason, including the RC timeout set off by the alarm
+static bool _link_down(const crsf_t *crsf)
+{
+  return __atomic_load_n(&crsf->failsafe_flags, __ATOMIC_ACQUIRE) != 0;
+}
+
+// Whether the active link has gone more than CRSF_DIVERSITY_STALE_FRAMES RC periods without a frame
+static bool _link_stale(const crsf_t *active, const crsf_t *standby, uint64_t now_us)
+{
+  if (active->last_rc_us == 0)
+  {
+    return true;
+  }
+  const uint32_t interval = active->rc_interval_us != 0 ? active->rc_interval_us : standby->rc_interval_us;
+  return interval != 0 && now_us - active->last_rc_us > (uint64_t)CRSF_DIVERSITY_STALE_FRAMES * interval;
+}
+
+// Link quality first, then RSSI (in -dBm, so lower is stronger)
+static bool _link_better(const link_statistics_t *standby, const link_statistics_t *active)
+{
+  const int lq_lead = (int)standby->link_quality - active->link_quality;
+  return lq_lead >= CRSF_DIVERSITY_LQ_MARGIN ||
+         (lq_lead >= 0 && (int)active->rssi - standby->rssi >= CRSF_DIVERSITY_RSSI_MARGIN);
+}
+
+static void _switch_to(crsf_diversity_t *diversity, uint8_t link, bool loss)
+{
+  __atomic_store_n(&diversity->active, link, __ATOMIC_RELEASE);
+  diversity->better_count = 0;
+  if (loss)
+  {
+    diversity->stats.loss_switches++;
+  }
+  else
+  {
+    diversity->stats.quality_switches++;
+  }
+}
+
+// Hands over to the standby link if the active one is down and the standby is not
+static void _check_loss(crsf_diversity_t *diversity)
+{
+  const uint8_t standby = diversity->active ^ 1;
+  if (_link_down(diversity->links[diversity->active]) && !_link_down(diversity->links[standby]))
+  {
+    _switch_to(diversity, standby, true);
+  }
+}
+
+static void _report_failsafe(crsf_diversity_t *diversity)
+{
+  const bool failsafe = _link_down(diversity->links[0]) && _link_down(diversity->links[1]);
+  if (failsafe == diversity->failsafe)
+  {
+    return;
+  }
+  __atomic_store_n(&diversity->failsafe, failsafe, __ATOMIC_RELEASE);
+  if (failsafe)
+  {
+    diversity->stats.failsafes++;
+  }
+  if (diversity->failsafe_callback != NULL)
+  {
+    diversity->failsafe_callback(diversity, failsafe);
+  }
+}
+
+void _diversity_on_rc_channels(crsf_t *crsf, const uint16_t channels[16])
+{
+  crsf_diversity_t *diversity = crsf->user_data;
+  const uint8_t link = _link_index(diversity, crsf);
+  if (link != diversity->active && !_link_down(crsf) &&
+      (_link_down(diversity->links[diversity->active]) ||
+       _link_stale(diversity->links[diversity->active], crsf, crsf->last_rc_us)))
+  {
+    _switch_to(diversity, link, true);
+  }
+  if (link != diversity->active)
+  {
+    diversity->stats.frames_dropped++;
+    return;
+  }
+  diversity->stats.frames_forwarded++;
+  if (diversity->rc_channels_callback != NULL)
+  {
+    diversity->rc_channels_callback(diversity, link, channels);
+  }
+}
+
+void _diversity_on_link_statistics(crsf_t *crsf, const link_statistics_t link_stats)
+{
+  (void)link_stats;
+  crsf_diversity_t *diversity = crsf->user_data;
+  const crsf_t *active = diversity->links[diversity->active];
+  const crsf_t *standby = diversity->links[diversity->active ^ 1];
+  if (_link_down(active) || _link_down(standby) ||
+      !_link_better(&standby->link_statistics, &active->link_statistics))
+  {
+    // Loss is handled once the instance reports its failsafe
+    diversity->better_count = 0;
+    return;
+  }
+  if (++diversity->better_count >= CRSF_DIVERSITY_SWITCH_COUNT)
+  {
+    _switch_to(diversity, diversity->active ^ 1, false);
+  }
+}
+
+void _diversity_on_failsafe(crsf_t *crsf, const bool failsafe)
+{
+  (void)failsafe;
+  crsf_diversity_t *diversity = crsf->user_data;
+  _check_loss(diversity);
+  _report_failsafe(diversity);
+}
+
+/**
+ * @brief Merges two initialized instances, starting with `link_a` active.
+ *
+ * Diversity takes over both instances' RC, link statistics and failsafe
+ * callbacks and their `user_data`. Failsafe counts as declared until a link
+ * comes up, as it does for a single instance.
+ *
+ * @param link_a An instance set up with crsf_init(), with its transport attached.
+ * @param link_b Likewise, for the second receiver.
+ */
+void crsf_diversity_init(crsf_diversity_t *diversity, crsf_t *link_a, crsf_t *link_b)
+{
+  memset(diversity, 0, sizeof(*diversity));
+  diversity->links[0] = link_a;
+  diversity->links[1] = link_b;
+  diversity->failsafe = true;
+  for (int i = 0; i < 2; i++)
+  {
+    crsf_t *crsf = diversity->links[i];
+    crsf->user_data = diversity;
+    crsf_ctx_set_on_rc_channels(crsf, _diversity_on_rc_channels);
+    crsf_ctx_set_on_link_statistics(crsf, _diversity_on_link_statistics);
+    crsf_ctx_set_on_failsafe(crsf, _diversity_on_failsafe);
+  }
+}
+
+/**
+ * @brief Sets the callback for RC channels, called with each frame forwarded and the link it came from.
+ */
+void crsf_diversity_set_on_rc_channels(crsf_diversity_t *diversity, void (*callback)(crsf_diversity_t *diversity, uint8_t link, const uint16_t channels[16]))
+{
+  diversity->rc_channels_callback = callback;
+}
+
+/**
+ * @brief Sets the callback for failsafe, called when both links are down and again when either recovers.
+ */
+void crsf_diversity_set_on_failsafe(crsf_diversity_t *diversity, void (*callback)(crsf_diversity_t *diversity, const bool failsafe))
+{
+  diversity->failsafe_callback = callback;
+}
+
+/**
+ * @brief Processes the frames received by both links. Call this in the main loop.
+ *
+ * Also picks up a link that timed out without receiving anything since.
+ */
+void crsf_diversity_process_frames(crsf_diversity_t *diversity)
+{
+  crsf_ctx_process_frames(diversity->links[0]);
+  crsf_ctx_process_frames(diversity->links[1]);
+  _check_loss(diversity);
+  _report_failsafe(diversity);
+}
+
+/**
+ * @brief Index of the link whose RC frames are forwarded: 0 for `link_a`, 1 for `link_b`.
+ */
+uint8_t crsf_diversity_active_link(const crsf_diversity_t *diversity)
+{
+  return __atomic_load_n(&diversity->active, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Copies the active link's snapshot, with the merged failsafe state.
+ *
+ * Safe to call from another core or thread, see crsf_ctx_get_latest().
+ *
+ * @return false if no consistent copy could be taken.
+ */
+bool crsf_diversity_get_latest(const crsf_diversity_t *diversity, crsf_snapshot_t *out)
+{
+  if (!crsf_ctx_get_latest(diversity->links[crsf_diversity_active_link(diversity)], out))
+  {
+    return false;
+  }
+  out->failsafe = __atomic_load_n(&diversity->failsafe, __ATOMIC_ACQUIRE);
+  return true;
+}
+
+/**
+ * @brief Copies the counters.
+ */
+void crsf_diversity_get_stats(const crsf_diversity_t *diversity, crsf_diversity_stats_t *out)
+{
+  *out = diversity->stats;
+}
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ * @file crsf_diversity.h
+ * @author Britannio Jarrett
+ * @brief Receiver diversity: one channel set merged from two CRSF receivers.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Each receiver is parsed by an instance of its own. RC frames are forwarded
+ * from the active link only; the other one stands by. The standby link takes
+ * over straight away when the active link enters failsafe or stops sending RC
+ * frames for CRSF_DIVERSITY_STALE_FRAMES periods, and otherwise only once its
+ * link statistics have been better for CRSF_DIVERSITY_SWITCH_COUNT reports in
+ * a row, so two links of about the same quality do not take turns. Failsafe is
+ * declared only when both links are in failsafe.
+ *
+ * Both transports must report time from the same clock.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "crsf.h"
+
+#ifndef CRSF_DIVERSITY_LQ_MARGIN
+// Link quality points by which the standby link must be ahead to count as better
+#define CRSF_DIVERSITY_LQ_MARGIN 10
+#endif
+
+#ifndef CRSF_DIVERSITY_RSSI_MARGIN
+// With link quality no worse, dB of RSSI by which the standby link must be ahead to count as better
+#define CRSF_DIVERSITY_RSSI_MARGIN 6
+#endif
+
+#ifndef CRSF_DIVERSITY_SWITCH_COUNT
+// Link statistics reports in a row in which the standby link must be better before it takes over
+#define CRSF_DIVERSITY_SWITCH_COUNT 3
+#endif
+
+#ifndef CRSF_DIVERSITY_STALE_FRAMES
+// RC periods without a frame from the active link after which the standby link takes over
+#define CRSF_DIVERSITY_STALE_FRAMES 3
+#endif
+
+typedef struct
+{
+	// RC frames forwarded from the active link, and those dropped from the standby link
+	uint32_t frames_forwarded;
+	uint32_t frames_dropped;
+	// Switches because the standby link reported better link statistics
+	uint32_t quality_switches;
+	// Switches because the active link entered failsafe or went quiet
+	uint32_t loss_switches;
+	// Times failsafe was declared, with both links down
+	uint32_t failsafes;
+} crsf_diversity_stats_t;
+
+typedef struct crsf_diversity_s crsf_diversity_t;
+
+/**
+ * @brief Merges two receivers. Owned by the caller, no allocation.
+ *
+ * Everything runs on the thread that calls crsf_diversity_process_frames().
+ */
+struct crsf_diversity_s
+{
+	crsf_t *links[2];
+	// Index of the link whose RC frames are forwarded
+	uint8_t active;
+	// Link statistics reports in a row in which the standby link was better
+	uint8_t better_count;
+	// Last state passed to failsafe_callback
+	bool failsafe;
+	void (*rc_channels_callback)(crsf_diversity_t *diversity, uint8_t link, const uint16_t channels[16]);
+	void (*failsafe_callback)(crsf_diversity_t *diversity, const bool failsafe);
+	// Free for the application, the instances' own `user_data` is taken
+	void *user_data;
+	crsf_diversity_stats_t stats;
+};
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    void crsf_diversity_init(crsf_diversity_t *diversity, crsf_t *link_a, crsf_t *link_b);
+    void crsf_diversity_set_on_rc_channels(crsf_diversity_t *diversity, void (*callback)(crsf_diversity_t *diversity, uint8_t link, const uint16_t channels[16]));
+    void crsf_diversity_set_on_failsafe(crsf_diversity_t *diversity, void (*callback)(crsf_diversity_t *diversity, const bool failsafe));
+    void crsf_diversity_process_frames(crsf_diversity_t *diversity);
+    uint8_t crsf_diversity_active_link(const crsf_diversity_t *diversity);
+    bool crsf_diversity_get_latest(const crsf_diversity_t *diversity, crsf_snapshot_t *out);
+    void crsf_diversity_get_stats(const crsf_diversity_t *diversity, crsf_diversity_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
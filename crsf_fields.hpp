@@ -0,0 +1,215 @@
+/**
+ * @file crsf_fields.hpp
+ * @author Britannio Jarrett
+ * @brief Building blocks of the constexpr frame descriptors in crsf_frames.hpp.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * A descriptor ties a frame type to its payload struct and says how the struct
+ * is laid out on the wire: field by field for fixed-size payloads, or through
+ * the generated C codec for bit-packed and variable-length ones. Everything is
+ * resolved at compile time, so decoding through a descriptor inlines to the
+ * same loads and stores crsf_frames.c makes, without the crsf_frame_codecs
+ * function pointers in between. Requires C++17.
+ */
+#pragma once
+#include <stdint.h>
+#include <type_traits>
+#include "crsf_frames.h"
+
+#if __cplusplus < 201703L
+#error "crsf_fields.hpp requires C++17"
+#endif
+
+namespace crsf
+{
+    // How an integer field is encoded on the wire, big-endian. Named after the
+    // _load_ and _store_ helpers of crsf_frames.c.
+    enum class wire : uint8_t
+    {
+        ui8,
+        ui16,
+        ui24,
+        ui32,
+        i8,
+        i16,
+        i32,
+    };
+
+    constexpr uint8_t wire_size(wire encoding)
+    {
+        switch (encoding)
+        {
+        case wire::ui8:
+        case wire::i8:
+            return 1;
+        case wire::ui16:
+        case wire::i16:
+            return 2;
+        case wire::ui24:
+            return 3;
+        default:
+            return 4;
+        }
+    }
+
+    constexpr bool wire_signed(wire encoding)
+    {
+        return encoding == wire::i8 || encoding == wire::i16 || encoding == wire::i32;
+    }
+
+    template <typename T>
+    struct member_traits;
+
+    template <typename Owner, typename T>
+    struct member_traits<T Owner::*>
+    {
+        using owner = Owner;
+        using type = T;
+    };
+
+    // One integer field of a fixed-size payload: the struct member it is read
+    // into and the offset and encoding it has in the payload
+    template <auto Member, uint8_t Offset, wire Encoding>
+    struct field
+    {
+        using owner = typename member_traits<decltype(Member)>::owner;
+        using value_type = typename member_traits<decltype(Member)>::type;
+        using unsigned_type = std::make_unsigned_t<value_type>;
+
+        static constexpr uint8_t offset = Offset;
+        static constexpr uint8_t size = wire_size(Encoding);
+
+        static_assert(std::is_integral_v<value_type>, "wire encodings are for integer members");
+        static_assert(sizeof(value_type) >= size, "the member is narrower than its wire encoding");
+        static_assert(std::is_signed_v<value_type> == wire_signed(Encoding),
+                      "the member and its wire encoding differ in signedness");
+
+        static constexpr void load(const uint8_t *payload, owner &out)
+        {
+            const uint8_t *src = &payload[Offset];
+            uint32_t value;
+            if constexpr (size == 1)
+            {
+                value = src[0];
+            }
+            else if constexpr (size == 2)
+            {
+                value = (uint32_t)src[0] << 8 | src[1];
+            }
+            else if constexpr (size == 3)
+            {
+                value = (uint32_t)src[0] << 16 | (uint32_t)src[1] << 8 | src[2];
+            }
+            else
+            {
+                value = (uint32_t)src[0] << 24 | (uint32_t)src[1] << 16 | (uint32_t)src[2] << 8 | src[3];
+            }
+            out.*Member = (value_type)(unsigned_type)value;
+        }
+
+        static constexpr void store(const owner &value, uint8_t *payload)
+        {
+            uint8_t *dst = &payload[Offset];
+            const uint32_t data = (unsigned_type)(value.*Member);
+            if constexpr (size == 4)
+            {
+                *dst++ = (uint8_t)(data >> 24);
+            }
+            if constexpr (size >= 3)
+            {
+                *dst++ = (uint8_t)(data >> 16);
+            }
+            if constexpr (size >= 2)
+            {
+                *dst++ = (uint8_t)(data >> 8);
+            }
+            *dst = (uint8_t)data;
+        }
+    };
+
+    // The fields of a fixed-size payload, in wire order
+    template <typename... Fields>
+    struct field_list
+    {
+        static constexpr uint8_t size = (0 + ... + Fields::size);
+
+        // Each field starts where the one before it ends
+        static constexpr bool contiguous()
+        {
+            uint8_t expected = 0;
+            bool ok = true;
+            ((ok = ok && Fields::offset == expected, expected += Fields::size), ...);
+            return ok;
+        }
+        static_assert(contiguous(), "payload fields overlap or leave gaps");
+
+        template <typename Payload, uint8_t PayloadSize>
+        static constexpr bool describes = size == PayloadSize && (std::is_same_v<typename Fields::owner, Payload> && ...);
+
+        // Same contract as the crsf_decode_* functions
+        template <typename Payload>
+        static constexpr bool decode(const uint8_t *payload, uint8_t length, Payload &out)
+        {
+            if (length < size)
+            {
+                return false;
+            }
+            (Fields::load(payload, out), ...);
+            return true;
+        }
+
+        template <typename Payload>
+        static constexpr uint8_t encode(const Payload &value, uint8_t *payload)
+        {
+            (Fields::store(value, payload), ...);
+            return size;
+        }
+    };
+
+    // Bit-packed and variable-length payloads keep their generated C codecs,
+    // called directly rather than through crsf_frame_codecs
+    template <auto Decode, auto Encode>
+    struct codec
+    {
+        template <typename Payload, uint8_t PayloadSize>
+        static constexpr bool describes = std::is_invocable_r_v<bool, decltype(Decode), const uint8_t *, uint8_t, Payload *> &&
+                                          std::is_invocable_r_v<uint8_t, decltype(Encode), const Payload *, uint8_t *>;
+
+        template <typename Payload>
+        static bool decode(const uint8_t *payload, uint8_t length, Payload &out)
+        {
+            return Decode(payload, length, &out);
+        }
+
+        template <typename Payload>
+        static uint8_t encode(const Payload &value, uint8_t *payload)
+        {
+            return Encode(&value, payload);
+        }
+    };
+
+    // Base of every frame<> specialization in crsf_frames.hpp
+    template <frame_type_t Type, typename Payload, uint8_t PayloadSize, typename Layout>
+    struct descriptor
+    {
+        using payload_type = Payload;
+        using layout = Layout;
+
+        static constexpr frame_type_t type = Type;
+        // Payload bytes of a fixed-size frame, the minimum for a variable one
+        static constexpr uint8_t payload_size = PayloadSize;
+        // [sync] [len] [type] [payload] [crc8] of the smallest valid frame
+        static constexpr uint8_t frame_size = PayloadSize + 4;
+
+        static_assert(frame_size <= CRSF_MAX_FRAME_SIZE, "the frame type does not fit in CRSF_MAX_FRAME_SIZE");
+        static_assert(Layout::template describes<Payload, PayloadSize>,
+                      "the layout does not match the payload struct or its size");
+    };
+}
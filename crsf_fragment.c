@@ -0,0 +1,260 @@
+/**
+ * @file crsf_fragment.c
+ * @author Britannio Jarrett
+ * @brief Messages of up to a few KB carried over custom (0x7F) telemetry frames.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+
+#include "crsf_fragment.h"
+#include <string.h>
+
+#define CRSF_FRAGMENT_MAX_COUNT ((CRSF_FRAGMENT_MESSAGE_MAX + CRSF_FRAGMENT_DATA_SIZE - 1) / CRSF_FRAGMENT_DATA_SIZE)
+#if CRSF_FRAGMENT_MAX_COUNT > 255
+#error "CRSF_FRAGMENT_MESSAGE_MAX needs more than 255 fragments"
+#endif
+
+static uint8_t _fragment_count(uint16_t length)
+{
+  // An empty message still takes one (empty) fragment
+  return length == 0 ? 1 : (length + CRSF_FRAGMENT_DATA_SIZE - 1) / CRSF_FRAGMENT_DATA_SIZE;
+}
+
+static uint64_t _link_now(const crsf_t *crsf)
+{
+  const crsf_transport_t *transport = crsf != NULL ? crsf->transport : NULL;
+  return transport != NULL ? transport->time_us(transport->ctx) : 0;
+}
+
+/**
+ * @brief Sets up a fragmenter sending through `crsf`'s custom telemetry frame.
+ *
+ * The frame is sent as soon as it is set (by default, see
+ * crsf_ctx_telem_set_schedule()), so fragments go out one per free telemetry slot.
+ */
+void crsf_fragmenter_init(crsf_fragmenter_t *fragmenter, crsf_t *crsf)
+{
+  memset(fragmenter, 0, sizeof(*fragmenter));
+  fragmenter->crsf = crsf;
+}
+
+/**
+ * @brief Copies a message into a free slot, to be sent after those already queued.
+ *
+ * @return false if the message is over CRSF_FRAGMENT_MESSAGE_MAX bytes or every slot is taken.
+ */
+bool crsf_fragmenter_queue(crsf_fragmenter_t *fragmenter, const uint8_t *data, size_t length)
+{
+  if (length > CRSF_FRAGMENT_MESSAGE_MAX || fragmenter->count == CRSF_FRAGMENT_SLOTS)
+  {
+    fragmenter->stats.messages_rejected++;
+    return false;
+  }
+  crsf_fragment_slot_t *slot = &fragmenter->slots[(fragmenter->head + fragmenter->count) % CRSF_FRAGMENT_SLOTS];
+  memcpy(slot->data, data, length);
+  slot->length = length;
+  slot->id = fragmenter->next_id++;
+  fragmenter->count++;
+  fragmenter->stats.messages_queued++;
+  return true;
+}
+
+/**
+ * @brief Hands the next fragment to the telemetry frame once the previous one has been sent.
+ *
+ * Call after every crsf_ctx_process_frames(), so each telemetry slot has a
+ * fragment ready.
+ */
+void crsf_fragmenter_poll(crsf_fragmenter_t *fragmenter)
+{
+  if (fragmenter->in_flight)
+  {
+    if (crsf_ctx_telem_pending(fragmenter->crsf, CRSF_CUSTOM_PAYLOAD_INDEX))
+    {
+      return;
+    }
+    const uint64_t now = _link_now(fragmenter->crsf);
+    if (fragmenter->stats.fragments_sent == 0)
+    {
+      fragmenter->first_sent_us = now;
+    }
+    fragmenter->last_sent_us = now;
+    fragmenter->stats.fragments_sent++;
+    fragmenter->in_flight = false;
+
+    const crsf_fragment_slot_t *slot = &fragmenter->slots[fragmenter->head];
+    if (++fragmenter->fragment == _fragment_count(slot->length))
+    {
+      fragmenter->stats.messages_sent++;
+      fragmenter->stats.bytes_sent += slot->length;
+      fragmenter->head = (fragmenter->head + 1) % CRSF_FRAGMENT_SLOTS;
+      fragmenter->count--;
+      fragmenter->fragment = 0;
+    }
+  }
+  if (fragmenter->count == 0)
+  {
+    return;
+  }
+
+  const crsf_fragment_slot_t *slot = &fragmenter->slots[fragmenter->head];
+  const uint16_t offset = fragmenter->fragment * CRSF_FRAGMENT_DATA_SIZE;
+  const uint16_t remaining = slot->length - offset;
+  const uint8_t length = remaining < CRSF_FRAGMENT_DATA_SIZE ? remaining : CRSF_FRAGMENT_DATA_SIZE;
+  uint8_t payload[CRSF_FRAGMENT_HEADER_SIZE + CRSF_FRAGMENT_DATA_SIZE];
+  payload[0] = slot->id;
+  payload[1] = fragmenter->fragment;
+  payload[2] = _fragment_count(slot->length);
+  memcpy(payload + CRSF_FRAGMENT_HEADER_SIZE, slot->data + offset, length);
+  crsf_ctx_telem_set_custom_payload(fragmenter->crsf, payload, CRSF_FRAGMENT_HEADER_SIZE + length);
+  fragmenter->in_flight = true;
+}
+
+/**
+ * @brief Slots free for crsf_fragmenter_queue().
+ */
+uint8_t crsf_fragmenter_free_slots(const crsf_fragmenter_t *fragmenter)
+{
+  return CRSF_FRAGMENT_SLOTS - fragmenter->count;
+}
+
+/**
+ * @brief Copies the counters, with throughput and the link's capacity worked out as of now.
+ */
+void crsf_fragmenter_get_stats(const crsf_fragmenter_t *fragmenter, crsf_fragment_stats_t *out)
+{
+  *out = fragmenter->stats;
+  const uint64_t elapsed_us = fragmenter->last_sent_us - fragmenter->first_sent_us;
+  out->throughput_bps = elapsed_us > 0 ? (uint32_t)((uint64_t)out->bytes_sent * 1000000 / elapsed_us) : 0;
+#if CRSF_TELEMETRY
+  // One telemetry slot every telem_ratio RC frames, each carrying a full custom payload
+  const crsf_t *crsf = fragmenter->crsf;
+  const uint64_t slot_us = (uint64_t)crsf->rc_interval_us * crsf->telem_ratio;
+  out->capacity_bps = slot_us > 0 ? (uint32_t)((CRSF_MAX_FRAME_SIZE - 4) * 1000000 / slot_us) : 0;
+#else
+  out->capacity_bps = 0;
+#endif
+}
+
+/**
+ * @brief Sets up a reassembler that calls `callback` with each complete message.
+ *
+ * Feed it the payload of every custom frame received on `crsf`, from the frame callback:
+ *
+ *     if (type == CRSF_FRAMETYPE_CUSTOM_PAYLOAD)
+ *         crsf_reassembler_push(&reassembler, payload->custom.buffer, payload->custom.length);
+ *
+ * `crsf` is only used for the time, and may be NULL at the cost of the goodput figure.
+ */
+void crsf_reassembler_init(crsf_reassembler_t *reassembler, crsf_t *crsf, crsf_message_callback_t callback, void *ctx)
+{
+  memset(reassembler, 0, sizeof(*reassembler));
+  reassembler->crsf = crsf;
+  reassembler->callback = callback;
+  reassembler->ctx = ctx;
+}
+
+/**
+ * @brief Copies the counters, with the goodput worked out from what was actually delivered.
+ */
+void crsf_reassembler_get_stats(const crsf_reassembler_t *reassembler, crsf_reassembly_stats_t *out)
+{
+  *out = reassembler->stats;
+  const uint64_t elapsed_us = reassembler->last_delivered_us - reassembler->first_received_us;
+  out->goodput_bps = out->messages > 0 && elapsed_us > 0 ? (uint32_t)((uint64_t)out->bytes * 1000000 / elapsed_us) : 0;
+}
+
+/**
+ * @brief Adds one received fragment, delivering the message once every fragment has arrived.
+ *
+ * A fragment of a new message abandons an unfinished one, and gaps in the
+ * message ids count as lost messages too. Fragments may arrive in any order
+ * within a message, and repeats are ignored.
+ */
+void crsf_reassembler_push(crsf_reassembler_t *reassembler, const uint8_t *payload, uint8_t length)
+{
+  if (length < CRSF_FRAGMENT_HEADER_SIZE)
+  {
+    reassembler->stats.malformed++;
+    return;
+  }
+  const uint8_t id = payload[0];
+  const uint8_t index = payload[1];
+  const uint8_t count = payload[2];
+  const uint8_t data_length = length - CRSF_FRAGMENT_HEADER_SIZE;
+  // Every fragment but the last is full
+  if (count == 0 || count > CRSF_FRAGMENT_MAX_COUNT || index >= count || data_length > CRSF_FRAGMENT_DATA_SIZE ||
+      (index < count - 1 && data_length != CRSF_FRAGMENT_DATA_SIZE))
+  {
+    reassembler->stats.malformed++;
+    return;
+  }
+  if (!reassembler->active && reassembler->synced && id == (uint8_t)(reassembler->expected_id - 1))
+  {
+    // A straggler from the message just delivered
+    reassembler->stats.duplicates++;
+    return;
+  }
+  if (!reassembler->active || id != reassembler->id || count != reassembler->count)
+  {
+    if (reassembler->active)
+    {
+      reassembler->stats.lost++;
+      reassembler->expected_id = reassembler->id + 1;
+    }
+    if (reassembler->synced)
+    {
+      // Messages of which no fragment arrived at all
+      reassembler->stats.lost += (uint8_t)(id - reassembler->expected_id);
+    }
+    memset(reassembler->received, 0, sizeof(reassembler->received));
+    reassembler->active = true;
+    reassembler->synced = true;
+    reassembler->id = id;
+    reassembler->count = count;
+    reassembler->missing = count;
+  }
+  uint32_t *word = &reassembler->received[index / 32];
+  const uint32_t bit = (uint32_t)1 << (index % 32);
+  if (*word & bit)
+  {
+    reassembler->stats.duplicates++;
+    return;
+  }
+  const size_t offset = (size_t)index * CRSF_FRAGMENT_DATA_SIZE;
+  if (offset + data_length > CRSF_FRAGMENT_MESSAGE_MAX)
+  {
+    reassembler->stats.malformed++;
+    return;
+  }
+  memcpy(reassembler->data + offset, payload + CRSF_FRAGMENT_HEADER_SIZE, data_length);
+  *word |= bit;
+  if (reassembler->stats.fragments++ == 0)
+  {
+    reassembler->first_received_us = _link_now(reassembler->crsf);
+  }
+  if (index == count - 1)
+  {
+    reassembler->last_length = data_length;
+  }
+  if (--reassembler->missing == 0)
+  {
+    reassembler->active = false;
+    reassembler->expected_id = id + 1;
+    const size_t message_length = (size_t)(count - 1) * CRSF_FRAGMENT_DATA_SIZE + reassembler->last_length;
+    reassembler->stats.messages++;
+    reassembler->stats.bytes += message_length;
+    reassembler->last_delivered_us = _link_now(reassembler->crsf);
+    if (reassembler->callback != NULL)
+    {
+      reassembler->callback(reassembler->ctx, reassembler->data, message_length);
+    }
+  }
+}
@@ -0,0 +1,150 @@
+/**
+ * @file crsf_fragment.h
+ * @author Britannio Jarrett
+ * @brief Messages of up to a few KB carried over custom (0x7F) telemetry frames.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Each custom frame payload carries one fragment:
+ *   [message id] [fragment index] [fragment count] [data: 57 bytes, fewer in the last fragment]
+ * Messages are sent one after another, their fragments in order, one per
+ * telemetry slot. There are no retransmissions: a message missing a fragment
+ * is counted as lost when the next message starts. A link that carries
+ * fragments should not also send raw custom payloads.
+ *
+ * Fragments are full 64-byte frames, so the reply slot must hold one: at
+ * 500 Hz and above that takes more than 420000 baud.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "crsf.h"
+
+#define CRSF_FRAGMENT_HEADER_SIZE 3
+// Data bytes per fragment: a whole custom payload less the header
+#define CRSF_FRAGMENT_DATA_SIZE (CRSF_MAX_FRAME_SIZE - 4 - CRSF_FRAGMENT_HEADER_SIZE)
+
+// Largest message, in bytes. At most 255 fragments.
+#ifndef CRSF_FRAGMENT_MESSAGE_MAX
+#define CRSF_FRAGMENT_MESSAGE_MAX 2048
+#endif
+
+// Messages that can be queued for sending at once
+#ifndef CRSF_FRAGMENT_SLOTS
+#define CRSF_FRAGMENT_SLOTS 4
+#endif
+
+typedef struct
+{
+	uint8_t data[CRSF_FRAGMENT_MESSAGE_MAX];
+	uint16_t length;
+	uint8_t id;
+} crsf_fragment_slot_t;
+
+typedef struct
+{
+	uint32_t messages_queued;
+	// Messages whose last fragment has been sent
+	uint32_t messages_sent;
+	// Messages refused because every slot was taken or they were too large
+	uint32_t messages_rejected;
+	uint32_t fragments_sent;
+	// Message bytes in the messages sent
+	uint32_t bytes_sent;
+	// Message bytes per second sent between the first and the latest fragment,
+	// whether or not they arrived (see crsf_reassembly_stats_t for goodput)
+	uint32_t throughput_bps;
+	// Custom payload bytes per second the telemetry slots could carry, at the
+	// measured RC rate and the telemetry ratio. 0 until the RC rate is known.
+	uint32_t capacity_bps;
+} crsf_fragment_stats_t;
+
+/**
+ * @brief Sends queued messages over an instance's custom telemetry frame.
+ *
+ * The slots are a FIFO: `head` is being sent, `count` are in use.
+ */
+typedef struct
+{
+	crsf_t *crsf;
+	crsf_fragment_slot_t slots[CRSF_FRAGMENT_SLOTS];
+	uint8_t head;
+	uint8_t count;
+	uint8_t next_id;
+	// Fragment of the head message handed to the telemetry frame, waiting to be sent
+	uint8_t fragment;
+	bool in_flight;
+	uint64_t first_sent_us;
+	uint64_t last_sent_us;
+	crsf_fragment_stats_t stats;
+} crsf_fragmenter_t;
+
+// Receives each reassembled message. `data` is only valid during the call.
+typedef void (*crsf_message_callback_t)(void *ctx, const uint8_t *data, size_t length);
+
+typedef struct
+{
+	uint32_t messages;
+	// Messages abandoned with fragments missing, or never seen at all
+	uint32_t lost;
+	uint32_t duplicates;
+	// Fragments with an impossible header or length
+	uint32_t malformed;
+	// Fragments taken into a message
+	uint32_t fragments;
+	// Message bytes in the messages delivered
+	uint32_t bytes;
+	// Message bytes delivered per second between the first fragment received and
+	// the latest message delivered. 0 without a receiving instance to tell the time.
+	uint32_t goodput_bps;
+} crsf_reassembly_stats_t;
+
+/**
+ * @brief Rebuilds messages from the custom payloads received on a link.
+ */
+typedef struct
+{
+	uint8_t data[CRSF_FRAGMENT_MESSAGE_MAX];
+	// Fragments of message `id` received so far, one bit each
+	uint32_t received[8];
+	uint8_t id;
+	uint8_t count;
+	uint8_t missing;
+	uint8_t last_length;
+	bool active;
+	// Id the next message should have, once any message has been seen
+	uint8_t expected_id;
+	bool synced;
+	crsf_message_callback_t callback;
+	void *ctx;
+	// Instance the fragments arrive on, for the time, or NULL
+	crsf_t *crsf;
+	uint64_t first_received_us;
+	uint64_t last_delivered_us;
+	crsf_reassembly_stats_t stats;
+} crsf_reassembler_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    void crsf_fragmenter_init(crsf_fragmenter_t *fragmenter, crsf_t *crsf);
+    bool crsf_fragmenter_queue(crsf_fragmenter_t *fragmenter, const uint8_t *data, size_t length);
+    void crsf_fragmenter_poll(crsf_fragmenter_t *fragmenter);
+    uint8_t crsf_fragmenter_free_slots(const crsf_fragmenter_t *fragmenter);
+    void crsf_fragmenter_get_stats(const crsf_fragmenter_t *fragmenter, crsf_fragment_stats_t *out);
+    void crsf_reassembler_init(crsf_reassembler_t *reassembler, crsf_t *crsf, crsf_message_callback_t callback, void *ctx);
+    void crsf_reassembler_push(crsf_reassembler_t *reassembler, const uint8_t *payload, uint8_t length);
+    void crsf_reassembler_get_stats(const crsf_reassembler_t *reassembler, crsf_reassembly_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
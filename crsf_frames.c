@@ -0,0 +1,1003 @@
+/**
+ * @file crsf_frames.c
+ * @author Britannio Jarrett
+ * @brief Payload structs and codecs for the CRSF frame types.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Generated by gen_frames.dart, do not edit.
+ */
+
+#include "crsf_frames.h"
+#include <string.h>
+
+// Fields are big-endian on the wire
+static inline uint8_t _load_ui8(const uint8_t *src)
+{
+  return src[0];
+}
+
+static inline int8_t _load_i8(const uint8_t *src)
+{
+  return (int8_t)src[0];
+}
+
+static inline uint16_t _load_ui16(const uint8_t *src)
+{
+  return (uint16_t)(src[0] << 8 | src[1]);
+}
+
+static inline int16_t _load_i16(const uint8_t *src)
+{
+  return (int16_t)_load_ui16(src);
+}
+
+static inline uint32_t _load_ui24(const uint8_t *src)
+{
+  return (uint32_t)src[0] << 16 | (uint32_t)src[1] << 8 | src[2];
+}
+
+static inline uint32_t _load_ui32(const uint8_t *src)
+{
+  return (uint32_t)src[0] << 24 | (uint32_t)src[1] << 16 | (uint32_t)src[2] << 8 | src[3];
+}
+
+static inline int32_t _load_i32(const uint8_t *src)
+{
+  return (int32_t)_load_ui32(src);
+}
+
+static inline void _store_ui8(uint8_t *dst, uint8_t data)
+{
+  dst[0] = data;
+}
+
+static inline void _store_i8(uint8_t *dst, int8_t data)
+{
+  dst[0] = (uint8_t)data;
+}
+
+static inline void _store_ui16(uint8_t *dst, uint16_t data)
+{
+  dst[0] = data >> 8;
+  dst[1] = data;
+}
+
+static inline void _store_i16(uint8_t *dst, int16_t data)
+{
+  _store_ui16(dst, (uint16_t)data);
+}
+
+static inline void _store_ui24(uint8_t *dst, uint32_t data)
+{
+  dst[0] = data >> 16;
+  dst[1] = data >> 8;
+  dst[2] = data;
+}
+
+static inline void _store_ui32(uint8_t *dst, uint32_t data)
+{
+  dst[0] = data >> 24;
+  dst[1] = data >> 16;
+  dst[2] = data >> 8;
+  dst[3] = data;
+}
+
+static inline void _store_i32(uint8_t *dst, int32_t data)
+{
+  _store_ui32(dst, (uint32_t)data);
+}
+
+// Store `data` big-endian at `dst`, returning whether any byte changed
+static inline bool _patch_ui8(uint8_t *dst, uint8_t data)
+{
+  const bool changed = dst[0] != data;
+  dst[0] = data;
+  return changed;
+}
+
+static inline bool _patch_i8(uint8_t *dst, int8_t data)
+{
+  return _patch_ui8(dst, (uint8_t)data);
+}
+
+static inline bool _patch_ui16(uint8_t *dst, uint16_t data)
+{
+  const uint8_t bytes[2] = {data >> 8, data};
+  const bool changed = memcmp(dst, bytes, sizeof(bytes)) != 0;
+  memcpy(dst, bytes, sizeof(bytes));
+  return changed;
+}
+
+static inline bool _patch_i16(uint8_t *dst, int16_t data)
+{
+  return _patch_ui16(dst, (uint16_t)data);
+}
+
+static inline bool _patch_ui24(uint8_t *dst, uint32_t data)
+{
+  const uint8_t bytes[3] = {data >> 16, data >> 8, data};
+  const bool changed = memcmp(dst, bytes, sizeof(bytes)) != 0;
+  memcpy(dst, bytes, sizeof(bytes));
+  return changed;
+}
+
+static inline bool _patch_ui32(uint8_t *dst, uint32_t data)
+{
+  const uint8_t bytes[4] = {data >> 24, data >> 16, data >> 8, data};
+  const bool changed = memcmp(dst, bytes, sizeof(bytes)) != 0;
+  memcpy(dst, bytes, sizeof(bytes));
+  return changed;
+}
+
+static inline bool _patch_i32(uint8_t *dst, int32_t data)
+{
+  return _patch_ui32(dst, (uint32_t)data);
+}
+
+// Copies the null-terminated string at `src` into `dst`, truncating it to fit.
+// Returns the bytes consumed including the terminator, 0 if there is none.
+static inline uint8_t _load_string(char *dst, size_t size, const uint8_t *src, uint8_t length)
+{
+  const uint8_t *end = memchr(src, 0, length);
+  if (end == NULL)
+  {
+    return 0;
+  }
+  const size_t consumed = end - src + 1;
+  const size_t copied = consumed < size ? consumed - 1 : size - 1;
+  memcpy(dst, src, copied);
+  dst[copied] = '\0';
+  return consumed;
+}
+
+static inline uint8_t _store_string(uint8_t *dst, const char *src, size_t size)
+{
+  const size_t length = strnlen(src, size - 1);
+  memcpy(dst, src, length);
+  dst[length] = '\0';
+  return length + 1;
+}
+
+#if CRSF_FRAME_RC_CHANNELS_PACKED
+bool crsf_decode_rc_channels_packed(const uint8_t *payload, uint8_t length, crsf_payload_rc_channels_packed_t *out)
+{
+  if (length < CRSF_RC_CHANNELS_PACKED_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  memcpy(out, payload, CRSF_RC_CHANNELS_PACKED_PAYLOAD_SIZE);
+  return true;
+}
+
+uint8_t crsf_encode_rc_channels_packed(const crsf_payload_rc_channels_packed_t *value, uint8_t *payload)
+{
+  memcpy(payload, value, CRSF_RC_CHANNELS_PACKED_PAYLOAD_SIZE);
+  return CRSF_RC_CHANNELS_PACKED_PAYLOAD_SIZE;
+}
+#endif
+
+#if CRSF_FRAME_BATTERY_SENSOR
+bool crsf_decode_battery_sensor(const uint8_t *payload, uint8_t length, crsf_payload_battery_sensor_t *out)
+{
+  if (length < CRSF_BATTERY_SENSOR_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  out->voltage = _load_ui16(&payload[0]);
+  out->current = _load_ui16(&payload[2]);
+  out->capacity = _load_ui24(&payload[4]);
+  out->percent = _load_ui8(&payload[7]);
+  return true;
+}
+
+uint8_t crsf_encode_battery_sensor(const crsf_payload_battery_sensor_t *value, uint8_t *payload)
+{
+  _store_ui16(&payload[0], value->voltage);
+  _store_ui16(&payload[2], value->current);
+  _store_ui24(&payload[4], value->capacity);
+  _store_ui8(&payload[7], value->percent);
+  return CRSF_BATTERY_SENSOR_PAYLOAD_SIZE;
+}
+
+bool crsf_patch_battery_sensor(uint8_t *payload, const crsf_payload_battery_sensor_t *value)
+{
+  bool changed = false;
+  changed |= _patch_ui16(&payload[0], value->voltage);
+  changed |= _patch_ui16(&payload[2], value->current);
+  changed |= _patch_ui24(&payload[4], value->capacity);
+  changed |= _patch_ui8(&payload[7], value->percent);
+  return changed;
+}
+#endif
+
+#if CRSF_FRAME_LINK_STATISTICS
+bool crsf_decode_link_statistics(const uint8_t *payload, uint8_t length, crsf_payload_link_statistics_t *out)
+{
+  if (length < CRSF_LINK_STATISTICS_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  out->uplink_rssi_ant_1 = _load_ui8(&payload[0]);
+  out->uplink_rssi_ant_2 = _load_ui8(&payload[1]);
+  out->uplink_package_success_rate = _load_ui8(&payload[2]);
+  out->uplink_snr = _load_i8(&payload[3]);
+  out->diversity_active_antenna = _load_ui8(&payload[4]);
+  out->rf_mode = _load_ui8(&payload[5]);
+  out->uplink_tx_power = _load_ui8(&payload[6]);
+  out->downlink_rssi = _load_ui8(&payload[7]);
+  out->downlink_package_success_rate = _load_ui8(&payload[8]);
+  out->downlink_snr = _load_i8(&payload[9]);
+  return true;
+}
+
+uint8_t crsf_encode_link_statistics(const crsf_payload_link_statistics_t *value, uint8_t *payload)
+{
+  _store_ui8(&payload[0], value->uplink_rssi_ant_1);
+  _store_ui8(&payload[1], value->uplink_rssi_ant_2);
+  _store_ui8(&payload[2], value->uplink_package_success_rate);
+  _store_i8(&payload[3], value->uplink_snr);
+  _store_ui8(&payload[4], value->diversity_active_antenna);
+  _store_ui8(&payload[5], value->rf_mode);
+  _store_ui8(&payload[6], value->uplink_tx_power);
+  _store_ui8(&payload[7], value->downlink_rssi);
+  _store_ui8(&payload[8], value->downlink_package_success_rate);
+  _store_i8(&payload[9], value->downlink_snr);
+  return CRSF_LINK_STATISTICS_PAYLOAD_SIZE;
+}
+
+bool crsf_patch_link_statistics(uint8_t *payload, const crsf_payload_link_statistics_t *value)
+{
+  bool changed = false;
+  changed |= _patch_ui8(&payload[0], value->uplink_rssi_ant_1);
+  changed |= _patch_ui8(&payload[1], value->uplink_rssi_ant_2);
+  changed |= _patch_ui8(&payload[2], value->uplink_package_success_rate);
+  changed |= _patch_i8(&payload[3], value->uplink_snr);
+  changed |= _patch_ui8(&payload[4], value->diversity_active_antenna);
+  changed |= _patch_ui8(&payload[5], value->rf_mode);
+  changed |= _patch_ui8(&payload[6], value->uplink_tx_power);
+  changed |= _patch_ui8(&payload[7], value->downlink_rssi);
+  changed |= _patch_ui8(&payload[8], value->downlink_package_success_rate);
+  changed |= _patch_i8(&payload[9], value->downlink_snr);
+  return changed;
+}
+#endif
+
+#if CRSF_FRAME_GPS
+bool crsf_decode_gps(const uint8_t *payload, uint8_t length, crsf_payload_gps_t *out)
+{
+  if (length < CRSF_GPS_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  out->latitude = _load_i32(&payload[0]);
+  out->longitude = _load_i32(&payload[4]);
+  out->groundspeed = _load_ui16(&payload[8]);
+  out->heading = _load_ui16(&payload[10]);
+  out->altitude = _load_ui16(&payload[12]);
+  out->satellites = _load_ui8(&payload[14]);
+  return true;
+}
+
+uint8_t crsf_encode_gps(const crsf_payload_gps_t *value, uint8_t *payload)
+{
+  _store_i32(&payload[0], value->latitude);
+  _store_i32(&payload[4], value->longitude);
+  _store_ui16(&payload[8], value->groundspeed);
+  _store_ui16(&payload[10], value->heading);
+  _store_ui16(&payload[12], value->altitude);
+  _store_ui8(&payload[14], value->satellites);
+  return CRSF_GPS_PAYLOAD_SIZE;
+}
+
+bool crsf_patch_gps(uint8_t *payload, const crsf_payload_gps_t *value)
+{
+  bool changed = false;
+  changed |= _patch_i32(&payload[0], value->latitude);
+  changed |= _patch_i32(&payload[4], value->longitude);
+  changed |= _patch_ui16(&payload[8], value->groundspeed);
+  changed |= _patch_ui16(&payload[10], value->heading);
+  changed |= _patch_ui16(&payload[12], value->altitude);
+  changed |= _patch_ui8(&payload[14], value->satellites);
+  return changed;
+}
+#endif
+
+#if CRSF_FRAME_VARIO
+bool crsf_decode_vario(const uint8_t *payload, uint8_t length, crsf_payload_vario_t *out)
+{
+  if (length < CRSF_VARIO_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  out->vertical_speed = _load_i16(&payload[0]);
+  return true;
+}
+
+uint8_t crsf_encode_vario(const crsf_payload_vario_t *value, uint8_t *payload)
+{
+  _store_i16(&payload[0], value->vertical_speed);
+  return CRSF_VARIO_PAYLOAD_SIZE;
+}
+
+bool crsf_patch_vario(uint8_t *payload, const crsf_payload_vario_t *value)
+{
+  bool changed = false;
+  changed |= _patch_i16(&payload[0], value->vertical_speed);
+  return changed;
+}
+#endif
+
+#if CRSF_FRAME_BARO_ALTITUDE
+bool crsf_decode_baro_altitude(const uint8_t *payload, uint8_t length, crsf_payload_baro_altitude_t *out)
+{
+  if (length < CRSF_BARO_ALTITUDE_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  out->altitude = _load_ui16(&payload[0]);
+  out->vertical_speed = _load_i8(&payload[2]);
+  return true;
+}
+
+uint8_t crsf_encode_baro_altitude(const crsf_payload_baro_altitude_t *value, uint8_t *payload)
+{
+  _store_ui16(&payload[0], value->altitude);
+  _store_i8(&payload[2], value->vertical_speed);
+  return CRSF_BARO_ALTITUDE_PAYLOAD_SIZE;
+}
+
+bool crsf_patch_baro_altitude(uint8_t *payload, const crsf_payload_baro_altitude_t *value)
+{
+  bool changed = false;
+  changed |= _patch_ui16(&payload[0], value->altitude);
+  changed |= _patch_i8(&payload[2], value->vertical_speed);
+  return changed;
+}
+#endif
+
+#if CRSF_FRAME_ATTITUDE
+bool crsf_decode_attitude(const uint8_t *payload, uint8_t length, crsf_payload_attitude_t *out)
+{
+  if (length < CRSF_ATTITUDE_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  out->pitch = _load_i16(&payload[0]);
+  out->roll = _load_i16(&payload[2]);
+  out->yaw = _load_i16(&payload[4]);
+  return true;
+}
+
+uint8_t crsf_encode_attitude(const crsf_payload_attitude_t *value, uint8_t *payload)
+{
+  _store_i16(&payload[0], value->pitch);
+  _store_i16(&payload[2], value->roll);
+  _store_i16(&payload[4], value->yaw);
+  return CRSF_ATTITUDE_PAYLOAD_SIZE;
+}
+
+bool crsf_patch_attitude(uint8_t *payload, const crsf_payload_attitude_t *value)
+{
+  bool changed = false;
+  changed |= _patch_i16(&payload[0], value->pitch);
+  changed |= _patch_i16(&payload[2], value->roll);
+  changed |= _patch_i16(&payload[4], value->yaw);
+  return changed;
+}
+#endif
+
+#if CRSF_FRAME_FLIGHT_MODE
+bool crsf_decode_flight_mode(const uint8_t *payload, uint8_t length, crsf_payload_flight_mode_t *out)
+{
+  if (length < CRSF_FLIGHT_MODE_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  uint8_t offset = 0;
+  const uint8_t flight_mode_size = _load_string(out->flight_mode, sizeof(out->flight_mode), &payload[offset], length - offset);
+  if (flight_mode_size == 0)
+  {
+    return false;
+  }
+  offset += flight_mode_size;
+  return true;
+}
+
+uint8_t crsf_encode_flight_mode(const crsf_payload_flight_mode_t *value, uint8_t *payload)
+{
+  uint8_t offset = 0;
+  offset += _store_string(&payload[offset], value->flight_mode, sizeof(value->flight_mode));
+  return offset;
+}
+#endif
+
+#if CRSF_FRAME_RC_CHANNELS_SUBSET
+bool crsf_decode_rc_channels_subset(const uint8_t *payload, uint8_t length, crsf_payload_rc_channels_subset_t *out)
+{
+  if (length < CRSF_RC_CHANNELS_SUBSET_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  uint8_t offset = 0;
+  out->count = crsf_unpack_channel_subset(&payload[offset], length - offset, &out->start_channel, &out->resolution, out->channels);
+  if (out->count == 0)
+  {
+    return false;
+  }
+  offset = length;
+  return true;
+}
+
+uint8_t crsf_encode_rc_channels_subset(const crsf_payload_rc_channels_subset_t *value, uint8_t *payload)
+{
+  uint8_t offset = 0;
+  offset += crsf_pack_channel_subset(value->start_channel, value->resolution, value->channels, value->count, &payload[offset]);
+  return offset;
+}
+#endif
+
+#if CRSF_FRAME_DEVICE_PING
+bool crsf_decode_device_ping(const uint8_t *payload, uint8_t length, crsf_payload_device_ping_t *out)
+{
+  if (length < CRSF_DEVICE_PING_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  out->destination = _load_ui8(&payload[0]);
+  out->origin = _load_ui8(&payload[1]);
+  return true;
+}
+
+uint8_t crsf_encode_device_ping(const crsf_payload_device_ping_t *value, uint8_t *payload)
+{
+  _store_ui8(&payload[0], value->destination);
+  _store_ui8(&payload[1], value->origin);
+  return CRSF_DEVICE_PING_PAYLOAD_SIZE;
+}
+
+bool crsf_patch_device_ping(uint8_t *payload, const crsf_payload_device_ping_t *value)
+{
+  bool changed = false;
+  changed |= _patch_ui8(&payload[0], value->destination);
+  changed |= _patch_ui8(&payload[1], value->origin);
+  return changed;
+}
+#endif
+
+#if CRSF_FRAME_DEVICE_INFO
+bool crsf_decode_device_info(const uint8_t *payload, uint8_t length, crsf_payload_device_info_t *out)
+{
+  if (length < CRSF_DEVICE_INFO_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  uint8_t offset = 0;
+  out->destination = _load_ui8(&payload[offset]);
+  offset += 1;
+  out->origin = _load_ui8(&payload[offset]);
+  offset += 1;
+  const uint8_t device_name_size = _load_string(out->device_name, sizeof(out->device_name), &payload[offset], length - offset);
+  if (device_name_size == 0 || length - offset - device_name_size < 14)
+  {
+    return false;
+  }
+  offset += device_name_size;
+  out->serial_number = _load_ui32(&payload[offset]);
+  offset += 4;
+  out->hardware_id = _load_ui32(&payload[offset]);
+  offset += 4;
+  out->firmware_id = _load_ui32(&payload[offset]);
+  offset += 4;
+  out->parameter_count = _load_ui8(&payload[offset]);
+  offset += 1;
+  out->parameter_version = _load_ui8(&payload[offset]);
+  offset += 1;
+  return true;
+}
+
+uint8_t crsf_encode_device_info(const crsf_payload_device_info_t *value, uint8_t *payload)
+{
+  uint8_t offset = 0;
+  _store_ui8(&payload[offset], value->destination);
+  offset += 1;
+  _store_ui8(&payload[offset], value->origin);
+  offset += 1;
+  offset += _store_string(&payload[offset], value->device_name, sizeof(value->device_name));
+  _store_ui32(&payload[offset], value->serial_number);
+  offset += 4;
+  _store_ui32(&payload[offset], value->hardware_id);
+  offset += 4;
+  _store_ui32(&payload[offset], value->firmware_id);
+  offset += 4;
+  _store_ui8(&payload[offset], value->parameter_count);
+  offset += 1;
+  _store_ui8(&payload[offset], value->parameter_version);
+  offset += 1;
+  return offset;
+}
+#endif
+
+#if CRSF_FRAME_PARAMETER_SETTINGS_ENTRY
+bool crsf_decode_parameter_settings_entry(const uint8_t *payload, uint8_t length, crsf_payload_parameter_settings_entry_t *out)
+{
+  if (length < CRSF_PARAMETER_SETTINGS_ENTRY_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  uint8_t offset = 0;
+  out->destination = _load_ui8(&payload[offset]);
+  offset += 1;
+  out->origin = _load_ui8(&payload[offset]);
+  offset += 1;
+  out->field_index = _load_ui8(&payload[offset]);
+  offset += 1;
+  out->chunks_remaining = _load_ui8(&payload[offset]);
+  offset += 1;
+  if ((size_t)(length - offset) > sizeof(out->data))
+  {
+    return false;
+  }
+  out->length = length - offset;
+  memcpy(out->data, &payload[offset], out->length);
+  offset += out->length;
+  return true;
+}
+
+uint8_t crsf_encode_parameter_settings_entry(const crsf_payload_parameter_settings_entry_t *value, uint8_t *payload)
+{
+  uint8_t offset = 0;
+  _store_ui8(&payload[offset], value->destination);
+  offset += 1;
+  _store_ui8(&payload[offset], value->origin);
+  offset += 1;
+  _store_ui8(&payload[offset], value->field_index);
+  offset += 1;
+  _store_ui8(&payload[offset], value->chunks_remaining);
+  offset += 1;
+  const uint8_t data_length = value->length < sizeof(value->data) ? value->length : sizeof(value->data);
+  memcpy(&payload[offset], value->data, data_length);
+  offset += data_length;
+  return offset;
+}
+#endif
+
+#if CRSF_FRAME_PARAMETER_READ
+bool crsf_decode_parameter_read(const uint8_t *payload, uint8_t length, crsf_payload_parameter_read_t *out)
+{
+  if (length < CRSF_PARAMETER_READ_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  out->destination = _load_ui8(&payload[0]);
+  out->origin = _load_ui8(&payload[1]);
+  out->field_index = _load_ui8(&payload[2]);
+  out->field_chunk = _load_ui8(&payload[3]);
+  return true;
+}
+
+uint8_t crsf_encode_parameter_read(const crsf_payload_parameter_read_t *value, uint8_t *payload)
+{
+  _store_ui8(&payload[0], value->destination);
+  _store_ui8(&payload[1], value->origin);
+  _store_ui8(&payload[2], value->field_index);
+  _store_ui8(&payload[3], value->field_chunk);
+  return CRSF_PARAMETER_READ_PAYLOAD_SIZE;
+}
+
+bool crsf_patch_parameter_read(uint8_t *payload, const crsf_payload_parameter_read_t *value)
+{
+  bool changed = false;
+  changed |= _patch_ui8(&payload[0], value->destination);
+  changed |= _patch_ui8(&payload[1], value->origin);
+  changed |= _patch_ui8(&payload[2], value->field_index);
+  changed |= _patch_ui8(&payload[3], value->field_chunk);
+  return changed;
+}
+#endif
+
+#if CRSF_FRAME_PARAMETER_WRITE
+bool crsf_decode_parameter_write(const uint8_t *payload, uint8_t length, crsf_payload_parameter_write_t *out)
+{
+  if (length < CRSF_PARAMETER_WRITE_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  uint8_t offset = 0;
+  out->destination = _load_ui8(&payload[offset]);
+  offset += 1;
+  out->origin = _load_ui8(&payload[offset]);
+  offset += 1;
+  out->field_index = _load_ui8(&payload[offset]);
+  offset += 1;
+  if ((size_t)(length - offset) > sizeof(out->value))
+  {
+    return false;
+  }
+  out->length = length - offset;
+  memcpy(out->value, &payload[offset], out->length);
+  offset += out->length;
+  return true;
+}
+
+uint8_t crsf_encode_parameter_write(const crsf_payload_parameter_write_t *value, uint8_t *payload)
+{
+  uint8_t offset = 0;
+  _store_ui8(&payload[offset], value->destination);
+  offset += 1;
+  _store_ui8(&payload[offset], value->origin);
+  offset += 1;
+  _store_ui8(&payload[offset], value->field_index);
+  offset += 1;
+  const uint8_t value_length = value->length < sizeof(value->value) ? value->length : sizeof(value->value);
+  memcpy(&payload[offset], value->value, value_length);
+  offset += value_length;
+  return offset;
+}
+#endif
+
+#if CRSF_FRAME_COMMAND
+bool crsf_decode_command(const uint8_t *payload, uint8_t length, crsf_payload_command_t *out)
+{
+  if (length < CRSF_COMMAND_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  uint8_t offset = 0;
+  out->destination = _load_ui8(&payload[offset]);
+  offset += 1;
+  out->origin = _load_ui8(&payload[offset]);
+  offset += 1;
+  out->command = _load_ui8(&payload[offset]);
+  offset += 1;
+  if ((size_t)(length - offset) > sizeof(out->data))
+  {
+    return false;
+  }
+  out->length = length - offset;
+  memcpy(out->data, &payload[offset], out->length);
+  offset += out->length;
+  return true;
+}
+
+uint8_t crsf_encode_command(const crsf_payload_command_t *value, uint8_t *payload)
+{
+  uint8_t offset = 0;
+  _store_ui8(&payload[offset], value->destination);
+  offset += 1;
+  _store_ui8(&payload[offset], value->origin);
+  offset += 1;
+  _store_ui8(&payload[offset], value->command);
+  offset += 1;
+  const uint8_t data_length = value->length < sizeof(value->data) ? value->length : sizeof(value->data);
+  memcpy(&payload[offset], value->data, data_length);
+  offset += data_length;
+  return offset;
+}
+#endif
+
+#if CRSF_FRAME_RADIO_ID
+bool crsf_decode_radio_id(const uint8_t *payload, uint8_t length, crsf_payload_radio_id_t *out)
+{
+  if (length < CRSF_RADIO_ID_PAYLOAD_SIZE)
+  {
+    return false;
+  }
+  out->destination = _load_ui8(&payload[0]);
+  out->origin = _load_ui8(&payload[1]);
+  out->subtype = _load_ui8(&payload[2]);
+  out->interval = _load_ui32(&payload[3]);
+  out->offset = _load_i32(&payload[7]);
+  return true;
+}
+
+uint8_t crsf_encode_radio_id(const crsf_payload_radio_id_t *value, uint8_t *payload)
+{
+  _store_ui8(&payload[0], value->destination);
+  _store_ui8(&payload[1], value->origin);
+  _store_ui8(&payload[2], value->subtype);
+  _store_ui32(&payload[3], value->interval);
+  _store_i32(&payload[7], value->offset);
+  return CRSF_RADIO_ID_PAYLOAD_SIZE;
+}
+
+bool crsf_patch_radio_id(uint8_t *payload, const crsf_payload_radio_id_t *value)
+{
+  bool changed = false;
+  changed |= _patch_ui8(&payload[0], value->destination);
+  changed |= _patch_ui8(&payload[1], value->origin);
+  changed |= _patch_ui8(&payload[2], value->subtype);
+  changed |= _patch_ui32(&payload[3], value->interval);
+  changed |= _patch_i32(&payload[7], value->offset);
+  return changed;
+}
+#endif
+
+#if CRSF_FRAME_CUSTOM_PAYLOAD
+bool crsf_decode_custom(const uint8_t *payload, uint8_t length, crsf_payload_custom_t *out)
+{
+  uint8_t offset = 0;
+  if ((size_t)(length - offset) > sizeof(out->buffer))
+  {
+    return false;
+  }
+  out->length = length - offset;
+  memcpy(out->buffer, &payload[offset], out->length);
+  offset += out->length;
+  return true;
+}
+
+uint8_t crsf_encode_custom(const crsf_payload_custom_t *value, uint8_t *payload)
+{
+  uint8_t offset = 0;
+  const uint8_t buffer_length = value->length < sizeof(value->buffer) ? value->length : sizeof(value->buffer);
+  memcpy(&payload[offset], value->buffer, buffer_length);
+  offset += buffer_length;
+  return offset;
+}
+#endif
+
+// Adapters to the untyped signatures stored in crsf_frame_codecs
+#if CRSF_FRAME_RC_CHANNELS_PACKED
+static bool _decode_rc_channels_packed(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_rc_channels_packed(payload, length, out);
+}
+
+static uint8_t _encode_rc_channels_packed(const void *value, uint8_t *payload)
+{
+  return crsf_encode_rc_channels_packed(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_BATTERY_SENSOR
+static bool _decode_battery_sensor(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_battery_sensor(payload, length, out);
+}
+
+static uint8_t _encode_battery_sensor(const void *value, uint8_t *payload)
+{
+  return crsf_encode_battery_sensor(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_LINK_STATISTICS
+static bool _decode_link_statistics(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_link_statistics(payload, length, out);
+}
+
+static uint8_t _encode_link_statistics(const void *value, uint8_t *payload)
+{
+  return crsf_encode_link_statistics(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_GPS
+static bool _decode_gps(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_gps(payload, length, out);
+}
+
+static uint8_t _encode_gps(const void *value, uint8_t *payload)
+{
+  return crsf_encode_gps(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_VARIO
+static bool _decode_vario(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_vario(payload, length, out);
+}
+
+static uint8_t _encode_vario(const void *value, uint8_t *payload)
+{
+  return crsf_encode_vario(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_BARO_ALTITUDE
+static bool _decode_baro_altitude(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_baro_altitude(payload, length, out);
+}
+
+static uint8_t _encode_baro_altitude(const void *value, uint8_t *payload)
+{
+  return crsf_encode_baro_altitude(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_ATTITUDE
+static bool _decode_attitude(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_attitude(payload, length, out);
+}
+
+static uint8_t _encode_attitude(const void *value, uint8_t *payload)
+{
+  return crsf_encode_attitude(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_FLIGHT_MODE
+static bool _decode_flight_mode(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_flight_mode(payload, length, out);
+}
+
+static uint8_t _encode_flight_mode(const void *value, uint8_t *payload)
+{
+  return crsf_encode_flight_mode(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_RC_CHANNELS_SUBSET
+static bool _decode_rc_channels_subset(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_rc_channels_subset(payload, length, out);
+}
+
+static uint8_t _encode_rc_channels_subset(const void *value, uint8_t *payload)
+{
+  return crsf_encode_rc_channels_subset(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_DEVICE_PING
+static bool _decode_device_ping(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_device_ping(payload, length, out);
+}
+
+static uint8_t _encode_device_ping(const void *value, uint8_t *payload)
+{
+  return crsf_encode_device_ping(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_DEVICE_INFO
+static bool _decode_device_info(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_device_info(payload, length, out);
+}
+
+static uint8_t _encode_device_info(const void *value, uint8_t *payload)
+{
+  return crsf_encode_device_info(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_PARAMETER_SETTINGS_ENTRY
+static bool _decode_parameter_settings_entry(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_parameter_settings_entry(payload, length, out);
+}
+
+static uint8_t _encode_parameter_settings_entry(const void *value, uint8_t *payload)
+{
+  return crsf_encode_parameter_settings_entry(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_PARAMETER_READ
+static bool _decode_parameter_read(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_parameter_read(payload, length, out);
+}
+
+static uint8_t _encode_parameter_read(const void *value, uint8_t *payload)
+{
+  return crsf_encode_parameter_read(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_PARAMETER_WRITE
+static bool _decode_parameter_write(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_parameter_write(payload, length, out);
+}
+
+static uint8_t _encode_parameter_write(const void *value, uint8_t *payload)
+{
+  return crsf_encode_parameter_write(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_COMMAND
+static bool _decode_command(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_command(payload, length, out);
+}
+
+static uint8_t _encode_command(const void *value, uint8_t *payload)
+{
+  return crsf_encode_command(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_RADIO_ID
+static bool _decode_radio_id(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_radio_id(payload, length, out);
+}
+
+static uint8_t _encode_radio_id(const void *value, uint8_t *payload)
+{
+  return crsf_encode_radio_id(value, payload);
+}
+#endif
+
+#if CRSF_FRAME_CUSTOM_PAYLOAD
+static bool _decode_custom(const uint8_t *payload, uint8_t length, void *out)
+{
+  return crsf_decode_custom(payload, length, out);
+}
+
+static uint8_t _encode_custom(const void *value, uint8_t *payload)
+{
+  return crsf_encode_custom(value, payload);
+}
+#endif
+
+const crsf_frame_codec_t crsf_frame_codecs[CRSF_FRAME_CODECS] = {
+#if CRSF_FRAME_RC_CHANNELS_PACKED
+    [CRSF_FRAMETYPE_RC_CHANNELS_PACKED] = {CRSF_RC_CHANNELS_PACKED_PAYLOAD_SIZE, _decode_rc_channels_packed, _encode_rc_channels_packed},
+#endif
+#if CRSF_FRAME_BATTERY_SENSOR
+    [CRSF_FRAMETYPE_BATTERY_SENSOR] = {CRSF_BATTERY_SENSOR_PAYLOAD_SIZE, _decode_battery_sensor, _encode_battery_sensor},
+#endif
+#if CRSF_FRAME_LINK_STATISTICS
+    [CRSF_FRAMETYPE_LINK_STATISTICS] = {CRSF_LINK_STATISTICS_PAYLOAD_SIZE, _decode_link_statistics, _encode_link_statistics},
+#endif
+#if CRSF_FRAME_GPS
+    [CRSF_FRAMETYPE_GPS] = {CRSF_GPS_PAYLOAD_SIZE, _decode_gps, _encode_gps},
+#endif
+#if CRSF_FRAME_VARIO
+    [CRSF_FRAMETYPE_VARIO] = {CRSF_VARIO_PAYLOAD_SIZE, _decode_vario, _encode_vario},
+#endif
+#if CRSF_FRAME_BARO_ALTITUDE
+    [CRSF_FRAMETYPE_BARO_ALTITUDE] = {CRSF_BARO_ALTITUDE_PAYLOAD_SIZE, _decode_baro_altitude, _encode_baro_altitude},
+#endif
+#if CRSF_FRAME_ATTITUDE
+    [CRSF_FRAMETYPE_ATTITUDE] = {CRSF_ATTITUDE_PAYLOAD_SIZE, _decode_attitude, _encode_attitude},
+#endif
+#if CRSF_FRAME_FLIGHT_MODE
+    [CRSF_FRAMETYPE_FLIGHT_MODE] = {CRSF_FLIGHT_MODE_PAYLOAD_SIZE, _decode_flight_mode, _encode_flight_mode},
+#endif
+#if CRSF_FRAME_RC_CHANNELS_SUBSET
+    [CRSF_FRAMETYPE_RC_CHANNELS_SUBSET] = {CRSF_RC_CHANNELS_SUBSET_PAYLOAD_SIZE, _decode_rc_channels_subset, _encode_rc_channels_subset},
+#endif
+#if CRSF_FRAME_DEVICE_PING
+    [CRSF_FRAMETYPE_DEVICE_PING] = {CRSF_DEVICE_PING_PAYLOAD_SIZE, _decode_device_ping, _encode_device_ping},
+#endif
+#if CRSF_FRAME_DEVICE_INFO
+    [CRSF_FRAMETYPE_DEVICE_INFO] = {CRSF_DEVICE_INFO_PAYLOAD_SIZE, _decode_device_info, _encode_device_info},
+#endif
+#if CRSF_FRAME_PARAMETER_SETTINGS_ENTRY
+    [CRSF_FRAMETYPE_PARAMETER_SETTINGS_ENTRY] = {CRSF_PARAMETER_SETTINGS_ENTRY_PAYLOAD_SIZE, _decode_parameter_settings_entry, _encode_parameter_settings_entry},
+#endif
+#if CRSF_FRAME_PARAMETER_READ
+    [CRSF_FRAMETYPE_PARAMETER_READ] = {CRSF_PARAMETER_READ_PAYLOAD_SIZE, _decode_parameter_read, _encode_parameter_read},
+#endif
+#if CRSF_FRAME_PARAMETER_WRITE
+    [CRSF_FRAMETYPE_PARAMETER_WRITE] = {CRSF_PARAMETER_WRITE_PAYLOAD_SIZE, _decode_parameter_write, _encode_parameter_write},
+#endif
+#if CRSF_FRAME_COMMAND
+    [CRSF_FRAMETYPE_COMMAND] = {CRSF_COMMAND_PAYLOAD_SIZE, _decode_command, _encode_command},
+#endif
+#if CRSF_FRAME_RADIO_ID
+    [CRSF_FRAMETYPE_RADIO_ID] = {CRSF_RADIO_ID_PAYLOAD_SIZE, _decode_radio_id, _encode_radio_id},
+#endif
+#if CRSF_FRAME_CUSTOM_PAYLOAD
+    [CRSF_FRAMETYPE_CUSTOM_PAYLOAD] = {CRSF_CUSTOM_PAYLOAD_SIZE, _decode_custom, _encode_custom},
+#endif
+};
@@ -0,0 +1,475 @@
+/**
+ * @file crsf_frames.h
+ * @author Britannio Jarrett
+ * @brief Payload structs and codecs for the CRSF frame types.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Generated by gen_frames.dart, do not edit.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "crsf_channels.h"
+#include "crsf_config.h"
+
+// Payload bytes in a frame of the largest size, [sync], [len], [type] and [crc8] excluded
+#define CRSF_MAX_PAYLOAD_SIZE (CRSF_MAX_FRAME_SIZE - 4)
+
+// Frame types whose codecs are built, see crsf_config.h
+#ifndef CRSF_FRAME_RC_CHANNELS_PACKED
+#define CRSF_FRAME_RC_CHANNELS_PACKED 1
+#endif
+#ifndef CRSF_FRAME_BATTERY_SENSOR
+#define CRSF_FRAME_BATTERY_SENSOR 1
+#endif
+#ifndef CRSF_FRAME_LINK_STATISTICS
+#define CRSF_FRAME_LINK_STATISTICS 1
+#endif
+#ifndef CRSF_FRAME_GPS
+#define CRSF_FRAME_GPS 1
+#endif
+#ifndef CRSF_FRAME_VARIO
+#define CRSF_FRAME_VARIO 1
+#endif
+#ifndef CRSF_FRAME_BARO_ALTITUDE
+#define CRSF_FRAME_BARO_ALTITUDE 1
+#endif
+#ifndef CRSF_FRAME_ATTITUDE
+#define CRSF_FRAME_ATTITUDE 1
+#endif
+#ifndef CRSF_FRAME_FLIGHT_MODE
+#define CRSF_FRAME_FLIGHT_MODE 1
+#endif
+#ifndef CRSF_FRAME_RC_CHANNELS_SUBSET
+#define CRSF_FRAME_RC_CHANNELS_SUBSET 1
+#endif
+#ifndef CRSF_FRAME_DEVICE_PING
+#define CRSF_FRAME_DEVICE_PING 1
+#endif
+#ifndef CRSF_FRAME_DEVICE_INFO
+#define CRSF_FRAME_DEVICE_INFO 1
+#endif
+#ifndef CRSF_FRAME_PARAMETER_SETTINGS_ENTRY
+#define CRSF_FRAME_PARAMETER_SETTINGS_ENTRY 1
+#endif
+#ifndef CRSF_FRAME_PARAMETER_READ
+#define CRSF_FRAME_PARAMETER_READ 1
+#endif
+#ifndef CRSF_FRAME_PARAMETER_WRITE
+#define CRSF_FRAME_PARAMETER_WRITE 1
+#endif
+#ifndef CRSF_FRAME_COMMAND
+#define CRSF_FRAME_COMMAND 1
+#endif
+#ifndef CRSF_FRAME_RADIO_ID
+#define CRSF_FRAME_RADIO_ID 1
+#endif
+#ifndef CRSF_FRAME_CUSTOM_PAYLOAD
+#define CRSF_FRAME_CUSTOM_PAYLOAD 1
+#endif
+
+#define CRSF_RC_CHANNELS_PACKED_PAYLOAD_SIZE 22
+// The values are CRSF channel values (0-1984). CRSF 172 represents 988us, CRSF 992 represents 1500us, and CRSF 1811 represents 2012us.
+typedef struct __attribute__((packed)) {
+	unsigned channel0 : 11;
+	unsigned channel1 : 11;
+	unsigned channel2 : 11;
+	unsigned channel3 : 11;
+	unsigned channel4 : 11;
+	unsigned channel5 : 11;
+	unsigned channel6 : 11;
+	unsigned channel7 : 11;
+	unsigned channel8 : 11;
+	unsigned channel9 : 11;
+	unsigned channel10 : 11;
+	unsigned channel11 : 11;
+	unsigned channel12 : 11;
+	unsigned channel13 : 11;
+	unsigned channel14 : 11;
+	unsigned channel15 : 11;
+} crsf_payload_rc_channels_packed_t;
+
+#define CRSF_BATTERY_SENSOR_PAYLOAD_SIZE 8
+typedef struct {
+	// voltage in dV (Big Endian)
+	uint16_t voltage;
+	// current in dA (Big Endian)
+	uint16_t current;
+	// used capacity in mAh
+	uint32_t capacity;
+	// estimated battery remaining in percent (%)
+	uint8_t percent;
+} crsf_payload_battery_sensor_t;
+
+#define CRSF_LINK_STATISTICS_PAYLOAD_SIZE 10
+typedef struct {
+	// Uplink RSSI Ant. 1 ( dBm * -1 )
+	uint8_t uplink_rssi_ant_1;
+	// Uplink RSSI Ant. 2 ( dBm * -1 )
+	uint8_t uplink_rssi_ant_2;
+	// Uplink Package success rate / Link quality ( % )
+	uint8_t uplink_package_success_rate;
+	// Uplink SNR ( dB, or dB*4 for TBS I believe )
+	int8_t uplink_snr;
+	// Diversity active antenna ( enum ant. 1 = 0, ant. 2 = 1 )
+	uint8_t diversity_active_antenna;
+	// RF Mode ( 500Hz, 250Hz etc, varies based on ELRS Band or TBS )
+	uint8_t rf_mode;
+	// Uplink TX Power ( enum 0mW = 0, 10mW, 25 mW, 100 mW, 500 mW, 1000 mW, 2000mW, 50mW )
+	uint8_t uplink_tx_power;
+	// Downlink RSSI ( dBm * -1 )
+	uint8_t downlink_rssi;
+	// Downlink package success rate / Link quality ( % )
+	uint8_t downlink_package_success_rate;
+	// Downlink SNR ( dB )
+	int8_t downlink_snr;
+} crsf_payload_link_statistics_t;
+
+#define CRSF_GPS_PAYLOAD_SIZE 15
+typedef struct {
+	// Latitude ( degree * 1e7 )
+	int32_t latitude;
+	// Longitude ( degree * 1e7 )
+	int32_t longitude;
+	// Groundspeed ( km/h * 10 )
+	uint16_t groundspeed;
+	// GPS heading ( degree * 100 )
+	uint16_t heading;
+	// Altitude ( metres + 1000 )
+	uint16_t altitude;
+	// Satellites in use
+	uint8_t satellites;
+} crsf_payload_gps_t;
+
+#define CRSF_VARIO_PAYLOAD_SIZE 2
+typedef struct {
+	// Vertical speed ( cm/s )
+	int16_t vertical_speed;
+} crsf_payload_vario_t;
+
+#define CRSF_BARO_ALTITUDE_PAYLOAD_SIZE 3
+typedef struct {
+	// Altitude ( decimetres + 10000, or metres when the MSB is set )
+	uint16_t altitude;
+	// Vertical speed ( logarithmically packed cm/s )
+	int8_t vertical_speed;
+} crsf_payload_baro_altitude_t;
+
+#define CRSF_ATTITUDE_PAYLOAD_SIZE 6
+typedef struct {
+	// Pitch ( rad * 10000 )
+	int16_t pitch;
+	// Roll ( rad * 10000 )
+	int16_t roll;
+	// Yaw ( rad * 10000 )
+	int16_t yaw;
+} crsf_payload_attitude_t;
+
+#define CRSF_FLIGHT_MODE_PAYLOAD_SIZE 1
+typedef struct {
+	// Flight mode name
+	char flight_mode[16];
+} crsf_payload_flight_mode_t;
+
+#define CRSF_RC_CHANNELS_SUBSET_PAYLOAD_SIZE 3
+typedef struct {
+	// First channel in the frame (0 - 15)
+	uint8_t start_channel;
+	// Bits per channel value (10 - 13)
+	uint8_t resolution;
+	// Number of channel values
+	uint8_t count;
+	// Channel values at the frame's resolution
+	uint16_t channels[CRSF_RC_CHANNELS];
+} crsf_payload_rc_channels_subset_t;
+
+#define CRSF_DEVICE_PING_PAYLOAD_SIZE 2
+typedef struct {
+	// Destination device address
+	uint8_t destination;
+	// Origin device address
+	uint8_t origin;
+} crsf_payload_device_ping_t;
+
+#define CRSF_DEVICE_INFO_PAYLOAD_SIZE 17
+typedef struct {
+	// Destination device address
+	uint8_t destination;
+	// Origin device address
+	uint8_t origin;
+	// Device name
+	char device_name[32];
+	// Serial number
+	uint32_t serial_number;
+	// Hardware ID
+	uint32_t hardware_id;
+	// Firmware ID
+	uint32_t firmware_id;
+	// Number of parameters
+	uint8_t parameter_count;
+	// Parameter protocol version
+	uint8_t parameter_version;
+} crsf_payload_device_info_t;
+
+#define CRSF_PARAMETER_SETTINGS_ENTRY_PAYLOAD_SIZE 4
+typedef struct {
+	// Destination device address
+	uint8_t destination;
+	// Origin device address
+	uint8_t origin;
+	// Parameter number
+	uint8_t field_index;
+	// Chunks still to come after this one
+	uint8_t chunks_remaining;
+	// Chunk of the parameter entry
+	uint8_t data[CRSF_MAX_PAYLOAD_SIZE - 4];
+	uint8_t length;
+} crsf_payload_parameter_settings_entry_t;
+
+#define CRSF_PARAMETER_READ_PAYLOAD_SIZE 4
+typedef struct {
+	// Destination device address
+	uint8_t destination;
+	// Origin device address
+	uint8_t origin;
+	// Parameter number
+	uint8_t field_index;
+	// Chunk number to send
+	uint8_t field_chunk;
+} crsf_payload_parameter_read_t;
+
+#define CRSF_PARAMETER_WRITE_PAYLOAD_SIZE 3
+typedef struct {
+	// Destination device address
+	uint8_t destination;
+	// Origin device address
+	uint8_t origin;
+	// Parameter number
+	uint8_t field_index;
+	// New value, encoded by parameter type
+	uint8_t value[CRSF_MAX_PAYLOAD_SIZE - 3];
+	uint8_t length;
+} crsf_payload_parameter_write_t;
+
+#define CRSF_COMMAND_PAYLOAD_SIZE 3
+// Checking the inner CRC is left to the command's handler
+typedef struct {
+	// Destination device address
+	uint8_t destination;
+	// Origin device address
+	uint8_t origin;
+	// Command ID
+	uint8_t command;
+	// Sub-command and arguments, then the command CRC8 (poly 0xBA)
+	uint8_t data[CRSF_MAX_PAYLOAD_SIZE - 3];
+	uint8_t length;
+} crsf_payload_command_t;
+
+#define CRSF_RADIO_ID_PAYLOAD_SIZE 11
+// Sent by TX modules (as OpenTX sync) so the handset can phase-lock its RC frames to the RF clock
+typedef struct {
+	// Destination device address
+	uint8_t destination;
+	// Origin device address
+	uint8_t origin;
+	// Sub-type, 0x10 for timing correction
+	uint8_t subtype;
+	// Frame interval the module runs at ( us * 10 )
+	uint32_t interval;
+	// How much earlier than wanted the last RC frame arrived ( us * 10 )
+	int32_t offset;
+} crsf_payload_radio_id_t;
+
+#define CRSF_CUSTOM_PAYLOAD_SIZE 0
+typedef struct {
+	uint8_t buffer[CRSF_MAX_PAYLOAD_SIZE];
+	uint8_t length;
+} crsf_payload_custom_t;
+
+typedef enum
+{
+	CRSF_FRAMETYPE_RC_CHANNELS_PACKED = 0x16,
+	CRSF_FRAMETYPE_BATTERY_SENSOR = 0x08,
+	CRSF_FRAMETYPE_LINK_STATISTICS = 0x14,
+	CRSF_FRAMETYPE_GPS = 0x02,
+	CRSF_FRAMETYPE_VARIO = 0x07,
+	CRSF_FRAMETYPE_BARO_ALTITUDE = 0x09,
+	CRSF_FRAMETYPE_ATTITUDE = 0x1E,
+	CRSF_FRAMETYPE_FLIGHT_MODE = 0x21,
+	CRSF_FRAMETYPE_RC_CHANNELS_SUBSET = 0x17,
+	CRSF_FRAMETYPE_DEVICE_PING = 0x28,
+	CRSF_FRAMETYPE_DEVICE_INFO = 0x29,
+	CRSF_FRAMETYPE_PARAMETER_SETTINGS_ENTRY = 0x2B,
+	CRSF_FRAMETYPE_PARAMETER_READ = 0x2C,
+	CRSF_FRAMETYPE_PARAMETER_WRITE = 0x2D,
+	CRSF_FRAMETYPE_COMMAND = 0x32,
+	CRSF_FRAMETYPE_RADIO_ID = 0x3A,
+	CRSF_FRAMETYPE_CUSTOM_PAYLOAD = 0x7F,
+
+} frame_type_t;
+
+// Any decoded payload, as handed to the frame callback
+typedef union
+{
+#if CRSF_FRAME_RC_CHANNELS_PACKED
+	crsf_payload_rc_channels_packed_t rc_channels_packed;
+#endif
+#if CRSF_FRAME_BATTERY_SENSOR
+	crsf_payload_battery_sensor_t battery_sensor;
+#endif
+#if CRSF_FRAME_LINK_STATISTICS
+	crsf_payload_link_statistics_t link_statistics;
+#endif
+#if CRSF_FRAME_GPS
+	crsf_payload_gps_t gps;
+#endif
+#if CRSF_FRAME_VARIO
+	crsf_payload_vario_t vario;
+#endif
+#if CRSF_FRAME_BARO_ALTITUDE
+	crsf_payload_baro_altitude_t baro_altitude;
+#endif
+#if CRSF_FRAME_ATTITUDE
+	crsf_payload_attitude_t attitude;
+#endif
+#if CRSF_FRAME_FLIGHT_MODE
+	crsf_payload_flight_mode_t flight_mode;
+#endif
+#if CRSF_FRAME_RC_CHANNELS_SUBSET
+	crsf_payload_rc_channels_subset_t rc_channels_subset;
+#endif
+#if CRSF_FRAME_DEVICE_PING
+	crsf_payload_device_ping_t device_ping;
+#endif
+#if CRSF_FRAME_DEVICE_INFO
+	crsf_payload_device_info_t device_info;
+#endif
+#if CRSF_FRAME_PARAMETER_SETTINGS_ENTRY
+	crsf_payload_parameter_settings_entry_t parameter_settings_entry;
+#endif
+#if CRSF_FRAME_PARAMETER_READ
+	crsf_payload_parameter_read_t parameter_read;
+#endif
+#if CRSF_FRAME_PARAMETER_WRITE
+	crsf_payload_parameter_write_t parameter_write;
+#endif
+#if CRSF_FRAME_COMMAND
+	crsf_payload_command_t command;
+#endif
+#if CRSF_FRAME_RADIO_ID
+	crsf_payload_radio_id_t radio_id;
+#endif
+#if CRSF_FRAME_CUSTOM_PAYLOAD
+	crsf_payload_custom_t custom;
+#endif
+} crsf_frame_payload_t;
+
+typedef bool (*crsf_frame_decoder_t)(const uint8_t *payload, uint8_t length, void *out);
+typedef uint8_t (*crsf_frame_encoder_t)(const void *value, uint8_t *payload);
+
+typedef struct
+{
+	// Payload bytes in the smallest valid frame
+	uint8_t min_length;
+	crsf_frame_decoder_t decode;
+	crsf_frame_encoder_t encode;
+} crsf_frame_codec_t;
+
+// crsf_frame_codecs is indexed by frame type; unknown types have no decoder
+#define CRSF_FRAME_CODECS 0x80
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    extern const crsf_frame_codec_t crsf_frame_codecs[CRSF_FRAME_CODECS];
+
+#if CRSF_FRAME_RC_CHANNELS_PACKED
+    bool crsf_decode_rc_channels_packed(const uint8_t *payload, uint8_t length, crsf_payload_rc_channels_packed_t *out);
+    uint8_t crsf_encode_rc_channels_packed(const crsf_payload_rc_channels_packed_t *value, uint8_t *payload);
+#endif
+#if CRSF_FRAME_BATTERY_SENSOR
+    bool crsf_decode_battery_sensor(const uint8_t *payload, uint8_t length, crsf_payload_battery_sensor_t *out);
+    uint8_t crsf_encode_battery_sensor(const crsf_payload_battery_sensor_t *value, uint8_t *payload);
+    bool crsf_patch_battery_sensor(uint8_t *payload, const crsf_payload_battery_sensor_t *value);
+#endif
+#if CRSF_FRAME_LINK_STATISTICS
+    bool crsf_decode_link_statistics(const uint8_t *payload, uint8_t length, crsf_payload_link_statistics_t *out);
+    uint8_t crsf_encode_link_statistics(const crsf_payload_link_statistics_t *value, uint8_t *payload);
+    bool crsf_patch_link_statistics(uint8_t *payload, const crsf_payload_link_statistics_t *value);
+#endif
+#if CRSF_FRAME_GPS
+    bool crsf_decode_gps(const uint8_t *payload, uint8_t length, crsf_payload_gps_t *out);
+    uint8_t crsf_encode_gps(const crsf_payload_gps_t *value, uint8_t *payload);
+    bool crsf_patch_gps(uint8_t *payload, const crsf_payload_gps_t *value);
+#endif
+#if CRSF_FRAME_VARIO
+    bool crsf_decode_vario(const uint8_t *payload, uint8_t length, crsf_payload_vario_t *out);
+    uint8_t crsf_encode_vario(const crsf_payload_vario_t *value, uint8_t *payload);
+    bool crsf_patch_vario(uint8_t *payload, const crsf_payload_vario_t *value);
+#endif
+#if CRSF_FRAME_BARO_ALTITUDE
+    bool crsf_decode_baro_altitude(const uint8_t *payload, uint8_t length, crsf_payload_baro_altitude_t *out);
+    uint8_t crsf_encode_baro_altitude(const crsf_payload_baro_altitude_t *value, uint8_t *payload);
+    bool crsf_patch_baro_altitude(uint8_t *payload, const crsf_payload_baro_altitude_t *value);
+#endif
+#if CRSF_FRAME_ATTITUDE
+    bool crsf_decode_attitude(const uint8_t *payload, uint8_t length, crsf_payload_attitude_t *out);
+    uint8_t crsf_encode_attitude(const crsf_payload_attitude_t *value, uint8_t *payload);
+    bool crsf_patch_attitude(uint8_t *payload, const crsf_payload_attitude_t *value);
+#endif
+#if CRSF_FRAME_FLIGHT_MODE
+    bool crsf_decode_flight_mode(const uint8_t *payload, uint8_t length, crsf_payload_flight_mode_t *out);
+    uint8_t crsf_encode_flight_mode(const crsf_payload_flight_mode_t *value, uint8_t *payload);
+#endif
+#if CRSF_FRAME_RC_CHANNELS_SUBSET
+    bool crsf_decode_rc_channels_subset(const uint8_t *payload, uint8_t length, crsf_payload_rc_channels_subset_t *out);
+    uint8_t crsf_encode_rc_channels_subset(const crsf_payload_rc_channels_subset_t *value, uint8_t *payload);
+#endif
+#if CRSF_FRAME_DEVICE_PING
+    bool crsf_decode_device_ping(const uint8_t *payload, uint8_t length, crsf_payload_device_ping_t *out);
+    uint8_t crsf_encode_device_ping(const crsf_payload_device_ping_t *value, uint8_t *payload);
+    bool crsf_patch_device_ping(uint8_t *payload, const crsf_payload_device_ping_t *value);
+#endif
+#if CRSF_FRAME_DEVICE_INFO
+    bool crsf_decode_device_info(const uint8_t *payload, uint8_t length, crsf_payload_device_info_t *out);
+    uint8_t crsf_encode_device_info(const crsf_payload_device_info_t *value, uint8_t *payload);
+#endif
+#if CRSF_FRAME_PARAMETER_SETTINGS_ENTRY
+    bool crsf_decode_parameter_settings_entry(const uint8_t *payload, uint8_t length, crsf_payload_parameter_settings_entry_t *out);
+    uint8_t crsf_encode_parameter_settings_entry(const crsf_payload_parameter_settings_entry_t *value, uint8_t *payload);
+#endif
+#if CRSF_FRAME_PARAMETER_READ
+    bool crsf_decode_parameter_read(const uint8_t *payload, uint8_t length, crsf_payload_parameter_read_t *out);
+    uint8_t crsf_encode_parameter_read(const crsf_payload_parameter_read_t *value, uint8_t *payload);
+    bool crsf_patch_parameter_read(uint8_t *payload, const crsf_payload_parameter_read_t *value);
+#endif
+#if CRSF_FRAME_PARAMETER_WRITE
+    bool crsf_decode_parameter_write(const uint8_t *payload, uint8_t length, crsf_payload_parameter_write_t *out);
+    uint8_t crsf_encode_parameter_write(const crsf_payload_parameter_write_t *value, uint8_t *payload);
+#endif
+#if CRSF_FRAME_COMMAND
+    bool crsf_decode_command(const uint8_t *payload, uint8_t length, crsf_payload_command_t *out);
+    uint8_t crsf_encode_command(const crsf_payload_command_t *value, uint8_t *payload);
+#endif
+#if CRSF_FRAME_RADIO_ID
+    bool crsf_decode_radio_id(const uint8_t *payload, uint8_t length, crsf_payload_radio_id_t *out);
+    uint8_t crsf_encode_radio_id(const crsf_payload_radio_id_t *value, uint8_t *payload);
+    bool crsf_patch_radio_id(uint8_t *payload, const crsf_payload_radio_id_t *value);
+#endif
+#if CRSF_FRAME_CUSTOM_PAYLOAD
+    bool crsf_decode_custom(const uint8_t *payload, uint8_t length, crsf_payload_custom_t *out);
+    uint8_t crsf_encode_custom(const crsf_payload_custom_t *value, uint8_t *payload);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
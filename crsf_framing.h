@@ -0,0 +1,211 @@
+/**
+ * @file crsf_framing.h
+ * @author Britannio Jarrett
+ * @brief Splits a CRSF byte stream into CRC-checked frames.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * The framing shared by crsf_ctx_parse() and crsf::parser<>, and usable on its
+ * own with the crsf_decode_*() functions. A caller finds a sync byte with
+ * crsf_find_sync_byte(), feeds the bytes from there with crsf_framer_fill() and
+ * then calls crsf_framer_check() and crsf_framer_realign() until the check
+ * returns CRSF_FRAMER_INCOMPLETE:
+ *
+ *     while (len > 0)
+ *     {
+ *         if (framer.length == 0)
+ *         {
+ *             const uint8_t *sync = crsf_find_sync_byte(data, len, address);
+ *             if (sync == NULL)
+ *             {
+ *                 break;
+ *             }
+ *             len -= sync - data;
+ *             data = sync;
+ *         }
+ *         const size_t count = crsf_framer_fill(&framer, data, len);
+ *         data += count;
+ *         len -= count;
+ *         crsf_framer_status_t status;
+ *         while ((status = crsf_framer_check(&framer)) != CRSF_FRAMER_INCOMPLETE)
+ *         {
+ *             // framer.frame holds a whole frame if status is CRSF_FRAMER_VALID
+ *             crsf_framer_realign(&framer, status, address);
+ *         }
+ *     }
+ *
+ * Everything is inline so each parser keeps its own callbacks and counters
+ * around it without a call per frame.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "crsf_config.h"
+#include "crsf_crc.h"
+
+// Frame length byte covers [type] [payload] [crc8]
+#define CRSF_MIN_FRAME_LENGTH 2
+#define CRSF_MAX_FRAME_LENGTH (CRSF_MAX_FRAME_SIZE - 2)
+#define CRSF_SYNC_BYTE 0xC8
+// "OpenTX/EdgeTX sends the channels packet starting with 0xEE instead of
+// 0xC8, this has been incorrect since the first CRSF implementation."
+#define CRSF_SYNC_BYTE_EDGETX 0xEE
+
+typedef struct
+{
+	// Bytes of the frame being received, from its sync byte
+	uint8_t frame[CRSF_MAX_FRAME_SIZE];
+	uint8_t length;
+	// Running CRC of the [type] [payload] bytes buffered so far
+	uint8_t crc;
+} crsf_framer_t;
+
+typedef enum
+{
+	// The buffered bytes are the valid prefix of a frame, or nothing
+	CRSF_FRAMER_INCOMPLETE,
+	CRSF_FRAMER_VALID,
+	CRSF_FRAMER_BAD_LENGTH,
+	CRSF_FRAMER_BAD_CRC,
+} crsf_framer_status_t;
+
+static inline void crsf_framer_reset(crsf_framer_t *framer)
+{
+	framer->length = 0;
+	framer->crc = 0;
+}
+
+/**
+ * Frames start with the destination's address: the usual sync bytes and
+ * `address` are accepted.
+ */
+static inline bool crsf_is_sync_byte(uint8_t byte, uint8_t address)
+{
+	return byte == CRSF_SYNC_BYTE || byte == CRSF_SYNC_BYTE_EDGETX || byte == address;
+}
+
+/**
+ * Returns a pointer to the first sync byte in `data`, or NULL if there is none.
+ *
+ * Four bytes are tested at a time with the "has zero byte" trick so runs of
+ * garbage between frames are skipped quickly.
+ */
+static inline const uint8_t *crsf_find_sync_byte(const uint8_t *data, size_t len, uint8_t address)
+{
+	const uint8_t *p = data;
+	const uint8_t *end = data + len;
+	const uint32_t own = address * 0x01010101u;
+	while (end - p >= 4)
+	{
+		uint32_t word;
+		memcpy(&word, p, sizeof(word));
+		const uint32_t a = word ^ 0xC8C8C8C8u;
+		const uint32_t b = word ^ 0xEEEEEEEEu;
+		const uint32_t c = word ^ own;
+		if (((a - 0x01010101u) & ~a & 0x80808080u) | ((b - 0x01010101u) & ~b & 0x80808080u) |
+			((c - 0x01010101u) & ~c & 0x80808080u))
+		{
+			break;
+		}
+		p += 4;
+	}
+	for (; p < end; p++)
+	{
+		if (crsf_is_sync_byte(*p, address))
+		{
+			return p;
+		}
+	}
+	return NULL;
+}
+
+// Folds frame[from, to) into the running CRC, limited to the [type] [payload] bytes
+static inline void _crsf_framer_update_crc(crsf_framer_t *framer, size_t from, size_t to)
+{
+	// The CRC byte sits at frameLength + 1
+	const size_t crcIndex = (size_t)framer->frame[1] + 1;
+	if (from < 2)
+	{
+		from = 2;
+	}
+	if (to > crcIndex)
+	{
+		to = crcIndex;
+	}
+	if (to > from)
+	{
+		framer->crc = crsf_crc8_update_buf(framer->crc, framer->frame + from, to - from);
+	}
+}
+
+/**
+ * Copies the header first, then everything up to and including the CRC, and
+ * folds the new bytes into the running CRC. An empty framer must be given a
+ * sync byte first.
+ *
+ * @return The number of bytes taken from `data`.
+ */
+static inline size_t crsf_framer_fill(crsf_framer_t *framer, const uint8_t *data, size_t len)
+{
+	const size_t wanted = framer->length < 2 ? 2 : (size_t)framer->frame[1] + 2;
+	size_t count = wanted - framer->length;
+	if (count > len)
+	{
+		count = len;
+	}
+	memcpy(framer->frame + framer->length, data, count);
+	_crsf_framer_update_crc(framer, framer->length, framer->length + count);
+	framer->length += count;
+	return count;
+}
+
+/**
+ * Checks the buffered frame. Complete frames are validated against the CRC
+ * accumulated while their bytes were copied in, so the check itself is a single compare.
+ */
+static inline crsf_framer_status_t crsf_framer_check(const crsf_framer_t *framer)
+{
+	if (framer->length < 2)
+	{
+		return CRSF_FRAMER_INCOMPLETE;
+	}
+	const uint8_t frameLength = framer->frame[1];
+	if (frameLength < CRSF_MIN_FRAME_LENGTH || frameLength > CRSF_MAX_FRAME_LENGTH)
+	{
+		return CRSF_FRAMER_BAD_LENGTH;
+	}
+	if (framer->length < frameLength + 2)
+	{
+		return CRSF_FRAMER_INCOMPLETE;
+	}
+	return framer->crc == framer->frame[frameLength + 1] ? CRSF_FRAMER_VALID : CRSF_FRAMER_BAD_CRC;
+}
+
+/**
+ * Drops the frame just checked and realigns on the next sync byte that is
+ * already buffered. After a bad length or a CRC failure only the sync byte is
+ * dropped, so a frame hidden behind a corrupt one is not lost.
+ *
+ * @param status What crsf_framer_check() returned, other than CRSF_FRAMER_INCOMPLETE.
+ * @return The number of bytes dropped, the valid frame included.
+ */
+static inline size_t crsf_framer_realign(crsf_framer_t *framer, crsf_framer_status_t status, uint8_t address)
+{
+	const size_t consumed = status == CRSF_FRAMER_VALID ? (size_t)framer->frame[1] + 2 : 1;
+	const uint8_t *next = crsf_find_sync_byte(framer->frame + consumed, framer->length - consumed, address);
+	const size_t drop = next != NULL ? (size_t)(next - framer->frame) : framer->length;
+	memmove(framer->frame, framer->frame + drop, framer->length - drop);
+	framer->length -= drop;
+	// Only reached after a valid frame (buffer usually empty) or on the error path
+	framer->crc = 0;
+	_crsf_framer_update_crc(framer, 0, framer->length);
+	return drop;
+}
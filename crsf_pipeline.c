@@ -0,0 +1,306 @@
+/**
+ * @file crsf_pipeline.c
+ * @author Britannio Jarrett
+ * @brief Runs a CRSF instance on a second core and hands decoded frames back through lock-free queues.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+
+#include "crsf_pipeline.h"
+#include <string.h>
+
+#if CRSF_HOST
+#include <sched.h>
+#else
+#include "pico/multicore.h"
+#endif
+
+// Built on the instance callbacks, see CRSF_CALLBACKS in crsf_config.h
+#if CRSF_CALLBACKS
+
+static uint64_t _now_us(const crsf_t *crsf)
+{
+  return crsf->transport != NULL ? crsf->transport->time_us(crsf->transport->ctx) : 0;
+}
+
+// Worker side: returns the next free event slot, or NULL when the queue is full
+static crsf_event_t *_event_claim(crsf_pipeline_t *pipeline)
+{
+  const uint32_t head = pipeline->events_head;
+  const uint32_t tail = __atomic_load_n(&pipeline->events_tail, __ATOMIC_ACQUIRE);
+  if (head - tail >= CRSF_EVENT_QUEUE_SIZE)
+  {
+    __atomic_store_n(&pipeline->events_dropped, pipeline->events_dropped + 1, __ATOMIC_RELAXED);
+    return NULL;
+  }
+  return &pipeline->events[head & (CRSF_EVENT_QUEUE_SIZE - 1)];
+}
+
+static void _event_publish(crsf_pipeline_t *pipeline)
+{
+  // Publish the slot before the new head
+  __atomic_store_n(&pipeline->events_head, pipeline->events_head + 1, __ATOMIC_RELEASE);
+}
+
+void _pipeline_on_rc_channels(crsf_t *crsf, const uint16_t channels[16])
+{
+  crsf_pipeline_t *pipeline = crsf->user_data;
+  crsf_event_t *event = _event_claim(pipeline);
+  if (event != NULL)
+  {
+    event->type = CRSF_EVENT_RC_CHANNELS;
+    event->timestamp_us = _now_us(crsf);
+    memcpy(event->channels, channels, sizeof(event->channels));
+    _event_publish(pipeline);
+  }
+}
+
+void _pipeline_on_link_statistics(crsf_t *crsf, const link_statistics_t link_stats)
+{
+  crsf_pipeline_t *pipeline = crsf->user_data;
+  crsf_event_t *event = _event_claim(pipeline);
+  if (event != NULL)
+  {
+    event->type = CRSF_EVENT_LINK_STATISTICS;
+    event->timestamp_us = _now_us(crsf);
+    event->link_statistics = link_stats;
+    _event_publish(pipeline);
+  }
+}
+
+void _pipeline_on_failsafe(crsf_t *crsf, const bool failsafe)
+{
+  crsf_pipeline_t *pipeline = crsf->user_data;
+  crsf_event_t *event = _event_claim(pipeline);
+  if (event != NULL)
+  {
+    event->type = CRSF_EVENT_FAILSAFE;
+    event->timestamp_us = _now_us(crsf);
+    event->failsafe = failsafe;
+    _event_publish(pipeline);
+  }
+}
+
+/**
+ * Prepares a pipeline around an initialized instance.
+ *
+ * The pipeline takes over the instance's callbacks and `user_data`. From here
+ * on only the worker may touch `crsf`; the application uses crsf_pipeline_pop()
+ * and the crsf_pipeline_telem_* functions instead.
+ *
+ * @param pipeline The pipeline to initialize.
+ * @param crsf An instance set up with crsf_init(), with its transport attached.
+ */
+void crsf_pipeline_init(crsf_pipeline_t *pipeline, crsf_t *crsf)
+{
+  memset(pipeline, 0, sizeof(*pipeline));
+  pipeline->crsf = crsf;
+  crsf->user_data = pipeline;
+  crsf_ctx_set_on_rc_channels(crsf, _pipeline_on_rc_channels);
+  crsf_ctx_set_on_link_statistics(crsf, _pipeline_on_link_statistics);
+  crsf_ctx_set_on_failsafe(crsf, _pipeline_on_failsafe);
+}
+
+// Applies the telemetry updates queued by the application
+static void _apply_telem_updates(crsf_pipeline_t *pipeline)
+{
+  uint32_t tail = pipeline->telem_tail;
+  const uint32_t head = __atomic_load_n(&pipeline->telem_head, __ATOMIC_ACQUIRE);
+  for (; tail != head; tail++)
+  {
+    const crsf_telem_update_t *update = &pipeline->telem[tail & (CRSF_TELEM_QUEUE_SIZE - 1)];
+    switch (update->index)
+    {
+    case CRSF_BATTERY_INDEX:
+      crsf_ctx_telem_set_battery_data(pipeline->crsf, update->battery_sensor.voltage, update->battery_sensor.current,
+                                      update->battery_sensor.capacity, update->battery_sensor.percent);
+      break;
+    case CRSF_CUSTOM_PAYLOAD_INDEX:
+      crsf_ctx_telem_set_custom_payload(pipeline->crsf, update->custom.buffer, update->custom.length);
+      break;
+    }
+  }
+  // Release the slots only after they have been read
+  __atomic_store_n(&pipeline->telem_tail, tail, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Runs one iteration of the worker.
+ *
+ * Applies pending telemetry updates, then parses whatever the transport has
+ * received and sends a telemetry frame. crsf_pipeline_start() calls this in a
+ * loop; call it yourself to run the worker on a thread or task of your own.
+ */
+void crsf_pipeline_service(crsf_pipeline_t *pipeline)
+{
+  _apply_telem_updates(pipeline);
+  crsf_ctx_process_frames(pipeline->crsf);
+}
+
+static void _run_worker(crsf_pipeline_t *pipeline)
+{
+  while (__atomic_load_n(&pipeline->running, __ATOMIC_ACQUIRE))
+  {
+    crsf_pipeline_service(pipeline);
+#if CRSF_HOST
+    sched_yield();
+#else
+    tight_loop_contents();
+#endif
+  }
+}
+
+#if CRSF_HOST
+static void *_worker_thread(void *arg)
+{
+  _run_worker(arg);
+  return NULL;
+}
+#else
+// multicore_launch_core1() takes no argument, so only one pipeline can run at a time
+crsf_pipeline_t *_core1_pipeline = NULL;
+
+static void _core1_entry(void)
+{
+  _run_worker(_core1_pipeline);
+}
+#endif
+
+/**
+ * @brief Starts the worker on core 1 (a new thread on the host).
+ *
+ * On the RP2040 core 1 must be otherwise unused. Prefer crsf_pico_uart_init()
+ * without the IRQ option for the transport: core 1 polls the UART anyway, and
+ * an IRQ would be serviced by the core that installed it.
+ *
+ * @return false if the worker could not be started.
+ */
+bool crsf_pipeline_start(crsf_pipeline_t *pipeline)
+{
+  __atomic_store_n(&pipeline->running, 1, __ATOMIC_RELEASE);
+#if CRSF_HOST
+  if (pthread_create(&pipeline->thread, NULL, _worker_thread, pipeline) != 0)
+  {
+    pipeline->running = 0;
+    return false;
+  }
+#else
+  if (_core1_pipeline != NULL)
+  {
+    pipeline->running = 0;
+    return false;
+  }
+  _core1_pipeline = pipeline;
+  multicore_launch_core1(_core1_entry);
+#endif
+  return true;
+}
+
+/**
+ * Stops the worker. The instance may be used directly again afterwards.
+ */
+void crsf_pipeline_stop(crsf_pipeline_t *pipeline)
+{
+  if (!__atomic_exchange_n(&pipeline->running, 0, __ATOMIC_ACQ_REL))
+  {
+    return;
+  }
+#if CRSF_HOST
+  pthread_join(pipeline->thread, NULL);
+#else
+  multicore_reset_core1();
+  _core1_pipeline = NULL;
+#endif
+}
+
+/**
+ * Application side: takes the oldest decoded event.
+ *
+ * @return false if no event is queued.
+ */
+bool crsf_pipeline_pop(crsf_pipeline_t *pipeline, crsf_event_t *event)
+{
+  const uint32_t tail = pipeline->events_tail;
+  const uint32_t head = __atomic_load_n(&pipeline->events_head, __ATOMIC_ACQUIRE);
+  if (head == tail)
+  {
+    return false;
+  }
+  *event = pipeline->events[tail & (CRSF_EVENT_QUEUE_SIZE - 1)];
+  __atomic_store_n(&pipeline->events_tail, tail + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+// Application side: returns the next free telemetry slot, or NULL when the queue is full
+static crsf_telem_update_t *_telem_claim(crsf_pipeline_t *pipeline)
+{
+  const uint32_t head = pipeline->telem_head;
+  const uint32_t tail = __atomic_load_n(&pipeline->telem_tail, __ATOMIC_ACQUIRE);
+  if (head - tail >= CRSF_TELEM_QUEUE_SIZE)
+  {
+    return NULL;
+  }
+  return &pipeline->telem[head & (CRSF_TELEM_QUEUE_SIZE - 1)];
+}
+
+static void _telem_publish(crsf_pipeline_t *pipeline)
+{
+  __atomic_store_n(&pipeline->telem_head, pipeline->telem_head + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Queues new battery telemetry for the worker. Arguments as crsf_telem_set_battery_data().
+ *
+ * @return false if the queue was full and the update was dropped.
+ */
+bool crsf_pipeline_telem_set_battery_data(crsf_pipeline_t *pipeline, uint16_t voltage, uint16_t current, uint32_t capacity, uint8_t percent)
+{
+  crsf_telem_update_t *update = _telem_claim(pipeline);
+  if (update == NULL)
+  {
+    return false;
+  }
+  update->index = CRSF_BATTERY_INDEX;
+  update->battery_sensor.voltage = voltage;
+  update->battery_sensor.current = current;
+  update->battery_sensor.capacity = capacity;
+  update->battery_sensor.percent = percent;
+  _telem_publish(pipeline);
+  return true;
+}
+
+/**
+ * Queues a new custom telemetry payload for the worker. Payloads over 60 bytes are rejected.
+ *
+ * @return false if the payload was too long or the queue was full.
+ */
+bool crsf_pipeline_telem_set_custom_payload(crsf_pipeline_t *pipeline, const uint8_t *data, uint8_t length)
+{
+  crsf_telem_update_t *update = _telem_claim(pipeline);
+  if (update == NULL || length > sizeof(update->custom.buffer))
+  {
+    return false;
+  }
+  update->index = CRSF_CUSTOM_PAYLOAD_INDEX;
+  memcpy(update->custom.buffer, data, length);
+  update->custom.length = length;
+  _telem_publish(pipeline);
+  return true;
+}
+
+/**
+ * Returns the number of events lost because crsf_pipeline_pop() was not called often enough.
+ */
+uint32_t crsf_pipeline_events_dropped(const crsf_pipeline_t *pipeline)
+{
+  return __atomic_load_n(&pipeline->events_dropped, __ATOMIC_RELAXED);
+}
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * @file crsf_pipeline.h
+ * @author Britannio Jarrett
+ * @brief Runs a CRSF instance on a second core and hands decoded frames back through lock-free queues.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * The worker (core 1 on the RP2040, a pthread on the host) parses frames and
+ * sends telemetry. Decoded RC channels, link statistics and failsafe changes
+ * are queued as events for the application core, and telemetry updates travel
+ * the other way, so neither side ever touches the crsf_t the other one owns.
+ * Both queues are single-producer/single-consumer rings of fixed slots, like
+ * crsf_ring.h, and never allocate.
+ */
+#pragma once
+#include "crsf.h"
+
+#if CRSF_HOST
+#include <pthread.h>
+#endif
+
+#ifndef CRSF_EVENT_QUEUE_SIZE
+// Must be a power of two. 16 events is 16 ms of RC frames at 1 kHz.
+#define CRSF_EVENT_QUEUE_SIZE 16
+#endif
+
+#ifndef CRSF_TELEM_QUEUE_SIZE
+// Must be a power of two
+#define CRSF_TELEM_QUEUE_SIZE 8
+#endif
+
+#if (CRSF_EVENT_QUEUE_SIZE & (CRSF_EVENT_QUEUE_SIZE - 1)) != 0
+#error "CRSF_EVENT_QUEUE_SIZE must be a power of two"
+#endif
+#if (CRSF_TELEM_QUEUE_SIZE & (CRSF_TELEM_QUEUE_SIZE - 1)) != 0
+#error "CRSF_TELEM_QUEUE_SIZE must be a power of two"
+#endif
+
+typedef enum
+{
+	CRSF_EVENT_RC_CHANNELS,
+	CRSF_EVENT_LINK_STATISTICS,
+	CRSF_EVENT_FAILSAFE,
+} crsf_event_type_t;
+
+typedef struct
+{
+	crsf_event_type_t type;
+	// Transport time at which the frame was decoded, 0 without a transport
+	uint64_t timestamp_us;
+	union
+	{
+		uint16_t channels[CRSF_RC_CHANNELS];
+		link_statistics_t link_statistics;
+		bool failsafe;
+	};
+} crsf_event_t;
+
+typedef struct
+{
+	// CRSF_BATTERY_INDEX or CRSF_CUSTOM_PAYLOAD_INDEX
+	uint8_t index;
+	union
+	{
+		crsf_payload_battery_sensor_t battery_sensor;
+		crsf_payload_custom_t custom;
+	};
+} crsf_telem_update_t;
+
+typedef struct
+{
+	crsf_t *crsf;
+
+	// Worker -> application
+	crsf_event_t events[CRSF_EVENT_QUEUE_SIZE];
+	uint32_t events_head;
+	uint32_t events_tail;
+	// Events lost because the application fell behind (written by the worker only)
+	uint32_t events_dropped;
+
+	// Application -> worker
+	crsf_telem_update_t telem[CRSF_TELEM_QUEUE_SIZE];
+	uint32_t telem_head;
+	uint32_t telem_tail;
+
+	uint32_t running;
+#if CRSF_HOST
+	pthread_t thread;
+#endif
+} crsf_pipeline_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    void crsf_pipeline_init(crsf_pipeline_t *pipeline, crsf_t *crsf);
+    bool crsf_pipeline_start(crsf_pipeline_t *pipeline);
+    void crsf_pipeline_stop(crsf_pipeline_t *pipeline);
+    void crsf_pipeline_service(crsf_pipeline_t *pipeline);
+    bool crsf_pipeline_pop(crsf_pipeline_t *pipeline, crsf_event_t *event);
+    bool crsf_pipeline_telem_set_battery_data(crsf_pipeline_t *pipeline, uint16_t voltage, uint16_t current, uint32_t capacity, uint8_t percent);
+    bool crsf_pipeline_telem_set_custom_payload(crsf_pipeline_t *pipeline, const uint8_t *data, uint8_t length);
+    uint32_t crsf_pipeline_events_dropped(const crsf_pipeline_t *pipeline);
+
+#ifdef __cplusplus
+}
+#endif
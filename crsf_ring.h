@@ -0,0 +1,111 @@
+/**
+ * @file crsf_ring.h
+ * @author Britannio Jarrett
+ * @brief Lock-free single-producer/single-consumer byte ring buffer.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * The producer (a UART IRQ, a DMA completion handler or a simulated ISR thread
+ * on the host) only writes `head`, the consumer (the parser) only writes
+ * `tail`. The indices are free-running and wrap naturally, so the ring holds
+ * exactly CRSF_RX_RING_SIZE bytes. Nothing here depends on the Pico SDK.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef CRSF_RX_RING_SIZE
+// Must be a power of two. 256 bytes is ~6 ms of back-to-back frames at 420 kbaud but
+// under 0.5 ms at 5.25 Mbaud, so raise it if crsf_process_frames() runs less often.
+#define CRSF_RX_RING_SIZE 256
+#endif
+
+#if (CRSF_RX_RING_SIZE & (CRSF_RX_RING_SIZE - 1)) != 0
+#error "CRSF_RX_RING_SIZE must be a power of two"
+#endif
+
+typedef struct
+{
+	uint8_t data[CRSF_RX_RING_SIZE];
+	// Written by the producer only
+	uint32_t head;
+	// Written by the consumer only
+	uint32_t tail;
+	// Bytes dropped because the ring was full (written by the producer only)
+	uint32_t overruns;
+} crsf_ring_t;
+
+static inline void crsf_ring_init(crsf_ring_t *ring)
+{
+	ring->head = 0;
+	ring->tail = 0;
+	ring->overruns = 0;
+}
+
+/**
+ * Number of bytes queued. Safe to call from either side.
+ */
+static inline size_t crsf_ring_count(const crsf_ring_t *ring)
+{
+	const uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	const uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	return head - tail;
+}
+
+/**
+ * Producer side: queue a single byte.
+ *
+ * @return false if the ring was full and the byte was dropped.
+ */
+static inline bool crsf_ring_push(crsf_ring_t *ring, uint8_t byte)
+{
+	const uint32_t head = ring->head;
+	const uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	if (head - tail >= CRSF_RX_RING_SIZE)
+	{
+		__atomic_store_n(&ring->overruns, ring->overruns + 1, __ATOMIC_RELAXED);
+		return false;
+	}
+	ring->data[head & (CRSF_RX_RING_SIZE - 1)] = byte;
+	// Publish the byte before the new head
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+/**
+ * Consumer side: copy up to `max` queued bytes into `out`.
+ *
+ * The copy is done in at most two memcpy calls (before and after the wrap).
+ *
+ * @return The number of bytes copied.
+ */
+static inline size_t crsf_ring_pop(crsf_ring_t *ring, uint8_t *out, size_t max)
+{
+	const uint32_t tail = ring->tail;
+	const uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	size_t count = head - tail;
+	if (count > max)
+	{
+		count = max;
+	}
+	const size_t start = tail & (CRSF_RX_RING_SIZE - 1);
+	const size_t first = (count < CRSF_RX_RING_SIZE - start) ? count : CRSF_RX_RING_SIZE - start;
+	memcpy(out, &ring->data[start], first);
+	memcpy(out + first, &ring->data[0], count - first);
+	// Release the slots only after the bytes have been copied out
+	__atomic_store_n(&ring->tail, tail + (uint32_t)count, __ATOMIC_RELEASE);
+	return count;
+}
+
+static inline uint32_t crsf_ring_overruns(const crsf_ring_t *ring)
+{
+	return __atomic_load_n(&ring->overruns, __ATOMIC_RELAXED);
+}
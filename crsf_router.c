@@ -0,0 +1,376 @@
+/**
+ * @file crsf_router.c
+ * @author Britannio Jarrett
+ * @brief Cut-through forwarding between a receiver and a flight controller, with telemetry injection.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+
+#include "crsf_router.h"
+#include "crsf_crc.h"
+#include "crsf_frames.h"
+#include <string.h>
+
+static inline bool _is_sync_byte(uint8_t byte)
+{
+  return byte == CRSF_SYNC_BYTE || byte == CRSF_SYNC_BYTE_EDGETX;
+}
+
+// Queues bytes for the route's output port, dropping whatever does not fit
+static void _route_emit(crsf_route_t *route, const uint8_t *data, size_t len)
+{
+  const size_t space = CRSF_ROUTE_QUEUE_SIZE - route->queued;
+  const size_t count = len < space ? len : space;
+  memcpy(route->queue + route->queued, data, count);
+  route->queued += count;
+  route->stats.overflows += len - count;
+}
+
+// Hands the queue to the output port, keeping whatever it did not accept for the next poll.
+// Written a frame's worth at a time, as a DMA transport only takes one frame per write.
+static void _route_flush(crsf_route_t *route)
+{
+  const crsf_transport_t *out = route->out;
+  while (route->queued > 0)
+  {
+    const size_t len = route->queued < CRSF_MAX_FRAME_SIZE ? route->queued : CRSF_MAX_FRAME_SIZE;
+    const size_t written = out->write(out->ctx, route->queue, len);
+    if (written == 0)
+    {
+      return;
+    }
+    memmove(route->queue, route->queue + written, route->queued - written);
+    route->queued -= written;
+  }
+}
+
+// Passes on the bytes of a cut-through frame that have been checked since the last call
+static void _route_emit_scanned(crsf_route_t *route)
+{
+  if (route->emitted != 0 && route->scanned > route->emitted)
+  {
+    _route_emit(route, route->frame + route->emitted, route->scanned - route->emitted);
+    route->emitted = route->scanned;
+  }
+}
+
+// Drops the first `count` buffered bytes and starts a new frame with whatever follows them
+static void _route_consume(crsf_route_t *route, uint8_t count)
+{
+  memmove(route->frame, route->frame + count, route->length - count);
+  route->length -= count;
+  route->scanned = 0;
+  route->emitted = 0;
+}
+
+// Rejects the frame start, so the search for the next frame restarts inside the buffered bytes
+static void _route_reject(crsf_route_t *route)
+{
+  route->stats.bytes_discarded++;
+  _route_consume(route, 1);
+}
+
+static void _route_store_and_forward(crsf_router_t *router, crsf_route_direction_t direction, const uint8_t *frame)
+{
+  crsf_route_t *route = &router->routes[direction];
+  const uint8_t size = frame[1] + 2;
+  const crsf_route_action_t action = route->actions[frame[2]];
+  if (action == CRSF_ROUTE_DROP)
+  {
+    route->stats.filtered++;
+    return;
+  }
+  if (action == CRSF_ROUTE_FORWARD || router->rewrite == NULL)
+  {
+    // Set to forward part way through the frame
+    _route_emit(route, frame, size);
+    route->stats.forwarded++;
+    return;
+  }
+
+  uint8_t rewritten[CRSF_MAX_FRAME_SIZE];
+  memcpy(rewritten, frame, size);
+  if (!router->rewrite(router->rewrite_ctx, direction, rewritten) || rewritten[1] < CRSF_MIN_FRAME_LENGTH ||
+      rewritten[1] > CRSF_MAX_FRAME_LENGTH)
+  {
+    route->stats.filtered++;
+    return;
+  }
+  const uint8_t length = rewritten[1];
+  rewritten[length + 1] = crsf_crc8(rewritten + 2, length - 1);
+  _route_emit(route, rewritten, length + 2);
+  route->stats.rewritten++;
+  route->stats.forwarded++;
+}
+
+// Called with a whole frame buffered and every byte but the CRC checked
+static void _route_complete(crsf_router_t *router, crsf_route_direction_t direction)
+{
+  crsf_route_t *route = &router->routes[direction];
+  const uint8_t size = route->frame[1] + 2;
+  _route_emit_scanned(route);
+  if (route->crc != route->frame[size - 1])
+  {
+    route->stats.crc_errors++;
+    if (route->emitted != 0)
+    {
+      // The wrong CRC goes out too, so the far end drops what it has received of the frame
+      _route_emit(route, route->frame + size - 1, 1);
+    }
+    _route_reject(route);
+    return;
+  }
+  if (route->emitted != 0)
+  {
+    _route_emit(route, route->frame + size - 1, 1);
+    route->stats.forwarded++;
+  }
+  else
+  {
+    _route_store_and_forward(router, direction, route->frame);
+  }
+  _route_consume(route, size);
+}
+
+/**
+ * Checks the buffered bytes from where the last call stopped.
+ *
+ * On return the buffer holds the unfinished start of a frame, or nothing.
+ */
+static void _route_advance(crsf_router_t *router, crsf_route_direction_t direction)
+{
+  crsf_route_t *route = &router->routes[direction];
+  uint8_t *frame = route->frame;
+  while (route->scanned < route->length)
+  {
+    const uint8_t index = route->scanned;
+    if (index == 0)
+    {
+      uint8_t skip = 0;
+      while (skip < route->length && !_is_sync_byte(frame[skip]))
+      {
+        skip++;
+      }
+      if (skip > 0)
+      {
+        route->stats.bytes_discarded += skip;
+        _route_consume(route, skip);
+        continue;
+      }
+    }
+    else if (index == 1)
+    {
+      if (frame[1] < CRSF_MIN_FRAME_LENGTH || frame[1] > CRSF_MAX_FRAME_LENGTH)
+      {
+        route->stats.bad_lengths++;
+        _route_reject(route);
+        continue;
+      }
+    }
+    else if (index == 2)
+    {
+      const uint8_t type = frame[2];
+      // Too short to decode, so it is not worth passing on
+      if (type < CRSF_FRAME_CODECS && frame[1] - 2 < crsf_frame_codecs[type].min_length)
+      {
+        route->stats.bad_lengths++;
+        _route_reject(route);
+        continue;
+      }
+      route->crc = crsf_crc8_update(0, type);
+      if (route->actions[type] == CRSF_ROUTE_FORWARD)
+      {
+        _route_emit(route, frame, 3);
+        route->emitted = 3;
+      }
+    }
+    else if (index == frame[1] + 1)
+    {
+      _route_complete(router, direction);
+      continue;
+    }
+    else
+    {
+      // The rest of the payload that has arrived, in one go
+      const uint8_t crc_index = frame[1] + 1;
+      const uint8_t end = route->length < crc_index ? route->length : crc_index;
+      route->crc = crsf_crc8_update_buf(route->crc, frame + index, end - index);
+      route->scanned = end;
+      continue;
+    }
+    route->scanned++;
+  }
+  _route_emit_scanned(route);
+}
+
+static void _route_input(crsf_router_t *router, crsf_route_direction_t direction, const uint8_t *data, size_t len)
+{
+  crsf_route_t *route = &router->routes[direction];
+  while (len > 0)
+  {
+    // _route_advance() never leaves a whole frame buffered, so there is always room
+    const size_t space = CRSF_MAX_FRAME_SIZE - route->length;
+    const size_t count = len < space ? len : space;
+    memcpy(route->frame + route->length, data, count);
+    route->length += count;
+    data += count;
+    len -= count;
+    _route_advance(router, direction);
+  }
+}
+
+static size_t _local_read(void *ctx, uint8_t *buf, size_t max)
+{
+  crsf_router_t *router = ctx;
+  const size_t count = router->local_length < max ? router->local_length : max;
+  memcpy(buf, router->local_data, count);
+  router->local_data += count;
+  router->local_length -= count;
+  return count;
+}
+
+static size_t _local_write(void *ctx, const uint8_t *buf, size_t len)
+{
+  crsf_router_t *router = ctx;
+  // The flight controller answers commands itself; two replies would confuse the receiver
+  if (len > 2 && buf[2] == CRSF_FRAMETYPE_COMMAND)
+  {
+    return len;
+  }
+  if (router->inject_length != 0 || len > sizeof(router->inject))
+  {
+    return 0;
+  }
+  memcpy(router->inject, buf, len);
+  router->inject_length = len;
+  return len;
+}
+
+static uint64_t _local_time_us(void *ctx)
+{
+  const crsf_transport_t *receiver = ((crsf_router_t *)ctx)->routes[CRSF_ROUTE_DOWNSTREAM].in;
+  return receiver->time_us(receiver->ctx);
+}
+
+// The ports keep their rate; the local instance only uses it to time telemetry slots
+static bool _local_set_baud(void *ctx, uint32_t baud)
+{
+  (void)ctx;
+  (void)baud;
+  return true;
+}
+
+/**
+ * @brief Sets up a router that forwards every frame in both directions.
+ *
+ * @param receiver The port the receiver is connected to.
+ * @param flight_controller The port the flight controller is connected to.
+ * @param local An instance to feed with the downstream bytes and to send
+ * telemetry from, e.g. crsf_default() for the crsf_telem_set_* functions, or
+ * NULL. It is initialized here, so configure it after this call.
+ */
+void crsf_router_init(crsf_router_t *router, const crsf_transport_t *receiver, const crsf_transport_t *flight_controller, crsf_t *local)
+{
+  // Zeroing leaves every type on CRSF_ROUTE_FORWARD
+  memset(router, 0, sizeof(*router));
+  router->routes[CRSF_ROUTE_DOWNSTREAM].in = receiver;
+  router->routes[CRSF_ROUTE_DOWNSTREAM].out = flight_controller;
+  router->routes[CRSF_ROUTE_UPSTREAM].in = flight_controller;
+  router->routes[CRSF_ROUTE_UPSTREAM].out = receiver;
+  if (local != NULL)
+  {
+    router->local_transport = (crsf_transport_t){
+        .read = _local_read,
+        .write = _local_write,
+        .time_us = _local_time_us,
+        .set_baud = _local_set_baud,
+        .ctx = router,
+    };
+    crsf_init(local, &router->local_transport);
+    router->local = local;
+  }
+}
+
+/**
+ * @brief Chooses what happens to frames of one type travelling in one direction.
+ *
+ * A frame already being forwarded when the action changes is finished as it started.
+ */
+void crsf_router_set_action(crsf_router_t *router, crsf_route_direction_t direction, uint8_t type, crsf_route_action_t action)
+{
+  router->routes[direction].actions[type] = action;
+}
+
+/**
+ * @brief Sets the callback for types set to CRSF_ROUTE_REWRITE. Without one they are forwarded unchanged.
+ */
+void crsf_router_set_rewrite(crsf_router_t *router, crsf_route_rewrite_t rewrite, void *ctx)
+{
+  router->rewrite = rewrite;
+  router->rewrite_ctx = ctx;
+}
+
+// Forwards everything the port has received, then feeds downstream bytes to the local instance
+static void _route_service(crsf_router_t *router, crsf_route_direction_t direction)
+{
+  crsf_route_t *route = &router->routes[direction];
+  const crsf_transport_t *in = route->in;
+  uint8_t chunk[CRSF_MAX_FRAME_SIZE];
+  size_t count;
+  _route_flush(route);
+  while ((count = in->read(in->ctx, chunk, sizeof(chunk))) > 0)
+  {
+    _route_input(router, direction, chunk, count);
+    _route_flush(route);
+    if (direction == CRSF_ROUTE_DOWNSTREAM && router->local != NULL)
+    {
+      router->local_data = chunk;
+      router->local_length = count;
+      crsf_ctx_process_frames(router->local);
+    }
+  }
+}
+
+// Slots the local instance's telemetry frame in between two upstream frames
+static void _route_inject(crsf_router_t *router)
+{
+  crsf_route_t *route = &router->routes[CRSF_ROUTE_UPSTREAM];
+  if (router->inject_length == 0 || route->emitted != 0 || CRSF_ROUTE_QUEUE_SIZE - route->queued < router->inject_length)
+  {
+    return;
+  }
+  _route_emit(route, router->inject, router->inject_length);
+  router->inject_length = 0;
+  route->stats.injected++;
+  _route_flush(route);
+}
+
+/**
+ * @brief Forwards whatever both ports have received, without waiting for more.
+ *
+ * The downstream direction is serviced first and the local instance only sees
+ * its bytes once they have been passed on, so neither the local callbacks nor
+ * the upstream traffic hold up RC frames. Call this as often as possible,
+ * from one thread (or core).
+ */
+void crsf_router_poll(crsf_router_t *router)
+{
+  _route_service(router, CRSF_ROUTE_DOWNSTREAM);
+  _route_service(router, CRSF_ROUTE_UPSTREAM);
+  _route_inject(router);
+}
+
+/**
+ * @brief Copies one direction's counters.
+ */
+void crsf_router_get_stats(const crsf_router_t *router, crsf_route_direction_t direction, crsf_route_stats_t *out)
+{
+  *out = router->routes[direction].stats;
+}
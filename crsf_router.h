@@ -0,0 +1,144 @@
+/**
+ * @file crsf_router.h
+ * @author Britannio Jarrett
+ * @brief Cut-through forwarding between a receiver and a flight controller, with telemetry injection.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * The router sits on the wire between a receiver and a flight controller:
+ *
+ *   receiver --(downstream: RC, link statistics)--> router --> flight controller
+ *   receiver <--(upstream: telemetry, replies)----- router <-- flight controller
+ *
+ * Each direction runs a small byte state machine. Garbage between frames is
+ * not forwarded; the sync and length bytes are held until the type byte
+ * arrives, and from then on a forwarded frame's bytes are written out in the
+ * same poll that read them rather than once the frame is complete. When the
+ * CRC turns out to be wrong the received CRC is passed on, so the far end
+ * rejects the frame too, and the search for the next frame restarts inside the
+ * bytes already buffered. Frames that are dropped or rewritten are stored
+ * until their CRC has been checked and are never partly forwarded.
+ *
+ * An optional local instance sees everything going downstream, so its
+ * callbacks and snapshot work as if it were connected to the receiver, and the
+ * telemetry it would send (crsf_ctx_telem_set_*) is merged into the upstream
+ * direction between the flight controller's frames.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "crsf.h"
+
+// Bytes a port may fall behind by before the router starts dropping them
+#define CRSF_ROUTE_QUEUE_SIZE (2 * CRSF_MAX_FRAME_SIZE)
+
+typedef enum
+{
+	// Receiver to flight controller
+	CRSF_ROUTE_DOWNSTREAM,
+	// Flight controller to receiver
+	CRSF_ROUTE_UPSTREAM,
+	CRSF_ROUTE_DIRECTIONS,
+} crsf_route_direction_t;
+
+typedef enum
+{
+	// Cut-through: bytes are passed on as they arrive
+	CRSF_ROUTE_FORWARD,
+	// Frames of this type are not passed on
+	CRSF_ROUTE_DROP,
+	// Store-and-forward through the rewrite callback
+	CRSF_ROUTE_REWRITE,
+} crsf_route_action_t;
+
+/**
+ * @brief Edits a complete, CRC-checked frame before it is forwarded.
+ *
+ * The payload and the length byte (frame[1]) may be changed, up to
+ * CRSF_MAX_FRAME_SIZE bytes in all; the CRC is recomputed afterwards.
+ *
+ * @return false to drop the frame.
+ */
+typedef bool (*crsf_route_rewrite_t)(void *ctx, crsf_route_direction_t direction, uint8_t *frame);
+
+typedef struct
+{
+	// Frames passed on, including rewritten ones
+	uint32_t forwarded;
+	uint32_t rewritten;
+	// Frames dropped by their type's action or by the rewrite callback
+	uint32_t filtered;
+	// Frames whose CRC failed, whether or not they had been partly forwarded
+	uint32_t crc_errors;
+	// Length bytes out of range, or frames too short for their type
+	uint32_t bad_lengths;
+	// Bytes outside any frame, not forwarded
+	uint64_t bytes_discarded;
+	// Bytes dropped because the port did not keep up
+	uint32_t overflows;
+	// Telemetry frames merged in from the local instance (upstream only)
+	uint32_t injected;
+} crsf_route_stats_t;
+
+/**
+ * @brief One direction of the router.
+ */
+typedef struct
+{
+	const crsf_transport_t *in;
+	const crsf_transport_t *out;
+	// crsf_route_action_t per frame type
+	uint8_t actions[256];
+	// The frame being received. The first `scanned` bytes have been checked.
+	uint8_t frame[CRSF_MAX_FRAME_SIZE];
+	uint8_t length;
+	uint8_t scanned;
+	uint8_t crc;
+	// Bytes of a cut-through frame already passed on, 0 while a frame is stored
+	uint8_t emitted;
+	// Bytes accepted for `out` but not yet written
+	uint8_t queue[CRSF_ROUTE_QUEUE_SIZE];
+	size_t queued;
+	crsf_route_stats_t stats;
+} crsf_route_t;
+
+/**
+ * @brief A router between two transports. Owned by the caller, no allocation.
+ */
+typedef struct
+{
+	crsf_route_t routes[CRSF_ROUTE_DIRECTIONS];
+	crsf_route_rewrite_t rewrite;
+	void *rewrite_ctx;
+	// Instance fed with the downstream bytes, NULL if there is none
+	crsf_t *local;
+	crsf_transport_t local_transport;
+	// Downstream chunk being handed to `local`
+	const uint8_t *local_data;
+	size_t local_length;
+	// Telemetry frame from `local` waiting for a gap between upstream frames
+	uint8_t inject[CRSF_MAX_FRAME_SIZE];
+	size_t inject_length;
+} crsf_router_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    void crsf_router_init(crsf_router_t *router, const crsf_transport_t *receiver, const crsf_transport_t *flight_controller, crsf_t *local);
+    void crsf_router_set_action(crsf_router_t *router, crsf_route_direction_t direction, uint8_t type, crsf_route_action_t action);
+    void crsf_router_set_rewrite(crsf_router_t *router, crsf_route_rewrite_t rewrite, void *ctx);
+    void crsf_router_poll(crsf_router_t *router);
+    void crsf_router_get_stats(const crsf_router_t *router, crsf_route_direction_t direction, crsf_route_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
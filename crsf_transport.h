@@ -0,0 +1,35 @@
+/**
+ * @file crsf_transport.h
+ * @author Britannio Jarrett
+ * @brief Byte transport used by the CRSF parser and telemetry encoder.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Backends:
+ *   - crsf_transport_pico.h: RP2040 hardware UART (polled or IRQ driven)
+ *   - crsf_transport_linux.h: termios serial ports and ptys on Linux
+ */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+	// Copy up to `max` received bytes into `buf`. Returns the number of bytes copied, 0 if none are available.
+	size_t (*read)(void *ctx, uint8_t *buf, size_t max);
+	// Queue `len` bytes for transmission. Returns the number of bytes accepted.
+	size_t (*write)(void *ctx, const uint8_t *buf, size_t len);
+	// Monotonic time in microseconds.
+	uint64_t (*time_us)(void *ctx);
+	// Optional. Switch the line to `baud` once queued bytes have been sent. NULL if the rate is fixed.
+	bool (*set_baud)(void *ctx, uint32_t baud);
+	// Backend state passed to every call.
+	void *ctx;
+} crsf_transport_t;
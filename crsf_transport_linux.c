@@ -0,0 +1,274 @@
+/**
+ * @file crsf_transport_linux.c
+ * @author Britannio Jarrett
+ * @brief Linux serial port / pty transport.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+
+#define _GNU_SOURCE
+#include "crsf_transport_linux.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+// termios2 allows arbitrary baud rates such as 420000 (BOTHER).
+// It cannot be mixed with <termios.h>, so raw mode is configured by hand.
+#include <asm/termbits.h>
+
+bool _set_raw_mode(int fd, uint32_t baud)
+{
+  struct termios2 tio;
+  if (ioctl(fd, TCGETS2, &tio) != 0)
+  {
+    return false;
+  }
+  // Equivalent of cfmakeraw(), 8N1
+  tio.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF);
+  tio.c_oflag &= ~OPOST;
+  tio.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+  tio.c_cflag &= ~(CSIZE | PARENB | CSTOPB | CRTSCTS);
+  tio.c_cflag |= CS8 | CREAD | CLOCAL;
+  tio.c_cc[VMIN] = 0;
+  tio.c_cc[VTIME] = 0;
+  if (baud != 0)
+  {
+    tio.c_cflag &= ~CBAUD;
+    tio.c_cflag |= BOTHER;
+    tio.c_ispeed = baud;
+    tio.c_ospeed = baud;
+  }
+  return ioctl(fd, TCSETS2, &tio) == 0;
+}
+
+/**
+ * Wraps an already open file descriptor (a serial device, a pty or a pipe).
+ *
+ * The descriptor is switched to non-blocking mode and owned by the port from now on.
+ */
+bool crsf_linux_port_open_fd(crsf_linux_port_t *port, int fd)
+{
+  port->fd = -1;
+  port->epoll_fd = -1;
+  if (fd < 0)
+  {
+    return false;
+  }
+  const int flags = fcntl(fd, F_GETFL);
+  if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0)
+  {
+    close(fd);
+    return false;
+  }
+  const int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd < 0)
+  {
+    close(fd);
+    return false;
+  }
+  struct epoll_event event = {.events = EPOLLIN};
+  event.data.fd = fd;
+  if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0)
+  {
+    close(epoll_fd);
+    close(fd);
+    return false;
+  }
+  port->fd = fd;
+  port->epoll_fd = epoll_fd;
+  return true;
+}
+
+/**
+ * Opens a serial device in raw 8N1 mode.
+ *
+ * @param port The port state, which must outlive the transport.
+ * @param path The device, e.g. /dev/ttyUSB0 or /dev/serial0.
+ * @param baud The baud rate. Non-standard rates such as 420000 are supported.
+ */
+bool crsf_linux_port_open(crsf_linux_port_t *port, const char *path, uint32_t baud)
+{
+  const int fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0)
+  {
+    port->fd = -1;
+    port->epoll_fd = -1;
+    return false;
+  }
+  if (!_set_raw_mode(fd, baud))
+  {
+    close(fd);
+    port->fd = -1;
+    port->epoll_fd = -1;
+    return false;
+  }
+  return crsf_linux_port_open_fd(port, fd);
+}
+
+/**
+ * Opens the master side of a new pseudo terminal.
+ *
+ * This stands in for a receiver: whatever is written to the peer (slave) side
+ * is read by the library and telemetry can be read back from it.
+ *
+ * @param peer_path Receives the path of the peer side, e.g. /dev/pts/3.
+ */
+bool crsf_linux_port_open_pty(crsf_linux_port_t *port, char *peer_path, size_t peer_path_size)
+{
+  const int fd = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0 ||
+      ptsname_r(fd, peer_path, peer_path_size) != 0 || !_set_raw_mode(fd, 0))
+  {
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+    port->fd = -1;
+    port->epoll_fd = -1;
+    return false;
+  }
+  return crsf_linux_port_open_fd(port, fd);
+}
+
+void crsf_linux_port_close(crsf_linux_port_t *port)
+{
+  if (port->epoll_fd >= 0)
+  {
+    close(port->epoll_fd);
+  }
+  if (port->fd >= 0)
+  {
+    close(port->fd);
+  }
+  port->fd = -1;
+  port->epoll_fd = -1;
+}
+
+/**
+ * Blocks until input is available or the timeout expires.
+ *
+ * @param timeout_ms The timeout in milliseconds, -1 to wait forever.
+ * @return 1 if input is available, 0 on timeout and -1 on error.
+ */
+int crsf_linux_port_wait(crsf_linux_port_t *port, int timeout_ms)
+{
+  struct epoll_event event;
+  int ready;
+  do
+  {
+    ready = epoll_wait(port->epoll_fd, &event, 1, timeout_ms);
+  } while (ready < 0 && errno == EINTR);
+  return ready;
+}
+
+size_t _linux_read(void *ctx, uint8_t *buf, size_t max)
+{
+  crsf_linux_port_t *port = ctx;
+  ssize_t count;
+  do
+  {
+    count = read(port->fd, buf, max);
+  } while (count < 0 && errno == EINTR);
+  // EAGAIN: nothing available. EIO: the pty peer is not open.
+  return count > 0 ? (size_t)count : 0;
+}
+
+// Whether `len` more bytes fit in the output queue right now
+static bool _linux_write_fits(const crsf_linux_port_t *port, size_t len)
+{
+  int queued;
+  // Pipes have no TIOCOUTQ, but writes of up to PIPE_BUF bytes to them are atomic
+  if (ioctl(port->fd, TIOCOUTQ, &queued) == 0 && (size_t)queued + len > CRSF_LINUX_TX_QUEUE_SIZE)
+  {
+    return false;
+  }
+  struct pollfd pfd = {.fd = port->fd, .events = POLLOUT};
+  return poll(&pfd, 1, 0) == 1 && (pfd.revents & POLLOUT);
+}
+
+/**
+ * Writes a whole frame or nothing, so that a frame the caller retries is
+ * never preceded on the wire by a stray copy of its start.
+ */
+size_t _linux_write(void *ctx, const uint8_t *buf, size_t len)
+{
+  crsf_linux_port_t *port = ctx;
+  if (!_linux_write_fits(port, len))
+  {
+    return 0;
+  }
+  size_t written = 0;
+  while (written < len)
+  {
+    const ssize_t count = write(port->fd, buf + written, len - written);
+    if (count >= 0)
+    {
+      written += count;
+    }
+    else if (errno == EAGAIN && written > 0)
+    {
+      // The queue filled up mid-frame despite the check: finish the frame,
+      // which the driver drains within a frame time
+      struct pollfd pfd = {.fd = port->fd, .events = POLLOUT};
+      if (poll(&pfd, 1, 10) <= 0)
+      {
+        // Cut short on the wire, where the receiver drops it on its CRC
+        break;
+      }
+    }
+    else if (errno != EINTR)
+    {
+      break;
+    }
+  }
+  // Once started the frame counts as sent, even if cut short
+  return written > 0 ? len : 0;
+}
+
+uint64_t _linux_time_us(void *ctx)
+{
+  (void)ctx;
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000u;
+}
+
+bool _linux_set_baud(void *ctx, uint32_t baud)
+{
+  crsf_linux_port_t *port = ctx;
+  struct termios2 tio;
+  if (ioctl(port->fd, TCGETS2, &tio) != 0)
+  {
+    return false;
+  }
+  tio.c_cflag &= ~CBAUD;
+  tio.c_cflag |= BOTHER;
+  tio.c_ispeed = baud;
+  tio.c_ospeed = baud;
+  // TCSETSW2 lets the output drain first, so a reply sent at the old rate is not cut off
+  return ioctl(port->fd, TCSETSW2, &tio) == 0;
+}
+
+/**
+ * Fills in `transport` to read from and write to an open port.
+ */
+void crsf_linux_transport(crsf_transport_t *transport, crsf_linux_port_t *port)
+{
+  transport->read = _linux_read;
+  transport->write = _linux_write;
+  transport->time_us = _linux_time_us;
+  transport->set_baud = _linux_set_baud;
+  transport->ctx = port;
+}
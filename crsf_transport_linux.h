@@ -0,0 +1,49 @@
+/**
+ * @file crsf_transport_linux.h
+ * @author Britannio Jarrett
+ * @brief Linux serial port / pty transport.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "crsf_transport.h"
+
+#ifndef CRSF_LINUX_TX_QUEUE_SIZE
+// Output queue of a serial port in the kernel (UART_XMIT_SIZE, a page). A
+// frame is only written if it fits behind what TIOCOUTQ reports as queued.
+#define CRSF_LINUX_TX_QUEUE_SIZE 4096
+#endif
+
+typedef struct
+{
+	// Non-blocking file descriptor of the serial device or pty
+	int fd;
+	// epoll instance watching `fd` for input
+	int epoll_fd;
+} crsf_linux_port_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    bool crsf_linux_port_open(crsf_linux_port_t *port, const char *path, uint32_t baud);
+    bool crsf_linux_port_open_fd(crsf_linux_port_t *port, int fd);
+    bool crsf_linux_port_open_pty(crsf_linux_port_t *port, char *peer_path, size_t peer_path_size);
+    void crsf_linux_port_close(crsf_linux_port_t *port);
+    int crsf_linux_port_wait(crsf_linux_port_t *port, int timeout_ms);
+    void crsf_linux_transport(crsf_transport_t *transport, crsf_linux_port_t *port);
+
+#ifdef __cplusplus
+}
+#endif
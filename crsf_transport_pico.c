@@ -0,0 +1,215 @@
+/**
+ * @file crsf_transport_pico.c
+ * @author Britannio Jarrett
+ * @brief RP2040 hardware UART transport.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+
+#include "crsf_transport_pico.h"
+#include <hardware/dma.h>
+#include <hardware/gpio.h>
+#include <hardware/irq.h>
+#include <pico/time.h>
+#include <string.h>
+
+// Ports with IRQ reception enabled, indexed by uart_get_index()
+crsf_pico_uart_t *_irq_ports[NUM_UARTS];
+
+void _drain_rx_fifo(crsf_pico_uart_t *port)
+{
+  while (uart_is_readable(port->uart))
+  {
+    // The upper bits of the data register carry the receive error flags
+    const uint32_t dr = uart_get_hw(port->uart)->dr;
+    if (dr & UART_UARTDR_OE_BITS)
+    {
+      port->fifo_overruns++;
+    }
+    crsf_ring_push(&port->rx_ring, (uint8_t)dr);
+  }
+}
+
+void _on_uart0_rx()
+{
+  _drain_rx_fifo(_irq_ports[0]);
+}
+
+void _on_uart1_rx()
+{
+  _drain_rx_fifo(_irq_ports[1]);
+}
+
+/**
+ * Initializes a UART for CRSF and sets up the RX and TX pins.
+ *
+ * @param port The port state, which must outlive the transport.
+ * @param uart The UART instance to be used for CRSF communication.
+ * @param tx The TX pin number.
+ * @param rx The RX pin number.
+ * @param baud The baud rate.
+ * @param use_irq Drain the RX FIFO from the UART interrupt into a ring buffer
+ * instead of polling it from read().
+ */
+void crsf_pico_uart_init(crsf_pico_uart_t *port, uart_inst_t *uart, uint8_t tx, uint8_t rx, uint32_t baud, bool use_irq)
+{
+  // TODO support PIO UART
+  port->uart = uart;
+  // set up the UART
+  const uint actual_baud = uart_init(uart, baud);
+  gpio_set_function(tx, GPIO_FUNC_UART);
+  gpio_set_function(rx, GPIO_FUNC_UART);
+  // 10 bits per byte (8N1), rounded up
+  port->byte_time_us = (10 * 1000000 + actual_baud - 1) / actual_baud;
+
+  crsf_ring_init(&port->rx_ring);
+  port->fifo_overruns = 0;
+  port->tx_dma_channel = -1;
+  port->irq_enabled = use_irq;
+  if (use_irq)
+  {
+    const uint index = uart_get_index(uart);
+    const uint irq = index == 0 ? UART0_IRQ : UART1_IRQ;
+    _irq_ports[index] = port;
+    irq_set_exclusive_handler(irq, index == 0 ? _on_uart0_rx : _on_uart1_rx);
+    irq_set_enabled(irq, true);
+    // Interrupt on RX FIFO threshold and on receive timeout
+    uart_set_irq_enables(uart, true, false);
+  }
+}
+
+/**
+ * @brief Transmits with DMA so write() returns as soon as the frame is queued.
+ *
+ * While a frame is still being copied into the TX FIFO, write() accepts nothing
+ * and returns 0 rather than waiting.
+ *
+ * @return false if no DMA channel was free, in which case writes stay blocking.
+ */
+bool crsf_pico_uart_enable_tx_dma(crsf_pico_uart_t *port)
+{
+  const int channel = dma_claim_unused_channel(false);
+  if (channel < 0)
+  {
+    return false;
+  }
+  dma_channel_config config = dma_channel_get_default_config(channel);
+  channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+  channel_config_set_read_increment(&config, true);
+  channel_config_set_write_increment(&config, false);
+  channel_config_set_dreq(&config, uart_get_dreq(port->uart, true));
+  dma_channel_configure(channel, &config, &uart_get_hw(port->uart)->dr, port->tx_buf, 0, false);
+  port->tx_dma_channel = channel;
+  return true;
+}
+
+/**
+ * Releases the UART, its interrupt and its DMA channel.
+ */
+void crsf_pico_uart_deinit(crsf_pico_uart_t *port)
+{
+  if (port->tx_dma_channel >= 0)
+  {
+    dma_channel_abort(port->tx_dma_channel);
+    dma_channel_unclaim(port->tx_dma_channel);
+    port->tx_dma_channel = -1;
+  }
+  if (port->irq_enabled)
+  {
+    const uint index = uart_get_index(port->uart);
+    const uint irq = index == 0 ? UART0_IRQ : UART1_IRQ;
+    uart_set_irq_enables(port->uart, false, false);
+    irq_set_enabled(irq, false);
+    irq_remove_handler(irq, index == 0 ? _on_uart0_rx : _on_uart1_rx);
+    _irq_ports[index] = NULL;
+    port->irq_enabled = false;
+  }
+  uart_deinit(port->uart);
+}
+
+/**
+ * @brief Returns the number of received bytes that were lost.
+ *
+ * This counts both bytes dropped because the RX ring buffer was full and
+ * hardware FIFO overruns. Only meaningful in IRQ mode.
+ */
+uint32_t crsf_pico_uart_overruns(const crsf_pico_uart_t *port)
+{
+  return crsf_ring_overruns(&port->rx_ring) + port->fifo_overruns;
+}
+
+size_t _pico_uart_read(void *ctx, uint8_t *buf, size_t max)
+{
+  crsf_pico_uart_t *port = ctx;
+  if (port->irq_enabled)
+  {
+    // Only hand over what the IRQ has queued without waiting for more
+    return crsf_ring_pop(&port->rx_ring, buf, max);
+  }
+
+  // Keep reading until the line has been idle for a byte time, so a frame
+  // that has started arriving is returned in one piece.
+  size_t count = 0;
+  while (count < max && uart_is_readable_within_us(port->uart, port->byte_time_us))
+  {
+    buf[count++] = uart_getc(port->uart);
+  }
+  return count;
+}
+
+size_t _pico_uart_write(void *ctx, const uint8_t *buf, size_t len)
+{
+  crsf_pico_uart_t *port = ctx;
+  if (port->tx_dma_channel < 0)
+  {
+    uart_write_blocking(port->uart, buf, len);
+    return len;
+  }
+  if (len > sizeof(port->tx_buf) || dma_channel_is_busy(port->tx_dma_channel))
+  {
+    return 0;
+  }
+  memcpy(port->tx_buf, buf, len);
+  dma_channel_set_read_addr(port->tx_dma_channel, port->tx_buf, false);
+  dma_channel_set_trans_count(port->tx_dma_channel, len, true);
+  return len;
+}
+
+uint64_t _pico_uart_time_us(void *ctx)
+{
+  (void)ctx;
+  return time_us_64();
+}
+
+bool _pico_uart_set_baud(void *ctx, uint32_t baud)
+{
+  crsf_pico_uart_t *port = ctx;
+  // Let a reply sent at the old rate finish first
+  if (port->tx_dma_channel >= 0)
+  {
+    dma_channel_wait_for_finish_blocking(port->tx_dma_channel);
+  }
+  uart_tx_wait_blocking(port->uart);
+  const uint actual_baud = uart_set_baudrate(port->uart, baud);
+  port->byte_time_us = (10 * 1000000 + actual_baud - 1) / actual_baud;
+  return true;
+}
+
+/**
+ * Fills in `transport` to read from and write to an initialized UART port.
+ */
+void crsf_pico_uart_transport(crsf_transport_t *transport, crsf_pico_uart_t *port)
+{
+  transport->read = _pico_uart_read;
+  transport->write = _pico_uart_write;
+  transport->time_us = _pico_uart_time_us;
+  transport->set_baud = _pico_uart_set_baud;
+  transport->ctx = port;
+}
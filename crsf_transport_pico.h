@@ -0,0 +1,52 @@
+/**
+ * @file crsf_transport_pico.h
+ * @author Britannio Jarrett
+ * @brief RP2040 hardware UART transport.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+#pragma once
+#include <stdbool.h>
+#include "hardware/uart.h"
+#include "crsf_ring.h"
+#include "crsf_transport.h"
+
+// Largest frame the DMA transmit path can queue
+#define CRSF_PICO_TX_BUF_SIZE 64
+
+typedef struct
+{
+	uart_inst_t *uart;
+	// Time to receive one byte, used to wait for the rest of a frame when polling
+	uint32_t byte_time_us;
+	// IRQ mode: bytes drained from the RX FIFO by the UART interrupt
+	bool irq_enabled;
+	crsf_ring_t rx_ring;
+	uint32_t fifo_overruns;
+	// DMA channel feeding the TX FIFO, or -1 to write with uart_write_blocking()
+	int tx_dma_channel;
+	// Copy of the frame being transmitted, so the caller may reuse its buffer at once
+	uint8_t tx_buf[CRSF_PICO_TX_BUF_SIZE];
+} crsf_pico_uart_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    void crsf_pico_uart_init(crsf_pico_uart_t *port, uart_inst_t *uart, uint8_t tx, uint8_t rx, uint32_t baud, bool use_irq);
+    void crsf_pico_uart_deinit(crsf_pico_uart_t *port);
+    bool crsf_pico_uart_enable_tx_dma(crsf_pico_uart_t *port);
+    uint32_t crsf_pico_uart_overruns(const crsf_pico_uart_t *port);
+    void crsf_pico_uart_transport(crsf_transport_t *transport, crsf_pico_uart_t *port);
+
+#ifdef __cplusplus
+}
+#endif
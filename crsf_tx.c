@@ -0,0 +1,330 @@
+/**
+ * @file crsf_tx.c
+ * @author Britannio Jarrett
+ * @brief Handset side: RC frames sent to a TX module, phase-locked to its RF clock.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ */
+
+#include "crsf_tx.h"
+#include <string.h>
+
+// Fractional bits of the schedule below a tenth of a microsecond
+#define CRSF_TX_FRACTION_BITS 8
+// Attempts at a consistent copy of the frame before the previous one is sent again
+#define CRSF_TX_FRAME_RETRIES 4
+// The trim stays within 1 / CRSF_TX_TRIM_LIMIT of the period, far beyond any crystal's error
+#define CRSF_TX_TRIM_LIMIT 64
+
+static uint64_t _tx_now_us(const crsf_tx_t *tx)
+{
+  const crsf_transport_t *transport = tx->crsf->transport;
+  return transport->time_us(transport->ctx);
+}
+
+static uint64_t _to_schedule(uint64_t us)
+{
+  return us * 10 << CRSF_TX_FRACTION_BITS;
+}
+
+// Rounded up, so a frame is never sent before its deadline
+static uint64_t _to_us(uint64_t schedule)
+{
+  const uint64_t unit = 10 << CRSF_TX_FRACTION_BITS;
+  return (schedule + unit - 1) / unit;
+}
+
+static void _build_frame(uint8_t frame[CRSF_TX_FRAME_SIZE], const uint16_t channels[CRSF_RC_CHANNELS])
+{
+  frame[0] = CRSF_ADDRESS_CRSF_TRANSMITTER;
+  frame[1] = CRSF_RC_CHANNELS_PAYLOAD_SIZE + 2;
+  frame[2] = CRSF_FRAMETYPE_RC_CHANNELS_PACKED;
+  crsf_pack_channels(channels, &frame[3]);
+  frame[CRSF_TX_FRAME_SIZE - 1] = crsf_crc8(&frame[2], CRSF_RC_CHANNELS_PAYLOAD_SIZE + 1);
+}
+
+// Copies the published frame into tx->sending, keeping the previous copy if a writer is mid-update
+static void _take_frame(crsf_tx_t *tx)
+{
+  for (int attempt = 0; attempt < CRSF_TX_FRAME_RETRIES; attempt++)
+  {
+    const uint32_t before = __atomic_load_n(&tx->frame_lock, __ATOMIC_ACQUIRE);
+    if (before & 1)
+    {
+      continue;
+    }
+    uint8_t copy[CRSF_TX_FRAME_SIZE];
+    memcpy(copy, tx->frame, sizeof(copy));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&tx->frame_lock, __ATOMIC_RELAXED) == before)
+    {
+      memcpy(tx->sending, copy, sizeof(copy));
+      return;
+    }
+  }
+}
+
+// Periods the sender has been through, sent or not
+static uint32_t _periods(const crsf_tx_t *tx)
+{
+  return tx->stats.frames_sent + tx->stats.frames_missed + tx->stats.write_failures;
+}
+
+// Sends the frame due at tx->next_deadline and schedules the next one
+static void _send(crsf_tx_t *tx, uint64_t now_us)
+{
+  const uint64_t now = _to_schedule(now_us);
+  while (tx->next_deadline + tx->period <= now)
+  {
+    tx->next_deadline += tx->period;
+    tx->stats.frames_missed++;
+  }
+  const uint64_t deadline_us = _to_us(tx->next_deadline);
+  const uint32_t jitter_us = now_us > deadline_us ? now_us - deadline_us : 0;
+
+  _take_frame(tx);
+  const crsf_transport_t *transport = tx->crsf->transport;
+  if (transport->write(transport->ctx, tx->sending, CRSF_TX_FRAME_SIZE) == CRSF_TX_FRAME_SIZE)
+  {
+    tx->stats.frames_sent++;
+    tx->jitter_sum_us += jitter_us;
+    if (jitter_us > tx->stats.jitter_max_us)
+    {
+      tx->stats.jitter_max_us = jitter_us;
+    }
+  }
+  else
+  {
+    tx->stats.write_failures++;
+  }
+
+  tx->next_deadline += tx->period;
+  const uint32_t seq = __atomic_load_n(&tx->correction_seq, __ATOMIC_ACQUIRE);
+  if (seq != tx->applied_seq)
+  {
+    tx->next_deadline += tx->correction_step;
+    tx->period = tx->corrected_period;
+    __atomic_store_n(&tx->applied_seq, seq, __ATOMIC_RELEASE);
+  }
+}
+
+static void _on_alarm(void *ctx)
+{
+  crsf_tx_t *tx = ctx;
+  uint64_t now_us = _tx_now_us(tx);
+  if (now_us >= _to_us(tx->next_deadline))
+  {
+    _send(tx, now_us);
+    now_us = _tx_now_us(tx);
+  }
+  const uint64_t deadline_us = _to_us(tx->next_deadline);
+  crsf_alarm_arm(&tx->alarm, deadline_us > now_us ? deadline_us - now_us : 1);
+}
+
+// Turns a new timing correction into a phase step and a period for the sender
+static void _track(crsf_tx_t *tx)
+{
+  crsf_timing_correction_t correction;
+  if (!crsf_ctx_get_timing_correction(tx->crsf, &correction) || correction.count == tx->correction_count ||
+      correction.interval == 0)
+  {
+    return;
+  }
+  if (__atomic_load_n(&tx->applied_seq, __ATOMIC_ACQUIRE) != tx->correction_seq)
+  {
+    // The previous correction has not been picked up yet
+    return;
+  }
+  tx->correction_count = correction.count;
+  const uint32_t periods = _periods(tx);
+  const uint32_t frames = periods - tx->frames_at_correction;
+  tx->frames_at_correction = periods;
+  if (correction.interval != tx->interval)
+  {
+    // The module changed packet rate, so the trim no longer applies
+    tx->interval = correction.interval;
+    tx->trim = 0;
+  }
+
+  // A positive offset means the frame came early, so later frames go later
+  const int64_t offset = (int64_t)correction.offset * (1 << CRSF_TX_FRACTION_BITS);
+  const int64_t interval = (int64_t)tx->interval << CRSF_TX_FRACTION_BITS;
+  int64_t step = offset / 2;
+  if (step > interval / 4)
+  {
+    step = interval / 4;
+  }
+  else if (step < -interval / 4)
+  {
+    step = -interval / 4;
+  }
+  tx->trim += offset / 4 / (frames > 0 ? frames : 1);
+  if (tx->trim > interval / CRSF_TX_TRIM_LIMIT)
+  {
+    tx->trim = interval / CRSF_TX_TRIM_LIMIT;
+  }
+  else if (tx->trim < -interval / CRSF_TX_TRIM_LIMIT)
+  {
+    tx->trim = -interval / CRSF_TX_TRIM_LIMIT;
+  }
+  tx->correction_step = step;
+  tx->corrected_period = interval + tx->trim;
+  __atomic_store_n(&tx->correction_seq, tx->correction_seq + 1, __ATOMIC_RELEASE);
+
+  const uint32_t error = correction.offset < 0 ? -(uint32_t)correction.offset : (uint32_t)correction.offset;
+  tx->stats.corrections++;
+  tx->stats.phase_error = correction.offset;
+  tx->stats.period = (tx->corrected_period + (1 << (CRSF_TX_FRACTION_BITS - 1))) >> CRSF_TX_FRACTION_BITS;
+  tx->stats.trim_ppm = (int32_t)(tx->trim * 1000000 / interval);
+  tx->stats.locked = error <= CRSF_TX_LOCK_OFFSET;
+  tx->ever_locked |= tx->stats.locked;
+  if (tx->ever_locked)
+  {
+    tx->phase_error_sum += error;
+    tx->phase_error_samples++;
+    if (error > tx->stats.phase_error_max)
+    {
+      tx->stats.phase_error_max = error;
+    }
+  }
+}
+
+/**
+ * @brief Sets up a generator sending centred channels at `rate_hz` through `crsf`'s transport.
+ *
+ * `crsf` is the instance on the module's UART, set up with crsf_init() and a
+ * transport. Its address becomes CRSF_ADDRESS_RADIO_TRANSMITTER so it parses the
+ * module's frames. Nothing else should write to its transport while frames are
+ * being sent, so leave its telemetry unset.
+ *
+ * @param rate_hz The packet rate until the first timing correction gives the module's own.
+ * @return false if `rate_hz` is 0, in which case `tx` is left untouched.
+ */
+bool crsf_tx_init(crsf_tx_t *tx, crsf_t *crsf, uint16_t rate_hz)
+{
+  if (rate_hz == 0)
+  {
+    return false;
+  }
+  memset(tx, 0, sizeof(*tx));
+  tx->crsf = crsf;
+  crsf_ctx_set_address(crsf, CRSF_ADDRESS_RADIO_TRANSMITTER);
+  tx->interval = 10000000 / rate_hz;
+  tx->period = (uint64_t)tx->interval << CRSF_TX_FRACTION_BITS;
+  tx->stats.period = tx->interval;
+  uint16_t channels[CRSF_RC_CHANNELS];
+  for (uint8_t i = 0; i < CRSF_RC_CHANNELS; i++)
+  {
+    channels[i] = CRSF_CHANNEL_CENTER;
+  }
+  _build_frame(tx->frame, channels);
+  memcpy(tx->sending, tx->frame, sizeof(tx->sending));
+  tx->next_deadline = _to_schedule(_tx_now_us(tx)) + tx->period;
+  return true;
+}
+
+/**
+ * @brief Packs the channels into the frame sent from the next period on.
+ *
+ * Safe to call while the alarm is sending. A send that interrupts this call
+ * repeats the previous frame.
+ *
+ * @param channels CRSF channel values (0 - 1984, 992 centred).
+ */
+void crsf_tx_set_channels(crsf_tx_t *tx, const uint16_t channels[CRSF_RC_CHANNELS])
+{
+  uint8_t frame[CRSF_TX_FRAME_SIZE];
+  _build_frame(frame, channels);
+  const uint32_t lock = tx->frame_lock;
+  __atomic_store_n(&tx->frame_lock, lock + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(tx->frame, frame, sizeof(frame));
+  __atomic_store_n(&tx->frame_lock, lock + 2, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Sends from a hardware alarm (a timer thread on the host) instead of from crsf_tx_poll().
+ *
+ * On the Pico the frame is written from the alarm IRQ, so give the transport
+ * TX DMA (crsf_pico_uart_enable_tx_dma()) and the write returns at once.
+ * Keep calling crsf_tx_poll() to parse the module's frames and apply its
+ * timing corrections.
+ *
+ * @return false if no alarm is free.
+ */
+bool crsf_tx_start(crsf_tx_t *tx)
+{
+  if (tx->alarm_running)
+  {
+    return true;
+  }
+  if (!crsf_alarm_init(&tx->alarm, _on_alarm, tx))
+  {
+    return false;
+  }
+  const uint64_t now_us = _tx_now_us(tx);
+  tx->next_deadline = _to_schedule(now_us) + tx->period;
+  tx->alarm_running = true;
+  crsf_alarm_arm(&tx->alarm, _to_us(tx->next_deadline) - now_us);
+  return true;
+}
+
+/**
+ * @brief Stops the alarm; crsf_tx_poll() sends the frames again from then on.
+ */
+void crsf_tx_stop(crsf_tx_t *tx)
+{
+  if (!tx->alarm_running)
+  {
+    return;
+  }
+  crsf_alarm_deinit(&tx->alarm);
+  tx->alarm_running = false;
+}
+
+/**
+ * @brief Parses the module's frames, applies its timing corrections and, without the alarm, sends when due.
+ *
+ * Without crsf_tx_start() the send time is only as good as how often this is
+ * called; with it, call this often enough to see every correction.
+ */
+void crsf_tx_poll(crsf_tx_t *tx)
+{
+  crsf_ctx_process_frames(tx->crsf);
+  _track(tx);
+  if (!tx->alarm_running)
+  {
+    const uint64_t now_us = _tx_now_us(tx);
+    if (now_us >= _to_us(tx->next_deadline))
+    {
+      _send(tx, now_us);
+    }
+  }
+}
+
+/**
+ * @brief When the next frame is due, in transport microseconds, e.g. to sleep until then between polls.
+ */
+uint64_t crsf_tx_next_send_us(const crsf_tx_t *tx)
+{
+  return _to_us(tx->next_deadline);
+}
+
+/**
+ * @brief Copies the send and phase-lock counters.
+ *
+ * While the alarm is running the send counters may be a frame apart from each other.
+ */
+void crsf_tx_get_stats(const crsf_tx_t *tx, crsf_tx_stats_t *out)
+{
+  *out = tx->stats;
+  out->jitter_avg_us = out->frames_sent > 0 ? tx->jitter_sum_us / out->frames_sent : 0;
+  out->phase_error_avg = tx->phase_error_samples > 0 ? tx->phase_error_sum / tx->phase_error_samples : 0;
+}
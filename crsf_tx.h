@@ -0,0 +1,123 @@
+/**
+ * @file crsf_tx.h
+ * @author Britannio Jarrett
+ * @brief Handset side: RC frames sent to a TX module, phase-locked to its RF clock.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * A TX module sends one RC packet over the air per RF period and wants the
+ * handset's RC frame to arrive a little before each one. ELRS modules report
+ * the period they run at and how far off the frames arrive in RADIO_ID timing
+ * correction frames (0x3A, sub-type 0x10). The generator keeps one
+ * RC_CHANNELS_PACKED frame encoded, sends it every period from a hardware alarm
+ * (see crsf_alarm.h) so the send time does not depend on the main loop, and
+ * steers the period with each correction: half the reported offset is taken
+ * out on the next frame, and a quarter of the drift it implies per frame is
+ * added to the period, which cancels the difference between the two clocks.
+ *
+ * The module's own frames (timing corrections, link statistics and telemetry)
+ * start with CRSF_ADDRESS_RADIO_TRANSMITTER and are parsed by the instance the
+ * generator is set up with, so its callbacks and snapshot see them.
+ */
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "crsf.h"
+
+// Bytes in an RC_CHANNELS_PACKED frame
+#define CRSF_TX_FRAME_SIZE (CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4)
+
+#ifndef CRSF_TX_LOCK_OFFSET
+// Largest reported offset, in tenths of a microsecond, at which the generator counts as locked
+#define CRSF_TX_LOCK_OFFSET 50
+#endif
+
+typedef struct
+{
+	uint32_t frames_sent;
+	// Periods skipped because the send came more than a period late
+	uint32_t frames_missed;
+	// Frames the transport did not accept, e.g. while its DMA was still busy
+	uint32_t write_failures;
+	// How long after its deadline each frame was handed to the transport, in microseconds
+	uint32_t jitter_avg_us;
+	uint32_t jitter_max_us;
+	uint32_t corrections;
+	// Latest offset reported by the module, in tenths of a microsecond
+	int32_t phase_error;
+	// Average and largest reported |offset| since the generator first locked, in tenths of a microsecond
+	uint32_t phase_error_avg;
+	uint32_t phase_error_max;
+	// Period in use including the clock trim, in tenths of a microsecond, rounded
+	uint32_t period;
+	// Clock trim added to the module's period, in parts per million
+	int32_t trim_ppm;
+	// The latest offset was within CRSF_TX_LOCK_OFFSET
+	bool locked;
+} crsf_tx_stats_t;
+
+/**
+ * @brief RC frame generator for one TX module. Owned by the caller, no allocation.
+ *
+ * Times are kept in 1/256ths of a tenth of a microsecond of transport time, so
+ * the period carries a fractional trim.
+ */
+typedef struct
+{
+	crsf_t *crsf;
+	crsf_alarm_t alarm;
+	bool alarm_running;
+	// Frame set by crsf_tx_set_channels(), published with a seqlock (odd while being written)
+	uint32_t frame_lock;
+	uint8_t frame[CRSF_TX_FRAME_SIZE];
+	// Copy taken for the latest send, sent again if a consistent copy cannot be taken
+	uint8_t sending[CRSF_TX_FRAME_SIZE];
+
+	// Schedule, only touched by the sender (the alarm once started)
+	uint64_t next_deadline;
+	uint64_t period;
+	uint64_t jitter_sum_us;
+
+	// Correction handed from crsf_tx_poll() to the sender, which applies it
+	// once `applied_seq` falls behind `correction_seq`
+	uint32_t correction_seq;
+	uint32_t applied_seq;
+	int64_t correction_step;
+	uint64_t corrected_period;
+
+	// Loop state, only touched by crsf_tx_poll(). `interval` is the module's
+	// period in tenths of a microsecond and `trim` what is added to it.
+	uint32_t interval;
+	int64_t trim;
+	// crsf_timing_correction_t.count last seen, and frames_sent when it was applied
+	uint32_t correction_count;
+	uint32_t frames_at_correction;
+	bool ever_locked;
+	uint64_t phase_error_sum;
+	uint32_t phase_error_samples;
+
+	crsf_tx_stats_t stats;
+} crsf_tx_t;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    bool crsf_tx_init(crsf_tx_t *tx, crsf_t *crsf, uint16_t rate_hz);
+    void crsf_tx_set_channels(crsf_tx_t *tx, const uint16_t channels[CRSF_RC_CHANNELS]);
+    bool crsf_tx_start(crsf_tx_t *tx);
+    void crsf_tx_stop(crsf_tx_t *tx);
+    void crsf_tx_poll(crsf_tx_t *tx);
+    uint64_t crsf_tx_next_send_us(const crsf_tx_t *tx);
+    void crsf_tx_get_stats(const crsf_tx_t *tx, crsf_tx_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
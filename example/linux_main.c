@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "crsf.h"
+#include "crsf_capture.h"
+#include "crsf_transport_linux.h"
+
+void on_rc_channels(const uint16_t channels[16]) {
+  for (int i = 0; i < 8; i++) {
+    printf("Channel %d: %d\n", i + 1, channels[i]);
+  }
+}
+
+void on_link_stats(const link_statistics_t link_stats) {
+  printf("RSSI: %d\n", link_stats.rssi);
+  printf("Link Quality: %d\n", link_stats.link_quality);
+  printf("SNR: %d\n", link_stats.snr);
+  printf("TX Power: %d\n", link_stats.tx_power);
+}
+
+void on_failsafe(const bool failsafe) {
+  printf("Failsafe: %d\n", failsafe);
+}
+
+// Flushed per record so the capture survives the process being interrupted
+size_t write_capture(void *ctx, const uint8_t *buf, size_t len) {
+  const size_t written = fwrite(buf, 1, len, ctx);
+  fflush(ctx);
+  return written;
+}
+
+// Usage: crsf_linux [--capture FILE] [/dev/ttyUSB0]
+// Without a device a pty is opened and its peer path printed, so frames can be
+// written to it by another process. With --capture everything read and written
+// is recorded to FILE, for tools/crsf_replay.
+int main(int argc, char **argv) {
+  const char *capture_path = NULL;
+  if (argc > 2 && strcmp(argv[1], "--capture") == 0) {
+    capture_path = argv[2];
+    argc -= 2;
+    argv += 2;
+  }
+
+  crsf_linux_port_t port;
+  if (argc > 1) {
+    if (!crsf_linux_port_open(&port, argv[1], 420000)) {
+      perror(argv[1]);
+      return EXIT_FAILURE;
+    }
+  } else {
+    char peer[64];
+    if (!crsf_linux_port_open_pty(&port, peer, sizeof(peer))) {
+      perror("pty");
+      return EXIT_FAILURE;
+    }
+    printf("Write CRSF frames to %s\n", peer);
+  }
+
+  crsf_set_link_quality_threshold(70);
+  crsf_set_rssi_threshold(105);
+
+#if CRSF_CALLBACKS
+  crsf_set_on_rc_channels(on_rc_channels);
+  crsf_set_on_link_statistics(on_link_stats);
+  crsf_set_on_failsafe(on_failsafe);
+#endif
+
+  crsf_transport_t transport;
+  crsf_linux_transport(&transport, &port);
+  crsf_begin_transport(&transport);
+
+  crsf_capture_t capture;
+  if (capture_path != NULL) {
+    FILE *file = fopen(capture_path, "wb");
+    if (file == NULL || !crsf_capture_init_stream(&capture, write_capture, file, 420000)) {
+      perror(capture_path);
+      return EXIT_FAILURE;
+    }
+    crsf_capture_attach(&capture, crsf_default());
+  }
+
+#if !CRSF_CALLBACKS
+  // Built without callbacks: print from the snapshot whenever new frames arrived
+  crsf_snapshot_t last = {0};
+#endif
+  for (;;) {
+    crsf_linux_port_wait(&port, 100);
+    crsf_process_frames();
+#if !CRSF_CALLBACKS
+    crsf_snapshot_t snapshot;
+    if (crsf_get_latest(&snapshot) && snapshot.seq != last.seq) {
+      on_rc_channels(snapshot.channels);
+      on_link_stats(snapshot.link_statistics);
+      if (snapshot.failsafe != last.failsafe) {
+        on_failsafe(snapshot.failsafe);
+      }
+      last = snapshot;
+    }
+#endif
+  }
+}
@@ -1,16 +1,21 @@
 #include <stdio.h>
 #include "pico/stdlib.h"
 #include "crsf.h"
+#include "crsf_capture.h"
+
+// The last second or so of a 420000 baud link, dumped over USB when 'd' is typed
+uint8_t capture_buffer[48 * 1024];
+crsf_capture_t capture;
 
 void on_rc_channels(const uint16_t channels[16]) {
-  printf("Channel 1: %d\n", TICKS_TO_US(channels[0]));
-  printf("Channel 2: %d\n", TICKS_TO_US(channels[1]));
-  printf("Channel 3: %d\n", TICKS_TO_US(channels[2]));
-  printf("Channel 4: %d\n", TICKS_TO_US(channels[3]));
-  printf("Channel 5: %d\n", TICKS_TO_US(channels[4]));
-  printf("Channel 6: %d\n", TICKS_TO_US(channels[5]));
-  printf("Channel 7: %d\n", TICKS_TO_US(channels[6]));
-  printf("Channel 8: %d\n", TICKS_TO_US(channels[7]));
+  printf("Channel 1: %d\n", CRSF_TICKS_TO_US(channels[0]));
+  printf("Channel 2: %d\n", CRSF_TICKS_TO_US(channels[1]));
+  printf("Channel 3: %d\n", CRSF_TICKS_TO_US(channels[2]));
+  printf("Channel 4: %d\n", CRSF_TICKS_TO_US(channels[3]));
+  printf("Channel 5: %d\n", CRSF_TICKS_TO_US(channels[4]));
+  printf("Channel 6: %d\n", CRSF_TICKS_TO_US(channels[5]));
+  printf("Channel 7: %d\n", CRSF_TICKS_TO_US(channels[6]));
+  printf("Channel 8: %d\n", CRSF_TICKS_TO_US(channels[7]));
 }
 
 void on_link_stats(const link_statistics_t link_stats) {
@@ -24,6 +29,11 @@ void on_failsafe(const bool failsafe) {
   printf("Failsafe: %d\n", failsafe);
 }
 
+size_t write_usb(void *ctx, const uint8_t *buf, size_t len) {
+  for (size_t i = 0; i < len; i++) putchar_raw(buf[i]);
+  return len;
+}
+
 int main() {
   stdio_init_all();
 
@@ -35,7 +45,16 @@ int main() {
   crsf_set_on_failsafe(on_failsafe);
 
   crsf_begin(uart0, 1, 0);
-  for (;;) crsf_process_frames();
+  crsf_capture_init(&capture, capture_buffer, sizeof(capture_buffer), 420000);
+  crsf_capture_attach(&capture, crsf_default());
+  for (;;) {
+    crsf_process_frames();
+    // Save it with e.g. `cat /dev/ttyACM0 > capture.bin`, the reader skips the text before it
+    if (getchar_timeout_us(0) == 'd') {
+      crsf_capture_dump(&capture, write_usb, NULL);
+      stdio_flush();
+    }
+  }
 }
 
 void set_battery() {
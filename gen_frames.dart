@@ -1,27 +1,274 @@
-void main() {
-  var str = StringBuffer();
+import 'dart:io';
+
+// Writes crsf_frames.h, crsf_frames.c and crsf_frames.hpp to the directory
+// given as the first argument (the current directory by default). CMake runs
+// this at configure time when the Dart SDK is installed; the output is checked
+// in for builds without it. Unchanged files are not rewritten so they do not
+// trigger a rebuild.
+void main(List<String> args) {
+  final dir = args.isEmpty ? "." : args[0];
+
+  var header = StringBuffer();
+  _fileHeader(header, "crsf_frames.h",
+      "Payload structs and codecs for the CRSF frame types.");
+  header.write(_headerPreamble);
+  Payload.toSwitches(header);
+  header.writeln();
   for (var payload in Payload.values) {
-    payload.toStruct(str);
-    str.writeln();
-    str.writeln();
+    payload.toStruct(header);
+    header.writeln();
+    header.writeln();
   }
+  Payload.toEnum(header);
+  header.writeln();
+  header.writeln();
+  Payload.toUnion(header);
+  header.writeln();
+  header.writeln();
+  Payload.toCodecTable(header);
+  header.writeln();
+  Payload.toPrototypes(header);
 
-  Payload.toTelemetryStruct(str);
-  str.writeln();
-  str.writeln();
-
-  Payload.toEnum(str);
-  str.writeln();
-  str.writeln();
+  var source = StringBuffer();
+  _fileHeader(source, "crsf_frames.c",
+      "Payload structs and codecs for the CRSF frame types.");
+  source.write(_sourcePreamble);
+  // Codecs of the frame types switched off in crsf_config.h are left out
+  for (var payload in Payload.values) {
+    source.write("#if ${payload.switchName}\n");
+    payload.toCDecode(source);
+    source.writeln();
+    source.writeln();
+    payload.toCEncode(source);
+    if (!payload.packed && !payload.variable) {
+      source.writeln();
+      source.writeln();
+      payload.toCPatch(source);
+    }
+    source.write("\n#endif\n\n");
+  }
+  Payload.toDispatchTable(source);
 
+  var cpp = StringBuffer();
+  _fileHeader(cpp, "crsf_frames.hpp",
+      "constexpr descriptors of the CRSF frame types, used by crsf.hpp.");
+  cpp.write(_cppPreamble);
   for (var payload in Payload.values) {
-    payload.toCBuffer(str);
-    str.writeln();
-    str.writeln();
+    payload.toCppDescriptor(cpp);
+    cpp.writeln();
+  }
+  Payload.toCppVisit(cpp);
+  cpp.write("}\n");
+
+  _writeIfChanged("$dir/crsf_frames.h", header.toString());
+  _writeIfChanged("$dir/crsf_frames.c", source.toString());
+  _writeIfChanged("$dir/crsf_frames.hpp", cpp.toString());
+}
+
+void _writeIfChanged(String path, String contents) {
+  final file = File(path);
+  if (file.existsSync() && file.readAsStringSync() == contents) {
+    return;
+  }
+  file.writeAsStringSync(contents);
+}
+
+void _fileHeader(StringBuffer str, String name, String brief) {
+  str.write("""/**
+ * @file $name
+ * @author Britannio Jarrett
+ * @brief $brief
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Generated by gen_frames.dart, do not edit.
+ */
+""");
+}
+
+const _headerPreamble = """#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "crsf_channels.h"
+#include "crsf_config.h"
+
+// Payload bytes in a frame of the largest size, [sync], [len], [type] and [crc8] excluded
+#define CRSF_MAX_PAYLOAD_SIZE (CRSF_MAX_FRAME_SIZE - 4)
+
+""";
+
+const _sourcePreamble = """
+#include "crsf_frames.h"
+#include <string.h>
+
+// Fields are big-endian on the wire
+static inline uint8_t _load_ui8(const uint8_t *src)
+{
+  return src[0];
+}
+
+static inline int8_t _load_i8(const uint8_t *src)
+{
+  return (int8_t)src[0];
+}
+
+static inline uint16_t _load_ui16(const uint8_t *src)
+{
+  return (uint16_t)(src[0] << 8 | src[1]);
+}
+
+static inline int16_t _load_i16(const uint8_t *src)
+{
+  return (int16_t)_load_ui16(src);
+}
+
+static inline uint32_t _load_ui24(const uint8_t *src)
+{
+  return (uint32_t)src[0] << 16 | (uint32_t)src[1] << 8 | src[2];
+}
+
+static inline uint32_t _load_ui32(const uint8_t *src)
+{
+  return (uint32_t)src[0] << 24 | (uint32_t)src[1] << 16 | (uint32_t)src[2] << 8 | src[3];
+}
+
+static inline int32_t _load_i32(const uint8_t *src)
+{
+  return (int32_t)_load_ui32(src);
+}
+
+static inline void _store_ui8(uint8_t *dst, uint8_t data)
+{
+  dst[0] = data;
+}
+
+static inline void _store_i8(uint8_t *dst, int8_t data)
+{
+  dst[0] = (uint8_t)data;
+}
+
+static inline void _store_ui16(uint8_t *dst, uint16_t data)
+{
+  dst[0] = data >> 8;
+  dst[1] = data;
+}
+
+static inline void _store_i16(uint8_t *dst, int16_t data)
+{
+  _store_ui16(dst, (uint16_t)data);
+}
+
+static inline void _store_ui24(uint8_t *dst, uint32_t data)
+{
+  dst[0] = data >> 16;
+  dst[1] = data >> 8;
+  dst[2] = data;
+}
+
+static inline void _store_ui32(uint8_t *dst, uint32_t data)
+{
+  dst[0] = data >> 24;
+  dst[1] = data >> 16;
+  dst[2] = data >> 8;
+  dst[3] = data;
+}
+
+static inline void _store_i32(uint8_t *dst, int32_t data)
+{
+  _store_ui32(dst, (uint32_t)data);
+}
+
+// Store `data` big-endian at `dst`, returning whether any byte changed
+static inline bool _patch_ui8(uint8_t *dst, uint8_t data)
+{
+  const bool changed = dst[0] != data;
+  dst[0] = data;
+  return changed;
+}
+
+static inline bool _patch_i8(uint8_t *dst, int8_t data)
+{
+  return _patch_ui8(dst, (uint8_t)data);
+}
+
+static inline bool _patch_ui16(uint8_t *dst, uint16_t data)
+{
+  const uint8_t bytes[2] = {data >> 8, data};
+  const bool changed = memcmp(dst, bytes, sizeof(bytes)) != 0;
+  memcpy(dst, bytes, sizeof(bytes));
+  return changed;
+}
+
+static inline bool _patch_i16(uint8_t *dst, int16_t data)
+{
+  return _patch_ui16(dst, (uint16_t)data);
+}
+
+static inline bool _patch_ui24(uint8_t *dst, uint32_t data)
+{
+  const uint8_t bytes[3] = {data >> 16, data >> 8, data};
+  const bool changed = memcmp(dst, bytes, sizeof(bytes)) != 0;
+  memcpy(dst, bytes, sizeof(bytes));
+  return changed;
+}
+
+static inline bool _patch_ui32(uint8_t *dst, uint32_t data)
+{
+  const uint8_t bytes[4] = {data >> 24, data >> 16, data >> 8, data};
+  const bool changed = memcmp(dst, bytes, sizeof(bytes)) != 0;
+  memcpy(dst, bytes, sizeof(bytes));
+  return changed;
+}
+
+static inline bool _patch_i32(uint8_t *dst, int32_t data)
+{
+  return _patch_ui32(dst, (uint32_t)data);
+}
+
+// Copies the null-terminated string at `src` into `dst`, truncating it to fit.
+// Returns the bytes consumed including the terminator, 0 if there is none.
+static inline uint8_t _load_string(char *dst, size_t size, const uint8_t *src, uint8_t length)
+{
+  const uint8_t *end = memchr(src, 0, length);
+  if (end == NULL)
+  {
+    return 0;
   }
-  print(str.toString());
+  const size_t consumed = end - src + 1;
+  const size_t copied = consumed < size ? consumed - 1 : size - 1;
+  memcpy(dst, src, copied);
+  dst[copied] = '\\0';
+  return consumed;
 }
 
+static inline uint8_t _store_string(uint8_t *dst, const char *src, size_t size)
+{
+  const size_t length = strnlen(src, size - 1);
+  memcpy(dst, src, length);
+  dst[length] = '\\0';
+  return length + 1;
+}
+
+""";
+
+const _cppPreamble = """#pragma once
+#include "crsf_fields.hpp"
+
+namespace crsf
+{
+    // Descriptor of a frame type: its payload struct and wire layout, see crsf_fields.hpp.
+    // Only the types switched on in crsf_config.h have one.
+    template <frame_type_t Type>
+    struct frame;
+
+""";
+
 extension on int {
   String get hex {
     return "0x" + "${toRadixString(16).padLeft(2, '0')}".toUpperCase();
@@ -29,21 +276,45 @@ extension on int {
 }
 
 enum CType {
-  uint8("uint8_t", "buf_write_ui8", 8),
-  uint16("uint16_t", "buf_write_ui16", 16),
-  uint24("uint24_t", "buf_write_ui24", 24),
-  uint32("uint32_t", "buf_write_ui32", 32),
-  int8("int8_t", "buf_write_i8", 8),
-  int16("int16_t", "buf_write_i16", 16),
-  int32("int32_t", "buf_write_i32", 32),
-  uint11LE("unsigned", "buf_write_ui11LE", 11, packed: true);
+  uint8("uint8_t", "ui8", 8),
+  uint16("uint16_t", "ui16", 16),
+  uint24("uint24_t", "ui24", 24),
+  uint32("uint32_t", "ui32", 32),
+  int8("int8_t", "i8", 8),
+  int16("int16_t", "i16", 16),
+  int32("int32_t", "i32", 32),
+  uint11LE("unsigned", "", 11, packed: true),
+  // Null-terminated. The C buffer holds `size` bytes including the terminator.
+  string("char", "", 8, variable: true),
+  // The rest of the payload, up to CRSF_MAX_PAYLOAD_SIZE. Its length is kept in a `length` member.
+  bytes("uint8_t", "", 0, variable: true),
+  // RC_CHANNELS_SUBSET: a start channel and resolution byte, then 10 - 13 bit channel values
+  channelSubset("uint16_t", "", 16, variable: true);
 
-  const CType(this.str, this.writeStr, this.bits, {this.packed = false});
+  const CType(this.str, this.suffix, this.bits,
+      {this.packed = false, this.variable = false});
 
   final String str;
-  final String writeStr;
+  // Names the _load_, _store_ and _patch_ helpers of fixed-size integers
+  final String suffix;
   final int bits;
   final bool packed;
+  final bool variable;
+
+  // Fewest bytes the field takes on the wire
+  int get minBytes {
+    switch (this) {
+      case CType.string:
+        return 1;
+      case CType.bytes:
+        return 0;
+      case CType.channelSubset:
+        // Configuration byte and at least one 10-bit channel
+        return 3;
+      default:
+        return bits ~/ 8;
+    }
+  }
 
   String toString() => str;
 }
@@ -53,11 +324,19 @@ class PayloadField {
   final String name;
   final String description;
   final CType writeType;
+  // Buffer size of string fields
+  final int size;
 
-  const PayloadField(this.type, this.name, this.description, {CType? writeType})
+  const PayloadField(this.type, this.name, this.description,
+      {CType? writeType, this.size = 0})
       : writeType = writeType ?? type;
 }
 
+const _extendedHeader = [
+  PayloadField(CType.uint8, "destination", "Destination device address"),
+  PayloadField(CType.uint8, "origin", "Origin device address"),
+];
+
 enum Payload {
   rc_channels_packed(
     0x16,
@@ -79,6 +358,8 @@ enum Payload {
       PayloadField(CType.uint11LE, "channel14", ""),
       PayloadField(CType.uint11LE, "channel15", ""),
     ],
+    comment:
+        "The values are CRSF channel values (0-1984). CRSF 172 represents 988us, CRSF 992 represents 1500us, and CRSF 1811 represents 2012us.",
   ),
   battery_sensor(0x08, [
     PayloadField(CType.uint16, "voltage", "voltage in dV (Big Endian)"),
@@ -108,23 +389,136 @@ enum Payload {
     PayloadField(CType.uint8, "downlink_package_success_rate",
         "Downlink package success rate / Link quality ( % )"),
     PayloadField(CType.int8, "downlink_snr", "Downlink SNR ( dB )"),
-  ]);
+  ]),
+  gps(0x02, [
+    PayloadField(CType.int32, "latitude", "Latitude ( degree * 1e7 )"),
+    PayloadField(CType.int32, "longitude", "Longitude ( degree * 1e7 )"),
+    PayloadField(CType.uint16, "groundspeed", "Groundspeed ( km/h * 10 )"),
+    PayloadField(CType.uint16, "heading", "GPS heading ( degree * 100 )"),
+    PayloadField(CType.uint16, "altitude", "Altitude ( metres + 1000 )"),
+    PayloadField(CType.uint8, "satellites", "Satellites in use"),
+  ]),
+  vario(0x07, [
+    PayloadField(CType.int16, "vertical_speed", "Vertical speed ( cm/s )"),
+  ]),
+  baro_altitude(0x09, [
+    PayloadField(CType.uint16, "altitude",
+        "Altitude ( decimetres + 10000, or metres when the MSB is set )"),
+    PayloadField(CType.int8, "vertical_speed",
+        "Vertical speed ( logarithmically packed cm/s )"),
+  ]),
+  attitude(0x1E, [
+    PayloadField(CType.int16, "pitch", "Pitch ( rad * 10000 )"),
+    PayloadField(CType.int16, "roll", "Roll ( rad * 10000 )"),
+    PayloadField(CType.int16, "yaw", "Yaw ( rad * 10000 )"),
+  ]),
+  flight_mode(0x21, [
+    PayloadField(CType.string, "flight_mode", "Flight mode name", size: 16),
+  ]),
+  rc_channels_subset(0x17, [
+    PayloadField(CType.channelSubset, "channels",
+        "Channel values at the frame's resolution"),
+  ]),
+  device_ping(0x28, _extendedHeader),
+  device_info(0x29, [
+    ..._extendedHeader,
+    PayloadField(CType.string, "device_name", "Device name", size: 32),
+    PayloadField(CType.uint32, "serial_number", "Serial number"),
+    PayloadField(CType.uint32, "hardware_id", "Hardware ID"),
+    PayloadField(CType.uint32, "firmware_id", "Firmware ID"),
+    PayloadField(CType.uint8, "parameter_count", "Number of parameters"),
+    PayloadField(
+        CType.uint8, "parameter_version", "Parameter protocol version"),
+  ]),
+  parameter_settings_entry(0x2B, [
+    ..._extendedHeader,
+    PayloadField(CType.uint8, "field_index", "Parameter number"),
+    PayloadField(
+        CType.uint8, "chunks_remaining", "Chunks still to come after this one"),
+    PayloadField(CType.bytes, "data", "Chunk of the parameter entry"),
+  ]),
+  parameter_read(0x2C, [
+    ..._extendedHeader,
+    PayloadField(CType.uint8, "field_index", "Parameter number"),
+    PayloadField(CType.uint8, "field_chunk", "Chunk number to send"),
+  ]),
+  parameter_write(0x2D, [
+    ..._extendedHeader,
+    PayloadField(CType.uint8, "field_index", "Parameter number"),
+    PayloadField(CType.bytes, "value", "New value, encoded by parameter type"),
+  ]),
+  command(
+    0x32,
+    [
+      ..._extendedHeader,
+      PayloadField(CType.uint8, "command", "Command ID"),
+      PayloadField(CType.bytes, "data",
+          "Sub-command and arguments, then the command CRC8 (poly 0xBA)"),
+    ],
+    comment: "Checking the inner CRC is left to the command's handler",
+  ),
+  radio_id(
+    0x3A,
+    [
+      ..._extendedHeader,
+      PayloadField(
+          CType.uint8, "subtype", "Sub-type, 0x10 for timing correction"),
+      PayloadField(CType.uint32, "interval",
+          "Frame interval the module runs at ( us * 10 )"),
+      PayloadField(CType.int32, "offset",
+          "How much earlier than wanted the last RC frame arrived ( us * 10 )"),
+    ],
+    comment:
+        "Sent by TX modules (as OpenTX sync) so the handset can phase-lock its RC frames to the RF clock",
+  ),
+  custom(
+    0x7F,
+    [PayloadField(CType.bytes, "buffer", "")],
+    typeName: "CUSTOM_PAYLOAD",
+  );
 
-  const Payload(this.frameType, this.fields);
+  const Payload(this.frameType, this.fields, {this.typeName, this.comment});
 
   final int frameType;
   final List<PayloadField> fields;
+  // Overrides the frame type enum name derived from `name`
+  final String? typeName;
+  final String? comment;
 
+  // The frame length byte of the smallest valid frame: [type] [payload] [crc8]
   int get length {
-    int len = 0;
-    for (var field in fields) {
-      len += field.type == CType.uint24 ? 3 : 2;
-    }
-    return len;
+    final payloadBits = fields.fold(
+      0,
+      (int prev, field) =>
+          prev +
+          (field.writeType.variable
+              ? field.writeType.minBytes * 8
+              : field.writeType.bits),
+    );
+    return 1 + payloadBits ~/ 8 + 1;
   }
 
+  bool get packed => fields.any((field) => field.type.packed);
+
+  bool get variable => fields.any((field) => field.type.variable);
+
+  // Payload bytes of a fixed-size frame, the minimum for a variable one
+  int get payloadSize => length - 2;
+
+  String get payloadSizeName => "CRSF_${name.toUpperCase()}_PAYLOAD_SIZE";
+
+  String get structName => "crsf_payload_${name}_t";
+
+  // Compile-time switch for the type's codecs, see crsf_config.h
+  String get switchName => "CRSF_FRAME_${typeName ?? name.toUpperCase()}";
+
   void toStruct(StringBuffer buffer) {
-    final packed = fields.any((field) => field.type.packed);
+    buffer.write("#define $payloadSizeName $payloadSize");
+    buffer.writeln();
+    if (comment != null) {
+      buffer.write("// $comment");
+      buffer.writeln();
+    }
     buffer.write("typedef struct ");
     if (packed) {
       buffer.write("__attribute__((packed)) ");
@@ -132,6 +526,14 @@ enum Payload {
     buffer.write("{");
     buffer.writeln();
     for (var field in fields) {
+      if (field.type == CType.channelSubset) {
+        buffer.write("\t// First channel in the frame (0 - 15)\n");
+        buffer.write("\tuint8_t start_channel;\n");
+        buffer.write("\t// Bits per channel value (10 - 13)\n");
+        buffer.write("\tuint8_t resolution;\n");
+        buffer.write("\t// Number of channel values\n");
+        buffer.write("\tuint8_t count;\n");
+      }
       final hasComment = field.description.isNotEmpty;
       if (hasComment) {
         buffer.write("\t// ${field.description}");
@@ -144,54 +546,198 @@ enum Payload {
       if (field.type.packed) {
         buffer.write(" : ${field.type.bits}");
       }
+      if (field.type == CType.string) {
+        buffer.write("[${field.size}]");
+      }
+      if (field.type == CType.bytes) {
+        // Whatever the fields before it leave of the largest payload
+        final rest = _fixedBytesFrom(0);
+        buffer.write(rest > 0
+            ? "[CRSF_MAX_PAYLOAD_SIZE - $rest]"
+            : "[CRSF_MAX_PAYLOAD_SIZE]");
+      }
+      if (field.type == CType.channelSubset) {
+        buffer.write("[CRSF_RC_CHANNELS]");
+      }
       buffer.write(";");
       buffer.writeln();
+      if (field.type == CType.bytes) {
+        buffer.write("\tuint8_t length;");
+        buffer.writeln();
+      }
+    }
+    buffer.write("} $structName;");
+  }
+
+  // Fixed-size bytes of the fields from `index` up to the next variable one
+  int _fixedBytesFrom(int index) {
+    var bytes = 0;
+    for (var field in fields.skip(index)) {
+      if (field.writeType.variable) {
+        break;
+      }
+      bytes += field.writeType.bits ~/ 8;
     }
-    buffer.write("} crsf_payload_${this.name}_t;");
+    return bytes;
   }
 
-  void toCBuffer(StringBuffer str) {
-    str.write("void _write_${this.name}_payload()");
+  // Reads the wire payload into the struct, failing on short or malformed payloads
+  void toCDecode(StringBuffer str) {
+    str.write(
+        "bool crsf_decode_$name(const uint8_t *payload, uint8_t length, $structName *out)");
     str.writeln();
     str.write("{");
     str.writeln();
-    final payloadBits = fields.fold(
-      0,
-      (int prev, field) => prev + field.writeType.bits,
-    );
-    final payloadBytes = payloadBits ~/ 8;
-    // Type + Payload + CRC
-    final frameLength = 1 + payloadBytes + 1;
-    _write_to_buffer(str, CType.uint8, "$frameLength");
-    str.write("\t// Frame length\n");
-    _write_to_buffer(str, CType.uint8, frameTypeEnumName);
-    str.write("\t// Frame type\n");
+    if (payloadSize > 0) {
+      str.write("  if (length < $payloadSizeName)\n");
+      str.write("  {\n");
+      str.write("    return false;\n");
+      str.write("  }\n");
+    }
+    if (packed) {
+      // Bitfields are allocated from the least significant bit on GCC and Clang,
+      // which matches the little-endian channel packing on the wire
+      str.write("  memcpy(out, payload, $payloadSizeName);\n");
+      str.write("  return true;\n");
+      str.write("}");
+      return;
+    }
+    if (!variable) {
+      var offset = 0;
+      for (var field in fields) {
+        str.write(
+            "  out->${field.name} = _load_${field.writeType.suffix}(&payload[$offset]);\n");
+        offset += field.writeType.bits ~/ 8;
+      }
+      str.write("  return true;\n");
+      str.write("}");
+      return;
+    }
+    str.write("  uint8_t offset = 0;\n");
+    for (var i = 0; i < fields.length; i++) {
+      final field = fields[i];
+      switch (field.writeType) {
+        case CType.string:
+          final rest = _fixedBytesFrom(i + 1);
+          str.write(
+              "  const uint8_t ${field.name}_size = _load_string(out->${field.name}, sizeof(out->${field.name}), &payload[offset], length - offset);\n");
+          str.write(rest > 0
+              ? "  if (${field.name}_size == 0 || length - offset - ${field.name}_size < $rest)\n"
+              : "  if (${field.name}_size == 0)\n");
+          str.write("  {\n");
+          str.write("    return false;\n");
+          str.write("  }\n");
+          str.write("  offset += ${field.name}_size;\n");
+          break;
+        case CType.bytes:
+          str.write("  if ((size_t)(length - offset) > sizeof(out->${field.name}))\n");
+          str.write("  {\n");
+          str.write("    return false;\n");
+          str.write("  }\n");
+          str.write("  out->length = length - offset;\n");
+          str.write(
+              "  memcpy(out->${field.name}, &payload[offset], out->length);\n");
+          str.write("  offset += out->length;\n");
+          break;
+        case CType.channelSubset:
+          str.write(
+              "  out->count = crsf_unpack_channel_subset(&payload[offset], length - offset, &out->start_channel, &out->resolution, out->${field.name});\n");
+          str.write("  if (out->count == 0)\n");
+          str.write("  {\n");
+          str.write("    return false;\n");
+          str.write("  }\n");
+          str.write("  offset = length;\n");
+          break;
+        default:
+          str.write(
+              "  out->${field.name} = _load_${field.writeType.suffix}(&payload[offset]);\n");
+          str.write("  offset += ${field.writeType.bits ~/ 8};\n");
+      }
+    }
+    str.write("  return true;\n");
+    str.write("}");
+  }
+
+  // Writes the struct as a wire payload, returning its length
+  void toCEncode(StringBuffer str) {
+    str.write(
+        "uint8_t crsf_encode_$name(const $structName *value, uint8_t *payload)");
+    str.writeln();
+    str.write("{");
+    str.writeln();
+    if (packed) {
+      str.write("  memcpy(payload, value, $payloadSizeName);\n");
+      str.write("  return $payloadSizeName;\n");
+      str.write("}");
+      return;
+    }
+    if (!variable) {
+      var offset = 0;
+      for (var field in fields) {
+        str.write(
+            "  _store_${field.writeType.suffix}(&payload[$offset], value->${field.name});\n");
+        offset += field.writeType.bits ~/ 8;
+      }
+      str.write("  return $payloadSizeName;\n");
+      str.write("}");
+      return;
+    }
+    str.write("  uint8_t offset = 0;\n");
     for (var field in fields) {
-      _write_to_buffer(
-        str,
-        field.writeType,
-        "_telemetry.${name}.${field.name}",
-      );
-      str.writeln();
+      switch (field.writeType) {
+        case CType.string:
+          str.write(
+              "  offset += _store_string(&payload[offset], value->${field.name}, sizeof(value->${field.name}));\n");
+          break;
+        case CType.bytes:
+          str.write(
+              "  const uint8_t ${field.name}_length = value->length < sizeof(value->${field.name}) ? value->length : sizeof(value->${field.name});\n");
+          str.write(
+              "  memcpy(&payload[offset], value->${field.name}, ${field.name}_length);\n");
+          str.write("  offset += ${field.name}_length;\n");
+          break;
+        case CType.channelSubset:
+          str.write(
+              "  offset += crsf_pack_channel_subset(value->start_channel, value->resolution, value->${field.name}, value->count, &payload[offset]);\n");
+          break;
+        default:
+          str.write(
+              "  _store_${field.writeType.suffix}(&payload[offset], value->${field.name});\n");
+          str.write("  offset += ${field.writeType.bits ~/ 8};\n");
+      }
     }
+    str.write("  return offset;\n");
     str.write("}");
   }
 
-  void _write_to_buffer(StringBuffer str, CType type, String arg) {
-    String writeFunc = type.writeStr;
-    str.write("\t${writeFunc}(&_telem_buf, $arg);");
+  // Stores each field big-endian into a pre-encoded payload, reporting whether any byte changed
+  void toCPatch(StringBuffer str) {
+    str.write(
+        "bool crsf_patch_$name(uint8_t *payload, const $structName *value)");
+    str.writeln();
+    str.write("{");
+    str.writeln();
+    str.write("  bool changed = false;");
+    str.writeln();
+    var offset = 0;
+    for (var field in fields) {
+      str.write(
+          "  changed |= _patch_${field.writeType.suffix}(&payload[$offset], value->${field.name});");
+      str.writeln();
+      offset += field.writeType.bits ~/ 8;
+    }
+    str.write("  return changed;");
+    str.writeln();
+    str.write("}");
   }
 
-  static void toTelemetryStruct(StringBuffer buffer) {
-    buffer.write("typedef struct telemetry_s");
-    buffer.writeln();
-    buffer.write("{");
-    buffer.writeln();
+  static void toSwitches(StringBuffer buffer) {
+    buffer.write("// Frame types whose codecs are built, see crsf_config.h\n");
     for (var payload in Payload.values) {
-      buffer.write("\tcrsf_payload_${payload.name}_t ${payload.name};");
-      buffer.writeln();
+      buffer.write("#ifndef ${payload.switchName}\n");
+      buffer.write("#define ${payload.switchName} 1\n");
+      buffer.write("#endif\n");
     }
-    buffer.write("} telemetry_t;");
   }
 
   static void toEnum(StringBuffer buffer) {
@@ -209,7 +755,158 @@ enum Payload {
     buffer.write("} frame_type_t;");
   }
 
+  static void toUnion(StringBuffer buffer) {
+    buffer.write("// Any decoded payload, as handed to the frame callback");
+    buffer.writeln();
+    buffer.write("typedef union");
+    buffer.writeln();
+    buffer.write("{");
+    buffer.writeln();
+    for (var payload in Payload.values) {
+      buffer.write("#if ${payload.switchName}\n");
+      buffer.write("\t${payload.structName} ${payload.name};");
+      buffer.writeln();
+      buffer.write("#endif\n");
+    }
+    buffer.write("} crsf_frame_payload_t;");
+  }
+
+  static void toCodecTable(StringBuffer buffer) {
+    final entries = Payload.values
+            .map((payload) => payload.frameType)
+            .reduce((a, b) => a > b ? a : b) +
+        1;
+    buffer.write("""typedef bool (*crsf_frame_decoder_t)(const uint8_t *payload, uint8_t length, void *out);
+typedef uint8_t (*crsf_frame_encoder_t)(const void *value, uint8_t *payload);
+
+typedef struct
+{
+	// Payload bytes in the smallest valid frame
+	uint8_t min_length;
+	crsf_frame_decoder_t decode;
+	crsf_frame_encoder_t encode;
+} crsf_frame_codec_t;
+
+// crsf_frame_codecs is indexed by frame type; unknown types have no decoder
+#define CRSF_FRAME_CODECS ${entries.hex}
+""");
+  }
+
+  static void toPrototypes(StringBuffer buffer) {
+    buffer.write("#ifdef __cplusplus\n");
+    buffer.write("extern \"C\"\n");
+    buffer.write("{\n");
+    buffer.write("#endif\n");
+    buffer.writeln();
+    buffer.write(
+        "    extern const crsf_frame_codec_t crsf_frame_codecs[CRSF_FRAME_CODECS];\n");
+    buffer.writeln();
+    for (var payload in Payload.values) {
+      buffer.write("#if ${payload.switchName}\n");
+      buffer.write(
+          "    bool crsf_decode_${payload.name}(const uint8_t *payload, uint8_t length, ${payload.structName} *out);\n");
+      buffer.write(
+          "    uint8_t crsf_encode_${payload.name}(const ${payload.structName} *value, uint8_t *payload);\n");
+      if (!payload.packed && !payload.variable) {
+        buffer.write(
+            "    bool crsf_patch_${payload.name}(uint8_t *payload, const ${payload.structName} *value);\n");
+      }
+      buffer.write("#endif\n");
+    }
+    buffer.writeln();
+    buffer.write("#ifdef __cplusplus\n");
+    buffer.write("}\n");
+    buffer.write("#endif\n");
+  }
+
+  static void toDispatchTable(StringBuffer str) {
+    str.write("// Adapters to the untyped signatures stored in crsf_frame_codecs\n");
+    for (var payload in Payload.values) {
+      str.write("#if ${payload.switchName}\n");
+      str.write(
+          "static bool _decode_${payload.name}(const uint8_t *payload, uint8_t length, void *out)\n");
+      str.write("{\n");
+      str.write(
+          "  return crsf_decode_${payload.name}(payload, length, out);\n");
+      str.write("}\n");
+      str.writeln();
+      str.write(
+          "static uint8_t _encode_${payload.name}(const void *value, uint8_t *payload)\n");
+      str.write("{\n");
+      str.write("  return crsf_encode_${payload.name}(value, payload);\n");
+      str.write("}\n");
+      str.write("#endif\n");
+      str.writeln();
+    }
+    str.write(
+        "const crsf_frame_codec_t crsf_frame_codecs[CRSF_FRAME_CODECS] = {\n");
+    for (var payload in Payload.values) {
+      str.write("#if ${payload.switchName}\n");
+      str.write(
+          "    [${payload.frameTypeEnumName}] = {${payload.payloadSizeName}, _decode_${payload.name}, _encode_${payload.name}},\n");
+      str.write("#endif\n");
+    }
+    str.write("};\n");
+  }
+
+  // Fixed-size payloads are described field by field so crsf.hpp can inline
+  // them; the others delegate to their C codecs
+  void toCppDescriptor(StringBuffer str) {
+    str.write("#if $switchName\n");
+    str.write("    template <>\n");
+    str.write("    struct frame<$frameTypeEnumName>\n");
+    str.write(
+        "        : descriptor<$frameTypeEnumName, $structName, $payloadSizeName,\n");
+    if (packed || variable) {
+      str.write(
+          "                     codec<crsf_decode_$name, crsf_encode_$name>>\n");
+    } else {
+      str.write("                     field_list<\n");
+      var offset = 0;
+      for (var i = 0; i < fields.length; i++) {
+        final field = fields[i];
+        str.write(
+            "                         field<&$structName::${field.name}, $offset, wire::${field.writeType.suffix}>");
+        str.write(i < fields.length - 1 ? ",\n" : ">>\n");
+        offset += field.writeType.bits ~/ 8;
+      }
+    }
+    str.write("    {\n");
+    if (packed) {
+      // The C codec copies the bitfields straight to and from the wire
+      str.write(
+          "        static_assert(sizeof(payload_type) == payload_size, \"the bitfields are not packed as on the wire\");\n");
+    }
+    str.write("    };\n");
+    str.write("#endif\n");
+  }
+
+  static void toCppVisit(StringBuffer str) {
+    str.write("""    // Calls `visitor` with an empty frame<> of the given type and returns its
+    // result, or returns false for types without a descriptor. The switch
+    // replaces the crsf_frame_codecs lookup and keeps every call visible to the
+    // compiler, so cases the visitor ignores fold away.
+    template <typename Visitor>
+    bool visit(uint8_t type, Visitor &&visitor)
+    {
+        switch (type)
+        {
+""");
+    for (var payload in Payload.values) {
+      str.write("#if ${payload.switchName}\n");
+      str.write("        case ${payload.frameTypeEnumName}:\n");
+      str.write(
+          "            return visitor(frame<${payload.frameTypeEnumName}>{});\n");
+      str.write("#endif\n");
+    }
+    str.write("""        default:
+            return false;
+        }
+    }
+""");
+  }
+
   String get frameTypeEnumName {
-    return "CRSF_FRAMETYPE_${name.toUpperCase()}";
+    return "CRSF_FRAMETYPE_${typeName ?? name.toUpperCase()}";
   }
 }
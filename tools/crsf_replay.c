@@ -0,0 +1,315 @@
+/**
+ * @file crsf_replay.c
+ * @author Britannio Jarrett
+ * @brief Replays a capture file through the library, as fast as possible or in real time.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Usage: crsf_replay [--realtime | --speed X] capture.bin
+ *
+ * The received bytes are handed to crsf_process_frames() chunk for chunk as
+ * they were recorded, through a transport whose clock is the capture's, so
+ * the telemetry scheduler and the failsafe see the original timing. By default
+ * the clock jumps straight to each record; --realtime waits for it instead and
+ * --speed scales the wait. The summary ends with a digest of every decoded
+ * channel value, which changes if any RC frame decodes differently. The frame
+ * counts and the digest come from the callbacks, so need CRSF_CALLBACKS.
+ */
+
+#include "crsf.h"
+#include "crsf_capture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct
+{
+  crsf_capture_reader_t reader;
+  // Received record being read, `consumed` bytes in
+  crsf_capture_record_t record;
+  size_t consumed;
+  bool pending;
+  bool done;
+  // 0 to replay as fast as possible, otherwise capture seconds per wall second
+  double speed;
+  uint64_t start_us;
+  // Capture clock when not replaying in real time
+  uint64_t now_us;
+  uint32_t tx_recorded;
+  uint32_t tx_written;
+} replay_t;
+
+static uint64_t _monotonic_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t _replay_time(void *ctx)
+{
+  replay_t *replay = ctx;
+  if (replay->speed == 0)
+  {
+    return replay->now_us;
+  }
+  return (uint64_t)((_monotonic_us() - replay->start_us) * replay->speed);
+}
+
+static size_t _replay_read(void *ctx, uint8_t *buf, size_t max)
+{
+  replay_t *replay = ctx;
+  while (!replay->pending)
+  {
+    if (!crsf_capture_next(&replay->reader, &replay->record))
+    {
+      replay->done = true;
+      return 0;
+    }
+    if (replay->record.tx)
+    {
+      replay->tx_recorded++;
+      continue;
+    }
+    replay->pending = true;
+    replay->consumed = 0;
+  }
+  if (replay->speed == 0)
+  {
+    replay->now_us = replay->record.time_us;
+  }
+  else if (_replay_time(replay) < replay->record.time_us)
+  {
+    return 0;
+  }
+  const size_t remaining = replay->record.length - replay->consumed;
+  const size_t count = remaining < max ? remaining : max;
+  memcpy(buf, replay->record.data + replay->consumed, count);
+  replay->consumed += count;
+  replay->pending = replay->consumed < replay->record.length;
+  return count;
+}
+
+static size_t _replay_write(void *ctx, const uint8_t *buf, size_t len)
+{
+  (void)buf;
+  ((replay_t *)ctx)->tx_written++;
+  return len;
+}
+
+// The capture was recorded at one rate; follow any switch the stream negotiates
+static bool _replay_set_baud(void *ctx, uint32_t baud)
+{
+  (void)ctx;
+  (void)baud;
+  return true;
+}
+
+// Sleeps until the pending record is due
+static void _replay_wait(const replay_t *replay)
+{
+  const uint64_t due_us = replay->start_us + (uint64_t)(replay->record.time_us / replay->speed);
+  const struct timespec until = {
+      .tv_sec = due_us / 1000000,
+      .tv_nsec = (due_us % 1000000) * 1000,
+  };
+  clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL);
+}
+
+// Counted through the callbacks, so only with CRSF_CALLBACKS
+#if CRSF_CALLBACKS
+static const struct
+{
+  frame_type_t type;
+  const char *name;
+} _frame_names[] = {
+    {CRSF_FRAMETYPE_GPS, "gps"},
+    {CRSF_FRAMETYPE_VARIO, "vario"},
+    {CRSF_FRAMETYPE_BATTERY_SENSOR, "battery"},
+    {CRSF_FRAMETYPE_BARO_ALTITUDE, "baro"},
+    {CRSF_FRAMETYPE_LINK_STATISTICS, "link stats"},
+    {CRSF_FRAMETYPE_RC_CHANNELS_PACKED, "rc"},
+    {CRSF_FRAMETYPE_RC_CHANNELS_SUBSET, "rc subset"},
+    {CRSF_FRAMETYPE_ATTITUDE, "attitude"},
+    {CRSF_FRAMETYPE_FLIGHT_MODE, "flight mode"},
+    {CRSF_FRAMETYPE_DEVICE_PING, "ping"},
+    {CRSF_FRAMETYPE_DEVICE_INFO, "device info"},
+    {CRSF_FRAMETYPE_PARAMETER_SETTINGS_ENTRY, "param entry"},
+    {CRSF_FRAMETYPE_PARAMETER_READ, "param read"},
+    {CRSF_FRAMETYPE_PARAMETER_WRITE, "param write"},
+    {CRSF_FRAMETYPE_COMMAND, "command"},
+    {CRSF_FRAMETYPE_CUSTOM_PAYLOAD, "custom"},
+};
+
+static uint32_t _frame_counts[256];
+static uint32_t _failsafe_changes;
+// FNV-1a over every decoded channel value
+static uint32_t _channel_digest = 2166136261u;
+
+static void _on_frame(crsf_t *crsf, frame_type_t type, const crsf_frame_payload_t *payload)
+{
+  (void)crsf;
+  (void)payload;
+  _frame_counts[type & 0xFF]++;
+}
+
+static void _on_rc_channels(crsf_t *crsf, const uint16_t channels[16])
+{
+  (void)crsf;
+  for (int i = 0; i < 16; i++)
+  {
+    _channel_digest = (_channel_digest ^ (channels[i] & 0xFF)) * 16777619u;
+    _channel_digest = (_channel_digest ^ (channels[i] >> 8)) * 16777619u;
+  }
+}
+
+static void _on_failsafe(crsf_t *crsf, const bool failsafe)
+{
+  (void)crsf;
+  (void)failsafe;
+  _failsafe_changes++;
+}
+#endif
+
+static uint8_t *_load(const char *path, size_t *length)
+{
+  FILE *file = fopen(path, "rb");
+  if (file == NULL)
+  {
+    perror(path);
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  rewind(file);
+  uint8_t *data = size >= 0 ? malloc(size > 0 ? size : 1) : NULL;
+  if (data != NULL && fread(data, 1, size, file) != (size_t)size)
+  {
+    free(data);
+    data = NULL;
+  }
+  fclose(file);
+  *length = size;
+  return data;
+}
+
+int main(int argc, char **argv)
+{
+  double speed = 0;
+  const char *path = NULL;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--realtime") == 0)
+    {
+      speed = 1;
+    }
+    else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc)
+    {
+      speed = strtod(argv[++i], NULL);
+    }
+    else if (path == NULL && argv[i][0] != '-')
+    {
+      path = argv[i];
+    }
+    else
+    {
+      path = NULL;
+      break;
+    }
+  }
+  if (path == NULL || speed < 0)
+  {
+    fprintf(stderr, "Usage: %s [--realtime | --speed X] capture.bin\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  size_t length;
+  uint8_t *data = _load(path, &length);
+  if (data == NULL)
+  {
+    return EXIT_FAILURE;
+  }
+  replay_t replay = {.speed = speed};
+  if (!crsf_capture_reader_init(&replay.reader, data, length))
+  {
+    fprintf(stderr, "%s: not a capture\n", path);
+    free(data);
+    return EXIT_FAILURE;
+  }
+
+  const crsf_transport_t transport = {
+      .read = _replay_read,
+      .write = _replay_write,
+      .time_us = _replay_time,
+      .set_baud = _replay_set_baud,
+      .ctx = &replay,
+  };
+  crsf_t crsf;
+  crsf_init(&crsf, &transport);
+  crsf_ctx_set_baud_rate(&crsf, replay.reader.baud_rate);
+#if CRSF_CALLBACKS
+  crsf_ctx_set_on_frame(&crsf, _on_frame);
+  crsf_ctx_set_on_rc_channels(&crsf, _on_rc_channels);
+  crsf_ctx_set_on_failsafe(&crsf, _on_failsafe);
+#endif
+
+  replay.start_us = _monotonic_us();
+  while (!replay.done)
+  {
+    crsf_ctx_process_frames(&crsf);
+    if (replay.pending && speed > 0)
+    {
+      _replay_wait(&replay);
+    }
+  }
+  const double wall_s = (_monotonic_us() - replay.start_us) / 1e6;
+  const double capture_s = replay.reader.time_us / 1e6;
+
+  printf("%s: %lu baud, %.3f s, %lu bytes\n", path, (unsigned long)replay.reader.baud_rate, capture_s,
+         (unsigned long)length);
+  printf("replayed in %.3f s (%.1fx real time)\n", wall_s, wall_s > 0 ? capture_s / wall_s : 0);
+#if CRSF_CALLBACKS
+  uint32_t frames = 0;
+  for (int type = 0; type < 256; type++)
+  {
+    if (_frame_counts[type] == 0)
+    {
+      continue;
+    }
+    const char *name = "unknown";
+    for (size_t i = 0; i < sizeof(_frame_names) / sizeof(_frame_names[0]); i++)
+    {
+      if ((int)_frame_names[i].type == type)
+      {
+        name = _frame_names[i].name;
+      }
+    }
+    printf("  0x%02X %-12s %lu\n", type, name, (unsigned long)_frame_counts[type]);
+    frames += _frame_counts[type];
+  }
+  printf("frames %lu, failsafe changes %lu, telemetry %lu sent (%lu in the capture)\n", (unsigned long)frames,
+         (unsigned long)_failsafe_changes, (unsigned long)replay.tx_written, (unsigned long)replay.tx_recorded);
+#else
+  printf("telemetry %lu sent (%lu in the capture), no frame counts without CRSF_CALLBACKS\n",
+         (unsigned long)replay.tx_written, (unsigned long)replay.tx_recorded);
+#endif
+  crsf_stats_t stats;
+  if (crsf_ctx_get_stats(&crsf, &stats))
+  {
+    printf("errors %lu crc, %lu length, %lu unknown, %lu malformed, %lu resyncs, %llu bytes discarded\n",
+           (unsigned long)stats.crc_errors, (unsigned long)stats.bad_lengths, (unsigned long)stats.unknown_types,
+           (unsigned long)stats.malformed, (unsigned long)stats.resyncs, (unsigned long long)stats.bytes_discarded);
+  }
+#if CRSF_CALLBACKS
+  printf("channel digest %08lx\n", (unsigned long)_channel_digest);
+#endif
+  free(data);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,192 @@
+/**
+ * @file crsf_size.c
+ * @author Britannio Jarrett
+ * @brief Smallest receive-only firmware, built once per configuration by the crsf_size report.
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Reads RC frames from a transport, hands the channels to the application
+ * through the callback or the snapshot (whichever the configuration keeps) and
+ * sends battery telemetry when it is built in. Built with CRSF_SIZE_BASELINE
+ * the same loop runs without the library, so the report can subtract the
+ * runtime and the scaffolding and show what the library itself costs. With
+ * CRSF_SIZE_FRAMING the loop frames the stream with crsf_framing.h and decodes
+ * RC frames with crsf_decode_rc_channels_packed(), without crsf_t: the same work
+ * as crsf::parser in crsf_size.cpp. With CRSF_SIZE_ON_FRAME the channels come
+ * from the frame callback of crsf_t instead.
+ */
+
+#include "crsf.h"
+
+// One RC frame with every channel centred, CRC included
+static const uint8_t _rc_frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4] = {
+    0xC8, 0x18, 0x16, 0xE0, 0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C,
+    0xE0, 0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0xAD,
+};
+
+// Keeps the channels alive past the optimizer, as an output stage would
+static volatile uint16_t _sink[CRSF_RC_CHANNELS];
+
+static uint64_t _clock_us;
+static uint32_t _frames_left = 100;
+
+static size_t _read(void *ctx, uint8_t *buf, size_t max)
+{
+  (void)ctx;
+  if (_frames_left == 0 || max < sizeof(_rc_frame))
+  {
+    return 0;
+  }
+  _frames_left--;
+  _clock_us += 4000;
+  for (size_t i = 0; i < sizeof(_rc_frame); i++)
+  {
+    buf[i] = _rc_frame[i];
+  }
+  return sizeof(_rc_frame);
+}
+
+static size_t _write(void *ctx, const uint8_t *buf, size_t len)
+{
+  (void)ctx;
+  _sink[0] = buf[len - 1];
+  return len;
+}
+
+static uint64_t _time_us(void *ctx)
+{
+  (void)ctx;
+  return _clock_us;
+}
+
+static const crsf_transport_t _transport = {
+    .read = _read,
+    .write = _write,
+    .time_us = _time_us,
+};
+
+#ifdef CRSF_SIZE_BASELINE
+int main(void)
+{
+  uint8_t chunk[CRSF_MAX_FRAME_SIZE];
+  size_t count;
+  while ((count = _transport.read(_transport.ctx, chunk, sizeof(chunk))) > 0)
+  {
+    _transport.write(_transport.ctx, chunk, count);
+    for (int i = 0; i < CRSF_RC_CHANNELS; i++)
+    {
+      _sink[i] = chunk[3 + i];
+    }
+  }
+  return _sink[0];
+}
+#elif defined(CRSF_SIZE_FRAMING)
+static crsf_framer_t _framer;
+
+// The framing of crsf_ctx_parse() and crsf::parser and the RC decoder, without crsf_t
+int main(void)
+{
+  uint8_t chunk[CRSF_MAX_FRAME_SIZE];
+  size_t count;
+  while ((count = _transport.read(_transport.ctx, chunk, sizeof(chunk))) > 0)
+  {
+    const uint8_t *data = chunk;
+    while (count > 0)
+    {
+      if (_framer.length == 0)
+      {
+        const uint8_t *sync = crsf_find_sync_byte(data, count, CRSF_ADDRESS_FLIGHT_CONTROLLER);
+        if (sync == NULL)
+        {
+          break;
+        }
+        count -= sync - data;
+        data = sync;
+      }
+      const size_t taken = crsf_framer_fill(&_framer, data, count);
+      data += taken;
+      count -= taken;
+
+      crsf_framer_status_t status;
+      while ((status = crsf_framer_check(&_framer)) != CRSF_FRAMER_INCOMPLETE)
+      {
+        crsf_payload_rc_channels_packed_t rc;
+        if (status == CRSF_FRAMER_VALID && _framer.frame[2] == CRSF_FRAMETYPE_RC_CHANNELS_PACKED &&
+            crsf_decode_rc_channels_packed(&_framer.frame[3], _framer.frame[1] - 2, &rc))
+        {
+          uint16_t channels[CRSF_RC_CHANNELS];
+          crsf_unpack_channels((const uint8_t *)&rc, channels);
+          for (int i = 0; i < CRSF_RC_CHANNELS; i++)
+          {
+            _sink[i] = channels[i];
+          }
+        }
+        crsf_framer_realign(&_framer, status, CRSF_ADDRESS_FLIGHT_CONTROLLER);
+      }
+    }
+  }
+  return _sink[0];
+}
+#else
+static crsf_t _link;
+
+#if CRSF_CALLBACKS && defined(CRSF_SIZE_ON_FRAME)
+// Frame-level handling through the frame callback, the C counterpart of crsf_size.cpp
+static void _on_frame(crsf_t *crsf, frame_type_t type, const crsf_frame_payload_t *payload)
+{
+  (void)crsf;
+  if (type == CRSF_FRAMETYPE_RC_CHANNELS_PACKED)
+  {
+    uint16_t channels[CRSF_RC_CHANNELS];
+    crsf_unpack_channels((const uint8_t *)&payload->rc_channels_packed, channels);
+    for (int i = 0; i < CRSF_RC_CHANNELS; i++)
+    {
+      _sink[i] = channels[i];
+    }
+  }
+}
+#elif CRSF_CALLBACKS
+static void _on_rc_channels(crsf_t *crsf, const uint16_t channels[16])
+{
+  (void)crsf;
+  for (int i = 0; i < CRSF_RC_CHANNELS; i++)
+  {
+    _sink[i] = channels[i];
+  }
+}
+#endif
+
+int main(void)
+{
+  crsf_init(&_link, &_transport);
+#if CRSF_CALLBACKS && defined(CRSF_SIZE_ON_FRAME)
+  crsf_ctx_set_on_frame(&_link, _on_frame);
+#elif CRSF_CALLBACKS
+  crsf_ctx_set_on_rc_channels(&_link, _on_rc_channels);
+#endif
+  while (_frames_left > 0)
+  {
+    crsf_ctx_process_frames(&_link);
+#if CRSF_SNAPSHOT && !CRSF_CALLBACKS
+    crsf_snapshot_t snapshot;
+    if (crsf_ctx_get_latest(&_link, &snapshot))
+    {
+      for (int i = 0; i < CRSF_RC_CHANNELS; i++)
+      {
+        _sink[i] = snapshot.channels[i];
+      }
+    }
+#endif
+#if CRSF_TELEMETRY
+    crsf_ctx_telem_set_battery_data(&_link, 120, 5, 1000, _frames_left);
+#endif
+  }
+  return _sink[0];
+}
+#endif
@@ -0,0 +1,41 @@
+# Prints the flash and RAM of every crsf_size_<config> binary, run by the crsf_size target:
+#   cmake -DSIZE=<size> -DCONFIGS=a,b -DBINARIES=<a>,<b> -P crsf_size.cmake
+# Flash is text + data (initial values are stored in flash), RAM is data + bss.
+# The deltas are against the baseline configuration, the same firmware without the library.
+string(REPLACE "," ";" CONFIGS "${CONFIGS}")
+string(REPLACE "," ";" BINARIES "${BINARIES}")
+
+set(report "")
+set(baseline_flash 0)
+set(baseline_ram 0)
+foreach (config ${CONFIGS})
+    list(GET BINARIES 0 binary)
+    list(REMOVE_AT BINARIES 0)
+    execute_process(
+        COMMAND ${SIZE} -B ${binary}
+        OUTPUT_VARIABLE output
+        RESULT_VARIABLE result
+    )
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "${SIZE} failed on ${binary}")
+    endif ()
+    # Second line: text data bss dec hex filename
+    string(REGEX MATCH "\n *([0-9]+)[ \t]+([0-9]+)[ \t]+([0-9]+)" _ "${output}")
+    math(EXPR flash "${CMAKE_MATCH_1} + ${CMAKE_MATCH_2}")
+    math(EXPR ram "${CMAKE_MATCH_2} + ${CMAKE_MATCH_3}")
+    if (config STREQUAL "baseline")
+        set(baseline_flash ${flash})
+        set(baseline_ram ${ram})
+    endif ()
+    math(EXPR flash_delta "${flash} - ${baseline_flash}")
+    math(EXPR ram_delta "${ram} - ${baseline_ram}")
+
+    set(name "${config}")
+    string(LENGTH "${name}" length)
+    while (length LESS 16)
+        string(APPEND name " ")
+        math(EXPR length "${length} + 1")
+    endwhile ()
+    string(APPEND report "${name}flash ${flash} (+${flash_delta})\tram ${ram} (+${ram_delta})\n")
+endforeach ()
+message("${report}")
@@ -0,0 +1,76 @@
+/**
+ * @file crsf_size.cpp
+ * @author Britannio Jarrett
+ * @brief crsf_size.c with crsf::parser from crsf.hpp in place of crsf_ctx_parse().
+ * @version 0.1
+ * @date 2024-04-13
+ *
+ * @copyright Copyright (c) Britannio Jarrett 2024
+ *
+ * @section LICENSE
+ * Licensed under the MIT License.
+ * See https://github.com/britannio/pico_crsf/blob/main/LICENSE for more information.
+ *
+ * Reads the same RC frames from the same transport and hands the channels to
+ * the application through a handler. crsf_size.c built with CRSF_SIZE_FRAMING
+ * (frames_c in the report) does the same in C with the same framing helpers, so
+ * the two compare like for like; frames_ctx is the frame callback of crsf_t,
+ * which brings in the failsafe, snapshot and telemetry left out here.
+ */
+
+#include "crsf.hpp"
+
+// One RC frame with every channel centred, CRC included
+static const uint8_t _rc_frame[CRSF_RC_CHANNELS_PAYLOAD_SIZE + 4] = {
+    0xC8, 0x18, 0x16, 0xE0, 0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C,
+    0xE0, 0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0xAD,
+};
+
+// Keeps the channels alive past the optimizer, as an output stage would
+static volatile uint16_t _sink[CRSF_RC_CHANNELS];
+
+static uint32_t _frames_left = 100;
+
+static size_t _read(void *ctx, uint8_t *buf, size_t max)
+{
+  (void)ctx;
+  if (_frames_left == 0 || max < sizeof(_rc_frame))
+  {
+    return 0;
+  }
+  _frames_left--;
+  for (size_t i = 0; i < sizeof(_rc_frame); i++)
+  {
+    buf[i] = _rc_frame[i];
+  }
+  return sizeof(_rc_frame);
+}
+
+// Receive only, so read is all it needs
+static const crsf_transport_t _transport = {_read, nullptr, nullptr, nullptr, nullptr};
+
+struct output
+{
+  void operator()(const crsf_payload_rc_channels_packed_t &rc)
+  {
+    uint16_t channels[CRSF_RC_CHANNELS];
+    crsf::unpack_channels(rc, channels);
+    for (int i = 0; i < CRSF_RC_CHANNELS; i++)
+    {
+      _sink[i] = channels[i];
+    }
+  }
+};
+
+static crsf::parser<output> _link{output{}};
+
+int main(void)
+{
+  uint8_t chunk[CRSF_MAX_FRAME_SIZE];
+  size_t count;
+  while ((count = _transport.read(_transport.ctx, chunk, sizeof(chunk))) > 0)
+  {
+    _link.parse(chunk, count);
+  }
+  return _sink[0];
+}